@@ -0,0 +1,464 @@
+/* KallistiGL for KallistiOS ##version##
+
+   libgl/bench/analyze.c
+
+   Offline analyzer for TA stream captures: reports where a frame spends TA
+   and ISP time, to find wasteful content and library paths. Built against
+   the host build with make bench.
+
+   Usage: analyze capture.kglc [heatmap prefix] [--scene n]
+
+   For each scene of the capture (or scene n only) it reports, per list:
+   - commands, polygon headers, strips, vertices and triangles;
+   - a histogram of vertices per strip, from the EOL flags;
+   - header switches by cause, the state that differs from the previous
+     header of the list (a header can switch for several causes at once);
+   - zero-area, tiny (under a pixel), off-screen and behind-the-eye
+     triangles;
+   - triangles per 32x32 tile, from the bounding box the TA bins by;
+   - estimated overdraw: triangles covering each pixel, depth test ignored.
+
+   With a heatmap prefix, the OP and TR overdraw of scene n is written to
+   prefix-n-op.ppm and prefix-n-tr.ppm: black for no coverage, then blue,
+   green, yellow and red at 8 or more triangles per pixel.
+*/
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <GL/gl.h>
+
+#include <dc/pvr.h>
+#include <dc/video.h>
+
+#define ANALYZE_TILE        32
+#define ANALYZE_STRIP_BINS  9
+#define ANALYZE_TILE_BINS   8
+#define ANALYZE_HEAT_MAX    8
+
+#define ANALYZE_CMD_TXR     (1 << 3) /* Textured bit of the polygon header cmd word */
+
+/* The lists analyzed, in the order the PVR renders them */
+static const struct {
+    uint32 list;
+    const char *name;
+} ANALYZE_LISTS[] = {
+    { PVR_LIST_OP_POLY, "OP" },
+    { PVR_LIST_PT_POLY, "PT" },
+    { PVR_LIST_TR_POLY, "TR" },
+};
+
+#define ANALYZE_LIST_COUNT (sizeof(ANALYZE_LISTS) / sizeof(ANALYZE_LISTS[0]))
+
+static const char *ANALYZE_STRIP_NAMES[ANALYZE_STRIP_BINS] = {
+    "1-2", "3", "4", "5-6", "7-8", "9-16", "17-32", "33-64", "65+"
+};
+
+static const char *ANALYZE_TILE_NAMES[ANALYZE_TILE_BINS] = {
+    "0", "1-4", "5-16", "17-64", "65-256", "257-1024", "1025-4096", "4097+"
+};
+
+/* Header switch causes, and the header bits each one covers */
+typedef enum {
+    ANALYZE_CAUSE_REPEAT,     /* Nothing changed - a redundant header */
+    ANALYZE_CAUSE_TEXTURE,
+    ANALYZE_CAUSE_TXR_PARAM,
+    ANALYZE_CAUSE_BLEND,
+    ANALYZE_CAUSE_DEPTH,
+    ANALYZE_CAUSE_CULL,
+    ANALYZE_CAUSE_FORMAT,
+    ANALYZE_CAUSE_CLIP,
+    ANALYZE_CAUSE_FOG,
+    ANALYZE_CAUSE_OTHER,
+    ANALYZE_CAUSES
+} ANALYZE_CAUSE;
+
+static const char *ANALYZE_CAUSE_NAMES[ANALYZE_CAUSES] = {
+    "repeat (no change)", "texture", "texture params", "blend / alpha", "depth",
+    "culling", "vertex format", "user clip", "fog", "other"
+};
+
+typedef struct {
+    uint32 cmds, headers, clips, strips, verts, tris;
+    uint32 zero_area, tiny, offscreen, behind;
+    uint32 strip_hist[ANALYZE_STRIP_BINS];
+    uint32 causes[ANALYZE_CAUSES];
+    uint32 *coverage;       /* Triangles covering each pixel */
+    uint32 *tile_tris;      /* Triangles binned to each tile */
+} ANALYZE_LIST;
+
+typedef struct {
+    uint32 width, height, tiles_x, tiles_y;
+    ANALYZE_LIST list[ANALYZE_LIST_COUNT];
+} ANALYZE_SCENE;
+
+typedef struct {
+    float x, y, invw;
+} ANALYZE_VERT;
+
+//===============================================================================//
+//== Stream Walk ==//
+
+static uint32 analyze_strip_bin(uint32 verts) {
+    static const uint32 top[ANALYZE_STRIP_BINS - 1] = { 2, 3, 4, 6, 8, 16, 32, 64 };
+    uint32 i;
+
+    for(i = 0; i < ANALYZE_STRIP_BINS - 1; i++)
+        if(verts <= top[i])
+            return i;
+
+    return ANALYZE_STRIP_BINS - 1;
+}
+
+static void analyze_header_causes(ANALYZE_LIST *l, const uint32 *prev, const uint32 *hdr) {
+    uint32 txr_param = PVR_TA_PM2_UVFLIP_MASK | PVR_TA_PM2_UVCLAMP_MASK | PVR_TA_PM2_FILTER_MASK
+                       | PVR_TA_PM2_MIPBIAS_MASK | PVR_TA_PM2_USIZE_MASK | PVR_TA_PM2_VSIZE_MASK;
+    uint32 blend = PVR_TA_PM2_SRCBLEND_MASK | PVR_TA_PM2_DSTBLEND_MASK | PVR_TA_PM2_SRCENABLE_MASK
+                   | PVR_TA_PM2_DSTENABLE_MASK | PVR_TA_PM2_ALPHA_MASK | PVR_TA_PM2_TXRALPHA_MASK
+                   | PVR_TA_PM2_TXRENV_MASK | PVR_TA_PM2_CLAMP_MASK;
+    uint32 depth = PVR_TA_PM1_DEPTHCMP_MASK | PVR_TA_PM1_DEPTHWRITE_MASK;
+    uint32 format = PVR_TA_CMD_CLRFMT_MASK | PVR_TA_CMD_SPECULAR_MASK | PVR_TA_CMD_SHADE_MASK
+                    | PVR_TA_CMD_UVFMT_MASK | PVR_TA_CMD_MODIFIER_MASK | PVR_TA_CMD_MODIFIERMODE_MASK
+                    | ANALYZE_CMD_TXR;
+    uint32 d0 = prev[0] ^ hdr[0], d1 = prev[1] ^ hdr[1], d2 = prev[2] ^ hdr[2], d3 = prev[3] ^ hdr[3];
+    uint32 known = 0;
+
+    if(!d0 && !d1 && !d2 && !d3) {
+        ++l->causes[ANALYZE_CAUSE_REPEAT];
+        return;
+    }
+
+    if(d3 || (d1 & PVR_TA_PM1_TXRENABLE_MASK))
+        ++l->causes[ANALYZE_CAUSE_TEXTURE];
+
+    if(d2 & txr_param)
+        ++l->causes[ANALYZE_CAUSE_TXR_PARAM];
+
+    if(d2 & blend)
+        ++l->causes[ANALYZE_CAUSE_BLEND];
+
+    if(d1 & depth)
+        ++l->causes[ANALYZE_CAUSE_DEPTH];
+
+    if(d1 & PVR_TA_PM1_CULLING_MASK)
+        ++l->causes[ANALYZE_CAUSE_CULL];
+
+    if(d0 & format)
+        ++l->causes[ANALYZE_CAUSE_FORMAT];
+
+    if(d0 & PVR_TA_CMD_USERCLIP_MASK)
+        ++l->causes[ANALYZE_CAUSE_CLIP];
+
+    if(d2 & PVR_TA_PM2_FOG_MASK)
+        ++l->causes[ANALYZE_CAUSE_FOG];
+
+    known = (d0 & ~(format | PVR_TA_CMD_USERCLIP_MASK))
+            | (d1 & ~(depth | PVR_TA_PM1_CULLING_MASK | PVR_TA_PM1_TXRENABLE_MASK))
+            | (d2 & ~(txr_param | blend | PVR_TA_PM2_FOG_MASK));
+
+    if(known)
+        ++l->causes[ANALYZE_CAUSE_OTHER];
+}
+
+/* Count the pixels a triangle covers, with the top-left fill rule */
+static void analyze_cover(ANALYZE_LIST *l, const ANALYZE_SCENE *s, const ANALYZE_VERT *v,
+                          float minx, float miny, float maxx, float maxy) {
+    int x0 = (int)floorf(fmaxf(minx, 0.0f)), y0 = (int)floorf(fmaxf(miny, 0.0f));
+    int x1 = (int)ceilf(fminf(maxx, s->width - 1.0f)), y1 = (int)ceilf(fminf(maxy, s->height - 1.0f));
+    float area = (v[1].x - v[0].x) * (v[2].y - v[0].y) - (v[1].y - v[0].y) * (v[2].x - v[0].x);
+    float sign = area > 0.0f ? 1.0f : -1.0f;
+    int x, y, e;
+
+    for(y = y0; y <= y1; y++)
+        for(x = x0; x <= x1; x++) {
+            for(e = 0; e < 3; e++) {
+                const ANALYZE_VERT *a = &v[e], *b = &v[(e + 1) % 3];
+                float dx = (b->x - a->x) * sign, dy = (b->y - a->y) * sign;
+                float edge = dx * (y + 0.5f - a->y) - dy * (x + 0.5f - a->x);
+
+                if(edge < 0.0f || (edge == 0.0f && !((dy == 0.0f && dx > 0.0f) || dy < 0.0f)))
+                    break;
+            }
+
+            if(e == 3)
+                ++l->coverage[y * s->width + x];
+        }
+}
+
+static void analyze_triangle(ANALYZE_LIST *l, const ANALYZE_SCENE *s, const ANALYZE_VERT *v) {
+    float area, minx, miny, maxx, maxy;
+    int tx, ty;
+
+    ++l->tris;
+
+    if(v[0].invw <= 0.0f || v[1].invw <= 0.0f || v[2].invw <= 0.0f) {
+        ++l->behind;
+        return;
+    }
+
+    area = 0.5f * fabsf((v[1].x - v[0].x) * (v[2].y - v[0].y) - (v[1].y - v[0].y) * (v[2].x - v[0].x));
+
+    minx = fminf(fminf(v[0].x, v[1].x), v[2].x);
+    miny = fminf(fminf(v[0].y, v[1].y), v[2].y);
+    maxx = fmaxf(fmaxf(v[0].x, v[1].x), v[2].x);
+    maxy = fmaxf(fmaxf(v[0].y, v[1].y), v[2].y);
+
+    if(maxx < 0.0f || maxy < 0.0f || minx >= s->width || miny >= s->height) {
+        ++l->offscreen;
+        return;
+    }
+
+    if(area == 0.0f) {
+        ++l->zero_area;
+        return;
+    }
+
+    if(area < 1.0f)
+        ++l->tiny;
+
+    for(ty = (int)fmaxf(miny, 0.0f) / ANALYZE_TILE; ty <= (int)fminf(maxy, s->height - 1.0f) / ANALYZE_TILE; ty++)
+        for(tx = (int)fmaxf(minx, 0.0f) / ANALYZE_TILE; tx <= (int)fminf(maxx, s->width - 1.0f) / ANALYZE_TILE; tx++)
+            ++l->tile_tris[ty * s->tiles_x + tx];
+
+    analyze_cover(l, s, v, minx, miny, maxx, maxy);
+}
+
+static void analyze_list(ANALYZE_LIST *l, const ANALYZE_SCENE *s, const uint8 *data, uint32 bytes) {
+    const uint32 *cmd = (const uint32 *)data, *end = (const uint32 *)(data + bytes);
+    uint32 prev[4], have_prev = 0, strip = 0;
+    ANALYZE_VERT v[3];
+
+    for(; cmd < end; cmd += 8) {
+        ++l->cmds;
+
+        switch(cmd[0] >> 29) {
+            case 1: /* User clip */
+                ++l->clips;
+                break;
+
+            case 4: /* Polygon header */
+            case 5: /* Sprite header */
+                if(have_prev)
+                    analyze_header_causes(l, prev, cmd);
+
+                memcpy(prev, cmd, sizeof(prev));
+                have_prev = 1;
+
+                ++l->headers;
+                break;
+
+            case 7: /* Vertex */
+                memcpy(&v[strip < 3 ? strip : 2].x, &cmd[1], 3 * sizeof(float));
+
+                ++l->verts;
+
+                if(++strip >= 3) {
+                    analyze_triangle(l, s, v);
+
+                    v[0] = v[1];
+                    v[1] = v[2];
+                }
+
+                if(cmd[0] & (1 << 28)) { /* End of strip */
+                    ++l->strips;
+                    ++l->strip_hist[analyze_strip_bin(strip)];
+                    strip = 0;
+                }
+
+                break;
+        }
+    }
+}
+
+//===============================================================================//
+//== Report ==//
+
+static void analyze_heat_color(uint8 *rgb, uint32 count) {
+    /* Black, then blue, green, yellow and red as the count climbs to ANALYZE_HEAT_MAX */
+    static const float ramp[5][3] = {
+        { 0, 0, 0 }, { 0, 0, 255 }, { 0, 255, 0 }, { 255, 255, 0 }, { 255, 0, 0 }
+    };
+    float t = count >= ANALYZE_HEAT_MAX ? 4.0f : count ? 1.0f + 3.0f * (count - 1) / (ANALYZE_HEAT_MAX - 1) : 0.0f;
+    int i = t >= 4.0f ? 3 : (int)t, c;
+    float f = t - i;
+
+    for(c = 0; c < 3; c++)
+        rgb[c] = (uint8)(ramp[i][c] * (1.0f - f) + ramp[i + 1][c] * f);
+}
+
+static int analyze_write_heatmap(const char *filename, const ANALYZE_SCENE *s, const ANALYZE_LIST *l) {
+    FILE *f = fopen(filename, "wb");
+    uint32 i;
+
+    if(!f) {
+        perror(filename);
+        return 0;
+    }
+
+    fprintf(f, "P6\n%u %u\n255\n", (unsigned)s->width, (unsigned)s->height);
+
+    for(i = 0; i < s->width * s->height; i++) {
+        uint8 rgb[3];
+
+        analyze_heat_color(rgb, l->coverage[i]);
+        fwrite(rgb, 1, 3, f);
+    }
+
+    fclose(f);
+
+    return 1;
+}
+
+static void analyze_report(const ANALYZE_SCENE *s) {
+    uint32 i, b, pixels = s->width * s->height, tiles = s->tiles_x * s->tiles_y;
+
+    for(i = 0; i < ANALYZE_LIST_COUNT; i++) {
+        const ANALYZE_LIST *l = &s->list[i];
+        uint32 tile_hist[ANALYZE_TILE_BINS] = { 0 }, tile_max = 0, tile_max_at = 0, tile_sum = 0;
+        uint32 covered = 0, cover_max = 0, switches = l->headers ? l->headers - 1 : 0;
+        double cover_sum = 0.0;
+
+        if(!l->cmds)
+            continue;
+
+        printf("  %s list: %u commands, %u headers, %u user clips, %u strips, %u vertices, %u triangles\n",
+               ANALYZE_LISTS[i].name, (unsigned)l->cmds, (unsigned)l->headers, (unsigned)l->clips,
+               (unsigned)l->strips, (unsigned)l->verts, (unsigned)l->tris);
+
+        if(l->tris)
+            printf("    %.2f vertices and %.2f header bytes per triangle\n",
+                   (double)l->verts / l->tris, 32.0 * l->headers / l->tris);
+
+        printf("    vertices per strip:");
+
+        for(b = 0; b < ANALYZE_STRIP_BINS; b++)
+            if(l->strip_hist[b])
+                printf(" %s: %u", ANALYZE_STRIP_NAMES[b], (unsigned)l->strip_hist[b]);
+
+        printf("\n    header switches: %u", (unsigned)switches);
+
+        for(b = 0; b < ANALYZE_CAUSES; b++)
+            if(l->causes[b])
+                printf(", %s %u", ANALYZE_CAUSE_NAMES[b], (unsigned)l->causes[b]);
+
+        printf("\n    triangles: %u zero area, %u under a pixel, %u off screen, %u behind the eye\n",
+               (unsigned)l->zero_area, (unsigned)l->tiny, (unsigned)l->offscreen, (unsigned)l->behind);
+
+        for(b = 0; b < tiles; b++) {
+            uint32 n = l->tile_tris[b], bin = 0;
+
+            while(bin < ANALYZE_TILE_BINS - 1 && n > (bin ? 1u << (2 * bin) : 0u))
+                ++bin;
+
+            ++tile_hist[bin];
+            tile_sum += n;
+
+            if(n > tile_max) {
+                tile_max = n;
+                tile_max_at = b;
+            }
+        }
+
+        printf("    triangles per tile: mean %.1f, max %u at tile %u,%u;", (double)tile_sum / tiles,
+               (unsigned)tile_max, (unsigned)(tile_max_at % s->tiles_x), (unsigned)(tile_max_at / s->tiles_x));
+
+        for(b = 0; b < ANALYZE_TILE_BINS; b++)
+            if(tile_hist[b])
+                printf(" %s: %u", ANALYZE_TILE_NAMES[b], (unsigned)tile_hist[b]);
+
+        for(b = 0; b < pixels; b++) {
+            covered += l->coverage[b] != 0;
+            cover_sum += l->coverage[b];
+            cover_max = l->coverage[b] > cover_max ? l->coverage[b] : cover_max;
+        }
+
+        printf("\n    overdraw: %.2f per pixel, %.2f per covered pixel, max %u, %.1f%% of pixels covered\n",
+               cover_sum / pixels, covered ? cover_sum / covered : 0.0, (unsigned)cover_max,
+               100.0 * covered / pixels);
+    }
+}
+
+//===============================================================================//
+//== Main ==//
+
+static void analyze_scene(const pvr_host_scene_t *scene, GLint index, const char *prefix) {
+    ANALYZE_SCENE s;
+    uint32 i;
+
+    memset(&s, 0, sizeof(s));
+
+    s.width = scene->target ? scene->target_width : (uint32)vid_mode->width;
+    s.height = scene->target ? scene->target_height : (uint32)vid_mode->height;
+    s.tiles_x = (s.width + ANALYZE_TILE - 1) / ANALYZE_TILE;
+    s.tiles_y = (s.height + ANALYZE_TILE - 1) / ANALYZE_TILE;
+
+    printf("scene %d: %ux%u%s\n", index, (unsigned)s.width, (unsigned)s.height,
+           scene->target ? ", rendered to a texture" : "");
+
+    for(i = 0; i < ANALYZE_LIST_COUNT; i++) {
+        ANALYZE_LIST *l = &s.list[i];
+
+        l->coverage = calloc(s.width * s.height, sizeof(uint32));
+        l->tile_tris = calloc(s.tiles_x * s.tiles_y, sizeof(uint32));
+
+        analyze_list(l, &s, scene->list[ANALYZE_LISTS[i].list], scene->list_bytes[ANALYZE_LISTS[i].list]);
+    }
+
+    analyze_report(&s);
+
+    if(prefix) {
+        char name[1024];
+
+        snprintf(name, sizeof(name), "%s-%d-op.ppm", prefix, index);
+        analyze_write_heatmap(name, &s, &s.list[0]);
+
+        snprintf(name, sizeof(name), "%s-%d-tr.ppm", prefix, index);
+        analyze_write_heatmap(name, &s, &s.list[2]);
+    }
+
+    for(i = 0; i < ANALYZE_LIST_COUNT; i++) {
+        free(s.list[i].coverage);
+        free(s.list[i].tile_tris);
+    }
+}
+
+int main(int argc, char **argv) {
+    const char *prefix = NULL;
+    GLint scenes, only = -1, i;
+
+    if(argc < 2) {
+        fprintf(stderr, "usage: analyze capture.kglc [heatmap prefix] [--scene n]\n");
+        return 2;
+    }
+
+    for(i = 2; i < argc; i++)
+        if(!strcmp(argv[i], "--scene") && i + 1 < argc)
+            only = atoi(argv[++i]);
+        else
+            prefix = argv[i];
+
+    glKosInit();
+
+    scenes = glKosReplayLoad(argv[1]);
+
+    if(scenes < 0) {
+        fprintf(stderr, "%s: not a capture file\n", argv[1]);
+        return 1;
+    }
+
+    printf("%s: %d scene(s)\n", argv[1], scenes);
+
+    /* Replaying a scene through the stand-in hands back its TA stream */
+    for(i = 0; i < scenes; i++) {
+        glKosReplayScene(i);
+
+        if(only < 0 || only == i)
+            analyze_scene(pvr_host_last_scene(), i, prefix);
+    }
+
+    glKosReplayFree();
+
+    return 0;
+}
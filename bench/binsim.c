@@ -0,0 +1,415 @@
+/* KallistiGL for KallistiOS ##version##
+
+   libgl/bench/binsim.c
+
+   Tile bin simulator for TA stream captures: replays captured frames through
+   a model of how the TA fills its object pointer buffers and vertex buffer,
+   and reports the smallest PVR buffer sizes that hold them, for glKosInitEx().
+   Built against the host build with make bench.
+
+   Usage: binsim capture.kglc... [--headroom percent]
+
+   The model, per list and per 32x32 tile:
+   - a strip is written as pieces of up to 6 triangles, and each piece costs
+     one object pointer word in every tile a triangle's bounding box touches,
+     less the tiles a user clip rejects;
+   - the tile's list ends with one word, and a block that fills up gives its
+     last word to the link to the next block, so entries + 1 words fit in a
+     block of the bin size without linking;
+   - each piece stored to the vertex buffer costs 3 words of polygon
+     parameters, plus x, y, z, u, v, base and offset colour for each vertex,
+     as the header's vertex format has them.
+
+   Independent triangles are not merged into triangle arrays, and culled or
+   zero-area triangles are binned anyway, so the estimate errs large. A tile
+   that links a second block is counted as unsafe: the library reserves no
+   VRAM for the TA to grow the buffers into.
+
+   The sizes reported are the peak over every scene, grown by the headroom
+   (25% by default): the smallest bin size per list whose first block holds
+   the busiest tile, and the vertex buffer rounded up to 4 KB. They are
+   printed as a GL_KOS_INIT_PARAMS initializer. Exits with status 1 when a
+   tile overflows even the largest bin size.
+*/
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <GL/gl.h>
+
+#include <dc/pvr.h>
+#include <dc/video.h>
+
+#define BINSIM_TILE         32
+#define BINSIM_PIECE_TRIS   6       /* Triangles per strip piece */
+#define BINSIM_HDR_WORDS    3       /* Polygon parameters per piece: ISP/TSP, TSP, texture */
+#define BINSIM_VBUF_ALIGN   4096
+
+#define BINSIM_CMD_TXR      (1 << 3) /* Textured bit of the polygon header cmd word */
+
+/* The lists simulated, ordered like GL_KOS_INIT_PARAMS */
+static const struct {
+    uint32 list;
+    const char *name;
+} BINSIM_LISTS[] = {
+    { PVR_LIST_OP_POLY, "OP" },
+    { PVR_LIST_TR_POLY, "TR" },
+    { PVR_LIST_PT_POLY, "PT" },
+};
+
+#define BINSIM_LIST_COUNT (sizeof(BINSIM_LISTS) / sizeof(BINSIM_LISTS[0]))
+
+static const uint32 BINSIM_BIN_SIZES[] = { PVR_BINSIZE_8, PVR_BINSIZE_16, PVR_BINSIZE_32 };
+
+#define BINSIM_BIN_SIZE_COUNT (sizeof(BINSIM_BIN_SIZES) / sizeof(BINSIM_BIN_SIZES[0]))
+
+typedef struct {
+    uint32 width, height, tiles_x, tiles_y;
+    uint32 *entries;        /* Object pointer entries per tile */
+    uint32 *mark;           /* Last piece binned to each tile */
+    uint32 piece;           /* Current piece, numbered from 1 */
+    uint32 piece_tiles;     /* Tiles the current piece was binned to */
+} BINSIM_SCENE;
+
+/* Peak of a list over every scene simulated */
+typedef struct {
+    uint32 entries;         /* Most entries in one tile */
+    uint32 tile_x, tile_y;
+    const char *file;
+    GLint scene;
+    uint32 used;            /* Scenes that sent anything to the list */
+} BINSIM_PEAK;
+
+typedef struct {
+    BINSIM_PEAK list[BINSIM_LIST_COUNT];
+    uint32 vertex_bytes;    /* Most vertex buffer bytes in one scene */
+    const char *vertex_file;
+    GLint vertex_scene;
+    uint32 scenes;
+} BINSIM_TOTALS;
+
+//===============================================================================//
+//== Model ==//
+
+/* Words of vertex buffer per vertex, for the format of the polygon header */
+static uint32 binsim_vertex_words(uint32 cmd) {
+    uint32 words = 3 + 1; /* x, y, z and the base colour */
+
+    if(cmd & BINSIM_CMD_TXR)
+        words += cmd & PVR_TA_CMD_UVFMT_MASK ? 1 : 2;
+
+    if(cmd & PVR_TA_CMD_SPECULAR_MASK)
+        words += 1;
+
+    return words;
+}
+
+/* Blocks of bin size words it takes to hold a tile's entries and end word */
+static uint32 binsim_blocks(uint32 entries, uint32 bin_size) {
+    uint32 words = entries + 1;
+
+    if(words <= bin_size)
+        return 1;
+
+    return 1 + (words - bin_size + bin_size - 2) / (bin_size - 1);
+}
+
+static int binsim_clipped(uint32 cmd, const int *clip, int tx, int ty) {
+    uint32 mode = (cmd & PVR_TA_CMD_USERCLIP_MASK) >> PVR_TA_CMD_USERCLIP_SHIFT;
+    int inside = tx >= clip[0] && tx <= clip[2] && ty >= clip[1] && ty <= clip[3];
+
+    if(mode == PVR_USERCLIP_INSIDE)
+        return !inside;
+
+    if(mode == PVR_USERCLIP_OUTSIDE)
+        return inside;
+
+    return 0;
+}
+
+/* Bin a triangle of the current piece to the tiles its bounding box touches */
+static void binsim_triangle(BINSIM_SCENE *s, const float *v, uint32 cmd, const int *clip) {
+    float minx = fminf(fminf(v[0], v[3]), v[6]), miny = fminf(fminf(v[1], v[4]), v[7]);
+    float maxx = fmaxf(fmaxf(v[0], v[3]), v[6]), maxy = fmaxf(fmaxf(v[1], v[4]), v[7]);
+    int tx, ty, tx0, ty0, tx1, ty1;
+
+    if(maxx < 0.0f || maxy < 0.0f || minx >= s->width || miny >= s->height)
+        return;
+
+    tx0 = (int)fmaxf(minx, 0.0f) / BINSIM_TILE;
+    ty0 = (int)fmaxf(miny, 0.0f) / BINSIM_TILE;
+    tx1 = (int)fminf(maxx, s->width - 1.0f) / BINSIM_TILE;
+    ty1 = (int)fminf(maxy, s->height - 1.0f) / BINSIM_TILE;
+
+    for(ty = ty0; ty <= ty1; ty++)
+        for(tx = tx0; tx <= tx1; tx++) {
+            uint32 t = ty * s->tiles_x + tx;
+
+            if(s->mark[t] == s->piece || binsim_clipped(cmd, clip, tx, ty))
+                continue;
+
+            s->mark[t] = s->piece;
+            ++s->entries[t];
+            ++s->piece_tiles;
+        }
+}
+
+/* Close the current piece, and return the vertex buffer bytes it takes */
+static uint32 binsim_piece_end(BINSIM_SCENE *s, uint32 verts, uint32 cmd) {
+    uint32 bytes = s->piece_tiles ? (BINSIM_HDR_WORDS + verts * binsim_vertex_words(cmd)) * 4 : 0;
+
+    ++s->piece;
+    s->piece_tiles = 0;
+
+    return bytes;
+}
+
+/* Walk one list of a scene; returns the vertex buffer bytes it takes */
+static uint32 binsim_list(BINSIM_SCENE *s, const uint8 *data, uint32 bytes) {
+    const uint32 *cmd = (const uint32 *)data, *end = (const uint32 *)(data + bytes);
+    int clip[4] = { 0, 0, s->tiles_x - 1, s->tiles_y - 1 };
+    uint32 hdr = 0, strip = 0, verts = 0, tris = 0, vbuf = 0;
+    float v[9];
+
+    for(; cmd < end; cmd += 8)
+        switch(cmd[0] >> 29) {
+            case 1: /* User clip */
+                clip[0] = cmd[4];
+                clip[1] = cmd[5];
+                clip[2] = cmd[6];
+                clip[3] = cmd[7];
+                break;
+
+            case 4: /* Polygon header */
+            case 5: /* Sprite header */
+                hdr = cmd[0];
+                break;
+
+            case 7: /* Vertex */
+                memcpy(&v[(strip < 3 ? strip : 2) * 3], &cmd[1], 3 * sizeof(float));
+
+                ++verts;
+
+                if(++strip >= 3) {
+                    binsim_triangle(s, v, hdr, clip);
+
+                    memmove(v, v + 3, 6 * sizeof(float));
+
+                    /* A full piece ends; the next one starts from its last two vertices */
+                    if(++tris == BINSIM_PIECE_TRIS && !(cmd[0] & (1 << 28))) {
+                        vbuf += binsim_piece_end(s, verts, hdr);
+                        verts = 2;
+                        tris = 0;
+                    }
+                }
+
+                if(cmd[0] & (1 << 28)) { /* End of strip */
+                    vbuf += binsim_piece_end(s, verts, hdr);
+                    strip = verts = tris = 0;
+                }
+
+                break;
+        }
+
+    return vbuf;
+}
+
+//===============================================================================//
+//== Report ==//
+
+static uint32 binsim_bin_size(uint32 entries) {
+    uint32 i;
+
+    for(i = 0; i < BINSIM_BIN_SIZE_COUNT; i++)
+        if(entries + 1 <= BINSIM_BIN_SIZES[i])
+            return BINSIM_BIN_SIZES[i];
+
+    return 0; /* Not even the largest block holds it */
+}
+
+static void binsim_scene(BINSIM_TOTALS *totals, const pvr_host_scene_t *scene,
+                         const char *file, GLint index) {
+    BINSIM_SCENE s;
+    uint32 i, t, vbuf = 0;
+
+    memset(&s, 0, sizeof(s));
+
+    s.width = scene->target ? scene->target_width : (uint32)vid_mode->width;
+    s.height = scene->target ? scene->target_height : (uint32)vid_mode->height;
+    s.tiles_x = (s.width + BINSIM_TILE - 1) / BINSIM_TILE;
+    s.tiles_y = (s.height + BINSIM_TILE - 1) / BINSIM_TILE;
+    s.entries = malloc(s.tiles_x * s.tiles_y * sizeof(uint32));
+    s.mark = calloc(s.tiles_x * s.tiles_y, sizeof(uint32));
+    s.piece = 1;
+
+    printf("  scene %d: %ux%u%s\n", index, (unsigned)s.width, (unsigned)s.height,
+           scene->target ? ", rendered to a texture" : "");
+
+    for(i = 0; i < BINSIM_LIST_COUNT; i++) {
+        BINSIM_PEAK *peak = &totals->list[i];
+        uint32 over[BINSIM_BIN_SIZE_COUNT] = { 0 }, max = 0, max_at = 0, sum = 0, b;
+        uint32 bytes = scene->list_bytes[BINSIM_LISTS[i].list];
+
+        if(!bytes)
+            continue;
+
+        memset(s.entries, 0, s.tiles_x * s.tiles_y * sizeof(uint32));
+
+        vbuf += binsim_list(&s, scene->list[BINSIM_LISTS[i].list], bytes);
+
+        for(t = 0; t < s.tiles_x * s.tiles_y; t++) {
+            sum += s.entries[t];
+
+            for(b = 0; b < BINSIM_BIN_SIZE_COUNT; b++)
+                over[b] += binsim_blocks(s.entries[t], BINSIM_BIN_SIZES[b]) - 1;
+
+            if(s.entries[t] > max) {
+                max = s.entries[t];
+                max_at = t;
+            }
+        }
+
+        printf("    %s: %u entries, max %u at tile %u,%u; blocks linked at 8/16/32 words: %u/%u/%u\n",
+               BINSIM_LISTS[i].name, (unsigned)sum, (unsigned)max, (unsigned)(max_at % s.tiles_x),
+               (unsigned)(max_at / s.tiles_x), (unsigned)over[0], (unsigned)over[1], (unsigned)over[2]);
+
+        if(!peak->used++ || max > peak->entries) {
+            peak->entries = max;
+            peak->tile_x = max_at % s.tiles_x;
+            peak->tile_y = max_at / s.tiles_x;
+            peak->file = file;
+            peak->scene = index;
+        }
+    }
+
+    printf("    vertex buffer: %u bytes\n", (unsigned)vbuf);
+
+    if(!totals->scenes || vbuf > totals->vertex_bytes) {
+        totals->vertex_bytes = vbuf;
+        totals->vertex_file = file;
+        totals->vertex_scene = index;
+    }
+
+    ++totals->scenes;
+
+    free(s.entries);
+    free(s.mark);
+}
+
+static int binsim_report(const BINSIM_TOTALS *totals, float headroom) {
+    GL_KOS_INIT_PARAMS defaults, params;
+    uint32 tiles = ((vid_mode->width + BINSIM_TILE - 1) / BINSIM_TILE)
+                   * ((vid_mode->height + BINSIM_TILE - 1) / BINSIM_TILE);
+    uint32 i, opb_default = 0, opb = 0, need;
+    int unsafe = 0;
+
+    glKosInitDefaults(&defaults);
+    params = defaults;
+
+    printf("\n%u scene(s), %.0f%% headroom, %u tiles\n", (unsigned)totals->scenes,
+           100.0f * headroom, (unsigned)tiles);
+
+    for(i = 0; i < BINSIM_LIST_COUNT; i++) {
+        const BINSIM_PEAK *peak = &totals->list[i];
+
+        need = (uint32)ceilf(peak->entries * (1.0f + headroom));
+        params.bin_size[i] = binsim_bin_size(need);
+
+        if(!peak->used) {
+            params.bin_size[i] = PVR_BINSIZE_8; /* The library opens every list, so keep the smallest */
+            printf("  %s: unused, bin size 8\n", BINSIM_LISTS[i].name);
+        }
+        else if(!params.bin_size[i]) {
+            params.bin_size[i] = PVR_BINSIZE_32;
+            unsafe = 1;
+            printf("  %s: %u entries in tile %u,%u of %s scene %d, %u with headroom - "
+                   "overflows even 32 word blocks\n", BINSIM_LISTS[i].name, (unsigned)peak->entries,
+                   (unsigned)peak->tile_x, (unsigned)peak->tile_y, peak->file, peak->scene, (unsigned)need);
+        }
+        else
+            printf("  %s: %u entries in tile %u,%u of %s scene %d, %u with headroom - bin size %u\n",
+                   BINSIM_LISTS[i].name, (unsigned)peak->entries, (unsigned)peak->tile_x,
+                   (unsigned)peak->tile_y, peak->file, peak->scene, (unsigned)need,
+                   (unsigned)params.bin_size[i]);
+
+        opb_default += defaults.bin_size[i] * 4 * tiles;
+        opb += params.bin_size[i] * 4 * tiles;
+    }
+
+    need = (uint32)ceilf(totals->vertex_bytes * (1.0f + headroom));
+    params.vertex_buf_size = (need + BINSIM_VBUF_ALIGN - 1) & ~(BINSIM_VBUF_ALIGN - 1);
+
+    if(!params.vertex_buf_size)
+        params.vertex_buf_size = BINSIM_VBUF_ALIGN;
+
+    printf("  vertex buffer: %u bytes in %s scene %d, %u with headroom - %u bytes\n",
+           (unsigned)totals->vertex_bytes, totals->vertex_file ? totals->vertex_file : "-",
+           totals->vertex_scene, (unsigned)need, (unsigned)params.vertex_buf_size);
+
+    printf("\nVRAM per TA buffer: object pointers %u bytes (default %u), vertex buffer %u bytes (default %u)\n",
+           (unsigned)opb, (unsigned)opb_default, (unsigned)params.vertex_buf_size,
+           (unsigned)defaults.vertex_buf_size);
+
+    if(totals->vertex_bytes > defaults.vertex_buf_size)
+        printf("warning: the default vertex buffer does not hold the peak scene\n");
+
+    if(unsafe)
+        printf("warning: some tiles overflow the largest bin size; split or cull their geometry\n");
+
+    printf("\nGL_KOS_INIT_PARAMS params = { { %u, %u, %u }, %u };\n", (unsigned)params.bin_size[0],
+           (unsigned)params.bin_size[1], (unsigned)params.bin_size[2], (unsigned)params.vertex_buf_size);
+
+    return unsafe;
+}
+
+//===============================================================================//
+//== Main ==//
+
+int main(int argc, char **argv) {
+    BINSIM_TOTALS totals;
+    float headroom = 0.25f;
+    GLint scenes, i, j, files = 0;
+
+    memset(&totals, 0, sizeof(totals));
+
+    for(i = 1; i < argc; i++)
+        if(!strcmp(argv[i], "--headroom") && i + 1 < argc)
+            ++i;
+        else
+            ++files;
+
+    if(!files) {
+        fprintf(stderr, "usage: binsim capture.kglc... [--headroom percent]\n");
+        return 2;
+    }
+
+    glKosInit();
+
+    for(i = 1; i < argc; i++) {
+        if(!strcmp(argv[i], "--headroom") && i + 1 < argc) {
+            headroom = atof(argv[++i]) / 100.0f;
+            continue;
+        }
+
+        scenes = glKosReplayLoad(argv[i]);
+
+        if(scenes < 0) {
+            fprintf(stderr, "%s: not a capture file\n", argv[i]);
+            return 1;
+        }
+
+        printf("%s: %d scene(s)\n", argv[i], scenes);
+
+        /* Replaying a scene through the stand-in hands back its TA stream */
+        for(j = 0; j < scenes; j++) {
+            glKosReplayScene(j);
+            binsim_scene(&totals, pvr_host_last_scene(), argv[i], j);
+        }
+
+        glKosReplayFree();
+    }
+
+    return binsim_report(&totals, headroom);
+}
@@ -0,0 +1,86 @@
+#!/usr/bin/env python3
+#
+# KallistiGL for KallistiOS ##version##
+#
+# libgl/bench/compare.py
+#
+# Compares a bench result file against a stored baseline. A benchmark
+# regresses when it sends more bytes per unit than before, which does not
+# depend on timing. A rate drop of more than the threshold is only a warning,
+# since rates on a shared host vary by more than that between runs of the same
+# tree; --strict makes it a regression too, for a quiet target. Exits with
+# status 1 on any regression.
+#
+# Usage: compare.py baseline.json results.json [--threshold 0.05] [--strict]
+
+import argparse
+import json
+import sys
+
+BYTES_TOLERANCE = 0.01
+
+
+def load(filename):
+    with open(filename) as f:
+        return {b["name"]: b for b in json.load(f)["benchmarks"]}
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Compare microbench results against a baseline")
+    parser.add_argument("baseline")
+    parser.add_argument("results")
+    parser.add_argument("--threshold", type=float, default=0.05,
+                        help="relative rate drop reported as slower (default 0.05)")
+    parser.add_argument("--strict", action="store_true",
+                        help="fail on slower rates as well as on more bytes")
+    args = parser.parse_args()
+
+    baseline = load(args.baseline)
+    results = load(args.results)
+    regressions = 0
+    warnings = 0
+
+    print("%-24s %14s %14s %8s %10s" % ("benchmark", "baseline", "result", "change", "bytes"))
+
+    for name, base in baseline.items():
+        if name not in results:
+            print("%-24s missing from results" % name)
+            regressions += 1
+            continue
+
+        result = results[name]
+        change = result["rate"] / base["rate"] - 1.0 if base["rate"] else 0.0
+        bytes_change = (result["bytes_per_unit"] - base["bytes_per_unit"]) / base["bytes_per_unit"] \
+            if base["bytes_per_unit"] else 0.0
+        status = []
+        slower = change < -args.threshold
+
+        if slower:
+            status.append("SLOWER" if args.strict else "slower")
+
+        if bytes_change > BYTES_TOLERANCE:
+            status.append("MORE BYTES")
+
+        if bytes_change > BYTES_TOLERANCE or (slower and args.strict):
+            regressions += 1
+        elif slower:
+            warnings += 1
+
+        print("%-24s %14.0f %14.0f %+7.1f%% %+9.1f%% %s" % (name, base["rate"], result["rate"],
+              change * 100.0, bytes_change * 100.0, " ".join(status)))
+
+    for name in results:
+        if name not in baseline:
+            print("%-24s new, not in baseline" % name)
+
+    if warnings:
+        print("%d slower rate(s), not gated without --strict" % warnings)
+
+    if regressions:
+        print("%d regression(s)" % regressions)
+
+    return 1 if regressions else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
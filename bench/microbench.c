@@ -0,0 +1,1186 @@
+/* KallistiGL for KallistiOS ##version##
+
+   libgl/bench/microbench.c
+
+   Microbenchmarks for each vertex pipeline path, polygon header building,
+   texture conversion and mipmap generation. Built against the host build
+   with make bench.
+
+   Usage: microbench [results.json]
+
+   Each benchmark reports a rate (units per second) and bytes per unit:
+   the TA bytes of a frame per submitted vertex for the draw paths, or the
+   VRAM bytes per texel for the texture paths. bench/compare.py checks a
+   result file against a stored baseline.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <GL/gl.h>
+#include <GL/glext.h>
+#include <GL/glu.h>
+#include <GL/glut.h>
+
+#define BENCH_MIN_SECONDS 0.25
+#define BENCH_MIN_FRAMES  8
+#define BENCH_REPEATS     3    /* Best of */
+
+#define BENCH_GRID        24   /* Quads per side of the draw mesh */
+#define BENCH_GRID_VERTS  ((BENCH_GRID + 1) * (BENCH_GRID + 1))
+#define BENCH_TRI_VERTS   (BENCH_GRID * BENCH_GRID * 6)
+#define BENCH_DRAWS       4    /* Mesh draws per frame */
+
+#define BENCH_U8_GRID     14   /* 15x15 = 225 vertices, indexable with U8 */
+#define BENCH_U16_GRID    63   /* 64x64 = 4096 vertices */
+
+#define BENCH_TEX_SIZE    256
+
+typedef struct {
+    const char *name;
+    const char *unit;
+    double rate;          /* Units per second */
+    double bytes;         /* Bytes per unit */
+} BENCH_RESULT;
+
+typedef struct {
+    const char *name;
+    void (*setup)();
+    GLuint (*frame)();    /* Draws one frame, returns vertices submitted */
+} BENCH_DRAW;
+
+typedef struct {
+    const char *name;
+    GLenum format, type;
+    GLuint texel_bytes;
+} BENCH_TEXTURE;
+
+static BENCH_RESULT BENCH_RESULTS[128];
+static GLuint BENCH_RESULT_COUNT = 0;
+
+//===============================================================================//
+//== Test Data ==//
+
+static GLfloat MESH_POS2[BENCH_TRI_VERTS * 2];
+static GLfloat MESH_POS3[BENCH_TRI_VERTS * 3];
+static GLfloat MESH_NORMAL[BENCH_TRI_VERTS * 3];
+static GLfloat MESH_UV[BENCH_TRI_VERTS * 2];
+static GLfloat MESH_COLOR3F[BENCH_TRI_VERTS * 3];
+static GLfloat MESH_COLOR4F[BENCH_TRI_VERTS * 4];
+static GLubyte MESH_COLOR4UB[BENCH_TRI_VERTS * 4];
+static GLuint  MESH_COLOR1UI[BENCH_TRI_VERTS];
+static GLfloat MESH_SIZE[BENCH_TRI_VERTS];     /* A particle per vertex */
+static GLfloat MESH_ROTATION[BENCH_TRI_VERTS];
+
+static GLfloat MESH_T2F_C4UB_V3F[BENCH_TRI_VERTS * 6]; /* The same mesh, interleaved */
+static GLfloat MESH_T2F_N3F_V3F[BENCH_TRI_VERTS * 8];
+static GLfloat MESH_C4UB_V3F[BENCH_TRI_VERTS * 4];
+
+static GLfloat U8_POS[(BENCH_U8_GRID + 1) * (BENCH_U8_GRID + 1) * 3];
+static GLubyte U8_INDEX[BENCH_U8_GRID * BENCH_U8_GRID * 6];
+static GLushort U8_INDEX16[BENCH_U8_GRID * BENCH_U8_GRID * 6]; /* The same, as U16 */
+
+static GLfloat  U16_POS[(BENCH_U16_GRID + 1) * (BENCH_U16_GRID + 1) * 3];
+static GLushort U16_INDEX[BENCH_U16_GRID * BENCH_U16_GRID * 6];
+static GLuint   U16_INDEX32[BENCH_U16_GRID * BENCH_U16_GRID * 6]; /* The same, as U32 */
+static GLushort STRIP_INDEX[BENCH_U16_GRID * BENCH_U16_GRID * 6];  /* The same, optimized to strips */
+
+static GLfloat  UNSHARED_POS[BENCH_U16_GRID * BENCH_U16_GRID * 4 * 3]; /* 4 vertices per quad */
+static GLushort UNSHARED_INDEX[BENCH_U16_GRID * BENCH_U16_GRID * 6];
+
+#define BENCH_MULTI_DRAWS (BENCH_GRID * BENCH_GRID) /* One small draw per mesh quad */
+
+static GLint   MULTI_FIRST[BENCH_MULTI_DRAWS];
+static GLsizei MULTI_COUNT[BENCH_MULTI_DRAWS];
+static const GLvoid *MULTI_INDEX[BENCH_MULTI_DRAWS];
+static GLfloat MULTI_MODEL[BENCH_MULTI_DRAWS * 16];
+
+static GLuint TEXTURES[2];
+
+static double bench_now() {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* Two triangles per grid quad, in [-1, 1] on the z = 0 plane */
+static void bench_build_mesh() {
+    GLuint x, y, c, v = 0;
+
+    for(y = 0; y < BENCH_GRID; y++)
+        for(x = 0; x < BENCH_GRID; x++) {
+            static const GLubyte corner[6][2] = {
+                { 0, 0 }, { 1, 0 }, { 1, 1 }, { 0, 0 }, { 1, 1 }, { 0, 1 }
+            };
+
+            for(c = 0; c < 6; c++, v++) {
+                GLfloat s = (GLfloat)(x + corner[c][0]) / BENCH_GRID;
+                GLfloat t = (GLfloat)(y + corner[c][1]) / BENCH_GRID;
+
+                MESH_POS2[v * 2 + 0] = s * 640.0f;
+                MESH_POS2[v * 2 + 1] = t * 480.0f;
+
+                MESH_POS3[v * 3 + 0] = s * 2.0f - 1.0f;
+                MESH_POS3[v * 3 + 1] = t * 2.0f - 1.0f;
+                MESH_POS3[v * 3 + 2] = 0.0f;
+
+                MESH_NORMAL[v * 3 + 0] = 0.0f;
+                MESH_NORMAL[v * 3 + 1] = 0.0f;
+                MESH_NORMAL[v * 3 + 2] = 1.0f;
+
+                MESH_UV[v * 2 + 0] = s;
+                MESH_UV[v * 2 + 1] = t;
+
+                MESH_COLOR3F[v * 3 + 0] = MESH_COLOR4F[v * 4 + 0] = s;
+                MESH_COLOR3F[v * 3 + 1] = MESH_COLOR4F[v * 4 + 1] = t;
+                MESH_COLOR3F[v * 3 + 2] = MESH_COLOR4F[v * 4 + 2] = 0.5f;
+                MESH_COLOR4F[v * 4 + 3] = 1.0f;
+
+                MESH_COLOR4UB[v * 4 + 0] = s * 255;
+                MESH_COLOR4UB[v * 4 + 1] = t * 255;
+                MESH_COLOR4UB[v * 4 + 2] = 128;
+                MESH_COLOR4UB[v * 4 + 3] = 255;
+
+                MESH_COLOR1UI[v] = 0xff000080 | ((GLuint)(s * 255) << 16) | ((GLuint)(t * 255) << 8);
+
+                MESH_SIZE[v] = 0.05f;
+                MESH_ROTATION[v] = s * 6.2831853f;
+            }
+        }
+
+    for(v = 0; v < BENCH_TRI_VERTS; v++) {
+        GLfloat *tcv = &MESH_T2F_C4UB_V3F[v * 6], *tnv = &MESH_T2F_N3F_V3F[v * 8];
+        GLfloat *cv = &MESH_C4UB_V3F[v * 4];
+
+        memcpy(&tcv[0], &MESH_UV[v * 2], 8);
+        memcpy(&tcv[2], &MESH_COLOR4UB[v * 4], 4);
+        memcpy(&tcv[3], &MESH_POS3[v * 3], 12);
+
+        memcpy(&tnv[0], &MESH_UV[v * 2], 8);
+        memcpy(&tnv[2], &MESH_NORMAL[v * 3], 12);
+        memcpy(&tnv[5], &MESH_POS3[v * 3], 12);
+
+        memcpy(&cv[0], &MESH_COLOR4UB[v * 4], 4);
+        memcpy(&cv[1], &MESH_POS3[v * 3], 12);
+    }
+}
+
+static void bench_build_grid(GLuint grid, GLfloat *pos, GLubyte *index8, GLushort *index16) {
+    GLuint x, y, i = 0;
+
+    for(y = 0; y <= grid; y++)
+        for(x = 0; x <= grid; x++, pos += 3) {
+            pos[0] = (GLfloat)x / grid * 2.0f - 1.0f;
+            pos[1] = (GLfloat)y / grid * 2.0f - 1.0f;
+            pos[2] = 0.0f;
+        }
+
+    for(y = 0; y < grid; y++)
+        for(x = 0; x < grid; x++) {
+            GLuint a = y * (grid + 1) + x, b = a + 1, c = a + grid + 1, d = c + 1;
+            GLuint tri[6] = { a, b, d, a, d, c };
+            GLuint k;
+
+            for(k = 0; k < 6; k++, i++)
+                if(index8)
+                    index8[i] = tri[k];
+                else
+                    index16[i] = tri[k];
+        }
+}
+
+/* The same grid with vertices of its own for every quad, 1.5 elements per vertex */
+static void bench_build_unshared(GLuint grid, GLfloat *pos, GLushort *index16) {
+    GLuint x, y, k, v = 0;
+
+    for(y = 0; y < grid; y++)
+        for(x = 0; x < grid; x++, v += 4) {
+            GLuint corner[4][2] = { { x, y }, { x + 1, y }, { x, y + 1 }, { x + 1, y + 1 } };
+            GLuint tri[6] = { 0, 1, 3, 0, 3, 2 };
+
+            for(k = 0; k < 4; k++, pos += 3) {
+                pos[0] = (GLfloat)corner[k][0] / grid * 2.0f - 1.0f;
+                pos[1] = (GLfloat)corner[k][1] / grid * 2.0f - 1.0f;
+                pos[2] = 0.0f;
+            }
+
+            for(k = 0; k < 6; k++)
+                *index16++ = v + tri[k];
+        }
+}
+
+static void bench_build_textures() {
+    static GLushort texels[BENCH_TEX_SIZE * BENCH_TEX_SIZE];
+    GLuint i;
+
+    for(i = 0; i < BENCH_TEX_SIZE * BENCH_TEX_SIZE; i++)
+        texels[i] = (i * 2654435761u) >> 16;
+
+    glGenTextures(2, TEXTURES);
+
+    for(i = 0; i < 2; i++) {
+        glBindTexture(GL_TEXTURE_2D, TEXTURES[i]);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, BENCH_TEX_SIZE, BENCH_TEX_SIZE, 0,
+                     GL_RGB, GL_UNSIGNED_SHORT_5_6_5, texels);
+    }
+}
+
+//===============================================================================//
+//== Harness ==//
+
+static void bench_report(const char *name, const char *unit, double rate, double bytes) {
+    BENCH_RESULT *r = &BENCH_RESULTS[BENCH_RESULT_COUNT++];
+
+    r->name = name;
+    r->unit = unit;
+    r->rate = rate;
+    r->bytes = bytes;
+
+    fprintf(stderr, "%-24s %14.0f %s/s %8.2f bytes/%s\n", name, rate, unit, bytes, unit);
+}
+
+static GLuint bench_scene_bytes() {
+    const pvr_host_scene_t *scene = pvr_host_last_scene();
+
+    return scene->list_bytes[PVR_LIST_OP_POLY] + scene->list_bytes[PVR_LIST_TR_POLY]
+           + scene->list_bytes[PVR_LIST_PT_POLY];
+}
+
+/* Put the state machine back to what every benchmark starts from */
+static void bench_reset_state() {
+    glDisable(GL_TEXTURE_2D);
+    glDisable(GL_BLEND);
+    glDisable(GL_ALPHA_TEST);
+    glDisable(GL_LIGHTING);
+    glDisable(GL_LIGHT0);
+    glDisable(GL_KOS_NEARZ_CLIPPING);
+    glDisable(GL_CULL_FACE);
+
+    glActiveTextureARB(GL_TEXTURE1_ARB);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glActiveTextureARB(GL_TEXTURE0_ARB);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glClientActiveTextureARB(GL_TEXTURE0_ARB);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    glMatrixMode(GL_PROJECTION);
+    glLoadIdentity();
+    gluPerspective(45.0f, 640.0f / 480.0f, 0.1f, 100.0f);
+
+    glMatrixMode(GL_MODELVIEW);
+    glLoadIdentity();
+    glTranslatef(0.0f, 0.0f, -3.0f);
+
+    glColor4f(1.0f, 1.0f, 1.0f, 1.0f);
+}
+
+static void bench_draw(const BENCH_DRAW *b) {
+    double best = 0.0, bytes = 0.0;
+    GLuint r;
+
+    for(r = 0; r < BENCH_REPEATS; r++) {
+        GLuint frames = 0, verts = 0, frame_verts = 0;
+        double start, elapsed;
+
+        bench_reset_state();
+
+        if(b->setup)
+            b->setup();
+
+        start = bench_now();
+
+        do {
+            frame_verts = b->frame();
+            glutSwapBuffers();
+
+            verts += frame_verts;
+            elapsed = bench_now() - start;
+        }
+        while(++frames < BENCH_MIN_FRAMES || elapsed < BENCH_MIN_SECONDS);
+
+        if(verts / elapsed > best)
+            best = verts / elapsed;
+
+        bytes = (double)bench_scene_bytes() / frame_verts;
+    }
+
+    bench_report(b->name, "vertex", best, bytes);
+}
+
+//===============================================================================//
+//== Vertex Array Paths ==//
+
+static GLuint bench_arrays(GLenum mode, GLuint count) {
+    GLuint i;
+
+    for(i = 0; i < BENCH_DRAWS; i++) {
+        glVertexPointer(3, GL_FLOAT, 0, MESH_POS3);
+        glDrawArrays(mode, 0, count);
+    }
+
+    return BENCH_DRAWS * count;
+}
+
+static GLuint frame_arrays_2d() {
+    GLuint i;
+
+    for(i = 0; i < BENCH_DRAWS; i++) {
+        glVertexPointer(2, GL_FLOAT, 0, MESH_POS2);
+        glDrawArrays(GL_TRIANGLES, 0, BENCH_TRI_VERTS);
+    }
+
+    return BENCH_DRAWS * BENCH_TRI_VERTS;
+}
+
+static GLuint frame_arrays_3d() {
+    return bench_arrays(GL_TRIANGLES, BENCH_TRI_VERTS);
+}
+
+static GLuint frame_arrays_strip() {
+    return bench_arrays(GL_TRIANGLE_STRIP, BENCH_TRI_VERTS);
+}
+
+static GLuint frame_arrays_fan() {
+    return bench_arrays(GL_TRIANGLE_FAN, BENCH_TRI_VERTS);
+}
+
+static GLuint frame_arrays_lines() {
+    return bench_arrays(GL_LINES, BENCH_TRI_VERTS);
+}
+
+/* Each point is a quad of 4 TA vertices, so one mesh per frame */
+static GLuint frame_arrays_points() {
+    glVertexPointer(3, GL_FLOAT, 0, MESH_POS3);
+    glDrawArrays(GL_POINTS, 0, BENCH_TRI_VERTS);
+
+    return BENCH_TRI_VERTS;
+}
+
+#define BENCH_COLOR_FRAME(name, size, type, data) \
+    static GLuint name() { \
+        GLuint i; \
+        for(i = 0; i < BENCH_DRAWS; i++) { \
+            glVertexPointer(3, GL_FLOAT, 0, MESH_POS3); \
+            glColorPointer(size, type, 0, data); \
+            glDrawArrays(GL_TRIANGLES, 0, BENCH_TRI_VERTS); \
+        } \
+        return BENCH_DRAWS * BENCH_TRI_VERTS; \
+    }
+
+BENCH_COLOR_FRAME(frame_color_1ui, 1, GL_UNSIGNED_INT, MESH_COLOR1UI)
+BENCH_COLOR_FRAME(frame_color_4ub, 4, GL_UNSIGNED_BYTE, MESH_COLOR4UB)
+BENCH_COLOR_FRAME(frame_color_3f, 3, GL_FLOAT, MESH_COLOR3F)
+BENCH_COLOR_FRAME(frame_color_4f, 4, GL_FLOAT, MESH_COLOR4F)
+
+static void setup_textured() {
+    glEnable(GL_TEXTURE_2D);
+    glBindTexture(GL_TEXTURE_2D, TEXTURES[0]);
+}
+
+static GLuint frame_textured() {
+    GLuint i;
+
+    for(i = 0; i < BENCH_DRAWS; i++) {
+        glVertexPointer(3, GL_FLOAT, 0, MESH_POS3);
+        glTexCoordPointer(2, GL_FLOAT, 0, MESH_UV);
+        glDrawArrays(GL_TRIANGLES, 0, BENCH_TRI_VERTS);
+    }
+
+    return BENCH_DRAWS * BENCH_TRI_VERTS;
+}
+
+static void setup_multitextured() {
+    glEnable(GL_TEXTURE_2D);
+    glActiveTextureARB(GL_TEXTURE1_ARB);
+    glBindTexture(GL_TEXTURE_2D, TEXTURES[1]);
+    glActiveTextureARB(GL_TEXTURE0_ARB);
+    glBindTexture(GL_TEXTURE_2D, TEXTURES[0]);
+}
+
+static GLuint frame_multitextured() {
+    GLuint i;
+
+    for(i = 0; i < BENCH_DRAWS; i++) {
+        glVertexPointer(3, GL_FLOAT, 0, MESH_POS3);
+        glClientActiveTextureARB(GL_TEXTURE1_ARB);
+        glTexCoordPointer(2, GL_FLOAT, 0, MESH_UV);
+        glClientActiveTextureARB(GL_TEXTURE0_ARB);
+        glTexCoordPointer(2, GL_FLOAT, 0, MESH_UV);
+        glDrawArrays(GL_TRIANGLES, 0, BENCH_TRI_VERTS);
+    }
+
+    return BENCH_DRAWS * BENCH_TRI_VERTS;
+}
+
+static void setup_lit() {
+    GLfloat position[4] = { 0.0f, 0.0f, 2.0f, 1.0f };
+
+    glEnable(GL_LIGHTING);
+    glEnable(GL_LIGHT0);
+    glLightfv(GL_LIGHT0, GL_POSITION, position);
+}
+
+static GLuint frame_lit() {
+    GLuint i;
+
+    for(i = 0; i < BENCH_DRAWS; i++) {
+        glVertexPointer(3, GL_FLOAT, 0, MESH_POS3);
+        glNormalPointer(GL_FLOAT, 0, MESH_NORMAL);
+        glDrawArrays(GL_TRIANGLES, 0, BENCH_TRI_VERTS);
+    }
+
+    return BENCH_DRAWS * BENCH_TRI_VERTS;
+}
+
+/* The mesh is scaled up and tilted through the camera, so part of it is
+   behind the near plane */
+static void setup_nearz() {
+    glEnable(GL_KOS_NEARZ_CLIPPING);
+
+    glLoadIdentity();
+    glTranslatef(0.0f, -0.5f, -1.0f);
+    glRotatef(-75.0f, 1.0f, 0.0f, 0.0f);
+    glScalef(4.0f, 4.0f, 1.0f);
+}
+
+static GLuint frame_nearz() {
+    return bench_arrays(GL_TRIANGLES, BENCH_TRI_VERTS);
+}
+
+/* Near-Z clipping enabled, with the mesh entirely in front of the near plane */
+static void setup_nearz_front() {
+    glEnable(GL_KOS_NEARZ_CLIPPING);
+}
+
+static const GLfloat MESH_MIN[3] = { -1.0f, -1.0f, 0.0f };
+static const GLfloat MESH_MAX[3] = { 1.0f, 1.0f, 0.0f };
+
+/* Each draw tested against its bounding box: in front of the near plane, it skips
+   near-Z clipping */
+static GLuint frame_bounds() {
+    GLuint i;
+
+    for(i = 0; i < BENCH_DRAWS; i++) {
+        glKosBoundingBox(MESH_MIN, MESH_MAX);
+        glVertexPointer(3, GL_FLOAT, 0, MESH_POS3);
+        glDrawArrays(GL_TRIANGLES, 0, BENCH_TRI_VERTS);
+    }
+
+    return BENCH_DRAWS * BENCH_TRI_VERTS;
+}
+
+/* The mesh behind the eye: every draw is dropped by its bounding box. Reported as
+   the vertices skipped per second. */
+static void setup_bounds_culled() {
+    glEnable(GL_KOS_NEARZ_CLIPPING);
+
+    glLoadIdentity();
+    glTranslatef(0.0f, 0.0f, 3.0f);
+}
+
+static GLuint frame_elements_u8() {
+    GLuint i;
+
+    for(i = 0; i < BENCH_DRAWS * 8; i++) {
+        glVertexPointer(3, GL_FLOAT, 0, U8_POS);
+        glDrawElements(GL_TRIANGLES, sizeof(U8_INDEX), GL_UNSIGNED_BYTE, U8_INDEX);
+    }
+
+    return BENCH_DRAWS * 8 * sizeof(U8_INDEX);
+}
+
+static GLuint frame_elements_u16() {
+    GLuint i, count = sizeof(U16_INDEX) / sizeof(GLushort);
+
+    for(i = 0; i < BENCH_DRAWS / 2; i++) {
+        glVertexPointer(3, GL_FLOAT, 0, U16_POS);
+        glDrawElements(GL_TRIANGLES, count, GL_UNSIGNED_SHORT, U16_INDEX);
+    }
+
+    return BENCH_DRAWS / 2 * count;
+}
+
+static GLuint frame_elements_u32() {
+    GLuint i, count = sizeof(U16_INDEX32) / sizeof(GLuint);
+
+    for(i = 0; i < BENCH_DRAWS / 2; i++) {
+        glVertexPointer(3, GL_FLOAT, 0, U16_POS);
+        glDrawElements(GL_TRIANGLES, count, GL_UNSIGNED_INT, U16_INDEX32);
+    }
+
+    return BENCH_DRAWS / 2 * count;
+}
+
+/* The range is given, so the elements are not scanned for it */
+static GLuint frame_range_u16() {
+    GLuint i, count = sizeof(U16_INDEX) / sizeof(GLushort);
+
+    for(i = 0; i < BENCH_DRAWS / 2; i++) {
+        glVertexPointer(3, GL_FLOAT, 0, U16_POS);
+        glDrawRangeElements(GL_TRIANGLES, 0, (BENCH_U16_GRID + 1) * (BENCH_U16_GRID + 1) - 1,
+                            count, GL_UNSIGNED_SHORT, U16_INDEX);
+    }
+
+    return BENCH_DRAWS / 2 * count;
+}
+
+/* The U16 grid converted to strips by glKosOptimizeElements(), a copy so the
+   other element cases keep drawing the triangle list */
+static void setup_elements_strips() {
+    glKosOptimizeElements(sizeof(STRIP_INDEX) / sizeof(GLushort), GL_UNSIGNED_SHORT, STRIP_INDEX);
+}
+
+static GLuint frame_elements_strips() {
+    GLuint i, count = sizeof(STRIP_INDEX) / sizeof(GLushort);
+
+    for(i = 0; i < BENCH_DRAWS / 2; i++) {
+        glVertexPointer(3, GL_FLOAT, 0, U16_POS);
+        glDrawElements(GL_TRIANGLES, count, GL_UNSIGNED_SHORT, STRIP_INDEX);
+    }
+
+    return BENCH_DRAWS / 2 * count;
+}
+
+/* Few elements per vertex, the least the element cache saves */
+static GLuint frame_elements_unshared() {
+    GLuint i, count = sizeof(UNSHARED_INDEX) / sizeof(GLushort);
+
+    for(i = 0; i < BENCH_DRAWS / 2; i++) {
+        glVertexPointer(3, GL_FLOAT, 0, UNSHARED_POS);
+        glDrawElements(GL_TRIANGLES, count, GL_UNSIGNED_SHORT, UNSHARED_INDEX);
+    }
+
+    return BENCH_DRAWS / 2 * count;
+}
+
+//===============================================================================//
+//== Multi-Draw Paths ==//
+
+/* A draw per mesh quad, as when drawing many small objects. The model matrices
+   move each quad a little toward the camera. */
+static void setup_multi() {
+    GLuint i;
+
+    for(i = 0; i < BENCH_MULTI_DRAWS; i++) {
+        GLfloat *m = &MULTI_MODEL[i * 16];
+
+        MULTI_FIRST[i] = i * 6;
+        MULTI_COUNT[i] = 6;
+        MULTI_INDEX[i] = &UNSHARED_INDEX[i * 6];
+
+        memset(m, 0, sizeof(GLfloat) * 16);
+        m[0] = m[5] = m[10] = m[15] = 1.0f;
+        m[14] = (i % 8) * 0.01f;
+    }
+}
+
+/* Each draw with its own pointers, as glDrawArrays() clears them */
+static GLuint frame_small_draws() {
+    GLuint d, i;
+
+    for(d = 0; d < BENCH_DRAWS; d++)
+        for(i = 0; i < BENCH_MULTI_DRAWS; i++) {
+            glVertexPointer(3, GL_FLOAT, 0, &MESH_POS3[MULTI_FIRST[i] * 3]);
+            glDrawArrays(GL_TRIANGLES, 0, MULTI_COUNT[i]);
+        }
+
+    return BENCH_DRAWS * BENCH_TRI_VERTS;
+}
+
+static GLuint frame_small_draws_model() {
+    GLuint d, i;
+
+    for(d = 0; d < BENCH_DRAWS; d++)
+        for(i = 0; i < BENCH_MULTI_DRAWS; i++) {
+            glPushMatrix();
+            glMultMatrixf(&MULTI_MODEL[i * 16]);
+            glVertexPointer(3, GL_FLOAT, 0, &MESH_POS3[MULTI_FIRST[i] * 3]);
+            glDrawArrays(GL_TRIANGLES, 0, MULTI_COUNT[i]);
+            glPopMatrix();
+        }
+
+    return BENCH_DRAWS * BENCH_TRI_VERTS;
+}
+
+static GLuint frame_multi_arrays() {
+    GLuint d;
+
+    for(d = 0; d < BENCH_DRAWS; d++) {
+        glVertexPointer(3, GL_FLOAT, 0, MESH_POS3);
+        glMultiDrawArrays(GL_TRIANGLES, MULTI_FIRST, MULTI_COUNT, BENCH_MULTI_DRAWS);
+    }
+
+    return BENCH_DRAWS * BENCH_TRI_VERTS;
+}
+
+static GLuint frame_multi_arrays_model() {
+    GLuint d;
+
+    for(d = 0; d < BENCH_DRAWS; d++) {
+        glVertexPointer(3, GL_FLOAT, 0, MESH_POS3);
+        glKosMultiDrawArraysModel(GL_TRIANGLES, MULTI_FIRST, MULTI_COUNT, MULTI_MODEL,
+                                  BENCH_MULTI_DRAWS);
+    }
+
+    return BENCH_DRAWS * BENCH_TRI_VERTS;
+}
+
+/* A quad of the unshared U16 grid per draw */
+static GLuint frame_small_elements() {
+    GLuint d, i;
+
+    for(d = 0; d < BENCH_DRAWS; d++)
+        for(i = 0; i < BENCH_MULTI_DRAWS; i++) {
+            glVertexPointer(3, GL_FLOAT, 0, UNSHARED_POS);
+            glDrawElements(GL_TRIANGLES, MULTI_COUNT[i], GL_UNSIGNED_SHORT, MULTI_INDEX[i]);
+        }
+
+    return BENCH_DRAWS * BENCH_TRI_VERTS;
+}
+
+static GLuint frame_multi_elements() {
+    GLuint d;
+
+    for(d = 0; d < BENCH_DRAWS; d++) {
+        glVertexPointer(3, GL_FLOAT, 0, UNSHARED_POS);
+        glMultiDrawElements(GL_TRIANGLES, MULTI_COUNT, GL_UNSIGNED_SHORT, MULTI_INDEX,
+                            BENCH_MULTI_DRAWS);
+    }
+
+    return BENCH_DRAWS * BENCH_TRI_VERTS;
+}
+
+//===============================================================================//
+//== Immediate Mode Paths ==//
+
+/* glBegin() picks the glVertex3f variant: _glKosVertex3ft by default,
+   fc with near Z clipping, fl with lighting, flc with both, fp for points */
+
+/* One block per mesh row: a glBegin()/glEnd() block has to fit in a single
+   Vertex Buffer chunk unless GL_KOS_USE_MALLOC is set */
+static GLuint bench_immediate(GLenum mode, GLubyte normals) {
+    const GLfloat *p = MESH_POS3, *n = MESH_NORMAL, *uv = MESH_UV;
+    GLuint d, i;
+
+    for(d = 0; d < BENCH_DRAWS; d++)
+        for(i = 0; i < BENCH_TRI_VERTS; i++) {
+            if(i % (BENCH_GRID * 6) == 0)
+                glBegin(mode);
+
+            if(normals)
+                glNormal3f(n[i * 3 + 0], n[i * 3 + 1], n[i * 3 + 2]);
+
+            glTexCoord2f(uv[i * 2 + 0], uv[i * 2 + 1]);
+            glVertex3f(p[i * 3 + 0], p[i * 3 + 1], p[i * 3 + 2]);
+
+            if((i + 1) % (BENCH_GRID * 6) == 0)
+                glEnd();
+        }
+
+    return BENCH_DRAWS * BENCH_TRI_VERTS;
+}
+
+static GLuint frame_immediate_ft() {
+    return bench_immediate(GL_TRIANGLES, 0);
+}
+
+static void setup_immediate_fl() {
+    setup_lit();
+}
+
+static GLuint frame_immediate_fl() {
+    return bench_immediate(GL_TRIANGLES, 1);
+}
+
+static void setup_immediate_flc() {
+    setup_nearz();
+    setup_lit();
+}
+
+static GLuint frame_immediate_points() {
+    const GLfloat *p = MESH_POS3;
+    GLuint i;
+
+    /* Each point is a quad of 4 TA vertices, so one mesh per frame */
+    glBegin(GL_POINTS);
+
+    for(i = 0; i < BENCH_TRI_VERTS; i++)
+        glVertex3f(p[i * 3 + 0], p[i * 3 + 1], p[i * 3 + 2]);
+
+    glEnd();
+
+    return BENCH_TRI_VERTS;
+}
+
+static GLuint frame_particles() {
+    glKosDrawParticles(BENCH_TRI_VERTS, MESH_POS3, MESH_SIZE, MESH_ROTATION, MESH_COLOR1UI);
+
+    return BENCH_TRI_VERTS;
+}
+
+//===============================================================================//
+//== Display List Paths ==//
+
+/* The mesh is compiled once by the setup, each frame calls it */
+static GLuint BENCH_LIST = 0;
+
+static void bench_compile_list(GLubyte normals) {
+    if(!BENCH_LIST)
+        BENCH_LIST = glGenLists(1);
+
+    glNewList(BENCH_LIST, GL_COMPILE);
+
+    glVertexPointer(3, GL_FLOAT, 0, MESH_POS3);
+    glTexCoordPointer(2, GL_FLOAT, 0, MESH_UV);
+
+    if(normals)
+        glNormalPointer(GL_FLOAT, 0, MESH_NORMAL);
+
+    glDrawArrays(GL_TRIANGLES, 0, BENCH_TRI_VERTS);
+
+    glEndList();
+}
+
+static void setup_list_textured() {
+    setup_textured();
+    bench_compile_list(0);
+}
+
+static void setup_list_nearz() {
+    setup_nearz();
+    bench_compile_list(0);
+}
+
+static void setup_list_lit() {
+    setup_lit();
+    bench_compile_list(1);
+}
+
+static GLuint frame_list() {
+    GLuint i;
+
+    for(i = 0; i < BENCH_DRAWS; i++)
+        glCallList(BENCH_LIST);
+
+    return BENCH_DRAWS * BENCH_TRI_VERTS;
+}
+
+//===============================================================================//
+//== Buffer Object Paths ==//
+
+/* The mesh positions, texture coordinates and colors, one after the other in a
+   GL_STATIC_DRAW buffer, converted to PVR vertices by the first draw */
+static GLuint BENCH_BUFFER = 0;
+
+#define BENCH_BUFFER_UV    sizeof(MESH_POS3)
+#define BENCH_BUFFER_COLOR (sizeof(MESH_POS3) + sizeof(MESH_UV))
+
+static void bench_fill_buffer() {
+    if(!BENCH_BUFFER)
+        glGenBuffers(1, &BENCH_BUFFER);
+
+    glBindBuffer(GL_ARRAY_BUFFER, BENCH_BUFFER);
+    glBufferData(GL_ARRAY_BUFFER, BENCH_BUFFER_COLOR + sizeof(MESH_COLOR4F), NULL, GL_STATIC_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(MESH_POS3), MESH_POS3);
+    glBufferSubData(GL_ARRAY_BUFFER, BENCH_BUFFER_UV, sizeof(MESH_UV), MESH_UV);
+    glBufferSubData(GL_ARRAY_BUFFER, BENCH_BUFFER_COLOR, sizeof(MESH_COLOR4F), MESH_COLOR4F);
+}
+
+static void setup_buffer_textured() {
+    setup_textured();
+    bench_fill_buffer();
+}
+
+static void setup_buffer_color() {
+    bench_fill_buffer();
+}
+
+static void setup_buffer_nearz() {
+    setup_nearz();
+    bench_fill_buffer();
+}
+
+static GLuint frame_buffer_textured() {
+    GLuint i;
+
+    for(i = 0; i < BENCH_DRAWS; i++) {
+        glVertexPointer(3, GL_FLOAT, 0, (GLvoid *)0);
+        glTexCoordPointer(2, GL_FLOAT, 0, (GLvoid *)BENCH_BUFFER_UV);
+        glDrawArrays(GL_TRIANGLES, 0, BENCH_TRI_VERTS);
+    }
+
+    return BENCH_DRAWS * BENCH_TRI_VERTS;
+}
+
+static GLuint frame_buffer_color() {
+    GLuint i;
+
+    for(i = 0; i < BENCH_DRAWS; i++) {
+        glVertexPointer(3, GL_FLOAT, 0, (GLvoid *)0);
+        glColorPointer(4, GL_FLOAT, 0, (GLvoid *)BENCH_BUFFER_COLOR);
+        glDrawArrays(GL_TRIANGLES, 0, BENCH_TRI_VERTS);
+    }
+
+    return BENCH_DRAWS * BENCH_TRI_VERTS;
+}
+
+//===============================================================================//
+//== Interleaved Array Paths ==//
+
+/* The same interleaved mesh, set with glInterleavedArrays() for the single pass
+   kernels, or with a pointer per attribute for the separate attribute passes */
+static GLuint bench_interleaved(GLenum format, const GLfloat *data, GLubyte fused) {
+    GLuint i;
+
+    for(i = 0; i < BENCH_DRAWS; i++) {
+        if(fused)
+            glInterleavedArrays(format, 0, data);
+        else
+            switch(format) {
+                case GL_T2F_C4UB_V3F:
+                    glTexCoordPointer(2, GL_FLOAT, 24, data);
+                    glColorPointer(4, GL_UNSIGNED_BYTE, 24, data + 2);
+                    glVertexPointer(3, GL_FLOAT, 24, data + 3);
+                    break;
+
+                case GL_T2F_N3F_V3F:
+                    glTexCoordPointer(2, GL_FLOAT, 32, data);
+                    glNormalPointer(GL_FLOAT, 32, data + 2);
+                    glVertexPointer(3, GL_FLOAT, 32, data + 5);
+                    break;
+
+                case GL_C4UB_V3F:
+                    glColorPointer(4, GL_UNSIGNED_BYTE, 16, data);
+                    glVertexPointer(3, GL_FLOAT, 16, data + 1);
+                    break;
+            }
+
+        glDrawArrays(GL_TRIANGLES, 0, BENCH_TRI_VERTS);
+    }
+
+    return BENCH_DRAWS * BENCH_TRI_VERTS;
+}
+
+#define BENCH_INTERLEAVED_FRAME(name, format, data, fused) \
+    static GLuint name() { \
+        return bench_interleaved(format, data, fused); \
+    }
+
+BENCH_INTERLEAVED_FRAME(frame_separate_t2f_c4ub_v3f, GL_T2F_C4UB_V3F, MESH_T2F_C4UB_V3F, 0)
+BENCH_INTERLEAVED_FRAME(frame_fused_t2f_c4ub_v3f, GL_T2F_C4UB_V3F, MESH_T2F_C4UB_V3F, 1)
+BENCH_INTERLEAVED_FRAME(frame_separate_t2f_n3f_v3f, GL_T2F_N3F_V3F, MESH_T2F_N3F_V3F, 0)
+BENCH_INTERLEAVED_FRAME(frame_fused_t2f_n3f_v3f, GL_T2F_N3F_V3F, MESH_T2F_N3F_V3F, 1)
+BENCH_INTERLEAVED_FRAME(frame_separate_c4ub_v3f, GL_C4UB_V3F, MESH_C4UB_V3F, 0)
+BENCH_INTERLEAVED_FRAME(frame_fused_c4ub_v3f, GL_C4UB_V3F, MESH_C4UB_V3F, 1)
+
+//===============================================================================//
+//== Kernel Table Paths ==//
+
+/* One benchmark per kernel of the glDrawElements() kernel table: index type,
+   position size, color source and texture coordinates. The U8 and U16 draws
+   index the same grid, so the index type is the only difference between them. */
+
+#define BENCH_KERNEL_CASES (2 * 2 * 5 * 2)
+
+static struct {
+    GLuint vsize, color, textured;
+    GLenum type;
+} BENCH_KERNEL;
+
+static GLuint frame_kernel() {
+    GLuint i;
+
+    for(i = 0; i < BENCH_DRAWS * 8; i++) {
+        if(BENCH_KERNEL.vsize == 2)
+            glVertexPointer(2, GL_FLOAT, 8, MESH_POS2);
+        else
+            glVertexPointer(3, GL_FLOAT, 0, U8_POS);
+
+        switch(BENCH_KERNEL.color) {
+            case 1:
+                glColorPointer(1, GL_UNSIGNED_INT, 0, MESH_COLOR1UI);
+                break;
+
+            case 2:
+                glColorPointer(4, GL_UNSIGNED_BYTE, 4, MESH_COLOR4UB);
+                break;
+
+            case 3:
+                glColorPointer(3, GL_FLOAT, 0, MESH_COLOR3F);
+                break;
+
+            case 4:
+                glColorPointer(4, GL_FLOAT, 0, MESH_COLOR4F);
+                break;
+        }
+
+        if(BENCH_KERNEL.textured)
+            glTexCoordPointer(2, GL_FLOAT, 0, MESH_UV);
+
+        if(BENCH_KERNEL.type == GL_UNSIGNED_BYTE)
+            glDrawElements(GL_TRIANGLES, sizeof(U8_INDEX), GL_UNSIGNED_BYTE, U8_INDEX);
+        else
+            glDrawElements(GL_TRIANGLES, sizeof(U8_INDEX), GL_UNSIGNED_SHORT, U8_INDEX16);
+    }
+
+    return BENCH_DRAWS * 8 * sizeof(U8_INDEX);
+}
+
+static void bench_kernels() {
+    static const char *colors[5] = { "c0", "1ui", "4ub", "3f", "4f" };
+    static char names[BENCH_KERNEL_CASES][32];
+    GLuint i;
+
+    for(i = 0; i < sizeof(U8_INDEX); i++)
+        U8_INDEX16[i] = U8_INDEX[i];
+
+    for(i = 0; i < BENCH_KERNEL_CASES; i++) {
+        BENCH_DRAW b = { names[i], NULL, frame_kernel };
+
+        BENCH_KERNEL.type = i < BENCH_KERNEL_CASES / 2 ? GL_UNSIGNED_BYTE : GL_UNSIGNED_SHORT;
+        BENCH_KERNEL.vsize = 2 + (i / 10) % 2;
+        BENCH_KERNEL.color = (i / 2) % 5;
+        BENCH_KERNEL.textured = i % 2;
+
+        sprintf(names[i], "kernel_%s_v%u_%s%s", BENCH_KERNEL.type == GL_UNSIGNED_BYTE ? "u8" : "u16",
+                BENCH_KERNEL.vsize, colors[BENCH_KERNEL.color], BENCH_KERNEL.textured ? "_t" : "");
+
+        if(BENCH_KERNEL.textured)
+            b.setup = setup_textured;
+
+        bench_draw(&b);
+    }
+}
+
+//===============================================================================//
+//== Polygon Header Building ==//
+
+/* One triangle per draw, so the frame is dominated by header building.
+   Alternating two textures forces a new header on every draw; a single
+   texture lets the repeated header check skip it. */
+
+static void bench_headers(const char *name, GLubyte alternate) {
+    const GLuint draws = 4096;
+    double best = 0.0;
+    GLuint r;
+
+    for(r = 0; r < BENCH_REPEATS; r++) {
+        GLuint frames = 0, i;
+        double start, elapsed;
+
+        bench_reset_state();
+        glEnable(GL_TEXTURE_2D);
+
+        start = bench_now();
+
+        do {
+            for(i = 0; i < draws; i++) {
+                glBindTexture(GL_TEXTURE_2D, TEXTURES[alternate ? i & 1 : 0]);
+                glVertexPointer(3, GL_FLOAT, 0, MESH_POS3);
+                glTexCoordPointer(2, GL_FLOAT, 0, MESH_UV);
+                glDrawArrays(GL_TRIANGLES, 0, 3);
+            }
+
+            glutSwapBuffers();
+
+            elapsed = bench_now() - start;
+        }
+        while(++frames < BENCH_MIN_FRAMES || elapsed < BENCH_MIN_SECONDS);
+
+        if(frames * draws / elapsed > best)
+            best = frames * draws / elapsed;
+    }
+
+    bench_report(name, "draw", best, (double)bench_scene_bytes() / draws);
+}
+
+//===============================================================================//
+//== Texture Paths ==//
+
+static void bench_teximage(const BENCH_TEXTURE *t) {
+    const GLuint texels = BENCH_TEX_SIZE * BENCH_TEX_SIZE;
+    GLubyte *src = calloc(texels, t->texel_bytes);
+    GLuint tex, r;
+    double best = 0.0;
+
+    glGenTextures(1, &tex);
+    glBindTexture(GL_TEXTURE_2D, tex);
+
+    for(r = 0; r < BENCH_REPEATS; r++) {
+        GLuint uploads = 0;
+        double start = bench_now(), elapsed;
+
+        do {
+            glTexImage2D(GL_TEXTURE_2D, 0, t->format, BENCH_TEX_SIZE, BENCH_TEX_SIZE, 0,
+                         t->format, t->type, src);
+
+            elapsed = bench_now() - start;
+        }
+        while(++uploads < BENCH_MIN_FRAMES || elapsed < BENCH_MIN_SECONDS);
+
+        if(uploads * texels / elapsed > best)
+            best = uploads * texels / elapsed;
+    }
+
+    glDeleteTextures(1, &tex);
+    free(src);
+
+    bench_report(t->name, "texel", best, 2.0);
+}
+
+static void bench_mipmaps() {
+    const GLuint texels = BENCH_TEX_SIZE * BENCH_TEX_SIZE;
+    GLushort *src = calloc(texels * 2, sizeof(GLushort)); /* Room for the whole chain */
+    GLuint r;
+    double best = 0.0;
+
+    for(r = 0; r < BENCH_REPEATS; r++) {
+        GLuint builds = 0;
+        double start = bench_now(), elapsed;
+
+        do {
+            gluBuild2DMipmaps(GL_TEXTURE_2D, GL_RGB, BENCH_TEX_SIZE, BENCH_TEX_SIZE,
+                              GL_RGB, GL_UNSIGNED_SHORT_5_6_5, src);
+
+            elapsed = bench_now() - start;
+        }
+        while(++builds < BENCH_MIN_FRAMES || elapsed < BENCH_MIN_SECONDS);
+
+        if(builds * texels / elapsed > best)
+            best = builds * texels / elapsed;
+    }
+
+    free(src);
+
+    /* The chain below the base level is a third of its size */
+    bench_report("glu_build_2d_mipmaps", "texel", best, 2.0 / 3.0);
+}
+
+//===============================================================================//
+//== Main ==//
+
+static const BENCH_DRAW BENCH_DRAWS_TABLE[] = {
+    { "arrays_2d",           NULL,                frame_arrays_2d },
+    { "arrays_3d",           NULL,                frame_arrays_3d },
+    { "arrays_3d_strip",     NULL,                frame_arrays_strip },
+    { "arrays_3d_fan",       NULL,                frame_arrays_fan },
+    { "arrays_3d_lines",     NULL,                frame_arrays_lines },
+    { "arrays_3d_points",    NULL,                frame_arrays_points },
+    { "arrays_color_1ui",    NULL,                frame_color_1ui },
+    { "arrays_color_4ub",    NULL,                frame_color_4ub },
+    { "arrays_color_3f",     NULL,                frame_color_3f },
+    { "arrays_color_4f",     NULL,                frame_color_4f },
+    { "arrays_textured",     setup_textured,      frame_textured },
+    { "arrays_multitextured", setup_multitextured, frame_multitextured },
+    { "arrays_lit",          setup_lit,           frame_lit },
+    { "arrays_nearz_clip",   setup_nearz,         frame_nearz },
+    { "arrays_nearz_front",  setup_nearz_front,   frame_arrays_3d },
+    { "bounds_nearz_front",  setup_nearz_front,   frame_bounds },
+    { "bounds_culled",       setup_bounds_culled, frame_bounds },
+    { "elements_u8",         NULL,                frame_elements_u8 },
+    { "elements_u16",        NULL,                frame_elements_u16 },
+    { "elements_u32",        NULL,                frame_elements_u32 },
+    { "elements_range_u16",  NULL,                frame_range_u16 },
+    { "elements_unshared",   NULL,                frame_elements_unshared },
+    { "elements_strips",     setup_elements_strips, frame_elements_strips },
+    { "small_draws",         setup_multi,         frame_small_draws },
+    { "small_draws_model",   setup_multi,         frame_small_draws_model },
+    { "small_elements",      setup_multi,         frame_small_elements },
+    { "multi_arrays",        setup_multi,         frame_multi_arrays },
+    { "multi_arrays_model",  setup_multi,         frame_multi_arrays_model },
+    { "multi_elements",      setup_multi,         frame_multi_elements },
+    { "immediate_ft",        NULL,                frame_immediate_ft },
+    { "immediate_fc",        setup_nearz,         frame_immediate_ft },
+    { "immediate_fl",        setup_immediate_fl,  frame_immediate_fl },
+    { "immediate_flc",       setup_immediate_flc, frame_immediate_fl },
+    { "immediate_fp",        NULL,                frame_immediate_points },
+    { "particles",           NULL,                frame_particles },
+    { "list_textured",       setup_list_textured, frame_list },
+    { "list_nearz_clip",     setup_list_nearz,    frame_list },
+    { "list_lit",            setup_list_lit,      frame_list },
+    { "buffer_textured",     setup_buffer_textured, frame_buffer_textured },
+    { "buffer_color_4f",     setup_buffer_color,  frame_buffer_color },
+    { "buffer_nearz_clip",   setup_buffer_nearz,  frame_buffer_textured },
+    { "separate_t2f_c4ub_v3f", setup_textured,    frame_separate_t2f_c4ub_v3f },
+    { "fused_t2f_c4ub_v3f",  setup_textured,      frame_fused_t2f_c4ub_v3f },
+    { "separate_t2f_n3f_v3f", setup_textured,     frame_separate_t2f_n3f_v3f },
+    { "fused_t2f_n3f_v3f",   setup_textured,      frame_fused_t2f_n3f_v3f },
+    { "separate_c4ub_v3f",   NULL,                frame_separate_c4ub_v3f },
+    { "fused_c4ub_v3f",      NULL,                frame_fused_c4ub_v3f },
+};
+
+static const BENCH_TEXTURE BENCH_TEXTURES[] = {
+    { "teximage_rgb_byte",     GL_RGB,  GL_BYTE,                 3 },
+    { "teximage_rgb_ubyte",    GL_RGB,  GL_UNSIGNED_BYTE,        3 },
+    { "teximage_rgb_short",    GL_RGB,  GL_SHORT,                6 },
+    { "teximage_rgb_ushort",   GL_RGB,  GL_UNSIGNED_SHORT,       6 },
+    { "teximage_rgb_float",    GL_RGB,  GL_FLOAT,                12 },
+    { "teximage_rgba_byte",    GL_RGBA, GL_BYTE,                 4 },
+    { "teximage_rgba_ubyte",   GL_RGBA, GL_UNSIGNED_BYTE,        4 },
+    { "teximage_rgba_short",   GL_RGBA, GL_SHORT,                8 },
+    { "teximage_rgba_ushort",  GL_RGBA, GL_UNSIGNED_SHORT,       8 },
+    { "teximage_rgba_float",   GL_RGBA, GL_FLOAT,                16 },
+    { "teximage_565",          GL_RGB,  GL_UNSIGNED_SHORT_5_6_5,   2 },
+    { "teximage_1555",         GL_RGBA, GL_UNSIGNED_SHORT_1_5_5_5, 2 },
+    { "teximage_4444",         GL_RGBA, GL_UNSIGNED_SHORT_4_4_4_4, 2 },
+};
+
+#define BENCH_COUNT(table) (sizeof(table) / sizeof(table[0]))
+
+static int bench_write_json(const char *filename) {
+    FILE *f = filename ? fopen(filename, "w") : stdout;
+    GLuint i;
+
+    if(!f) {
+        perror(filename);
+        return 0;
+    }
+
+    fprintf(f, "{\n  \"benchmarks\": [\n");
+
+    for(i = 0; i < BENCH_RESULT_COUNT; i++)
+        fprintf(f, "    { \"name\": \"%s\", \"unit\": \"%s\", \"rate\": %.1f, \"bytes_per_unit\": %.4f }%s\n",
+                BENCH_RESULTS[i].name, BENCH_RESULTS[i].unit, BENCH_RESULTS[i].rate,
+                BENCH_RESULTS[i].bytes, i + 1 < BENCH_RESULT_COUNT ? "," : "");
+
+    fprintf(f, "  ]\n}\n");
+
+    if(filename)
+        fclose(f);
+
+    return 1;
+}
+
+int main(int argc, char **argv) {
+    GLuint i;
+
+    glKosInit();
+
+    bench_build_mesh();
+    bench_build_grid(BENCH_U8_GRID, U8_POS, U8_INDEX, NULL);
+    bench_build_grid(BENCH_U16_GRID, U16_POS, NULL, U16_INDEX);
+    bench_build_unshared(BENCH_U16_GRID, UNSHARED_POS, UNSHARED_INDEX);
+
+    for(i = 0; i < BENCH_COUNT(U16_INDEX); i++)
+        U16_INDEX32[i] = STRIP_INDEX[i] = U16_INDEX[i];
+    bench_build_textures();
+
+    for(i = 0; i < BENCH_COUNT(BENCH_DRAWS_TABLE); i++)
+        bench_draw(&BENCH_DRAWS_TABLE[i]);
+
+    bench_kernels();
+
+    bench_headers("header_build_alternate", 1);
+    bench_headers("header_build_repeat", 0);
+
+    for(i = 0; i < BENCH_COUNT(BENCH_TEXTURES); i++)
+        bench_teximage(&BENCH_TEXTURES[i]);
+
+    bench_mipmaps();
+
+    return bench_write_json(argc > 1 ? argv[1] : NULL) ? 0 : 1;
+}
@@ -0,0 +1,357 @@
+/* KallistiGL for KallistiOS ##version##
+
+   libgl/bench/raster.c
+
+   Renders TA stream captures with the host build's reference rasterizer,
+   to check that a change to the library leaves the image alone. Built
+   against the host build with make bench.
+
+   Usage: raster render capture.kglc prefix [ppm]
+          raster diff baseline.kglc results.kglc [prefix] [--tolerance n]
+
+   render writes scene n of the capture to prefix-n.png, or .ppm.
+
+   diff renders both captures and compares them pixel by pixel, scene by
+   scene. A pixel differs when a channel is off by more than the tolerance,
+   0 by default. Each scene with differing pixels is reported, and written
+   to prefix-n.png when a prefix is given: the baseline dimmed, with the
+   differing pixels in red. Exits with status 1 when any scene differs.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <GL/gl.h>
+#include <GL/glut.h>
+
+#include <dc/pvr.h>
+#include <dc/video.h>
+
+typedef struct {
+    uint32 *argb;
+    uint32 width, height;
+} RASTER_IMAGE;
+
+//===============================================================================//
+//== Image Files ==//
+
+static uint32 RASTER_CRC[256];
+
+static uint32 raster_crc(uint32 crc, const uint8 *data, uint32 bytes) {
+    uint32 i, k;
+
+    if(!RASTER_CRC[1])
+        for(i = 0; i < 256; i++) {
+            uint32 c = i;
+
+            for(k = 0; k < 8; k++)
+                c = c & 1 ? 0xedb88320 ^ (c >> 1) : c >> 1;
+
+            RASTER_CRC[i] = c;
+        }
+
+    crc = ~crc;
+
+    for(i = 0; i < bytes; i++)
+        crc = RASTER_CRC[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+
+    return ~crc;
+}
+
+static void raster_put32(uint8 *dst, uint32 v) {
+    dst[0] = v >> 24;
+    dst[1] = v >> 16;
+    dst[2] = v >> 8;
+    dst[3] = v;
+}
+
+static void raster_png_chunk(FILE *f, const char *type, const uint8 *data, uint32 bytes) {
+    uint8 word[4];
+    uint32 crc;
+
+    raster_put32(word, bytes);
+    fwrite(word, 1, 4, f);
+    fwrite(type, 1, 4, f);
+    fwrite(data, 1, bytes, f);
+
+    crc = raster_crc(raster_crc(0, (const uint8 *)type, 4), data, bytes);
+    raster_put32(word, crc);
+    fwrite(word, 1, 4, f);
+}
+
+/* RGB PNG, with the image data in stored (uncompressed) deflate blocks */
+static int raster_write_png(const char *filename, const RASTER_IMAGE *img) {
+    static const uint8 signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+    uint32 row = img->width * 3 + 1, raw_bytes = row * img->height;
+    uint32 blocks = (raw_bytes + 65534) / 65535, a = 1, b = 0, i, x, y;
+    uint8 *raw = malloc(raw_bytes), *z = malloc(raw_bytes + blocks * 5 + 6), *p;
+    uint8 ihdr[13];
+    FILE *f = fopen(filename, "wb");
+
+    if(!f) {
+        perror(filename);
+        free(raw);
+        free(z);
+        return 0;
+    }
+
+    for(y = 0; y < img->height; y++) {
+        p = raw + y * row;
+        *p++ = 0; /* No filter */
+
+        for(x = 0; x < img->width; x++) {
+            uint32 c = img->argb[y * img->width + x];
+
+            *p++ = c >> 16;
+            *p++ = c >> 8;
+            *p++ = c;
+        }
+    }
+
+    p = z;
+    *p++ = 0x78;
+    *p++ = 0x01;
+
+    for(i = 0; i < raw_bytes; i += 65535) {
+        uint32 n = raw_bytes - i < 65535 ? raw_bytes - i : 65535;
+
+        *p++ = i + n == raw_bytes;
+        *p++ = n;
+        *p++ = n >> 8;
+        *p++ = ~n;
+        *p++ = ~n >> 8;
+        memcpy(p, raw + i, n);
+        p += n;
+    }
+
+    for(i = 0; i < raw_bytes; i++) {
+        a = (a + raw[i]) % 65521;
+        b = (b + a) % 65521;
+    }
+
+    raster_put32(p, (b << 16) | a);
+    p += 4;
+
+    raster_put32(ihdr, img->width);
+    raster_put32(ihdr + 4, img->height);
+    ihdr[8] = 8;  /* Bits per channel */
+    ihdr[9] = 2;  /* RGB */
+    ihdr[10] = ihdr[11] = ihdr[12] = 0;
+
+    fwrite(signature, 1, sizeof(signature), f);
+    raster_png_chunk(f, "IHDR", ihdr, sizeof(ihdr));
+    raster_png_chunk(f, "IDAT", z, p - z);
+    raster_png_chunk(f, "IEND", NULL, 0);
+
+    fclose(f);
+    free(raw);
+    free(z);
+
+    return 1;
+}
+
+static int raster_write_ppm(const char *filename, const RASTER_IMAGE *img) {
+    FILE *f = fopen(filename, "wb");
+    uint32 i;
+
+    if(!f) {
+        perror(filename);
+        return 0;
+    }
+
+    fprintf(f, "P6\n%u %u\n255\n", (unsigned)img->width, (unsigned)img->height);
+
+    for(i = 0; i < img->width * img->height; i++) {
+        uint8 rgb[3] = { img->argb[i] >> 16, img->argb[i] >> 8, img->argb[i] };
+
+        fwrite(rgb, 1, 3, f);
+    }
+
+    fclose(f);
+
+    return 1;
+}
+
+//===============================================================================//
+//== Rendering ==//
+
+/* Replay every scene of a capture through the stand-in and rasterize it.
+   Scenes rendered to a texture come out at the size of the target. */
+static int raster_capture(const char *filename, RASTER_IMAGE **images) {
+    GLint scenes = glKosReplayLoad(filename), i;
+
+    if(scenes < 0) {
+        fprintf(stderr, "%s: not a capture file\n", filename);
+        return -1;
+    }
+
+    *images = calloc(scenes ? scenes : 1, sizeof(RASTER_IMAGE));
+
+    for(i = 0; i < scenes; i++) {
+        const pvr_host_scene_t *scene;
+        RASTER_IMAGE *img = &(*images)[i];
+
+        glKosReplayScene(i);
+        scene = pvr_host_last_scene();
+
+        img->width = scene->target ? scene->target_width : (uint32)vid_mode->width;
+        img->height = scene->target ? scene->target_height : (uint32)vid_mode->height;
+        img->argb = malloc(img->width * img->height * sizeof(uint32));
+
+        pvr_host_render(scene, img->argb, img->width, img->height);
+    }
+
+    glKosReplayFree();
+
+    return scenes;
+}
+
+static void raster_free(RASTER_IMAGE *images, GLint count) {
+    GLint i;
+
+    for(i = 0; i < count; i++)
+        free(images[i].argb);
+
+    free(images);
+}
+
+static int raster_render(const char *filename, const char *prefix, int ppm) {
+    RASTER_IMAGE *images;
+    GLint scenes = raster_capture(filename, &images), i;
+    char name[1024];
+    int ok = scenes >= 0;
+
+    for(i = 0; i < scenes && ok; i++) {
+        snprintf(name, sizeof(name), "%s-%d.%s", prefix, i, ppm ? "ppm" : "png");
+        ok = ppm ? raster_write_ppm(name, &images[i]) : raster_write_png(name, &images[i]);
+    }
+
+    if(ok)
+        printf("%s: %d scene(s) written to %s-*.%s\n", filename, scenes, prefix, ppm ? "ppm" : "png");
+
+    if(scenes >= 0)
+        raster_free(images, scenes);
+
+    return ok ? 0 : 1;
+}
+
+//===============================================================================//
+//== Diff ==//
+
+static uint32 raster_delta(uint32 a, uint32 b) {
+    uint32 d = 0, s;
+
+    for(s = 0; s < 32; s += 8) {
+        int c = (int)((a >> s) & 0xff) - (int)((b >> s) & 0xff);
+
+        c = c < 0 ? -c : c;
+        d = (uint32)c > d ? (uint32)c : d;
+    }
+
+    return d;
+}
+
+static int raster_diff(const char *baseline, const char *results, const char *prefix, uint32 tolerance) {
+    RASTER_IMAGE *base, *res;
+    GLint base_scenes = raster_capture(baseline, &base), res_scenes, i;
+    int differ = 0;
+
+    if(base_scenes < 0)
+        return 1;
+
+    res_scenes = raster_capture(results, &res);
+
+    if(res_scenes < 0) {
+        raster_free(base, base_scenes);
+        return 1;
+    }
+
+    if(base_scenes != res_scenes) {
+        printf("%s: %d scene(s), baseline %d\n", results, res_scenes, base_scenes);
+        differ = 1;
+    }
+
+    for(i = 0; i < base_scenes && i < res_scenes; i++) {
+        RASTER_IMAGE *a = &base[i], *b = &res[i];
+        uint32 p, pixels = 0, max = 0;
+
+        if(a->width != b->width || a->height != b->height) {
+            printf("%s: scene %d is %ux%u, baseline %ux%u\n", results, i, (unsigned)b->width,
+                   (unsigned)b->height, (unsigned)a->width, (unsigned)a->height);
+            differ = 1;
+            continue;
+        }
+
+        /* Reuse the result image for the diff: dimmed baseline, red where it differs */
+        for(p = 0; p < a->width * a->height; p++) {
+            uint32 d = raster_delta(a->argb[p], b->argb[p]);
+
+            max = d > max ? d : max;
+
+            if(d > tolerance) {
+                b->argb[p] = 0xff000000 | ((d < 128 ? 128 + d : 255) << 16);
+                ++pixels;
+            }
+            else
+                b->argb[p] = 0xff000000 | ((a->argb[p] >> 2) & 0x3f3f3f);
+        }
+
+        if(!pixels)
+            continue;
+
+        printf("%s: scene %d, %u of %u pixels differ, largest channel difference %u\n",
+               results, i, (unsigned)pixels, (unsigned)(a->width * a->height), (unsigned)max);
+        differ = 1;
+
+        if(prefix) {
+            char name[1024];
+
+            snprintf(name, sizeof(name), "%s-%d.png", prefix, i);
+            raster_write_png(name, b);
+        }
+    }
+
+    if(!differ)
+        printf("%s: %d scene(s) match %s\n", results, res_scenes, baseline);
+
+    raster_free(base, base_scenes);
+    raster_free(res, res_scenes);
+
+    return differ;
+}
+
+//===============================================================================//
+//== Main ==//
+
+static int raster_usage() {
+    fprintf(stderr, "usage: raster render capture.kglc prefix [ppm]\n"
+            "       raster diff baseline.kglc results.kglc [prefix] [--tolerance n]\n");
+
+    return 2;
+}
+
+int main(int argc, char **argv) {
+    const char *prefix = NULL;
+    uint32 tolerance = 0;
+    int i;
+
+    if(argc < 4)
+        return raster_usage();
+
+    glKosInit();
+
+    if(!strcmp(argv[1], "render"))
+        return raster_render(argv[2], argv[3], argc > 4 && !strcmp(argv[4], "ppm"));
+
+    if(strcmp(argv[1], "diff"))
+        return raster_usage();
+
+    for(i = 4; i < argc; i++)
+        if(!strcmp(argv[i], "--tolerance") && i + 1 < argc)
+            tolerance = (uint32)atoi(argv[++i]);
+        else
+            prefix = argv[i];
+
+    return raster_diff(argv[2], argv[3], prefix, tolerance);
+}
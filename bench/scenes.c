@@ -0,0 +1,858 @@
+/* KallistiGL for KallistiOS ##version##
+
+   libgl/bench/scenes.c
+
+   Scene-level benchmarks. Each scene drives the public API the way a game
+   frame does, with a camera scripted by the frame number, so every run of a
+   scene submits the same frames. Built against the host build with
+   make bench.
+
+   Usage: scenes [frames] [results.json] [capture prefix]
+
+   Each scene reports its mean frame time and percentiles, TA bytes per frame
+   and the peak usage of the scratch buffers, in the format read by
+   bench/compare.py (rate is frames per second at the mean frame time).
+
+   Given a capture prefix, each scene draws one more frame after the timed
+   ones and captures it to prefix-<scene>.kglc, for bench/raster to compare
+   against a baseline capture.
+*/
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <GL/gl.h>
+#include <GL/glext.h>
+#include <GL/glu.h>
+#include <GL/glut.h>
+
+#define SCENE_DEFAULT_FRAMES 300
+
+#define SCENE_TEX_SIZE       64
+#define SCENE_LIGHTMAP_SIZE  16
+
+typedef struct {
+    const char *name;
+    void (*setup)();
+    void (*frame)(GLuint n);  /* Draws frame n, ending it with scene_swap() */
+} SCENE;
+
+typedef struct {
+    const char *name;
+    double mean, p50, p90, p99, max; /* Frame time, milliseconds */
+    double ta_bytes;          /* Mean TA bytes per frame */
+    GLuint ta_bytes_peak;
+    GLuint array_buf_peak, clip_buf_peak, uv_buf_peak;
+} SCENE_RESULT;
+
+static SCENE_RESULT SCENE_RESULTS[16];
+static GLuint SCENE_RESULT_COUNT = 0;
+
+static GLuint SCENE_SEED;
+
+static double scene_now() {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* Deterministic across platforms, unlike rand() */
+static GLfloat scene_rand() {
+    SCENE_SEED = SCENE_SEED * 1664525u + 1013904223u;
+
+    return (SCENE_SEED >> 8) * (1.0f / 16777216.0f);
+}
+
+static SCENE_RESULT *SCENE_CURRENT;
+static GLuint        SCENE_FRAME_BYTES;
+
+/* glutSwapBuffers(), adding the submitted scene to the frame being measured.
+   A frame may swap more than once, to render to a texture first. */
+static void scene_swap() {
+    const pvr_host_scene_t *ta;
+    GL_KOS_FRAME_STATS stats;
+    GLuint scenes = pvr_host_scene_count(), l;
+
+    glutSwapBuffers();
+
+    ta = pvr_host_last_scene();
+
+    /* With frames queued ahead of the PVR, a swap may submit no scene */
+    if(ta && pvr_host_scene_count() != scenes)
+        for(l = 0; l < PVR_HOST_LISTS; l++)
+            SCENE_FRAME_BYTES += ta->list_bytes[l];
+
+    glKosGetFrameStats(&stats);
+
+    if(stats.array_buf_peak > SCENE_CURRENT->array_buf_peak)
+        SCENE_CURRENT->array_buf_peak = stats.array_buf_peak;
+
+    if(stats.clip_buf_peak > SCENE_CURRENT->clip_buf_peak)
+        SCENE_CURRENT->clip_buf_peak = stats.clip_buf_peak;
+
+    if(stats.uv_buf_peak > SCENE_CURRENT->uv_buf_peak)
+        SCENE_CURRENT->uv_buf_peak = stats.uv_buf_peak;
+}
+
+static GLuint scene_texture(GLuint size, GLenum format, GLenum type) {
+    GLushort *texels = malloc(size * size * sizeof(GLushort));
+    GLuint tex, i;
+
+    for(i = 0; i < size * size; i++)
+        texels[i] = (GLushort)(scene_rand() * 65535.0f);
+
+    glGenTextures(1, &tex);
+    glBindTexture(GL_TEXTURE_2D, tex);
+    glTexImage2D(GL_TEXTURE_2D, 0, format, size, size, 0, format, type, texels);
+
+    free(texels);
+
+    return tex;
+}
+
+static void scene_perspective(GLfloat fov) {
+    glMatrixMode(GL_PROJECTION);
+    glLoadIdentity();
+    gluPerspective(fov, 640.0f / 480.0f, 0.1f, 200.0f);
+    glMatrixMode(GL_MODELVIEW);
+    glLoadIdentity();
+}
+
+//===============================================================================//
+//== BSP Level: lightmapped multi-texture rooms, near-Z clipping ==//
+
+/* A grid of rooms, each a leaf with floor, ceiling and four walls. Every
+   face is a tessellated quad, batched per leaf like a BSP renderer batches
+   the faces of a visible leaf. */
+
+#define BSP_ROOMS       6     /* Rooms per side */
+#define BSP_ROOM_SIZE   8.0f
+#define BSP_ROOM_HEIGHT 4.0f
+#define BSP_TESS        4     /* Quads per face side */
+#define BSP_FACE_VERTS  (BSP_TESS * BSP_TESS * 6)
+#define BSP_LEAF_VERTS  (BSP_FACE_VERTS * 6)
+
+typedef struct {
+    GLfloat pos[BSP_LEAF_VERTS * 3];
+    GLfloat uv[BSP_LEAF_VERTS * 2];
+    GLfloat lm[BSP_LEAF_VERTS * 2];
+    GLuint  texture, lightmap;
+    GLfloat cx, cz;
+} BSP_LEAF;
+
+static BSP_LEAF *BSP_LEAVES;
+static GLuint    BSP_TEXTURES[4], BSP_LIGHTMAPS[8];
+
+/* Emit face as BSP_TESS^2 quads spanning o + s * du + t * dv */
+static GLuint bsp_face(BSP_LEAF *leaf, GLuint v, const GLfloat *o, const GLfloat *du, const GLfloat *dv) {
+    static const GLubyte corner[6][2] = {
+        { 0, 0 }, { 1, 0 }, { 1, 1 }, { 0, 0 }, { 1, 1 }, { 0, 1 }
+    };
+    GLuint x, y, c, k;
+
+    for(y = 0; y < BSP_TESS; y++)
+        for(x = 0; x < BSP_TESS; x++)
+            for(c = 0; c < 6; c++, v++) {
+                GLfloat s = (GLfloat)(x + corner[c][0]) / BSP_TESS;
+                GLfloat t = (GLfloat)(y + corner[c][1]) / BSP_TESS;
+
+                for(k = 0; k < 3; k++)
+                    leaf->pos[v * 3 + k] = o[k] + s * du[k] + t * dv[k];
+
+                leaf->uv[v * 2 + 0] = s * 4.0f;
+                leaf->uv[v * 2 + 1] = t * 4.0f;
+                leaf->lm[v * 2 + 0] = s;
+                leaf->lm[v * 2 + 1] = t;
+            }
+
+    return v;
+}
+
+static void bsp_setup() {
+    const GLfloat S = BSP_ROOM_SIZE, H = BSP_ROOM_HEIGHT;
+    GLuint i, x, z;
+
+    SCENE_SEED = 1;
+
+    for(i = 0; i < 4; i++)
+        BSP_TEXTURES[i] = scene_texture(SCENE_TEX_SIZE, GL_RGB, GL_UNSIGNED_SHORT_5_6_5);
+
+    for(i = 0; i < 8; i++)
+        BSP_LIGHTMAPS[i] = scene_texture(SCENE_LIGHTMAP_SIZE, GL_RGB, GL_UNSIGNED_SHORT_5_6_5);
+
+    if(!BSP_LEAVES)
+        BSP_LEAVES = malloc(BSP_ROOMS * BSP_ROOMS * sizeof(BSP_LEAF));
+
+    for(z = 0; z < BSP_ROOMS; z++)
+        for(x = 0; x < BSP_ROOMS; x++) {
+            BSP_LEAF *leaf = &BSP_LEAVES[z * BSP_ROOMS + x];
+            GLfloat x0 = x * S, z0 = z * S;
+            GLuint v = 0;
+
+            const GLfloat floor_o[3] = { x0, 0, z0 }, floor_u[3] = { S, 0, 0 }, floor_v[3] = { 0, 0, S };
+            const GLfloat ceil_o[3] = { x0, H, z0 + S }, ceil_u[3] = { S, 0, 0 }, ceil_v[3] = { 0, 0, -S };
+            const GLfloat north_o[3] = { x0, 0, z0 }, north_u[3] = { 0, H, 0 }, north_v[3] = { S, 0, 0 };
+            const GLfloat south_o[3] = { x0, 0, z0 + S }, south_u[3] = { S, 0, 0 }, south_v[3] = { 0, H, 0 };
+            const GLfloat west_o[3] = { x0, 0, z0 }, west_u[3] = { 0, 0, S }, west_v[3] = { 0, H, 0 };
+            const GLfloat east_o[3] = { x0 + S, 0, z0 }, east_u[3] = { 0, H, 0 }, east_v[3] = { 0, 0, S };
+
+            v = bsp_face(leaf, v, floor_o, floor_u, floor_v);
+            v = bsp_face(leaf, v, ceil_o, ceil_u, ceil_v);
+            v = bsp_face(leaf, v, north_o, north_u, north_v);
+            v = bsp_face(leaf, v, south_o, south_u, south_v);
+            v = bsp_face(leaf, v, west_o, west_u, west_v);
+            bsp_face(leaf, v, east_o, east_u, east_v);
+
+            leaf->texture = BSP_TEXTURES[(x + z) & 3];
+            leaf->lightmap = BSP_LIGHTMAPS[(x * 3 + z) & 7];
+            leaf->cx = x0 + S * 0.5f;
+            leaf->cz = z0 + S * 0.5f;
+        }
+
+    glEnable(GL_TEXTURE_2D);
+    glEnable(GL_KOS_NEARZ_CLIPPING);
+    glEnable(GL_CULL_FACE);
+}
+
+static void bsp_frame(GLuint n) {
+    const GLfloat extent = BSP_ROOMS * BSP_ROOM_SIZE;
+    GLfloat t = n * 0.01f;
+    GLfloat ex = extent * 0.5f + sinf(t) * extent * 0.35f;
+    GLfloat ez = extent * 0.5f + cosf(t * 0.7f) * extent * 0.35f;
+    GLfloat dx = cosf(t * 1.3f), dz = sinf(t * 1.3f);
+    GLuint i;
+
+    scene_perspective(70.0f);
+    gluLookAt(ex, 1.7f, ez, ex + dx, 1.6f, ez + dz, 0.0f, 1.0f, 0.0f);
+
+    for(i = 0; i < BSP_ROOMS * BSP_ROOMS; i++) {
+        BSP_LEAF *leaf = &BSP_LEAVES[i];
+        GLfloat lx = leaf->cx - ex, lz = leaf->cz - ez;
+
+        /* Leaves behind the camera or far away are not visible */
+        if(lx * dx + lz * dz < -BSP_ROOM_SIZE || lx * lx + lz * lz > 30.0f * 30.0f)
+            continue;
+
+        glActiveTextureARB(GL_TEXTURE1_ARB);
+        glBindTexture(GL_TEXTURE_2D, leaf->lightmap);
+        glActiveTextureARB(GL_TEXTURE0_ARB);
+        glBindTexture(GL_TEXTURE_2D, leaf->texture);
+
+        glVertexPointer(3, GL_FLOAT, 0, leaf->pos);
+        glClientActiveTextureARB(GL_TEXTURE1_ARB);
+        glTexCoordPointer(2, GL_FLOAT, 0, leaf->lm);
+        glClientActiveTextureARB(GL_TEXTURE0_ARB);
+        glTexCoordPointer(2, GL_FLOAT, 0, leaf->uv);
+
+        glDrawArrays(GL_TRIANGLES, 0, BSP_LEAF_VERTS);
+    }
+
+    scene_swap();
+}
+
+//===============================================================================//
+//== Crowd: CPU skinned characters lit by 6 lights ==//
+
+/* Each character is a capsule-like cylinder with two bones, hips and
+   chest. Vertices blend between the bones by height, on the CPU, as titles
+   skin their meshes before handing them to the GL. */
+
+#define CROWD_COUNT    24
+#define CROWD_SEGMENTS 10
+#define CROWD_RINGS    10
+#define CROWD_VERTS    (CROWD_SEGMENTS * (CROWD_RINGS - 1) * 6)
+#define CROWD_LIGHTS   6
+
+static GLfloat CROWD_BIND_POS[CROWD_VERTS * 3];
+static GLfloat CROWD_BIND_NORMAL[CROWD_VERTS * 3];
+static GLfloat CROWD_WEIGHT[CROWD_VERTS];
+static GLfloat CROWD_POS[CROWD_VERTS * 3];
+static GLfloat CROWD_NORMAL[CROWD_VERTS * 3];
+static GLuint  CROWD_COLOR[CROWD_VERTS];
+static GLfloat CROWD_PLACE[CROWD_COUNT][3];
+
+static void crowd_setup() {
+    static const GLubyte corner[6][2] = {
+        { 0, 0 }, { 1, 0 }, { 1, 1 }, { 0, 0 }, { 1, 1 }, { 0, 1 }
+    };
+    GLuint s, r, c, v = 0, i;
+
+    SCENE_SEED = 2;
+
+    for(r = 0; r < CROWD_RINGS - 1; r++)
+        for(s = 0; s < CROWD_SEGMENTS; s++)
+            for(c = 0; c < 6; c++, v++) {
+                GLfloat a = (s + corner[c][0]) * (6.2831853f / CROWD_SEGMENTS);
+                GLfloat h = (GLfloat)(r + corner[c][1]) / (CROWD_RINGS - 1);
+                GLfloat radius = 0.3f + 0.1f * sinf(h * 3.1415926f);
+
+                CROWD_BIND_POS[v * 3 + 0] = cosf(a) * radius;
+                CROWD_BIND_POS[v * 3 + 1] = h * 1.8f;
+                CROWD_BIND_POS[v * 3 + 2] = sinf(a) * radius;
+
+                CROWD_BIND_NORMAL[v * 3 + 0] = cosf(a);
+                CROWD_BIND_NORMAL[v * 3 + 1] = 0.0f;
+                CROWD_BIND_NORMAL[v * 3 + 2] = sinf(a);
+
+                CROWD_WEIGHT[v] = h;
+                CROWD_COLOR[v] = 0xff000000 | (GLuint)(h * 255) << 16 | 0x4080;
+            }
+
+    for(i = 0; i < CROWD_COUNT; i++) {
+        CROWD_PLACE[i][0] = (i % 6) * 1.5f - 3.75f;
+        CROWD_PLACE[i][1] = 0.0f;
+        CROWD_PLACE[i][2] = (i / 6) * -1.5f - 2.0f;
+    }
+
+    for(i = 0; i < CROWD_LIGHTS; i++) {
+        GLfloat diffuse[4] = { scene_rand(), scene_rand(), scene_rand(), 1.0f };
+        GLfloat position[4] = { i * 2.0f - 5.0f, 3.0f, -4.0f - (i & 1) * 3.0f, 0.0f };
+
+        glLightfv(GL_LIGHT0 + i, GL_DIFFUSE, diffuse);
+        glLightfv(GL_LIGHT0 + i, GL_POSITION, position);
+        glLightf(GL_LIGHT0 + i, GL_LINEAR_ATTENUATION, 0.1f);
+        glEnable(GL_LIGHT0 + i);
+    }
+
+    glEnable(GL_LIGHTING);
+}
+
+/* Two bones: the chest sways about the hips by angle, around z */
+static void crowd_skin(GLfloat angle) {
+    GLfloat cs = cosf(angle), sn = sinf(angle);
+    GLuint v;
+
+    for(v = 0; v < CROWD_VERTS; v++) {
+        const GLfloat *p = &CROWD_BIND_POS[v * 3], *nrm = &CROWD_BIND_NORMAL[v * 3];
+        GLfloat w = CROWD_WEIGHT[v], y = p[1] - 0.9f;
+
+        CROWD_POS[v * 3 + 0] = (1.0f - w) * p[0] + w * (p[0] * cs - y * sn);
+        CROWD_POS[v * 3 + 1] = (1.0f - w) * p[1] + w * (p[0] * sn + y * cs + 0.9f);
+        CROWD_POS[v * 3 + 2] = p[2];
+
+        CROWD_NORMAL[v * 3 + 0] = (1.0f - w) * nrm[0] + w * nrm[0] * cs;
+        CROWD_NORMAL[v * 3 + 1] = w * nrm[0] * sn;
+        CROWD_NORMAL[v * 3 + 2] = nrm[2];
+    }
+}
+
+static void crowd_frame(GLuint n) {
+    GLuint i;
+
+    scene_perspective(55.0f);
+    gluLookAt(sinf(n * 0.02f) * 3.0f, 2.5f, 4.0f, 0.0f, 1.0f, -4.0f, 0.0f, 1.0f, 0.0f);
+
+    for(i = 0; i < CROWD_COUNT; i++) {
+        crowd_skin(sinf(n * 0.1f + i) * 0.4f);
+
+        glPushMatrix();
+        glTranslatef(CROWD_PLACE[i][0], CROWD_PLACE[i][1], CROWD_PLACE[i][2]);
+        glRotatef(i * 37.0f + n, 0.0f, 1.0f, 0.0f);
+
+        glVertexPointer(3, GL_FLOAT, 0, CROWD_POS);
+        glNormalPointer(GL_FLOAT, 0, CROWD_NORMAL);
+        glColorPointer(1, GL_UNSIGNED_INT, 0, CROWD_COLOR);
+        glDrawArrays(GL_TRIANGLES, 0, CROWD_VERTS);
+
+        glPopMatrix();
+    }
+
+    scene_swap();
+}
+
+//===============================================================================//
+//== Particles: blended camera-facing quads in the translucent list ==//
+
+#define PARTICLE_COUNT 3000
+
+typedef struct {
+    GLfloat pos[3], vel[3];
+    GLfloat age, life;
+} PARTICLE;
+
+static PARTICLE PARTICLES[PARTICLE_COUNT];
+static GLuint   PARTICLE_TEXTURE;
+
+static void particle_spawn(PARTICLE *p) {
+    p->pos[0] = (scene_rand() - 0.5f) * 0.5f;
+    p->pos[1] = 0.0f;
+    p->pos[2] = (scene_rand() - 0.5f) * 0.5f;
+    p->vel[0] = (scene_rand() - 0.5f) * 0.05f;
+    p->vel[1] = 0.05f + scene_rand() * 0.05f;
+    p->vel[2] = (scene_rand() - 0.5f) * 0.05f;
+    p->age = 0.0f;
+    p->life = 60.0f + scene_rand() * 60.0f;
+}
+
+static void particle_setup() {
+    GLuint i;
+
+    SCENE_SEED = 3;
+
+    PARTICLE_TEXTURE = scene_texture(SCENE_TEX_SIZE, GL_RGBA, GL_UNSIGNED_SHORT_4_4_4_4);
+
+    for(i = 0; i < PARTICLE_COUNT; i++) {
+        particle_spawn(&PARTICLES[i]);
+        PARTICLES[i].age = scene_rand() * PARTICLES[i].life;
+    }
+}
+
+static void particle_frame(GLuint n) {
+    GLfloat m[16], rx, ry, rz, ux, uy, uz;
+    GLuint i;
+
+    scene_perspective(60.0f);
+    gluLookAt(sinf(n * 0.01f) * 6.0f, 3.0f, cosf(n * 0.01f) * 6.0f, 0.0f, 2.0f, 0.0f, 0.0f, 1.0f, 0.0f);
+
+    /* Opaque ground */
+    glDisable(GL_BLEND);
+    glDisable(GL_TEXTURE_2D);
+    glColor4f(0.3f, 0.3f, 0.3f, 1.0f);
+
+    glBegin(GL_QUADS);
+    glVertex3f(-10.0f, 0.0f, 10.0f);
+    glVertex3f(10.0f, 0.0f, 10.0f);
+    glVertex3f(10.0f, 0.0f, -10.0f);
+    glVertex3f(-10.0f, 0.0f, -10.0f);
+    glEnd();
+
+    /* Billboard axes are the camera right and up vectors */
+    glKosGetMatrix(GL_MODELVIEW, m);
+    rx = m[0] * 0.1f;
+    ry = m[4] * 0.1f;
+    rz = m[8] * 0.1f;
+    ux = m[1] * 0.1f;
+    uy = m[5] * 0.1f;
+    uz = m[9] * 0.1f;
+
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE);
+    glEnable(GL_TEXTURE_2D);
+    glBindTexture(GL_TEXTURE_2D, PARTICLE_TEXTURE);
+
+    glBegin(GL_QUADS);
+
+    for(i = 0; i < PARTICLE_COUNT; i++) {
+        PARTICLE *p = &PARTICLES[i];
+        GLfloat fade = 1.0f - p->age / p->life;
+
+        p->pos[0] += p->vel[0];
+        p->pos[1] += p->vel[1];
+        p->pos[2] += p->vel[2];
+        p->vel[1] -= 0.0005f;
+
+        if(++p->age > p->life)
+            particle_spawn(p);
+
+        glColor4f(1.0f, 0.5f + fade * 0.5f, fade * 0.3f, fade);
+
+        glTexCoord2f(0.0f, 0.0f);
+        glVertex3f(p->pos[0] - rx - ux, p->pos[1] - ry - uy, p->pos[2] - rz - uz);
+        glTexCoord2f(1.0f, 0.0f);
+        glVertex3f(p->pos[0] + rx - ux, p->pos[1] + ry - uy, p->pos[2] + rz - uz);
+        glTexCoord2f(1.0f, 1.0f);
+        glVertex3f(p->pos[0] + rx + ux, p->pos[1] + ry + uy, p->pos[2] + rz + uz);
+        glTexCoord2f(0.0f, 1.0f);
+        glVertex3f(p->pos[0] - rx + ux, p->pos[1] - ry + uy, p->pos[2] - rz + uz);
+
+        /* Keep each block inside a Vertex Buffer chunk */
+        if(i % 256 == 255) {
+            glEnd();
+            glBegin(GL_QUADS);
+        }
+    }
+
+    glEnd();
+
+    scene_swap();
+}
+
+//===============================================================================//
+//== UI: glRectf panels and glKosVertex2f text ==//
+
+#define UI_PANELS 24
+#define UI_GLYPHS 1500
+
+static GLuint UI_FONT;
+
+static void ui_setup() {
+    SCENE_SEED = 4;
+
+    UI_FONT = scene_texture(SCENE_TEX_SIZE * 2, GL_RGBA, GL_UNSIGNED_SHORT_4_4_4_4);
+
+    glMatrixMode(GL_PROJECTION);
+    glLoadIdentity();
+    glOrtho(0.0f, 640.0f, 0.0f, 480.0f, -1.0f, 1.0f);
+    glMatrixMode(GL_MODELVIEW);
+    glLoadIdentity();
+}
+
+static void ui_frame(GLuint n) {
+    GLuint i;
+
+    /* Background gradient, which also sets the untextured header for the panels */
+    glDisable(GL_TEXTURE_2D);
+    glDisable(GL_BLEND);
+
+    glBegin(GL_QUADS);
+    glColor4f(0.1f, 0.1f, 0.3f, 1.0f);
+    glKosVertex2f(0.0f, 0.0f);
+    glKosVertex2f(640.0f, 0.0f);
+    glColor4f(0.0f, 0.0f, 0.1f, 1.0f);
+    glKosVertex2f(640.0f, 480.0f);
+    glKosVertex2f(0.0f, 480.0f);
+    glEnd();
+
+    for(i = 0; i < UI_PANELS; i++) {
+        GLfloat x = (i % 6) * 105.0f + 5.0f, y = (i / 6) * 118.0f + 5.0f;
+
+        glColor4f(0.2f + (i & 1) * 0.2f, 0.3f, 0.4f + ((i + n / 30) & 3) * 0.1f, 1.0f);
+        glRectf(x, y, x + 100.0f, y + 110.0f);
+    }
+
+    /* Text: one textured quad per glyph, from a 16x16 glyph atlas */
+    glEnable(GL_TEXTURE_2D);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glBindTexture(GL_TEXTURE_2D, UI_FONT);
+    glColor4f(1.0f, 1.0f, 1.0f, 1.0f);
+
+    glBegin(GL_QUADS);
+
+    for(i = 0; i < UI_GLYPHS; i++) {
+        GLuint glyph = (i * 7 + n) & 255;
+        GLfloat u = (glyph & 15) / 16.0f, v = (glyph >> 4) / 16.0f;
+        GLfloat x = (i % 75) * 8.0f + 20.0f, y = (i / 75) * 22.0f + 10.0f;
+
+        glTexCoord2f(u, v);
+        glKosVertex2f(x, y);
+        glTexCoord2f(u + 1.0f / 16.0f, v);
+        glKosVertex2f(x + 8.0f, y);
+        glTexCoord2f(u + 1.0f / 16.0f, v + 1.0f / 16.0f);
+        glKosVertex2f(x + 8.0f, y + 16.0f);
+        glTexCoord2f(u, v + 1.0f / 16.0f);
+        glKosVertex2f(x, y + 16.0f);
+
+        if(i % 256 == 255) {
+            glEnd();
+            glBegin(GL_QUADS);
+        }
+    }
+
+    glEnd();
+
+    scene_swap();
+}
+
+//===============================================================================//
+//== Post-Process: render to texture, then blur it onto the screen ==//
+
+#define POST_GRID 32
+#define POST_RTT_SIZE 256
+
+static GLuint  POST_FBO, POST_TARGET, POST_TEXTURE;
+static GLfloat POST_POS[POST_GRID * POST_GRID * 6 * 3];
+static GLfloat POST_UV[POST_GRID * POST_GRID * 6 * 2];
+
+static void post_setup() {
+    static const GLubyte corner[6][2] = {
+        { 0, 0 }, { 1, 0 }, { 1, 1 }, { 0, 0 }, { 1, 1 }, { 0, 1 }
+    };
+    GLushort *blank = calloc(POST_RTT_SIZE * POST_RTT_SIZE, sizeof(GLushort));
+    GLuint x, y, c, v = 0;
+
+    SCENE_SEED = 5;
+
+    POST_TEXTURE = scene_texture(SCENE_TEX_SIZE, GL_RGB, GL_UNSIGNED_SHORT_5_6_5);
+
+    glGenTextures(1, &POST_TARGET);
+    glBindTexture(GL_TEXTURE_2D, POST_TARGET);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, POST_RTT_SIZE, POST_RTT_SIZE, 0,
+                 GL_RGB, GL_UNSIGNED_SHORT_5_6_5, blank);
+    free(blank);
+
+    glGenFramebuffers(1, &POST_FBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, POST_FBO);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, POST_TARGET, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    for(y = 0; y < POST_GRID; y++)
+        for(x = 0; x < POST_GRID; x++)
+            for(c = 0; c < 6; c++, v++) {
+                GLfloat s = (GLfloat)(x + corner[c][0]) / POST_GRID;
+                GLfloat t = (GLfloat)(y + corner[c][1]) / POST_GRID;
+
+                POST_POS[v * 3 + 0] = s * 2.0f - 1.0f;
+                POST_POS[v * 3 + 1] = t * 2.0f - 1.0f;
+                POST_POS[v * 3 + 2] = sinf(s * 12.0f) * cosf(t * 12.0f) * 0.1f;
+                POST_UV[v * 2 + 0] = s;
+                POST_UV[v * 2 + 1] = t;
+            }
+
+    glEnable(GL_TEXTURE_2D);
+}
+
+static void post_frame(GLuint n) {
+    static const GLfloat taps[4][2] = {
+        { -1.5f, -1.5f }, { 1.5f, -1.5f }, { 1.5f, 1.5f }, { -1.5f, 1.5f }
+    };
+    GLuint i;
+
+    /* Scene pass, into the render target */
+    glBindFramebuffer(GL_FRAMEBUFFER, POST_FBO);
+    glDisable(GL_BLEND);
+
+    scene_perspective(60.0f);
+    glTranslatef(0.0f, 0.0f, -2.5f);
+    glRotatef(n * 0.5f, 0.3f, 1.0f, 0.0f);
+
+    glBindTexture(GL_TEXTURE_2D, POST_TEXTURE);
+    glVertexPointer(3, GL_FLOAT, 0, POST_POS);
+    glTexCoordPointer(2, GL_FLOAT, 0, POST_UV);
+    glDrawArrays(GL_TRIANGLES, 0, POST_GRID * POST_GRID * 6);
+
+    scene_swap();
+
+    /* Post pass: the target blended onto the screen at four offsets */
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glBindTexture(GL_TEXTURE_2D, POST_TARGET);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE);
+    glColor4f(1.0f, 1.0f, 1.0f, 0.25f);
+
+    for(i = 0; i < 4; i++) {
+        GLfloat x = taps[i][0], y = taps[i][1];
+
+        glBegin(GL_QUADS);
+        glTexCoord2f(0.0f, 0.0f);
+        glKosVertex2f(x, y);
+        glTexCoord2f(1.0f, 0.0f);
+        glKosVertex2f(x + 640.0f, y);
+        glTexCoord2f(1.0f, 1.0f);
+        glKosVertex2f(x + 640.0f, y + 480.0f);
+        glTexCoord2f(0.0f, 1.0f);
+        glKosVertex2f(x, y + 480.0f);
+        glEnd();
+    }
+
+    scene_swap();
+}
+
+//===============================================================================//
+//== Pipeline: frames alternating CPU and PVR load, with 1 and 2 frame contexts ==//
+
+/* The host PVR renders at PIPE_RENDER_COST per KB of TA stream. Two frames of
+   PIPE_QUADS quads keep it busy while the CPU has little to do, then two frames
+   of spinning for PIPE_SPIN_MS draw a handful. With one frame context each heavy
+   frame holds the client up until the PVR takes it; with two, the client goes on
+   recording while the heavy frames render. Compare the mean frame times. */
+
+#define PIPE_QUADS       1500
+#define PIPE_LIGHT_QUADS 16
+#define PIPE_SPIN_MS     6.0
+#define PIPE_RENDER_COST 30000 /* Nanoseconds per KB */
+
+static void pipe_setup(GLuint contexts) {
+    glKosFrameContexts(contexts);
+
+    pvr_host_render_cost(PIPE_RENDER_COST);
+
+    glMatrixMode(GL_PROJECTION);
+    glLoadIdentity();
+    glOrtho(0.0f, 640.0f, 0.0f, 480.0f, -1.0f, 1.0f);
+    glMatrixMode(GL_MODELVIEW);
+    glLoadIdentity();
+}
+
+static void pipe_setup_1() {
+    pipe_setup(1);
+}
+
+static void pipe_setup_2() {
+    pipe_setup(2);
+}
+
+static void pipe_frame(GLuint n) {
+    GLuint quads = (n & 2) ? PIPE_LIGHT_QUADS : PIPE_QUADS, i;
+
+    if(n & 2) { /* Game logic */
+        double until = scene_now() + PIPE_SPIN_MS * 0.001;
+
+        while(scene_now() < until);
+    }
+
+    glBegin(GL_QUADS);
+
+    for(i = 0; i < quads; i++) {
+        GLfloat x = (i % 40) * 16.0f, y = (i / 40 % 30) * 16.0f;
+
+        glColor4f((i & 7) / 7.0f, (n & 15) / 15.0f, 0.5f, 1.0f);
+        glKosVertex2f(x, y);
+        glKosVertex2f(x + 16.0f, y);
+        glKosVertex2f(x + 16.0f, y + 16.0f);
+        glKosVertex2f(x, y + 16.0f);
+    }
+
+    glEnd();
+
+    scene_swap();
+}
+
+//===============================================================================//
+//== Harness ==//
+
+static void scene_reset_state() {
+    GLuint i;
+
+    glDisable(GL_TEXTURE_2D);
+    glDisable(GL_BLEND);
+    glDisable(GL_LIGHTING);
+    glDisable(GL_KOS_NEARZ_CLIPPING);
+    glDisable(GL_CULL_FACE);
+
+    for(i = 0; i < 8; i++)
+        glDisable(GL_LIGHT0 + i);
+
+    glActiveTextureARB(GL_TEXTURE1_ARB);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glActiveTextureARB(GL_TEXTURE0_ARB);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glClientActiveTextureARB(GL_TEXTURE0_ARB);
+
+    glColor4f(1.0f, 1.0f, 1.0f, 1.0f);
+
+    glKosFrameContexts(2);
+    pvr_host_render_cost(0);
+
+    scene_perspective(60.0f);
+}
+
+static int scene_compare_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+
+    return x < y ? -1 : x > y;
+}
+
+static double scene_percentile(const double *sorted, GLuint count, double p) {
+    GLuint i = (GLuint)(p * (count - 1) + 0.5);
+
+    return sorted[i];
+}
+
+static void scene_run(const SCENE *scene, GLuint frames, const char *capture) {
+    SCENE_RESULT *r = &SCENE_RESULTS[SCENE_RESULT_COUNT++];
+    double *times = malloc(frames * sizeof(double)), bytes = 0.0, total = 0.0;
+    GLuint n;
+
+    memset(r, 0, sizeof(SCENE_RESULT));
+    r->name = scene->name;
+
+    SCENE_CURRENT = r;
+
+    scene_reset_state();
+    scene->setup();
+
+    for(n = 0; n < frames; n++) {
+        double start = scene_now();
+
+        SCENE_FRAME_BYTES = 0;
+
+        scene->frame(n);
+
+        times[n] = (scene_now() - start) * 1000.0;
+        total += times[n];
+
+        bytes += SCENE_FRAME_BYTES;
+
+        if(SCENE_FRAME_BYTES > r->ta_bytes_peak)
+            r->ta_bytes_peak = SCENE_FRAME_BYTES;
+    }
+
+    if(capture) {
+        char filename[1024];
+
+        snprintf(filename, sizeof(filename), "%s-%s.kglc", capture, scene->name);
+
+        if(glKosCaptureBegin(filename)) {
+            scene->frame(frames);
+            glKosCaptureEnd();
+        }
+    }
+
+    qsort(times, frames, sizeof(double), scene_compare_double);
+
+    r->mean = total / frames;
+    r->p50 = scene_percentile(times, frames, 0.5);
+    r->p90 = scene_percentile(times, frames, 0.9);
+    r->p99 = scene_percentile(times, frames, 0.99);
+    r->max = times[frames - 1];
+    r->ta_bytes = bytes / frames;
+
+    free(times);
+
+    fprintf(stderr, "%-13s mean %7.3f ms  p50 %7.3f ms  p90 %7.3f ms  p99 %7.3f ms  max %7.3f ms  "
+            "%9.0f TA bytes/frame  peak array %u clip %u uv %u\n", r->name, r->mean, r->p50, r->p90, r->p99, r->max,
+            r->ta_bytes, r->array_buf_peak, r->clip_buf_peak, r->uv_buf_peak);
+}
+
+//===============================================================================//
+//== Main ==//
+
+static const SCENE SCENES[] = {
+    { "bsp_level",  bsp_setup,      bsp_frame },
+    { "crowd",      crowd_setup,    crowd_frame },
+    { "particles",  particle_setup, particle_frame },
+    { "ui",         ui_setup,       ui_frame },
+    { "post_rtt",   post_setup,     post_frame },
+    { "pipeline_1ctx", pipe_setup_1, pipe_frame },
+    { "pipeline_2ctx", pipe_setup_2, pipe_frame },
+};
+
+static int scene_write_json(const char *filename) {
+    FILE *f = filename ? fopen(filename, "w") : stdout;
+    GLuint i;
+
+    if(!f) {
+        perror(filename);
+        return 0;
+    }
+
+    fprintf(f, "{\n  \"benchmarks\": [\n");
+
+    for(i = 0; i < SCENE_RESULT_COUNT; i++) {
+        const SCENE_RESULT *r = &SCENE_RESULTS[i];
+
+        fprintf(f, "    { \"name\": \"%s\", \"unit\": \"frame\", \"rate\": %.2f, \"bytes_per_unit\": %.1f,\n"
+                "      \"mean_ms\": %.4f, \"p50_ms\": %.4f, \"p90_ms\": %.4f, \"p99_ms\": %.4f, \"max_ms\": %.4f,\n"
+                "      \"ta_bytes_peak\": %u, \"array_buf_peak\": %u, \"clip_buf_peak\": %u, \"uv_buf_peak\": %u }%s\n",
+                r->name, 1000.0 / r->mean, r->ta_bytes, r->mean, r->p50, r->p90, r->p99, r->max,
+                r->ta_bytes_peak, r->array_buf_peak, r->clip_buf_peak, r->uv_buf_peak,
+                i + 1 < SCENE_RESULT_COUNT ? "," : "");
+    }
+
+    fprintf(f, "  ]\n}\n");
+
+    if(filename)
+        fclose(f);
+
+    return 1;
+}
+
+int main(int argc, char **argv) {
+    GLuint frames = argc > 1 ? (GLuint)atoi(argv[1]) : SCENE_DEFAULT_FRAMES, i;
+
+    if(!frames)
+        frames = SCENE_DEFAULT_FRAMES;
+
+    glKosInit();
+
+    for(i = 0; i < sizeof(SCENES) / sizeof(SCENES[0]); i++)
+        scene_run(&SCENES[i], frames, argc > 3 ? argv[3] : NULL);
+
+    return scene_write_json(argc > 2 ? argv[2] : NULL) ? 0 : 1;
+}
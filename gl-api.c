@@ -18,8 +18,12 @@
 #include <GL/gl.h>
 #include <GL/glu.h>
 #include "gl-api.h"
+#include "gl-list.h"
+#include "gl-primitive.h"
 #include "gl-sh4.h"
 #include "gl-pvr.h"
+#include "gl-stats.h"
+#include "gl-trace.h"
 
 //====================================================================================================//
 //== Local API State Macine Variables ==//
@@ -31,19 +35,44 @@ static GLubyte GL_KOS_SHADE_FUNC  = PVR_SHADE_GOURAUD;
 static GLubyte GL_KOS_CULL_FUNC   = PVR_CULLING_NONE;
 static GLubyte GL_KOS_FACE_FRONT  = 0;
 static GLubyte GL_KOS_SUPERSAMPLE = 0;
+static GLenum  GL_KOS_ALPHA_FUNC  = GL_ALWAYS;
 
 static GLuint  GL_KOS_VERTEX_COUNT = 0;
 static GLuint  GL_KOS_VERTEX_MODE  = GL_TRIANGLES;
+static GLubyte GL_KOS_VERTEX_CULLED = 0; /* The block is outside its bounding volume test */
 static GLuint  GL_KOS_VERTEX_COLOR = 0xFFFFFFFF;
 static GLfloat GL_KOS_VERTEX_UV[2] = { 0, 0 };
 //static glTexCoord4f GL_KOS_VERTEX_TEX_COORD = { 0, 0, 0, 1 };
 
 static GLfloat GL_KOS_COLOR_CLEAR[3] = { 0, 0, 0 };
 
-static GLfloat GL_KOS_POINT_SIZE = 0.02;
+static GLfloat GL_KOS_POINT_SIZE = 1.0f;
+static GLfloat GL_KOS_LINE_WIDTH = 1.0f;
 
 static pvr_poly_cxt_t GL_KOS_POLY_CXT;
 
+#define GL_KOS_HDR_DEPTH_TEST   (1<<0)          /* GL_KOS_HDR_STATE caps bits */
+#define GL_KOS_HDR_SCISSOR_TEST (1<<1)
+#define GL_KOS_HDR_FOG          (1<<2)
+#define GL_KOS_HDR_CULLING      (1<<3)
+#define GL_KOS_HDR_BLEND        (1<<4)
+
+typedef struct {
+    GL_KOS_HDR_STATE state;
+    GLuint cmd,                                 /* Texture bits of each header word, 0 if untextured */
+           mode2,
+           mode3;
+} GL_KOS_HDR_KEY; /* Everything a polygon header is built from */
+
+static pvr_poly_hdr_t   GL_KOS_HDR_TEMPLATE[GL_KOS_LISTS];       /* Untextured header per list */
+static GL_KOS_HDR_STATE GL_KOS_HDR_TEMPLATE_STATE[GL_KOS_LISTS]; /* State it was compiled from */
+static GLubyte          GL_KOS_HDR_TEMPLATE_VALID = 0;
+
+static GL_KOS_HDR_KEY GL_KOS_HDR_LAST[GL_KOS_LISTS]; /* Last header emitted per list */
+static GLubyte GL_KOS_HDR_VALID = 0;                 /* Bit per list with a header this frame */
+static GLuint  GL_KOS_HDR_COUNT[2] = { 0, 0 },       /* Headers requested, emitted */
+               GL_KOS_HDR_COUNT_LAST[2] = { 0, 0 };  /* Same, for the last frame */
+
 static inline void _glKosFlagsSetTriangleStrip();
 static inline void _glKosFlagsSetTriangle();
 static inline void _glKosFlagsSetQuad();
@@ -53,7 +82,37 @@ static inline void _glKosFinishRect();
 //== API Initialization ==//
 
 void APIENTRY glKosInit() {
-    _glKosInitPVR();
+    glKosInitEx(NULL);
+}
+
+void APIENTRY glKosInitDefaults(GL_KOS_INIT_PARAMS *params) {
+    params->bin_size[GL_KOS_LIST_OP] = GL_PVR_BIN_SIZE;
+    params->bin_size[GL_KOS_LIST_TR] = GL_PVR_BIN_SIZE;
+    params->bin_size[GL_KOS_LIST_PT] = GL_PVR_BIN_SIZE;
+    params->vertex_buf_size = GL_PVR_VERTEX_BUF_SIZE;
+}
+
+GLint APIENTRY glKosInitEx(const GL_KOS_INIT_PARAMS *params) {
+    GL_KOS_INIT_PARAMS defaults;
+    GLuint i;
+
+    if(!params) {
+        glKosInitDefaults(&defaults);
+        params = &defaults;
+    }
+
+    for(i = 0; i < GL_KOS_LISTS; i++)
+        if(params->bin_size[i] != PVR_BINSIZE_8 && params->bin_size[i] != PVR_BINSIZE_16
+           && params->bin_size[i] != PVR_BINSIZE_32)
+            break;
+
+    if(i < GL_KOS_LISTS || !params->vertex_buf_size || (params->vertex_buf_size & 31)) {
+        _glKosThrowError(GL_INVALID_VALUE, "glKosInitEx");
+        _glKosPrintError();
+        return 0;
+    }
+
+    _glKosInitPVR(params);
 
     _glKosInitTextures();
 
@@ -62,6 +121,12 @@ void APIENTRY glKosInit() {
     _glKosInitLighting();
 
     _glKosInitFrameBuffers();
+
+#ifdef GL_ENABLE_TRACE
+    _glKosTraceInit();
+#endif
+
+    return 1;
 }
 
 //====================================================================================================//
@@ -157,6 +222,23 @@ void APIENTRY glBlendFunc(GLenum sfactor, GLenum dfactor) {
             GL_KOS_BLEND_FUNC |= (PVR_BLEND_INVDESTCOLOR & 0XF);
             break;
     }
+
+    _glKosSelectList();
+}
+
+/* Route the following geometry to the PVR list matching the blend and alpha test state.
+   Blending with GL_ONE, GL_ZERO just replaces the framebuffer, so it is demoted out of
+   the per-pixel sorted TR list. Unblended alpha tested geometry goes to the PT list,
+   which can only keep pixels at or above the reference alpha. */
+void _glKosSelectList() {
+    if(_glKosEnabledBlend()
+            && GL_KOS_BLEND_FUNC != ((PVR_BLEND_ONE << 4) | (PVR_BLEND_ZERO & 0x0F)))
+        _glKosVertexBufSwitchTR();
+    else if(_glKosEnabledAlphaTest()
+            && (GL_KOS_ALPHA_FUNC == GL_GREATER || GL_KOS_ALPHA_FUNC == GL_GEQUAL))
+        _glKosVertexBufSwitchPT();
+    else
+        _glKosVertexBufSwitchOP();
 }
 
 //====================================================================================================//
@@ -164,7 +246,7 @@ void APIENTRY glBlendFunc(GLenum sfactor, GLenum dfactor) {
 
 void APIENTRY glClear(GLuint mode) {
     if(mode & GL_COLOR_BUFFER_BIT)
-        pvr_set_bg_color(GL_KOS_COLOR_CLEAR[0], GL_KOS_COLOR_CLEAR[1], GL_KOS_COLOR_CLEAR[2]);
+        _glKosFrameClearColor(GL_KOS_COLOR_CLEAR[0], GL_KOS_COLOR_CLEAR[1], GL_KOS_COLOR_CLEAR[2]);
 }
 
 void APIENTRY glClearColor(float r, float g, float b, float a) {
@@ -301,14 +383,29 @@ void APIENTRY(*glVertex3f)(GLfloat, GLfloat, GLfloat);
 void APIENTRY(*glVertex3fv)(const GLfloat *);
 
 void APIENTRY glVertex2f(GLfloat x, GLfloat y) {
+    if(GL_KOS_LIST_RECORD)
+        return _glKosListVertex3f(x, y, 0.0f);
+
+    if(GL_KOS_VERTEX_CULLED)
+        return;
+
     return _glKosVertex3ft(x, y, 0.0f);
 }
 
 void APIENTRY glVertex2fv(const GLfloat *xy) {
+    if(GL_KOS_LIST_RECORD)
+        return _glKosListVertex3f(xy[0], xy[1], 0.0f);
+
+    if(GL_KOS_VERTEX_CULLED)
+        return;
+
     return _glKosVertex3ft(xy[0], xy[1], 0.0f);
 }
 
 void APIENTRY glRectf(GLfloat x1, GLfloat y1, GLfloat x2, GLfloat y2) {
+    if(!_glKosVertexBufReserve(4, "glRectf"))
+        return;
+
     pvr_vertex_t *v = _glKosVertexBufPointer();
 
     v[0].z = v[3].z = 0;
@@ -317,9 +414,14 @@ void APIENTRY glRectf(GLfloat x1, GLfloat y1, GLfloat x2, GLfloat y2) {
     mat_trans_single3_nomod(x2, y2, v[3].z, v[3].x, v[3].y, v[3].z);
 
     _glKosFinishRect();
+
+    _glKosVertexBufStream();
 }
 
 void APIENTRY glRectfv(const GLfloat *v1, const GLfloat *v2) {
+    if(!_glKosVertexBufReserve(4, "glRectfv"))
+        return;
+
     pvr_vertex_t *v = _glKosVertexBufPointer();
 
     v[0].z = v[3].z = 0;
@@ -328,6 +430,8 @@ void APIENTRY glRectfv(const GLfloat *v1, const GLfloat *v2) {
     mat_trans_single3_nomod(v2[0], v2[1], v[3].z, v[3].x, v[3].y, v[3].z);
 
     _glKosFinishRect();
+
+    _glKosVertexBufStream();
 }
 
 void APIENTRY glRecti(GLint x1, GLint y1, GLint x2, GLint y2) {
@@ -372,6 +476,24 @@ void APIENTRY glKosVertex2fv(const GLfloat *xy) {
 //== GL Begin / End ==//
 
 void APIENTRY glBegin(GLenum mode) {
+    if(GL_KOS_LIST_RECORD) { /* Compiling a Display List */
+        _glKosListBegin(mode);
+
+        glVertex3f = _glKosListVertex3f;
+        glVertex3fv = _glKosListVertex3fv;
+
+        return;
+    }
+
+    if(_glKosBoundsOutside()) { /* Drop the vertices of the block */
+        GL_KOS_VERTEX_CULLED = 1;
+
+        glVertex3f = _glKosVertex3fx;
+        glVertex3fv = _glKosVertex3fxv;
+
+        return;
+    }
+
     _glKosMatrixApplyRender();
 
     _glKosArrayBufReset();
@@ -381,11 +503,7 @@ void APIENTRY glBegin(GLenum mode) {
     GL_KOS_VERTEX_MODE = mode;
     GL_KOS_VERTEX_COUNT = 0;
 
-    if(mode == GL_POINTS) {
-        glVertex3f = _glKosVertex3fp;
-        glVertex3fv = _glKosVertex3fpv;
-    }
-    else if(_glKosEnabledNearZClip()
+    if(_glKosEnabledNearZClip()
             && _glKosEnabledLighting()) {
         glVertex3f = _glKosVertex3flc;
         glVertex3fv = _glKosVertex3flcv;
@@ -404,7 +522,37 @@ void APIENTRY glBegin(GLenum mode) {
     }
 }
 
-void APIENTRY glEnd() {
+/* Convert the block of a primitive type the PVR has no strip order for. Its vertices
+   are moved aside, and what they convert to is written where they were. */
+static void _glKosEndConverted() {
+    pvr_vertex_t *v = (pvr_vertex_t *)_glKosVertexBufPointer() - GL_KOS_VERTEX_COUNT;
+    pvr_vertex_t *src;
+    GLuint i;
+
+    if(!GL_KOS_VERTEX_COUNT)
+        return;
+
+    src = _glKosPrimitiveScratch(GL_KOS_VERTEX_COUNT);
+
+    if(src != NULL)
+        memcpy(src, v, GL_KOS_VERTEX_COUNT * sizeof(pvr_vertex_t));
+
+    for(i = 0; i < GL_KOS_VERTEX_COUNT; i++)
+        _glKosVertexBufDecrement();
+
+    if(src == NULL) {
+        _glKosThrowError(GL_OUT_OF_MEMORY, "glEnd");
+        _glKosPrintError();
+        return;
+    }
+
+    _glKosPrimitiveImmediate(GL_KOS_VERTEX_MODE, src, GL_KOS_VERTEX_COUNT, 0);
+}
+
+/* Submit the block of vertices glBegin() started */
+static void _glKosEndBlock() {
+    GL_KOS_TRACE("glEnd");
+
     if(_glKosEnabledNearZClip()) { /* Z-Clipping Enabled */
         if(_glKosEnabledLighting()) {
             _glKosVertexComputeLighting(_glKosClipBufAddress(), GL_KOS_VERTEX_COUNT);
@@ -413,31 +561,79 @@ void APIENTRY glEnd() {
         }
 
         GLuint cverts;
-        pvr_vertex_t *v = _glKosVertexBufPointer();
+        pvr_vertex_t *v;
+
+        /* Clipping emits at most 4 vertices per input triangle.
+           The converted types reserve their output a piece at a time. */
+        cverts = _glKosPrimitiveConverted(GL_KOS_VERTEX_MODE) ? 0 :
+                 GL_KOS_VERTEX_MODE == GL_TRIANGLES ? (GL_KOS_VERTEX_COUNT / 3) * 4 :
+                 GL_KOS_VERTEX_MODE == GL_QUADS ? GL_KOS_VERTEX_COUNT * 2 :
+                 GL_KOS_VERTEX_COUNT * 4;
+
+        if(!_glKosVertexBufReserve(cverts, "glEnd")) {
+            _glKosClipBufReset();
+            return;
+        }
+
+        v = _glKosVertexBufPointer();
 
         switch(GL_KOS_VERTEX_MODE) {
             case GL_TRIANGLES:
                 cverts = _glKosClipTriangles(_glKosClipBufAddress(), v, GL_KOS_VERTEX_COUNT);
+                GL_KOS_STAT_CLIP(GL_TRIANGLES, GL_KOS_VERTEX_COUNT, v, cverts);
                 _glKosTransformClipBuf(v, cverts);
                 _glKosVertexBufAdd(cverts);
                 break;
 
             case GL_TRIANGLE_STRIP:
                 cverts = _glKosClipTriangleStrip(_glKosClipBufAddress(), v, GL_KOS_VERTEX_COUNT);
+                GL_KOS_STAT_CLIP(GL_TRIANGLE_STRIP, GL_KOS_VERTEX_COUNT, v, cverts);
                 _glKosTransformClipBuf(v, cverts);
                 _glKosVertexBufAdd(cverts);
                 break;
 
             case GL_QUADS:
                 cverts = _glKosClipQuads(_glKosClipBufAddress(), v, GL_KOS_VERTEX_COUNT);
+                GL_KOS_STAT_CLIP(GL_QUADS, GL_KOS_VERTEX_COUNT, v, cverts);
                 _glKosTransformClipBuf(v, cverts);
                 _glKosVertexBufAdd(cverts);
                 break;
+
+            case GL_QUAD_STRIP: /* A triangle strip of whole quads */
+                if(GL_KOS_VERTEX_COUNT < 4)
+                    break;
+
+                cverts = _glKosClipTriangleStrip(_glKosClipBufAddress(), v, GL_KOS_VERTEX_COUNT & ~1);
+                GL_KOS_STAT_CLIP(GL_TRIANGLE_STRIP, GL_KOS_VERTEX_COUNT & ~1, v, cverts);
+                _glKosTransformClipBuf(v, cverts);
+                _glKosVertexBufAdd(cverts);
+                break;
+
+            case GL_POINTS:
+            case GL_TRIANGLE_FAN:
+            case GL_POLYGON:
+            case GL_LINES:
+            case GL_LINE_STRIP:
+            case GL_LINE_LOOP:
+                _glKosPrimitiveImmediate(GL_KOS_VERTEX_MODE, _glKosClipBufAddress(),
+                                         GL_KOS_VERTEX_COUNT, 1);
+                break;
         }
 
         _glKosClipBufReset();
     }
     else { /* No Z-Clipping Enabled */
+        /* The Vertex Buffer ran out mid-block - drop what is left of it.
+           The block holds its header, unless a repeated header was skipped. */
+        if(GL_KOS_VERTEX_COUNT > _glKosVertexBufOpen()) {
+            while(_glKosVertexBufOpen())
+                _glKosVertexBufDecrement();
+
+            _glKosHdrInvalidate(_glKosList()); /* The header went too */
+
+            return;
+        }
+
         if(_glKosEnabledLighting())
             _glKosVertexComputeLighting((pvr_vertex_t *)_glKosVertexBufPointer() - GL_KOS_VERTEX_COUNT, GL_KOS_VERTEX_COUNT);
 
@@ -453,8 +649,42 @@ void APIENTRY glEnd() {
             case GL_QUADS:
                 _glKosFlagsSetQuad();
                 break;
+
+            case GL_QUAD_STRIP: /* A triangle strip of whole quads */
+                while(GL_KOS_VERTEX_COUNT & 1 || (GL_KOS_VERTEX_COUNT && GL_KOS_VERTEX_COUNT < 4)) {
+                    _glKosVertexBufDecrement();
+                    --GL_KOS_VERTEX_COUNT;
+                }
+
+                if(GL_KOS_VERTEX_COUNT)
+                    _glKosFlagsSetTriangleStrip();
+
+                break;
+
+            case GL_POINTS:
+            case GL_TRIANGLE_FAN:
+            case GL_POLYGON:
+            case GL_LINES:
+            case GL_LINE_STRIP:
+            case GL_LINE_LOOP:
+                _glKosEndConverted();
+                break;
         }
     }
+
+    _glKosVertexBufStream();
+}
+
+void APIENTRY glEnd() {
+    if(GL_KOS_LIST_RECORD)
+        return _glKosListEnd();
+
+    if(!GL_KOS_VERTEX_CULLED)
+        _glKosEndBlock();
+
+    GL_KOS_VERTEX_CULLED = 0;
+
+    _glKosBoundsEnd();
 }
 
 //====================================================================================================//
@@ -477,6 +707,9 @@ void APIENTRY glEnd() {
     disallows modification to all 'tiles' on the screen.
 */
 void APIENTRY glScissor(GLint x, GLint y, GLsizei width, GLsizei height) {
+    if(!_glKosVertexBufReserve(1, "glScissor"))
+        return;
+
     pvr_cmd_tclip_t *c = _glKosVertexBufPointer();
 
     GLint miny, maxx, maxy;
@@ -497,6 +730,8 @@ void APIENTRY glScissor(GLint x, GLint y, GLsizei width, GLsizei height) {
     c->ey = CLAMP((maxy / 32) - 1, 0, vid_mode->height / 32);
 
     _glKosVertexBufIncrement();
+
+    GL_KOS_STAT_ADD(clips[_glKosList()], 1);
 }
 
 void APIENTRY glHint(GLenum target, GLenum mode) {
@@ -508,6 +743,10 @@ void APIENTRY glHint(GLenum target, GLenum mode) {
                 GL_KOS_SUPERSAMPLE = 0;
 
             break;
+
+        case GL_KOS_DIRECT_RENDER_HINT:
+            _glKosVertexBufDirect(mode == GL_FASTEST);
+            break;
     }
 
 }
@@ -515,6 +754,17 @@ void APIENTRY glHint(GLenum target, GLenum mode) {
 //====================================================================================================//
 //== Internal API Vertex Submission functions ==//
 
+/* The vertices of a block dropped by its bounding volume */
+void _glKosVertex3fx(GLfloat x, GLfloat y, GLfloat z) {
+    (void)x;
+    (void)y;
+    (void)z;
+}
+
+void _glKosVertex3fxv(const GLfloat *xyz) {
+    (void)xyz;
+}
+
 void _glKosVertex3fs(GLfloat x, GLfloat y, GLfloat z) {
     pvr_vertex_t *v = _glKosVertexBufPointer();
 
@@ -599,29 +849,6 @@ void _glKosVertex3fcv(const GLfloat *xyz) {
     ++GL_KOS_VERTEX_COUNT;
 }
 
-/* GL_POINTS */
-GLvoid _glKosVertex3fp(GLfloat x, GLfloat y, GLfloat z) {
-    pvr_vertex_t *v = _glKosVertexBufPointer();
-
-    mat_trans_single3_nomod(x - GL_KOS_POINT_SIZE, y + GL_KOS_POINT_SIZE, z,
-                            v[0].x, v[0].y, v[0].z);
-    mat_trans_single3_nomod(x + GL_KOS_POINT_SIZE, y - GL_KOS_POINT_SIZE, z,
-                            v[3].x, v[3].y, v[3].z);
-
-    _glKosFinishRect();
-}
-
-GLvoid _glKosVertex3fpv(const GLfloat *xyz) {
-    pvr_vertex_t *v = _glKosVertexBufPointer();
-
-    mat_trans_single3_nomod(xyz[0] - GL_KOS_POINT_SIZE, xyz[1] + GL_KOS_POINT_SIZE, xyz[2],
-                            v[0].x, v[0].y, v[0].z);
-    mat_trans_single3_nomod(xyz[0] + GL_KOS_POINT_SIZE, xyz[1] - GL_KOS_POINT_SIZE, xyz[2],
-                            v[3].x, v[3].y, v[3].z);
-
-    _glKosFinishRect();
-}
-
 static inline void _glKosFinishRect() {
     pvr_vertex_t *v = _glKosVertexBufPointer();
 
@@ -644,9 +871,9 @@ static inline void _glKosFinishRect() {
 }
 
 void _glKosTransformClipBuf(pvr_vertex_t *v, GLuint verts) {
-    register float __x  __asm__("fr12");
-    register float __y  __asm__("fr13");
-    register float __z  __asm__("fr14");
+    register float __x  GL_KOS_FREG("fr12");
+    register float __y  GL_KOS_FREG("fr13");
+    register float __z  GL_KOS_FREG("fr14");
 
     while(verts--) {
         __x = v->x;
@@ -706,48 +933,56 @@ static inline void _glKosFlagsSetTriangleStrip() {
 //====================================================================================================//
 //== GL KOS PVR Header Parameter Compilation Functions ==//
 
-static inline void _glKosApplyDepthFunc() {
-    if(_glKosEnabledDepthTest())
-        GL_KOS_POLY_CXT.depth.comparison = GL_KOS_DEPTH_FUNC;
+static inline void _glKosApplyDepthFunc(const GL_KOS_HDR_STATE *state) {
+    if(state->caps & GL_KOS_HDR_DEPTH_TEST)
+        GL_KOS_POLY_CXT.depth.comparison = state->depth_func;
     else
         GL_KOS_POLY_CXT.depth.comparison = PVR_DEPTHCMP_ALWAYS;
 
-    GL_KOS_POLY_CXT.depth.write = GL_KOS_DEPTH_WRITE;
+    GL_KOS_POLY_CXT.depth.write = state->depth_write;
 }
 
-static inline void _glKosApplyScissorFunc() {
-    if(_glKosEnabledScissorTest())
+static inline void _glKosApplyScissorFunc(const GL_KOS_HDR_STATE *state) {
+    if(state->caps & GL_KOS_HDR_SCISSOR_TEST)
         GL_KOS_POLY_CXT.gen.clip_mode = PVR_USERCLIP_INSIDE;
 }
 
-static inline void _glKosApplyFogFunc() {
-    if(_glKosEnabledFog())
+static inline void _glKosApplyFogFunc(const GL_KOS_HDR_STATE *state) {
+    if(state->caps & GL_KOS_HDR_FOG)
         GL_KOS_POLY_CXT.gen.fog_type = PVR_FOG_TABLE;
 }
 
-static inline void _glKosApplyCullingFunc() {
-    if(_glKosEnabledCulling()) {
-        if(GL_KOS_CULL_FUNC == GL_BACK) {
-            if(GL_KOS_FACE_FRONT == GL_CW)
-                GL_KOS_POLY_CXT.gen.culling = PVR_CULLING_CCW;
+/* The PVR culling mode of the culling state */
+static inline GLubyte _glKosCullingMode(GLubyte enabled, GLubyte cull_func, GLubyte face_front) {
+    if(enabled) {
+        if(cull_func == GL_BACK) {
+            if(face_front == GL_CW)
+                return PVR_CULLING_CCW;
             else
-                GL_KOS_POLY_CXT.gen.culling = PVR_CULLING_CW;
+                return PVR_CULLING_CW;
         }
-        else if(GL_KOS_CULL_FUNC == GL_FRONT) {
-            if(GL_KOS_FACE_FRONT == GL_CCW)
-                GL_KOS_POLY_CXT.gen.culling = PVR_CULLING_CCW;
+        else if(cull_func == GL_FRONT) {
+            if(face_front == GL_CCW)
+                return PVR_CULLING_CCW;
             else
-                GL_KOS_POLY_CXT.gen.culling = PVR_CULLING_CW;
+                return PVR_CULLING_CW;
         }
+
+        return PVR_CULLING_CCW; /* As pvr_poly_cxt_col() leaves it */
     }
-    else
-        GL_KOS_POLY_CXT.gen.culling = PVR_CULLING_NONE;
+
+    return PVR_CULLING_NONE;
 }
 
-static inline void _glKosApplyBlendFunc() {
-    if(_glKosEnabledBlend()) {
-        GL_KOS_POLY_CXT.blend.src = (GL_KOS_BLEND_FUNC & 0xF0) >> 4;
-        GL_KOS_POLY_CXT.blend.dst = (GL_KOS_BLEND_FUNC & 0x0F);
+static inline void _glKosApplyCullingFunc(const GL_KOS_HDR_STATE *state) {
+    GL_KOS_POLY_CXT.gen.culling = _glKosCullingMode(state->caps & GL_KOS_HDR_CULLING,
+                                                    state->cull_func, state->face_front);
+}
+
+static inline void _glKosApplyBlendFunc(const GL_KOS_HDR_STATE *state) {
+    if(state->caps & GL_KOS_HDR_BLEND) {
+        GL_KOS_POLY_CXT.blend.src = (state->blend_func & 0xF0) >> 4;
+        GL_KOS_POLY_CXT.blend.dst = (state->blend_func & 0x0F);
     }
 }
 
@@ -757,64 +992,193 @@ static inline void _glKosApplyTextureFunc(GL_TEXTURE_OBJECT *tex) {
     GL_KOS_POLY_CXT.txr.mipmap_bias = PVR_MIPBIAS_NORMAL;
 }
 
-void _glKosCompileHdr() {
-    pvr_poly_hdr_t *hdr = _glKosVertexBufPointer();
+/* The global state the header of a draw made now is compiled from */
+void _glKosHdrState(GL_KOS_HDR_STATE *state) {
+    state->shade       = GL_KOS_SHADE_FUNC;
+    state->depth_func  = GL_KOS_DEPTH_FUNC;
+    state->depth_write = GL_KOS_DEPTH_WRITE;
+    state->blend_func  = GL_KOS_BLEND_FUNC;
+    state->cull_func   = GL_KOS_CULL_FUNC;
+    state->face_front  = GL_KOS_FACE_FRONT;
+    state->pad[0] = state->pad[1] = 0;
+
+    state->caps = (_glKosEnabledDepthTest() ? GL_KOS_HDR_DEPTH_TEST : 0)
+                  | (_glKosEnabledScissorTest() ? GL_KOS_HDR_SCISSOR_TEST : 0)
+                  | (_glKosEnabledFog() ? GL_KOS_HDR_FOG : 0)
+                  | (_glKosEnabledCulling() ? GL_KOS_HDR_CULLING : 0)
+                  | (_glKosEnabledBlend() ? GL_KOS_HDR_BLEND : 0);
+}
+
+/* Build the key of the header state needs on the current list. The texture words
+   come from the template compiled into the texture object, patched with the bits
+   that follow draw state instead of the texture. */
+static void _glKosHdrKey(GL_KOS_HDR_KEY *key, const GL_KOS_HDR_STATE *state,
+                         GL_TEXTURE_OBJECT *tex) {
+    key->state = *state;
+
+    if(!tex) {
+        key->cmd = key->mode2 = key->mode3 = 0;
+        return;
+    }
 
-    pvr_poly_cxt_col(&GL_KOS_POLY_CXT, _glKosList() * 2);
+    key->cmd   = GL_PVR_CMD_TXR_ENABLE;
+    key->mode2 = tex->hdr[0];
+    key->mode3 = tex->hdr[1];
 
-    GL_KOS_POLY_CXT.gen.shading = GL_KOS_SHADE_FUNC;
+    if(_glKosList() == GL_KOS_LIST_OP)
+        key->mode2 |= PVR_TXRALPHA_DISABLE << PVR_TA_PM2_TXRALPHA_SHIFT;
+    else
+        key->mode2 |= PVR_TXRALPHA_ENABLE << PVR_TA_PM2_TXRALPHA_SHIFT;
 
-    _glKosApplyDepthFunc();
+    if(state->caps & GL_KOS_HDR_BLEND)
+        key->mode2 |= tex->env << PVR_TA_PM2_TXRENV_SHIFT;
+    else
+        key->mode2 |= PVR_TXRENV_MODULATE << PVR_TA_PM2_TXRENV_SHIFT;
 
-    _glKosApplyScissorFunc();
+    if(GL_KOS_SUPERSAMPLE)
+        key->mode2 |= GL_PVR_SAMPLE_SUPER << PVR_TA_SUPER_SAMPLE_SHIFT;
+}
 
-    _glKosApplyFogFunc();
+/* Untextured header of the current list for state, compiled only when the state
+   differs from the last time the list asked for one. */
+static pvr_poly_hdr_t *_glKosHdrTemplate(const GL_KOS_HDR_STATE *state) {
+    GLubyte list = _glKosList();
 
-    _glKosApplyCullingFunc();
+    if((GL_KOS_HDR_TEMPLATE_VALID & (1 << list))
+            && !memcmp(state, &GL_KOS_HDR_TEMPLATE_STATE[list], sizeof(GL_KOS_HDR_STATE)))
+        return &GL_KOS_HDR_TEMPLATE[list];
 
-    _glKosApplyBlendFunc();
+    pvr_poly_cxt_col(&GL_KOS_POLY_CXT, list * 2);
 
-    pvr_poly_compile(hdr, &GL_KOS_POLY_CXT);
+    GL_KOS_POLY_CXT.gen.shading = state->shade;
 
-    _glKosVertexBufIncrement();
+    _glKosApplyDepthFunc(state);
+
+    _glKosApplyScissorFunc(state);
+
+    _glKosApplyFogFunc(state);
+
+    _glKosApplyCullingFunc(state);
+
+    _glKosApplyBlendFunc(state);
+
+    pvr_poly_compile(&GL_KOS_HDR_TEMPLATE[list], &GL_KOS_POLY_CXT);
+
+    GL_KOS_HDR_TEMPLATE_STATE[list] = *state;
+    GL_KOS_HDR_TEMPLATE_VALID |= 1 << list;
+
+    return &GL_KOS_HDR_TEMPLATE[list];
 }
 
-void _glKosCompileHdrT(GL_TEXTURE_OBJECT *tex) {
-    pvr_poly_hdr_t *hdr = _glKosVertexBufPointer();
+/* Compile the texture words of a texture object's header template.
+   Called when the texture is specified or its parameters change. */
+void _glKosCompileHdrTexture(GL_TEXTURE_OBJECT *tex) {
+    pvr_poly_hdr_t hdr;
 
     pvr_poly_cxt_txr(&GL_KOS_POLY_CXT,
-                     _glKosList() * 2,
+                     PVR_LIST_OP_POLY,
                      tex->color,
                      tex->width,
                      tex->height,
                      tex->data,
                      tex->filter);
 
-    GL_KOS_POLY_CXT.gen.shading = GL_KOS_SHADE_FUNC;
+    _glKosApplyTextureFunc(tex);
 
-    _glKosApplyDepthFunc();
+    pvr_poly_compile(&hdr, &GL_KOS_POLY_CXT);
 
-    _glKosApplyScissorFunc();
+    tex->hdr[0] = hdr.mode2 & GL_PVR_PM2_TXR_MASK;
+    tex->hdr[1] = hdr.mode3;
+}
 
-    _glKosApplyFogFunc();
+/* Check the header against the last header emitted to the current list.
+   Returns 1 if they match, so the draw can use the header already in the list. */
+static GLubyte _glKosHdrCached(const GL_KOS_HDR_KEY *key) {
+    GLubyte list = _glKosList();
 
-    _glKosApplyCullingFunc();
+    ++GL_KOS_HDR_COUNT[0];
 
-    _glKosApplyBlendFunc();
+    if((GL_KOS_HDR_VALID & (1 << list))
+            && !memcmp(key, &GL_KOS_HDR_LAST[list], sizeof(GL_KOS_HDR_KEY)))
+        return 1;
 
-    _glKosApplyTextureFunc(tex);
+    GL_KOS_HDR_LAST[list] = *key;
+    GL_KOS_HDR_VALID |= 1 << list;
 
-    if(_glKosEnabledBlend())
-        GL_KOS_POLY_CXT.txr.env = tex->env;
+    ++GL_KOS_HDR_COUNT[1];
 
-    pvr_poly_compile(hdr, &GL_KOS_POLY_CXT);
+    GL_KOS_STAT_ADD(frame.headers[list], 1);
 
-    if(GL_KOS_SUPERSAMPLE)
-        hdr->mode2 |= GL_PVR_SAMPLE_SUPER << PVR_TA_SUPER_SAMPLE_SHIFT;
+    return 0;
+}
+
+/* The next draw on list must emit its header */
+void _glKosHdrInvalidate(GLubyte list) {
+    GL_KOS_HDR_VALID &= ~(1 << list);
+}
+
+/* A new frame starts with empty lists */
+void _glKosHdrFrameReset() {
+    GL_KOS_HDR_VALID = 0;
+
+    GL_KOS_HDR_COUNT_LAST[0] = GL_KOS_HDR_COUNT[0];
+    GL_KOS_HDR_COUNT_LAST[1] = GL_KOS_HDR_COUNT[1];
+
+    GL_KOS_HDR_COUNT[0] = GL_KOS_HDR_COUNT[1] = 0;
+}
+
+GLuint _glKosHdrRequested() {
+    return GL_KOS_HDR_COUNT_LAST[0];
+}
+
+GLuint _glKosHdrEmitted() {
+    return GL_KOS_HDR_COUNT_LAST[1];
+}
+
+/* Headers are built from the per list template and the texture's precompiled words,
+   so only a state change costs a full context compile. A display list passes the
+   state its block was recorded with, and the texture object its name resolves to now. */
+void _glKosCompileHdrState(const GL_KOS_HDR_STATE *state, GL_TEXTURE_OBJECT *tex) {
+    GL_KOS_HDR_KEY key;
+
+    if(!_glKosVertexBufReserve(1, "_glKosCompileHdr"))
+        return;
+
+    _glKosHdrKey(&key, state, tex);
+
+    if(_glKosHdrCached(&key))
+        return;
+
+    pvr_poly_hdr_t *hdr = _glKosVertexBufPointer();
+
+    *hdr = *_glKosHdrTemplate(state);
+
+    if(tex) {
+        hdr->cmd   |= key.cmd;
+        hdr->mode1 |= PVR_TA_PM1_TXRENABLE_MASK;
+        hdr->mode2 |= key.mode2;
+        hdr->mode3  = key.mode3;
+    }
 
     _glKosVertexBufIncrement();
 }
 
+void _glKosCompileHdr() {
+    GL_KOS_HDR_STATE state;
+
+    _glKosHdrState(&state);
+
+    _glKosCompileHdrState(&state, NULL);
+}
+
+void _glKosCompileHdrT(GL_TEXTURE_OBJECT *tex) {
+    GL_KOS_HDR_STATE state;
+
+    _glKosHdrState(&state);
+
+    _glKosCompileHdrState(&state, tex);
+}
+
 void _glKosCompileHdrMT(pvr_poly_hdr_t *dst, GL_TEXTURE_OBJECT *tex) {
     pvr_poly_cxt_txr(&GL_KOS_POLY_CXT,
                      PVR_LIST_TR_POLY,
@@ -824,15 +1188,19 @@ void _glKosCompileHdrMT(pvr_poly_hdr_t *dst, GL_TEXTURE_OBJECT *tex) {
                      tex->data,
                      tex->filter);
 
-    GL_KOS_POLY_CXT.gen.shading = GL_KOS_SHADE_FUNC;
+    GL_KOS_HDR_STATE state;
+
+    _glKosHdrState(&state);
 
-    _glKosApplyDepthFunc();
+    GL_KOS_POLY_CXT.gen.shading = state.shade;
 
-    _glKosApplyScissorFunc();
+    _glKosApplyDepthFunc(&state);
 
-    _glKosApplyFogFunc();
+    _glKosApplyScissorFunc(&state);
 
-    _glKosApplyCullingFunc();
+    _glKosApplyFogFunc(&state);
+
+    _glKosApplyCullingFunc(&state);
 
     _glKosApplyTextureFunc(tex);
 
@@ -917,6 +1285,29 @@ GLubyte _glKosCullFaceFront() {
     return GL_KOS_FACE_FRONT;
 }
 
+/* 1, or -1 if the quads points and lines are drawn as must wind the other way not to
+   be culled: they wind clockwise on screen for a positive size */
+GLfloat _glKosFacing() {
+    return _glKosCullingMode(_glKosEnabledCulling(), GL_KOS_CULL_FUNC, GL_KOS_FACE_FRONT)
+           == PVR_CULLING_CW ? -1.0f : 1.0f;
+}
+
+GLfloat _glKosLineHalfWidth() {
+    return GL_KOS_LINE_WIDTH * 0.5f * _glKosFacing();
+}
+
+GLfloat _glKosLineWidth() {
+    return GL_KOS_LINE_WIDTH;
+}
+
+GLfloat _glKosPointHalfSize() {
+    return GL_KOS_POINT_SIZE * 0.5f * _glKosFacing();
+}
+
+GLfloat _glKosPointSize() {
+    return GL_KOS_POINT_SIZE;
+}
+
 GLuint _glKosDepthFunc() {
     switch(GL_KOS_DEPTH_FUNC) {
         case PVR_DEPTHCMP_GEQUAL:
@@ -944,12 +1335,95 @@ GLuint _glKosVertexColor() {
     return GL_KOS_VERTEX_COLOR;
 }
 
+const GLfloat *_glKosVertexTexCoord() {
+    return GL_KOS_VERTEX_UV;
+}
+
+/* The current vertex attributes, header state, enabled capabilities and texture
+   bindings, as glNewList() finds them */
+void _glKosStateSave(GL_KOS_STATE *state) {
+    const GLfloat *norm = _glKosVertexNormal();
+
+    state->color = GL_KOS_VERTEX_COLOR;
+    state->uv[0] = GL_KOS_VERTEX_UV[0];
+    state->uv[1] = GL_KOS_VERTEX_UV[1];
+    state->norm[0] = norm[0];
+    state->norm[1] = norm[1];
+    state->norm[2] = norm[2];
+
+    state->shade       = GL_KOS_SHADE_FUNC;
+    state->depth_func  = GL_KOS_DEPTH_FUNC;
+    state->depth_write = GL_KOS_DEPTH_WRITE;
+    state->blend_func  = GL_KOS_BLEND_FUNC;
+    state->cull_func   = GL_KOS_CULL_FUNC;
+    state->face_front  = GL_KOS_FACE_FRONT;
+    state->alpha_func  = GL_KOS_ALPHA_FUNC;
+
+    state->caps = _glKosEnabledCaps();
+
+    _glKosTextureSave(state);
+}
+
+/* Put back the state a GL_COMPILE display list was recorded over */
+void _glKosStateRestore(const GL_KOS_STATE *state) {
+    GL_KOS_VERTEX_COLOR = state->color;
+    GL_KOS_VERTEX_UV[0] = state->uv[0];
+    GL_KOS_VERTEX_UV[1] = state->uv[1];
+    glNormal3fv(state->norm);
+
+    GL_KOS_SHADE_FUNC  = state->shade;
+    GL_KOS_DEPTH_FUNC  = state->depth_func;
+    GL_KOS_DEPTH_WRITE = state->depth_write;
+    GL_KOS_BLEND_FUNC  = state->blend_func;
+    GL_KOS_CULL_FUNC   = state->cull_func;
+    GL_KOS_FACE_FRONT  = state->face_front;
+    GL_KOS_ALPHA_FUNC  = state->alpha_func;
+
+    _glKosRestoreCaps(state->caps);
+
+    _glKosTextureRestore(state);
+
+    _glKosSelectList();
+}
+
 void glAlphaFunc(GLenum func, GLclampf ref) {
-    ;
+    if(func < GL_NEVER || func > GL_ALWAYS) {
+        _glKosThrowError(GL_INVALID_ENUM, "glAlphaFunc");
+        _glKosPrintError();
+        return;
+    }
+
+    GLuint alpha = CLAMP(ref, 0.0f, 1.0f) * 255;
+
+    /* The PVR keeps pixels with alpha >= PVR_PT_ALPHA_REF */
+    if(func == GL_GREATER && alpha < 255)
+        ++alpha;
+
+    GL_KOS_ALPHA_FUNC = func;
+
+    _glKosFrameAlphaRef(alpha);
+
+    _glKosSelectList();
 }
 
 void glLineWidth(GLfloat width) {
-    ;
+    if(width <= 0.0f) {
+        _glKosThrowError(GL_INVALID_VALUE, "glLineWidth");
+        _glKosPrintError();
+        return;
+    }
+
+    GL_KOS_LINE_WIDTH = width;
+}
+
+void glPointSize(GLfloat size) {
+    if(size <= 0.0f) {
+        _glKosThrowError(GL_INVALID_VALUE, "glPointSize");
+        _glKosPrintError();
+        return;
+    }
+
+    GL_KOS_POINT_SIZE = size;
 }
 
 void glPolygonOffset(GLfloat factor, GLfloat units) {
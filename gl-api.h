@@ -34,6 +34,8 @@ typedef struct {
     GLubyte  mip_map;
     GLubyte  uv_clamp;
     GLuint   index;
+    GLuint   hdr[2];     /* Precompiled texture bits of the header mode2 and mode3 words */
+    GLuint   bytes;      /* Size of the VRAM block at data */
     GLvoid *data;
     GLvoid *link;
 } GL_TEXTURE_OBJECT; /* KOS Open GL Texture Object */
@@ -45,6 +47,24 @@ typedef struct {
     GLvoid *link;
 } GL_FRAMEBUFFER_OBJECT; /* KOS Open GL Frame Buffer Object */
 
+typedef struct {
+    GLuint attribs;             /* GL_KOS_USE_COLOR and GL_KOS_USE_TEXTURE0 */
+    GLuint vertex_offset, vertex_stride, vertex_size;
+    GLuint color_offset, color_stride, color_type, color_components;
+    GLuint texcoord_offset, texcoord_stride;
+} GL_BUFFER_LAYOUT; /* Arrays Pointers a Buffer Object was converted with */
+
+typedef struct {
+    GLuint  index;
+    GLenum  usage;
+    GLuint  size;               /* Bytes at data */
+    GLvoid *data;
+    pvr_vertex_t *packed;       /* GL_STATIC_DRAW vertices in PVR layout, or NULL */
+    GLuint  packed_count;
+    GL_BUFFER_LAYOUT layout;
+    GLvoid *link;
+} GL_BUFFER_OBJECT; /* KOS Open GL Buffer Object */
+
 typedef struct {
     pvr_poly_hdr_t hdr;
     pvr_vertex_t *src;
@@ -57,6 +77,8 @@ typedef GLubyte  uint8;
 /* Vertex Main Buffer Internal Functions */
 inline void  _glKosVertexBufSwitchOP();
 inline void  _glKosVertexBufSwitchTR();
+inline void  _glKosVertexBufSwitchPT();
+void  _glKosSelectList();
 inline void *_glKosVertexBufAddress(unsigned char list);
 inline void *_glKosVertexBufPointer();
 inline void *_glKosTRVertexBufPointer();
@@ -67,6 +89,11 @@ inline void  _glKosTRVertexBufAdd(unsigned int count);
 inline void  _glKosVertexBufDecrement();
 inline void  _glKosVertexBufReset();
 inline unsigned int _glKosVertexBufCount(unsigned char list);
+GLubyte _glKosVertexBufReserve(GLuint count, char *functionName);
+GLuint  _glKosVertexBufOpen();
+void    _glKosVertexBufStream();
+void    _glKosVertexBufDirect(GLubyte enable);
+GLuint  _glKosVertexBufDirectBytes();
 unsigned char _glKosList();
 inline void _glKosVertexBufCopy(void *src, void *dst, GLuint count);
 inline void _glKosResetEnabledTex();
@@ -75,6 +102,10 @@ inline void *_glKosMultiUVBufPointer();
 inline void _glKosMultiUVBufIncrement();
 inline void _glKosMultiUVBufAdd(GLuint count);
 inline void _glKosMultiUVBufReset();
+void _glKosFrameClearColor(GLfloat r, GLfloat g, GLfloat b);
+void _glKosFrameAlphaRef(GLubyte ref);
+GLubyte _glKosFrameFlush();
+void _glKosSubmitCommands(GLvoid *src, GLuint count);
 
 /* Vertex Clip Buffer Internal Functions */
 inline void *_glKosClipBufAddress();
@@ -89,15 +120,58 @@ inline glVertex *_glKosArrayBufAddr();
 inline glVertex *_glKosArrayBufPtr();
 
 /* Initialize the OpenGL PVR Pipeline */
-int  _glKosInitPVR();
+int  _glKosInitPVR(const GL_KOS_INIT_PARAMS *params);
 unsigned char  _glKosInitTextures();
 
+typedef struct {
+    GLubyte shade,
+            depth_func,
+            depth_write,
+            blend_func,
+            cull_func,
+            face_front,
+            pad[2];
+    GLuint  caps;                               /* Enabled capabilities used by the header */
+} GL_KOS_HDR_STATE; /* Global state a polygon header is compiled from */
+
+typedef struct {
+    GLuint  color;
+    GLfloat uv[2],
+            norm[3];
+    GLubyte shade,
+            depth_func,
+            depth_write,
+            blend_func,
+            cull_func,
+            face_front,
+            active_texture,
+            pad;
+    GLenum  alpha_func;
+    GLuint  caps,                               /* Enabled capabilities, as glEnable() sets them */
+            texture[2];                         /* Name bound to each texture unit, 0 for none */
+} GL_KOS_STATE; /* Current state a GL_COMPILE display list leaves as it found it */
+
 /* Compile the current Polygon Header for the PVR */
 void _glKosCompileHdr();
 void _glKosCompileHdrTx();
 void _glKosCompileHdrMTx();
 void _glKosCompileHdrT(GL_TEXTURE_OBJECT *tex);
 void _glKosCompileHdrMT(pvr_poly_hdr_t *dst, GL_TEXTURE_OBJECT *tex);
+void _glKosCompileHdrTexture(GL_TEXTURE_OBJECT *tex);
+void _glKosCompileHdrState(const GL_KOS_HDR_STATE *state, GL_TEXTURE_OBJECT *tex);
+void _glKosHdrState(GL_KOS_HDR_STATE *state);
+void _glKosHdrInvalidate(GLubyte list);
+void _glKosHdrFrameReset();
+GLuint _glKosHdrRequested();
+GLuint _glKosHdrEmitted();
+
+/* Save and restore the current state around a GL_COMPILE display list */
+void _glKosStateSave(GL_KOS_STATE *state);
+void _glKosStateRestore(const GL_KOS_STATE *state);
+GLuint _glKosEnabledCaps();
+void _glKosRestoreCaps(GLuint caps);
+void _glKosTextureSave(GL_KOS_STATE *state);
+void _glKosTextureRestore(const GL_KOS_STATE *state);
 
 /* Clipping Internal Functions */
 void         _glKosTransformClipBuf(pvr_vertex_t *v, GLuint verts);
@@ -108,6 +182,7 @@ unsigned int _glKosClipQuads(pvr_vertex_t *vin, pvr_vertex_t *vout, unsigned int
 unsigned int _glKosClipTrianglesTransformed(pvr_vertex_t *src, float *w, pvr_vertex_t *dst, GLuint count);
 unsigned int _glKosClipQuadsTransformed(pvr_vertex_t *vin, float *w, pvr_vertex_t *vout, unsigned int vertices);
 unsigned int _glKosClipTriangleStripTransformed(pvr_vertex_t *src, float *w, pvr_vertex_t *dst, GLuint count);
+GLubyte      _glKosClipLineTransformed(pvr_vertex_t *v, float *w);
 
 unsigned int _glKosClipTrianglesTransformedMT(pvr_vertex_t *src, float *w, pvr_vertex_t *dst,
         GLfloat *uvsrc, glTexCoord *uvdst, GLuint uv_src_stride, GLuint count);
@@ -132,14 +207,14 @@ void _glKosVertex3ft(GLfloat x, GLfloat y, GLfloat z);
 void _glKosVertex3ftv(const GLfloat *xyz);
 void _glKosVertex3fc(GLfloat x, GLfloat y, GLfloat z);
 void _glKosVertex3fcv(const GLfloat *xyz);
-void _glKosVertex3fp(GLfloat x, GLfloat y, GLfloat z);
-void _glKosVertex3fpv(const GLfloat *xyz);
 void _glKosVertex3fl(GLfloat x, GLfloat y, GLfloat z);
 void _glKosVertex3flv(const GLfloat *xyz);
 void _glKosVertex3flc(GLfloat x, GLfloat y, GLfloat z);
 void _glKosVertex3flcv(const GLfloat *xyz);
 void _glKosVertex3fs(GLfloat x, GLfloat y, GLfloat z);
 void _glKosVertex3fsv(const GLfloat *xyz);
+void _glKosVertex3fx(GLfloat x, GLfloat y, GLfloat z);
+void _glKosVertex3fxv(const GLfloat *xyz);
 
 /* Matrix Internal Functions */
 void _glKosInitMatrix();
@@ -149,6 +224,15 @@ void _glKosMatrixApplyScreenSpace();
 void _glKosMatrixApplyRender();
 void _glKosMatrixLoadRender();
 void _glKosMatrixLoadTexture();
+void _glKosMatrixBeginModel();
+void _glKosMatrixApplyModel(const GLfloat *model, GLubyte modelview);
+void _glKosMatrixEndModel();
+void _glKosMatrixEyeAxes(GLfloat *axes);
+
+/* Bounding Volume Internal Functions */
+GLubyte _glKosBoundsOutside();
+GLubyte _glKosBoundsInside();
+void _glKosBoundsEnd();
 
 /* API Enabled Capabilities Internal Functions */
 GLubyte _glKosEnabledBlend();
@@ -171,6 +255,9 @@ uint16 __glKosAverageBiPixelARGB4444(uint16 p1, uint16 p2);
 /* Render-To-Texture Functions */
 void _glKosInitFrameBuffers();
 
+/* Buffer Object Functions */
+GL_BUFFER_OBJECT *_glKosBoundBuffer(GLenum target);
+
 /* Error Codes */
 void _glKosThrowError(GLenum error, char *functionName);
 void _glKosResetError();
@@ -180,6 +267,7 @@ GLsizei _glKosGetError();
 GLuint  _glKosTextureWidth(GLuint index);
 GLuint  _glKosTextureHeight(GLuint index);
 GLvoid *_glKosTextureData(GLuint index);
+GL_TEXTURE_OBJECT *_glKosTextureFindData(GLvoid *data);
 
 /* Frame Buffer Object Internal Functions */
 GLsizei _glKosGetFBO();
@@ -196,20 +284,30 @@ GLubyte _glKosEnabledLighting();
 GLubyte _glKosEnabledNearZClip();
 GLubyte _glKosEnabledTexture2D();
 GLubyte _glKosEnabledBlend();
+GLubyte _glKosEnabledAlphaTest();
 GLuint  _glKosBlendSrcFunc();
 GLuint  _glKosBlendDstFunc();
 GLubyte _glKosCullFaceMode();
 GLubyte _glKosCullFaceFront();
+GLfloat _glKosFacing();
+GLfloat _glKosLineWidth();
+GLfloat _glKosLineHalfWidth();
+GLfloat _glKosPointSize();
+GLfloat _glKosPointHalfSize();
 GLuint  _glKosDepthFunc();
 GLubyte _glKosDepthMask();
 GLubyte _glKosIsLightEnabled(GLubyte light);
 GLubyte _glKosGetMaxLights();
 GLuint  _glKosBoundTexID();
 GLuint  _glKosVertexColor();
+const GLfloat *_glKosVertexTexCoord();
+const GLfloat *_glKosVertexNormal();
 GLubyte _glKosMaxTextureUnits();
 GLubyte _glKosEnabledTextureMatrix();
 
 GL_TEXTURE_OBJECT *_glKosBoundMultiTexID();
+GL_TEXTURE_OBJECT *_glKosBoundTexObject();
+GL_TEXTURE_OBJECT *_glKosTextureObject(GLuint index);
 
 inline void _glKosPushMultiTexObject(GL_TEXTURE_OBJECT *tex,
                                      pvr_vertex_t *src,
@@ -7,6 +7,9 @@
    -GL_TRIANGLES
    -GL_TRIANGLE_STRIPS
    -GL_QUADS
+   -GL_QUAD_STRIP, drawn as the triangle strip it is
+   -GL_TRIANGLE_FAN, GL_POLYGON, GL_POINTS, GL_LINES, GL_LINE_STRIP and
+    GL_LINE_LOOP, converted to strips in gl-primitive.c
 
    Here, it is not necessary to enable or disable client states;
    the API is aware of what pointers have been submitted, and will
@@ -17,14 +20,21 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <malloc.h>
 
 #include <GL/gl.h>
 #include <GL/glext.h>
 #include "gl-api.h"
 #include "gl-arrays.h"
+#include "gl-elements.h"
+#include "gl-list.h"
+#include "gl-primitive.h"
 #include "gl-pvr.h"
 #include "gl-rgb.h"
 #include "gl-sh4.h"
+#include "gl-stats.h"
+#include "gl-trace.h"
 
 //========================================================================================//
 //== Local Variables ==//
@@ -46,6 +56,14 @@ static GLfloat  *GL_KOS_TEXCOORD1_POINTER = NULL;
 static GLfloat  *GL_KOS_COLOR_POINTER = NULL;
 static GLubyte  *GL_KOS_INDEX_POINTER_U8 = NULL;
 static GLushort *GL_KOS_INDEX_POINTER_U16 = NULL;
+static GLuint   *GL_KOS_INDEX_POINTER_U32 = NULL;
+static pvr_vertex_t *GL_KOS_PACKED_POINTER = NULL; /* GL_STATIC_DRAW Buffer Object vertices */
+
+static GL_BUFFER_OBJECT *GL_KOS_VERTEX_BUFFER = NULL; /* Buffer Objects the pointers are in */
+static GL_BUFFER_OBJECT *GL_KOS_COLOR_BUFFER = NULL;
+static GL_BUFFER_OBJECT *GL_KOS_TEXCOORD0_BUFFER = NULL;
+
+static const GL_KOS_INTERLEAVED_FORMAT *GL_KOS_INTERLEAVED = NULL; /* Set by glInterleavedArrays() */
 
 static GLushort GL_KOS_VERTEX_STRIDE = 0;
 static GLushort GL_KOS_NORMAL_STRIDE = 0;
@@ -54,15 +72,31 @@ static GLushort GL_KOS_TEXCOORD1_STRIDE = 0;
 static GLushort GL_KOS_COLOR_STRIDE = 0;
 
 static GLuint  GL_KOS_VERTEX_PTR_MODE = 0;
+static GLuint  GL_KOS_ELEMENT_START = 0; /* First vertex in the element cache */
 static GLubyte GL_KOS_VERTEX_SIZE = 0;
 static GLubyte GL_KOS_COLOR_COMPONENTS = 0;
 static GLenum  GL_KOS_COLOR_TYPE = 0;
+static GLubyte GL_KOS_ARRAYS_KEY = 0; /* Kernel table key of the pointers, see _glKosArraysUpdateKey() */
+static GLubyte GL_KOS_ARRAYS_COLOR = 0; /* GL_KOS_KERNEL_* color source of the pointers */
+
+static pvr_vertex_t *GL_KOS_ELEMENT_CACHE = NULL; /* Post-transform vertices of glDrawElements */
+static GLuint GL_KOS_ELEMENT_CACHE_SIZE = 0;
+
+static GLubyte GL_KOS_ARRAYS_MULTI = 0; /* Drawing the sub-draws of a multi-draw */
 
 //========================================================================================//
 //== Local Function Definitions ==//
 
 static inline void _glKosArraysTransformNormals(GLfloat *normal, GLuint count);
 static inline void _glKosArraysTransformPositions(GLfloat *position, GLuint count);
+static inline GLfloat *_glKosArraysPointer(const GLvoid *pointer, GL_BUFFER_OBJECT **buffer);
+static void _glKosArraysRecord(GLenum mode, GLenum type, GLuint count);
+static void _glKosArraysApplyColor(pvr_vertex_t *dst, GLuint count);
+static inline void _glKosArrayTexCoord2f(pvr_vertex_t *dst, GLuint count);
+static GLubyte _glKosArraysDrawPacked(GLenum mode, GLenum type, GLuint first, GLuint count);
+static void _glKosArraysUpdateKey();
+static GLubyte _glKosArraysDrawKernel(GLenum mode, GLenum type, GLuint count);
+static GL_BUFFER_OBJECT *_glKosArraysPackedBuffer();
 
 void (*_glKosArrayTexCoordFunc)(pvr_vertex_t *);
 void (*_glKosArrayColorFunc)(pvr_vertex_t *);
@@ -93,11 +127,15 @@ GLAPI void APIENTRY glVertexPointer(GLint size, GLenum type,
 
     GL_KOS_VERTEX_SIZE = size;
 
-    (stride) ? (GL_KOS_VERTEX_STRIDE = stride / 4) : (GL_KOS_VERTEX_STRIDE = 3);
+    (stride) ? (GL_KOS_VERTEX_STRIDE = stride / 4) : (GL_KOS_VERTEX_STRIDE = size);
 
-    GL_KOS_VERTEX_POINTER = (float *)pointer;
+    GL_KOS_VERTEX_POINTER = _glKosArraysPointer(pointer, &GL_KOS_VERTEX_BUFFER);
 
     GL_KOS_VERTEX_PTR_MODE |= GL_KOS_USE_ARRAY;
+
+    GL_KOS_INTERLEAVED = NULL;
+
+    _glKosArraysUpdateKey();
 }
 
 /* Submit a Vertex Normal Pointer */
@@ -115,9 +153,11 @@ GLAPI void APIENTRY glNormalPointer(GLenum type, GLsizei stride, const GLvoid *p
 
     (stride) ? (GL_KOS_NORMAL_STRIDE = stride / 4) : (GL_KOS_NORMAL_STRIDE = 3);
 
-    GL_KOS_NORMAL_POINTER = (float *)pointer;
+    GL_KOS_NORMAL_POINTER = _glKosArraysPointer(pointer, NULL);
 
     GL_KOS_VERTEX_PTR_MODE |= GL_KOS_USE_NORMAL;
+
+    GL_KOS_INTERLEAVED = NULL;
 }
 
 /* Submit a Texture Coordinate Pointer */
@@ -140,17 +180,21 @@ GLAPI void APIENTRY glTexCoordPointer(GLint size, GLenum type,
     if(GL_KOS_CLIENT_ACTIVE_TEXTURE) {
         (stride) ? (GL_KOS_TEXCOORD1_STRIDE = stride / 4) : (GL_KOS_TEXCOORD1_STRIDE = 2);
 
-        GL_KOS_TEXCOORD1_POINTER = (float *)pointer;
+        GL_KOS_TEXCOORD1_POINTER = _glKosArraysPointer(pointer, NULL);
 
         GL_KOS_VERTEX_PTR_MODE |= GL_KOS_USE_TEXTURE1;
     }
     else {
         (stride) ? (GL_KOS_TEXCOORD0_STRIDE = stride / 4) : (GL_KOS_TEXCOORD0_STRIDE = 2);
 
-        GL_KOS_TEXCOORD0_POINTER = (float *)pointer;
+        GL_KOS_TEXCOORD0_POINTER = _glKosArraysPointer(pointer, &GL_KOS_TEXCOORD0_BUFFER);
 
         GL_KOS_VERTEX_PTR_MODE |= GL_KOS_USE_TEXTURE0;
     }
+
+    GL_KOS_INTERLEAVED = NULL;
+
+    _glKosArraysUpdateKey();
 }
 
 /* Submit a Color Pointer */
@@ -158,22 +202,18 @@ GLAPI void APIENTRY glColorPointer(GLint size, GLenum type,
                                    GLsizei stride, const GLvoid *pointer) {
     if((type == GL_UNSIGNED_INT) && (size == 1)) {
         GL_KOS_COLOR_COMPONENTS = 1;
-        GL_KOS_COLOR_POINTER = (GLvoid *)pointer;
         GL_KOS_COLOR_TYPE = type;
     }
     else if((type == GL_UNSIGNED_BYTE) && (size == 4)) {
         GL_KOS_COLOR_COMPONENTS = 4;
-        GL_KOS_COLOR_POINTER = (GLvoid *)pointer;
         GL_KOS_COLOR_TYPE = type;
     }
     else if((type == GL_FLOAT) && (size == 3)) {
         GL_KOS_COLOR_COMPONENTS = 3;
-        GL_KOS_COLOR_POINTER = (GLfloat *)pointer;
         GL_KOS_COLOR_TYPE = type;
     }
     else if((type == GL_FLOAT) && (size == 4)) {
         GL_KOS_COLOR_COMPONENTS = 4;
-        GL_KOS_COLOR_POINTER = (GLfloat *)pointer;
         GL_KOS_COLOR_TYPE = type;
     }
     else {
@@ -182,13 +222,33 @@ GLAPI void APIENTRY glColorPointer(GLint size, GLenum type,
         return;
     }
 
-    (stride) ? (GL_KOS_COLOR_STRIDE = stride / 4) : (GL_KOS_COLOR_STRIDE = size);
+    GL_KOS_COLOR_POINTER = _glKosArraysPointer(pointer, &GL_KOS_COLOR_BUFFER);
+
+    /* Strides are in 32 bit words: a packed GL_UNSIGNED_BYTE color takes one */
+    (stride) ? (GL_KOS_COLOR_STRIDE = stride / 4) : (GL_KOS_COLOR_STRIDE = type == GL_FLOAT ? size : 1);
 
     GL_KOS_VERTEX_PTR_MODE |= GL_KOS_USE_COLOR;
+
+    GL_KOS_INTERLEAVED = NULL;
+
+    _glKosArraysUpdateKey();
 }
 //========================================================================================//
 //== Vertex Pointer Internal API ==//
 
+/* While a GL_ARRAY_BUFFER is bound, the pointer is an offset into it */
+static inline GLfloat *_glKosArraysPointer(const GLvoid *pointer, GL_BUFFER_OBJECT **buffer) {
+    GL_BUFFER_OBJECT *buf = _glKosBoundBuffer(GL_ARRAY_BUFFER);
+
+    if(buffer != NULL)
+        *buffer = buf;
+
+    if(buf != NULL)
+        return (GLfloat *)((GLubyte *)buf->data + (size_t)pointer);
+
+    return (GLfloat *)pointer;
+}
+
 inline void _glKosArrayBufIncrement() {
     ++GL_KOS_ARRAY_BUF_PTR;
 }
@@ -234,12 +294,14 @@ static inline void _glKosArraysTransformPositions(GLfloat *position, GLuint coun
 //========================================================================================//
 //== Arrays Vertex Transform ==/
 static void _glKosArraysTransform2D(GLuint count) {
+    GL_KOS_TRACE("transform");
+
     GLfloat *src = GL_KOS_VERTEX_POINTER;
     pvr_vertex_t *dst = _glKosVertexBufPointer();
 
-    register float __x  __asm__("fr12");
-    register float __y  __asm__("fr13");
-    register float __z  __asm__("fr14");
+    register float __x  GL_KOS_FREG("fr12");
+    register float __y  GL_KOS_FREG("fr13");
+    register float __z  GL_KOS_FREG("fr14");
 
     while(count--)  {
         __x = src[0];
@@ -259,12 +321,14 @@ static void _glKosArraysTransform2D(GLuint count) {
 }
 
 static void _glKosArraysTransform(GLuint count) {
+    GL_KOS_TRACE("transform");
+
     GLfloat *src = GL_KOS_VERTEX_POINTER;
     pvr_vertex_t *dst = _glKosVertexBufPointer();
 
-    register float __x  __asm__("fr12");
-    register float __y  __asm__("fr13");
-    register float __z  __asm__("fr14");
+    register float __x  GL_KOS_FREG("fr12");
+    register float __y  GL_KOS_FREG("fr13");
+    register float __z  GL_KOS_FREG("fr14");
 
     while(count--)  {
         __x = src[0];
@@ -284,14 +348,16 @@ static void _glKosArraysTransform(GLuint count) {
 }
 
 static void _glKosArraysTransformClip(GLuint count) {
+    GL_KOS_TRACE("transform");
+
     GLfloat *src = GL_KOS_VERTEX_POINTER;
     GLfloat *W = GL_KOS_ARRAY_DSTW;
     pvr_vertex_t *dst = _glKosClipBufAddress();
 
-    register float __x  __asm__("fr12");
-    register float __y  __asm__("fr13");
-    register float __z  __asm__("fr14");
-    register float __w  __asm__("fr15");
+    register float __x  GL_KOS_FREG("fr12");
+    register float __y  GL_KOS_FREG("fr13");
+    register float __z  GL_KOS_FREG("fr14");
+    register float __w  GL_KOS_FREG("fr15");
 
     while(count--)  {
         __x = src[0];
@@ -311,51 +377,67 @@ static void _glKosArraysTransformClip(GLuint count) {
     }
 }
 
-static void _glKosArraysTransformElements(GLuint count) {
-    GLfloat *src = GL_KOS_VERTEX_POINTER;
-    GLuint i = 0;
+/* Transform count vertices into the element cache. The texture coordinates and
+   offset color are cleared, the texture coordinate pass fills them in after. */
+static void _glKosArraysTransformElements(pvr_vertex_t *dst, GLuint count) {
+    GL_KOS_TRACE("transform");
 
-    register float __x  __asm__("fr12");
-    register float __y  __asm__("fr13");
-    register float __z  __asm__("fr14");
+    const GLfloat *src = GL_KOS_VERTEX_POINTER;
+    const GLuint stride = GL_KOS_VERTEX_STRIDE;
+    const GLubyte size = GL_KOS_VERTEX_SIZE;
 
-    for(i = 0; i < count; i++) {
+    register float __x  GL_KOS_FREG("fr12");
+    register float __y  GL_KOS_FREG("fr13");
+    register float __z  GL_KOS_FREG("fr14");
+
+    while(count--) {
         __x = src[0];
         __y = src[1];
-        __z = src[2];
+        __z = size == 3 ? src[2] : 0;
 
         mat_trans_fv12()
 
-        GL_KOS_ARRAY_BUF[i].pos[0] = __x;
-        GL_KOS_ARRAY_BUF[i].pos[1] = __y;
-        GL_KOS_ARRAY_BUF[i].pos[2] = __z;
+        dst->x = __x;
+        dst->y = __y;
+        dst->z = __z;
+        dst->u = dst->v = 0;
+        dst->oargb = 0;
+
+        ++dst;
 
-        src += GL_KOS_VERTEX_STRIDE;
+        src += stride;
     }
 }
 
-static void _glKosArraysTransformClipElements(GLuint count) {
-    GLfloat *src = GL_KOS_VERTEX_POINTER;
-    GLuint i;
+static void _glKosArraysTransformClipElements(pvr_vertex_t *dst, GLuint count) {
+    GL_KOS_TRACE("transform");
 
-    register float __x  __asm__("fr12");
-    register float __y  __asm__("fr13");
-    register float __z  __asm__("fr14");
-    register float __w  __asm__("fr15");
+    const GLfloat *src = GL_KOS_VERTEX_POINTER;
+    const GLuint stride = GL_KOS_VERTEX_STRIDE;
+    GLfloat *W = GL_KOS_ARRAY_BUFW;
 
-    for(i = 0; i < count; i++) {
+    register float __x  GL_KOS_FREG("fr12");
+    register float __y  GL_KOS_FREG("fr13");
+    register float __z  GL_KOS_FREG("fr14");
+    register float __w  GL_KOS_FREG("fr15");
+
+    while(count--) {
         __x = src[0];
         __y = src[1];
         __z = src[2];
 
         mat_trans_fv12_nodivw()
 
-        GL_KOS_ARRAY_BUF[i].pos[0] = __x;
-        GL_KOS_ARRAY_BUF[i].pos[1] = __y;
-        GL_KOS_ARRAY_BUF[i].pos[2] = __z;
-        GL_KOS_ARRAY_BUFW[i] = __w;
+        dst->x = __x;
+        dst->y = __y;
+        dst->z = __z;
+        dst->u = dst->v = 0;
+        dst->oargb = 0;
+        *W++ = __w;
+
+        ++dst;
 
-        src += GL_KOS_VERTEX_STRIDE;
+        src += stride;
     }
 }
 
@@ -373,243 +455,97 @@ static inline void _glKosArrayColor0(pvr_vertex_t *dst, GLuint count) {
         dst[i].argb = dst[0].argb;
 }
 
-static inline void _glKosElementColor1uiU8(pvr_vertex_t *dst, GLuint count) {
-    GLuint i;
-    GLuint *src = (GLuint *)GL_KOS_COLOR_POINTER;
-
-    for(i = 0; i < count; i++)
-        dst[i].argb = src[GL_KOS_INDEX_POINTER_U8[i] * GL_KOS_COLOR_STRIDE];
-}
-
-static inline void _glKosElementColor1uiU16(pvr_vertex_t *dst, GLuint count) {
-    GLuint i;
-    GLuint *color = (GLuint *)GL_KOS_COLOR_POINTER;
-
-    for(i = 0; i < count; i++)
-        dst[i].argb = color[GL_KOS_INDEX_POINTER_U16[i] * GL_KOS_COLOR_STRIDE];
-}
-
-static inline void _glKosElementColor4ubU8(pvr_vertex_t *dst, GLuint count) {
-    GLuint i, *color = (GLuint *)GL_KOS_COLOR_POINTER;
-
-    for(i = 0; i < count; i++)
-        dst[i].argb = RGBA32_2_ARGB32(color[GL_KOS_INDEX_POINTER_U8[i]] * GL_KOS_COLOR_STRIDE);
-}
-
-static inline void _glKosElementColor4ubU16(pvr_vertex_t *dst, GLuint count) {
-    GLuint i, *color = (GLuint *)GL_KOS_COLOR_POINTER;
-
-    for(i = 0; i < count; i++)
-        dst[i].argb = RGBA32_2_ARGB32(color[GL_KOS_INDEX_POINTER_U16[i] * GL_KOS_COLOR_STRIDE]);
-}
-
-static inline void _glKosElementColor3fU8(pvr_vertex_t *dst, GLuint count) {
-    GLuint i, index;
-    GLrgb3f *color = (GLrgb3f *)GL_KOS_COLOR_POINTER;
-
-    for(i = 0; i < count; i++) {
-        index =  GL_KOS_INDEX_POINTER_U8[i] * GL_KOS_COLOR_STRIDE;
-        dst[i].argb = (0xFF000000 | ((GLubyte)color[index][0] * 0xFF) << 16
-                       | ((GLubyte)color[index][1] * 0xFF) << 8
-                       | ((GLubyte)color[index][2] * 0xFF));
-    }
-}
-
-static inline void _glKosElementColor3fU16(pvr_vertex_t *dst, GLuint count) {
-    GLuint i, index;
-    GLrgb3f *color = (GLrgb3f *)GL_KOS_COLOR_POINTER;
-
-    for(i = 0; i < count; i++) {
-        index =  GL_KOS_INDEX_POINTER_U16[i] * GL_KOS_COLOR_STRIDE;
-        dst[i].argb = (0xFF000000 | ((GLubyte)color[index][0] * 0xFF) << 16
-                       | ((GLubyte)color[index][1] * 0xFF) << 8
-                       | ((GLubyte)color[index][2] * 0xFF));
-    }
-}
-
-static inline void _glKosElementColor4fU8(pvr_vertex_t *dst, GLuint count) {
-    GLuint i, index;
-    GLrgba4f *color = (GLrgba4f *)GL_KOS_COLOR_POINTER;
+//== Indices ==//
 
-    for(i = 0; i < count; i++) {
-        index = GL_KOS_INDEX_POINTER_U8[i] * GL_KOS_COLOR_STRIDE;
-        dst[i].argb = (((GLubyte)color[index][3] * 0xFF) << 24
-                       | ((GLubyte)color[index][0] * 0xFF) << 16
-                       | ((GLubyte)color[index][1] * 0xFF) << 8
-                       | ((GLubyte)color[index][2] * 0xFF));
-    }
-}
+/* Element i of the index type, or vertex i for glDrawArrays() */
+static inline GLuint _glKosArraysIndex(GLenum type, GLuint i) {
+    switch(type) {
+        case GL_UNSIGNED_BYTE:
+            return GL_KOS_INDEX_POINTER_U8[i];
 
-static inline void _glKosElementColor4fU16(pvr_vertex_t *dst, GLuint count) {
-    GLuint i, index;
-    GLrgba4f *color = (GLrgba4f *)GL_KOS_COLOR_POINTER;
+        case GL_UNSIGNED_SHORT:
+            return GL_KOS_INDEX_POINTER_U16[i];
 
-    for(i = 0; i < count; i++) {
-        index = GL_KOS_INDEX_POINTER_U16[i] * GL_KOS_COLOR_STRIDE;
-        dst[i].argb = (((GLubyte)color[index][3] * 0xFF) << 24
-                       | ((GLubyte)color[index][0] * 0xFF) << 16
-                       | ((GLubyte)color[index][1] * 0xFF) << 8
-                       | ((GLubyte)color[index][2] * 0xFF));
+        case GL_UNSIGNED_INT:
+            return GL_KOS_INDEX_POINTER_U32[i];
     }
-}
-
-//== Texture Coordinates ==//
-
-
-
-static inline void _glKosElementTexCoord2fU16(pvr_vertex_t *dst, GLuint count) {
-    GLuint i, index;
-    GLfloat *t = GL_KOS_TEXCOORD0_POINTER;
 
-    if(_glKosEnabledTextureMatrix()) {
-        _glKosMatrixLoadTexture();
-
-        for(i = 0; i < count; i++) {
-            index = GL_KOS_INDEX_POINTER_U16[i] * GL_KOS_TEXCOORD0_STRIDE;
-
-            mat_trans_texture2_nomod(t[index], t[index + 1], dst[i].u, dst[i].v);
-        }
-
-        _glKosMatrixLoadRender();
-    }
-    else {
-        for(i = 0; i < count; i++) {
-            index = GL_KOS_INDEX_POINTER_U16[i] * GL_KOS_TEXCOORD0_STRIDE;
-            dst[i].u = t[index];
-            dst[i].v = t[index + 1];
-        }
-    }
+    return i;
 }
 
-static inline void _glKosElementTexCoord2fU8(pvr_vertex_t *dst, GLuint count) {
-    GLuint i, index;
-    GLfloat *t = GL_KOS_TEXCOORD0_POINTER;
-
-    if(_glKosEnabledTextureMatrix()) {
-        _glKosMatrixLoadTexture();
+/* Point the index pointer of the type at indices. While a GL_ELEMENT_ARRAY_BUFFER is
+   bound, indices is an offset into it. */
+static inline void _glKosArraysIndexPointer(GLenum type, const GLvoid *indices) {
+    if(_glKosBoundBuffer(GL_ELEMENT_ARRAY_BUFFER))
+        indices = (GLubyte *)_glKosBoundBuffer(GL_ELEMENT_ARRAY_BUFFER)->data + (size_t)indices;
 
-        for(i = 0; i < count; i++) {
-            index = GL_KOS_INDEX_POINTER_U8[i] * GL_KOS_TEXCOORD0_STRIDE;
+    switch(type) {
+        case GL_UNSIGNED_BYTE:
+            GL_KOS_INDEX_POINTER_U8 = (GLubyte *)indices;
+            break;
 
-            mat_trans_texture2_nomod(t[index], t[index + 1], dst[i].u, dst[i].v);
-        }
+        case GL_UNSIGNED_SHORT:
+            GL_KOS_INDEX_POINTER_U16 = (GLushort *)indices;
+            break;
 
-        _glKosMatrixLoadRender();
-    }
-    else {
-        for(i = 0; i < count; i++) {
-            index = GL_KOS_INDEX_POINTER_U8[i] * GL_KOS_TEXCOORD0_STRIDE;
-            dst[i].u = t[index];
-            dst[i].v = t[index + 1];
-        }
+        case GL_UNSIGNED_INT:
+            GL_KOS_INDEX_POINTER_U32 = (GLuint *)indices;
+            break;
     }
 }
 
-static inline void _glKosElementMultiTexCoord2fU16C(GLuint count) {
-    GLuint i, index;
-    GLfloat *t = GL_KOS_TEXCOORD1_POINTER;
-    GLfloat *dst = GL_KOS_ARRAY_BUFUV;
+/* The lowest and highest vertex count elements of the index type reference */
+static inline void _glKosArraysRange(GLenum type, GLuint count, GLuint *start, GLuint *end) {
+    const GLubyte *index8 = GL_KOS_INDEX_POINTER_U8;
+    const GLushort *index16 = GL_KOS_INDEX_POINTER_U16;
+    const GLuint *index32 = GL_KOS_INDEX_POINTER_U32;
+    GLuint i, n, lo = 0xFFFFFFFF, hi = 0;
 
     for(i = 0; i < count; i++) {
-        index = GL_KOS_INDEX_POINTER_U16[i] * GL_KOS_TEXCOORD1_STRIDE;
-        *dst++ = t[index];
-        *dst++ = t[index + 1];
-    }
-}
+        n = type == GL_UNSIGNED_BYTE ? index8[i] :
+            type == GL_UNSIGNED_SHORT ? index16[i] : index32[i];
 
-static inline void _glKosElementMultiTexCoord2fU8C(GLuint count) {
-    GLuint i, index;
-    GLfloat *t = GL_KOS_TEXCOORD1_POINTER;
-    GLfloat *dst = GL_KOS_ARRAY_BUFUV;
-
-    for(i = 0; i < count; i++) {
-        index = GL_KOS_INDEX_POINTER_U8[i] * GL_KOS_TEXCOORD1_STRIDE;
-        *dst++ = t[index];
-        *dst++ = t[index + 1];
+        lo = n < lo ? n : lo;
+        hi = n > hi ? n : hi;
     }
+
+    *start = lo;
+    *end = hi;
 }
 
-static inline void _glKosElementMultiTexCoord2fU16(GLuint count) {
-    if(_glKosEnabledNearZClip())
-        return _glKosElementMultiTexCoord2fU16C(count);
+static void _glKosArraysElementRange(GLenum type, GLuint count, GLuint *start, GLuint *end) {
+    switch(type) {
+        case GL_UNSIGNED_BYTE:
+            _glKosArraysRange(GL_UNSIGNED_BYTE, count, start, end);
+            break;
 
-    GLuint i, index;
-    GLfloat *t = GL_KOS_TEXCOORD1_POINTER;
-    glTexCoord *dst = (glTexCoord *)_glKosMultiUVBufPointer();
+        case GL_UNSIGNED_SHORT:
+            _glKosArraysRange(GL_UNSIGNED_SHORT, count, start, end);
+            break;
 
-    for(i = 0; i < count; i++) {
-        index = GL_KOS_INDEX_POINTER_U16[i] * GL_KOS_TEXCOORD1_STRIDE;
-        dst[i].u = t[index];
-        dst[i].v = t[index + 1];
+        case GL_UNSIGNED_INT:
+            _glKosArraysRange(GL_UNSIGNED_INT, count, start, end);
+            break;
     }
-
-    _glKosMultiUVBufAdd(count);
 }
 
-static inline void _glKosElementMultiTexCoord2fU8(GLuint count) {
-    if(_glKosEnabledNearZClip())
-        return _glKosElementMultiTexCoord2fU8C(count);
+//== Texture Coordinates ==//
 
+/* Second texture unit coordinates of count elements, to the Multi-Texture buffer,
+   or to GL_KOS_ARRAY_BUFUV for near-Z clipping */
+static void _glKosElementMultiTexCoord2f(GLenum type, GLuint count, GLubyte clip) {
     GLuint i, index;
     GLfloat *t = GL_KOS_TEXCOORD1_POINTER;
-    glTexCoord *dst = (glTexCoord *)_glKosMultiUVBufPointer();
+    glTexCoord *dst = clip ? (glTexCoord *)GL_KOS_ARRAY_BUFUV : (glTexCoord *)_glKosMultiUVBufPointer();
 
     for(i = 0; i < count; i++) {
-        index = GL_KOS_INDEX_POINTER_U8[i] * GL_KOS_TEXCOORD1_STRIDE;
+        index = (_glKosArraysIndex(type, i) - GL_KOS_ELEMENT_START) * GL_KOS_TEXCOORD1_STRIDE;
         dst[i].u = t[index];
         dst[i].v = t[index + 1];
     }
 
-    _glKosMultiUVBufAdd(count);
-}
-
-//========================================================================================//
-//== Element Unpacking ==//
-
-static inline void _glKosArraysUnpackElementsS16(pvr_vertex_t *dst, GLuint count) {
-    glVertex *vert = GL_KOS_ARRAY_BUF;
-    GLuint i;
-
-    for(i = 0; i < count; i++) {
-        dst[i].x = vert[GL_KOS_INDEX_POINTER_U16[i]].pos[0];
-        dst[i].y = vert[GL_KOS_INDEX_POINTER_U16[i]].pos[1];
-        dst[i].z = vert[GL_KOS_INDEX_POINTER_U16[i]].pos[2];
-    }
-}
-
-static inline void _glKosArraysUnpackElementsS8(pvr_vertex_t *dst, GLuint count) {
-    glVertex *vert = GL_KOS_ARRAY_BUF;
-    GLuint i;
-
-    for(i = 0; i < count; i++) {
-        dst[i].x = vert[GL_KOS_INDEX_POINTER_U8[i]].pos[0];
-        dst[i].y = vert[GL_KOS_INDEX_POINTER_U8[i]].pos[1];
-        dst[i].z = vert[GL_KOS_INDEX_POINTER_U8[i]].pos[2];
-    }
-}
-
-static inline void _glKosArraysUnpackClipElementsS16(pvr_vertex_t *dst, GLuint count) {
-    glVertex *vert = GL_KOS_ARRAY_BUF;
-    GLuint i;
-
-    for(i = 0; i < count; i++) {
-        dst[i].x = vert[GL_KOS_INDEX_POINTER_U16[i]].pos[0];
-        dst[i].y = vert[GL_KOS_INDEX_POINTER_U16[i]].pos[1];
-        dst[i].z = vert[GL_KOS_INDEX_POINTER_U16[i]].pos[2];
-        GL_KOS_ARRAY_DSTW[i] = GL_KOS_ARRAY_BUFW[GL_KOS_INDEX_POINTER_U16[i]];
-    }
-}
-
-static inline void _glKosArraysUnpackClipElementsS8(pvr_vertex_t *dst, GLuint count) {
-    glVertex *vert = GL_KOS_ARRAY_BUF;
-    GLuint i;
-
-    for(i = 0; i < count; i++) {
-        dst[i].x = vert[GL_KOS_INDEX_POINTER_U8[i]].pos[0];
-        dst[i].y = vert[GL_KOS_INDEX_POINTER_U8[i]].pos[1];
-        dst[i].z = vert[GL_KOS_INDEX_POINTER_U8[i]].pos[2];
-        GL_KOS_ARRAY_DSTW[i] = GL_KOS_ARRAY_BUFW[GL_KOS_INDEX_POINTER_U8[i]];
-    }
+    if(!clip)
+        _glKosMultiUVBufAdd(count);
 }
 
 //========================================================================================//
@@ -629,6 +565,20 @@ static inline void _glKosTexCoordSwizzle(glTexCoord *uv1, glTexCoord *uv2) {
 
 static inline void _glKosArraysResetState() {
     GL_KOS_VERTEX_PTR_MODE = 0;
+    GL_KOS_INTERLEAVED = NULL;
+
+    _glKosArraysUpdateKey();
+}
+
+/* Drop a draw its bounding volume found outside the screen. The caller clears the
+   held result with _glKosBoundsEnd() on every way out of the draw. */
+static inline GLubyte _glKosArraysCulled() {
+    if(!_glKosBoundsOutside())
+        return 0;
+
+    _glKosArraysResetState();
+
+    return 1;
 }
 
 //========================================================================================//
@@ -663,6 +613,28 @@ static inline void _glKosArrayFlagsSetTriangleStrip(pvr_vertex_t *dst, GLuint co
 }
 
 
+/* Where vertex i of count goes in dst, with its PVR flags set */
+static inline pvr_vertex_t *_glKosArraysKernelVertex(GLenum mode, pvr_vertex_t *dst,
+        GLuint i, GLuint count, GLuint *k) {
+    pvr_vertex_t *d;
+
+    if(mode == GL_QUADS) { /* The PVR takes quads as strips, swap v2 and v3 */
+        d = &dst[i ^ ((i >> 1) & 1)];
+        d->flags = (i & 3) == 2 ? PVR_CMD_VERTEX_EOL : PVR_CMD_VERTEX;
+    }
+    else if(mode == GL_TRIANGLES) {
+        d = &dst[i];
+        d->flags = *k == 2 ? PVR_CMD_VERTEX_EOL : PVR_CMD_VERTEX;
+        *k = *k == 2 ? 0 : *k + 1;
+    }
+    else {
+        d = &dst[i];
+        d->flags = i == count - 1 ? PVR_CMD_VERTEX_EOL : PVR_CMD_VERTEX;
+    }
+
+    return d;
+}
+
 static inline void _glKosArraysSwizzleQuadsMultiTex(GLuint count) {
     if(!_glKosEnabledNearZClip()) {
         GLuint i;
@@ -676,11 +648,14 @@ static inline void _glKosArraysSwizzleQuadsMultiTex(GLuint count) {
 //========================================================================================//
 //== OpenGL Error Code Generation ==//
 
+/* type is the element type for glDrawElements(), or first for glDrawArrays(), which
+   may be anywhere in the arrays but not before them */
 static GLuint _glKosArraysVerifyParameter(GLenum mode, GLsizei count, GLenum type, GLubyte element) {
     if(mode != GL_QUADS)
         if(mode != GL_TRIANGLES)
             if(mode != GL_TRIANGLE_STRIP)
-                _glKosThrowError(GL_INVALID_ENUM, "glDrawArrays");
+                if(mode != GL_QUAD_STRIP && !_glKosPrimitiveConverted(mode))
+                    _glKosThrowError(GL_INVALID_ENUM, "glDrawArrays");
 
     if(count < 0)
         _glKosThrowError(GL_INVALID_VALUE, "glDrawArrays");
@@ -688,20 +663,18 @@ static GLuint _glKosArraysVerifyParameter(GLenum mode, GLsizei count, GLenum typ
     if(!(GL_KOS_VERTEX_PTR_MODE & GL_KOS_USE_ARRAY))
         _glKosThrowError(GL_INVALID_OPERATION, "glDrawArrays");
 
-    if(count > GL_KOS_MAX_VERTS)
-        _glKosThrowError(GL_OUT_OF_MEMORY, "glDrawArrays");
-
     if(element) {
         switch(type) {
             case GL_UNSIGNED_BYTE:
             case GL_UNSIGNED_SHORT:
+            case GL_UNSIGNED_INT:
                 break;
 
             default:
                 _glKosThrowError(GL_INVALID_ENUM, "glDrawArrays");
         }
     }
-    else if(type > count)
+    else if((GLint)type < 0)
         _glKosThrowError(GL_INVALID_VALUE, "glDrawArrays");
 
     if(_glKosGetError()) {
@@ -713,20 +686,24 @@ static GLuint _glKosArraysVerifyParameter(GLenum mode, GLsizei count, GLenum typ
 }
 
 static GLuint _glKosArraysApplyClipping(GLfloat *uvsrc, GLuint uvstride, GLenum mode, GLuint count) {
+    GL_KOS_TRACE("clip");
+
+    GLuint verts;
+
     switch(mode) {
         case GL_TRIANGLES:
             if(GL_KOS_VERTEX_PTR_MODE & GL_KOS_USE_TEXTURE1) {
-                count = _glKosClipTrianglesTransformedMT((pvr_vertex_t *)_glKosClipBufAddress(),
+                verts = _glKosClipTrianglesTransformedMT((pvr_vertex_t *)_glKosClipBufAddress(),
                         GL_KOS_ARRAY_DSTW,
                         (pvr_vertex_t *)_glKosVertexBufPointer(),
                         uvsrc,
                         (glTexCoord *)_glKosMultiUVBufPointer(),
                         uvstride,
                         count);
-                _glKosMultiUVBufAdd(count);
+                _glKosMultiUVBufAdd(verts);
             }
             else
-                count = _glKosClipTrianglesTransformed((pvr_vertex_t *)_glKosClipBufAddress(),
+                verts = _glKosClipTrianglesTransformed((pvr_vertex_t *)_glKosClipBufAddress(),
                                                        GL_KOS_ARRAY_DSTW,
                                                        (pvr_vertex_t *)_glKosVertexBufPointer(),
                                                        count);
@@ -735,17 +712,17 @@ static GLuint _glKosArraysApplyClipping(GLfloat *uvsrc, GLuint uvstride, GLenum
 
         case GL_QUADS:
             if(GL_KOS_VERTEX_PTR_MODE & GL_KOS_USE_TEXTURE1) {
-                count = _glKosClipQuadsTransformedMT((pvr_vertex_t *)_glKosClipBufAddress(),
+                verts = _glKosClipQuadsTransformedMT((pvr_vertex_t *)_glKosClipBufAddress(),
                                                      GL_KOS_ARRAY_DSTW,
                                                      (pvr_vertex_t *)_glKosVertexBufPointer(),
                                                      uvsrc,
                                                      (glTexCoord *)_glKosMultiUVBufPointer(),
                                                      uvstride,
                                                      count);
-                _glKosMultiUVBufAdd(count);
+                _glKosMultiUVBufAdd(verts);
             }
             else
-                count = _glKosClipQuadsTransformed((pvr_vertex_t *)_glKosClipBufAddress(),
+                verts = _glKosClipQuadsTransformed((pvr_vertex_t *)_glKosClipBufAddress(),
                                                    GL_KOS_ARRAY_DSTW,
                                                    (pvr_vertex_t *)_glKosVertexBufPointer(),
                                                    count);
@@ -754,17 +731,17 @@ static GLuint _glKosArraysApplyClipping(GLfloat *uvsrc, GLuint uvstride, GLenum
 
         case GL_TRIANGLE_STRIP:
             if(GL_KOS_VERTEX_PTR_MODE & GL_KOS_USE_TEXTURE1) {
-                count = _glKosClipTriangleStripTransformedMT((pvr_vertex_t *)_glKosClipBufAddress(),
+                verts = _glKosClipTriangleStripTransformedMT((pvr_vertex_t *)_glKosClipBufAddress(),
                         GL_KOS_ARRAY_DSTW,
                         (pvr_vertex_t *)_glKosVertexBufPointer(),
                         uvsrc,
                         (glTexCoord *)_glKosMultiUVBufPointer(),
                         uvstride,
                         count);
-                _glKosMultiUVBufAdd(count);
+                _glKosMultiUVBufAdd(verts);
             }
             else
-                count = _glKosClipTriangleStripTransformed((pvr_vertex_t *)_glKosClipBufAddress(),
+                verts = _glKosClipTriangleStripTransformed((pvr_vertex_t *)_glKosClipBufAddress(),
                         GL_KOS_ARRAY_DSTW,
                         (pvr_vertex_t *)_glKosVertexBufPointer(),
                         count);
@@ -772,11 +749,13 @@ static GLuint _glKosArraysApplyClipping(GLfloat *uvsrc, GLuint uvstride, GLenum
             break;
 
         default:
-            count = 0;
+            verts = 0;
             break;
     }
 
-    return count;
+    GL_KOS_STAT_CLIP(mode, count, (pvr_vertex_t *)_glKosVertexBufPointer(), verts);
+
+    return verts;
 }
 
 static inline void _glKosArraysApplyMultiTexture(GLenum mode, GLuint count) {
@@ -807,6 +786,8 @@ static inline void _glKosArraysApplyVertexFlags(GLenum mode, pvr_vertex_t *dst,
 }
 
 static inline void _glKosArraysApplyLighting(pvr_vertex_t *dst, GLuint count) {
+    GL_KOS_TRACE("lighting");
+
     _glKosArraysTransformNormals(GL_KOS_NORMAL_POINTER, count);
     _glKosArraysTransformPositions(GL_KOS_VERTEX_POINTER, count);
     _glKosVertexLights(GL_KOS_ARRAY_BUF, dst, count);
@@ -819,6 +800,20 @@ static inline void _glKosArraysApplyHeader() {
         _glKosCompileHdr();
 }
 
+/* Compile the PVR polygon context with the currently enabled flags and apply the
+   Render Matrix Stack. Sub-draws of a multi-draw share what the multi-draw applied,
+   and only load its Render Matrix back. */
+static inline void _glKosArraysApplyDrawState() {
+    if(GL_KOS_ARRAYS_MULTI) {
+        _glKosMatrixLoadRender();
+        return;
+    }
+
+    _glKosArraysApplyHeader();
+
+    _glKosMatrixApplyRender();
+}
+
 static inline pvr_vertex_t *_glKosArraysDest() {
     if(_glKosEnabledNearZClip())
         return _glKosClipBufAddress();
@@ -827,162 +822,206 @@ static inline pvr_vertex_t *_glKosArraysDest() {
 }
 
 static inline void _glKosArraysFlush(GLuint count) {
+    GL_KOS_TRACE("flush");
+
     _glKosVertexBufAdd(count);
 
-    _glKosArraysResetState();
+    _glKosVertexBufStream();
 }
 
-//========================================================================================//
-//== OpenGL Elemental Array Submission ==//
+/* Make room in the Vertex Buffer for the output of count vertices.
+   Near-Z clipping can emit up to 4 vertices for every input triangle. */
+static inline GLubyte _glKosArraysReserve(GLenum mode, GLuint count, char *functionName) {
+    if(_glKosEnabledNearZClip())
+        switch(mode) {
+            case GL_TRIANGLES:
+                count = (count / 3) * 4;
+                break;
 
-GLAPI void APIENTRY glDrawElements(GLenum mode, GLsizei count, GLenum type, const GLvoid *indices) {
-    /* Before we process the vertex data, ensure all parameters are valid */
-    if(!_glKosArraysVerifyParameter(mode, count, type, 1))
-        return;
+            case GL_QUADS:
+                count *= 2;
+                break;
 
-    /* Compile the PVR polygon context with the currently enabled flags */
-    _glKosArraysApplyHeader();
+            default:
+                count *= 4;
+                break;
+        }
 
-    /* Destination of Output Vertex Array */
-    pvr_vertex_t *dst = _glKosArraysDest();
+    return _glKosVertexBufReserve(count, functionName);
+}
 
-    switch(type) {
-        case GL_UNSIGNED_BYTE:
-            GL_KOS_INDEX_POINTER_U8 = (GLubyte *)indices;
-            break;
+/* Move the client array pointers forward by count vertices */
+static inline void _glKosArraysAdvance(GLuint count) {
+    GL_KOS_VERTEX_POINTER    += count * GL_KOS_VERTEX_STRIDE;
+    GL_KOS_NORMAL_POINTER    += count * GL_KOS_NORMAL_STRIDE;
+    GL_KOS_TEXCOORD0_POINTER += count * GL_KOS_TEXCOORD0_STRIDE;
+    GL_KOS_TEXCOORD1_POINTER += count * GL_KOS_TEXCOORD1_STRIDE;
+    GL_KOS_COLOR_POINTER     += count * GL_KOS_COLOR_STRIDE;
+    GL_KOS_PACKED_POINTER    += count;
+}
 
-        case GL_UNSIGNED_SHORT:
-            GL_KOS_INDEX_POINTER_U16 = (GLushort *)indices;
+/* Submit a draw in pieces of at most GL_KOS_MAX_DRAW_VERTS, so the output of every
+   piece fits in one Vertex Buffer chunk. GL_KOS_MAX_DRAW_VERTS is a multiple of 3 and 4,
+   so pieces end on a whole primitive. Strip pieces overlap by 2 vertices and always
+   start on an even vertex, which keeps the winding order. */
+static void _glKosArraysDrawPieces(GLenum mode, GLenum type, GLuint count,
+                                   GLubyte(*draw)(GLenum, GLenum, GLuint)) {
+    GLuint n;
+
+    while(count) {
+        n = count < GL_KOS_MAX_DRAW_VERTS ? count : GL_KOS_MAX_DRAW_VERTS;
+
+        if(!draw(mode, type, n) || n == count)
             break;
-    }
 
-    /* Check if Vertex Lighting is enabled. Else, check for Color Submission */
-    if((GL_KOS_VERTEX_PTR_MODE & GL_KOS_USE_NORMAL) && _glKosEnabledLighting())
-        _glKosArraysApplyLighting(dst, count);
+        if(mode == GL_TRIANGLE_STRIP)
+            n -= 2;
 
-    else if(GL_KOS_VERTEX_PTR_MODE & GL_KOS_USE_COLOR) {
-        switch(GL_KOS_COLOR_TYPE) {
-            case GL_FLOAT:
-                switch(GL_KOS_COLOR_COMPONENTS) {
-                    case 3:
-                        switch(type) {
-                            case GL_UNSIGNED_BYTE:
-                                _glKosElementColor3fU8(dst, count);
-                                break;
-
-                            case GL_UNSIGNED_SHORT:
-                                _glKosElementColor3fU16(dst, count);
-                                break;
-                        }
-
-                        break;
-
-                    case 4:
-                        switch(type) {
-                            case GL_UNSIGNED_BYTE:
-                                _glKosElementColor4fU8(dst, count);
-                                break;
-
-                            case GL_UNSIGNED_SHORT:
-                                _glKosElementColor4fU16(dst, count);
-                                break;
-                        }
-
-                        break;
-                }
+        if(type == GL_UNSIGNED_BYTE)
+            GL_KOS_INDEX_POINTER_U8 += n;
+        else if(type == GL_UNSIGNED_SHORT)
+            GL_KOS_INDEX_POINTER_U16 += n;
+        else if(type == GL_UNSIGNED_INT)
+            GL_KOS_INDEX_POINTER_U32 += n;
+        else
+            _glKosArraysAdvance(n);
 
-                break;
+        count -= n;
+    }
 
-            case GL_UNSIGNED_INT:
-                if(GL_KOS_COLOR_COMPONENTS == 1)
-                    switch(type) {
-                        case GL_UNSIGNED_BYTE:
-                            _glKosElementColor1uiU8(dst, count);
-                            break;
+    _glKosArraysResetState();
+}
 
-                        case GL_UNSIGNED_SHORT:
-                            _glKosElementColor1uiU16(dst, count);
-                            break;
-                    }
+//========================================================================================//
+//== OpenGL Elemental Array Submission ==//
 
-                break;
+/* Make room in the element cache for count vertices */
+static GLubyte _glKosArraysCacheReserve(GLuint count) {
+    if(count <= GL_KOS_ELEMENT_CACHE_SIZE)
+        return 1;
 
-            case GL_UNSIGNED_BYTE:
-                if(GL_KOS_COLOR_COMPONENTS == 4)
-                    switch(type) {
-                        case GL_UNSIGNED_BYTE:
-                            _glKosElementColor4ubU8(dst, count);
-                            break;
+    free(GL_KOS_ELEMENT_CACHE);
 
-                        case GL_UNSIGNED_SHORT:
-                            _glKosElementColor4ubU16(dst, count);
-                            break;
-                    }
+    GL_KOS_ELEMENT_CACHE_SIZE = (count + 1023) & ~1023;
+    GL_KOS_ELEMENT_CACHE = memalign(32, GL_KOS_ELEMENT_CACHE_SIZE * sizeof(pvr_vertex_t));
 
-                break;
-        }
+    if(GL_KOS_ELEMENT_CACHE == NULL) {
+        GL_KOS_ELEMENT_CACHE_SIZE = 0;
+        return 0;
     }
-    else
-        _glKosArrayColor0(dst, count); /* No colors bound */
 
-    /* Check if Texture Coordinates are enabled */
-    if((GL_KOS_VERTEX_PTR_MODE & GL_KOS_USE_TEXTURE0) && (_glKosEnabledTexture2D() >= 0))
-        switch(type) {
-            case GL_UNSIGNED_BYTE:
-                _glKosElementTexCoord2fU8(dst, count);
-                break;
+    return 1;
+}
 
-            case GL_UNSIGNED_SHORT:
-                _glKosElementTexCoord2fU16(dst, count);
-                break;
-        }
+/* Convert the count vertices from start into the element cache, once for the
+   whole draw: lighting or colors, texture coordinates and the Render Matrix
+   transform. The client array pointers are moved to start. */
+static void _glKosArraysFillCache(GLuint start, GLuint count, GLubyte clip) {
+    pvr_vertex_t *dst = GL_KOS_ELEMENT_CACHE;
 
-    /* Check if Multi Texture Coordinates are enabled */
-    if((GL_KOS_VERTEX_PTR_MODE & GL_KOS_USE_TEXTURE1) && (_glKosEnabledTexture2D() >= 0))
-        switch(type) {
-            case GL_UNSIGNED_BYTE:
-                _glKosElementMultiTexCoord2fU8(count);
-                break;
+    GL_KOS_STAT_PEAK(array_buf_peak, count);
 
-            case GL_UNSIGNED_SHORT:
-                _glKosElementMultiTexCoord2fU16(count);
-                break;
-        }
+    GL_KOS_ELEMENT_START = start;
+
+    _glKosArraysAdvance(start);
+
+    GL_KOS_TRACE_BEGIN(color);
+
+    /* Check if Vertex Lighting is enabled. Else, check for Color Submission */
+    if((GL_KOS_VERTEX_PTR_MODE & GL_KOS_USE_NORMAL) && _glKosEnabledLighting()) {
+        _glKosArraysApplyLighting(dst, count);
+
+        _glKosMatrixLoadRender(); /* Lighting replaced it */
+    }
+    else
+        _glKosArraysApplyColor(dst, count);
 
-    _glKosMatrixApplyRender(); /* Apply the Render Matrix Stack */
+    GL_KOS_TRACE_END(color, "color");
 
-    if(!(_glKosEnabledNearZClip())) {/* Transform the element vertices */
+    if(!clip)
         /* Transform vertices with perspective divide */
-        _glKosArraysTransformElements(count);
+        _glKosArraysTransformElements(dst, count);
+    else
+        /* Transform vertices with no perspective divide, store w component */
+        _glKosArraysTransformClipElements(dst, count);
 
-        /* Unpack the indexed positions into primitives for rasterization */
-        switch(type) {
-            case GL_UNSIGNED_BYTE:
-                _glKosArraysUnpackElementsS8(dst, count);
-                break;
+    GL_KOS_TRACE_BEGIN(texcoord);
 
-            case GL_UNSIGNED_SHORT:
-                _glKosArraysUnpackElementsS16(dst, count);
-                break;
-        }
+    /* Check if Texture Coordinates are enabled */
+    if((GL_KOS_VERTEX_PTR_MODE & GL_KOS_USE_TEXTURE0) && (_glKosEnabledTexture2D() >= 0))
+        _glKosArrayTexCoord2f(dst, count);
 
-        /* Set the vertex flags for use with the PVR */
-        _glKosArraysApplyVertexFlags(mode, dst, count);
+    GL_KOS_TRACE_END(texcoord, "texcoord");
+}
+
+/* Copy the cached vertices of count elements of the index type to dst, with their
+   PVR flags set. type is constant in every caller, see below. */
+static inline void _glKosArraysGather(GLenum type, GLenum mode, pvr_vertex_t *dst, GLuint count) {
+    GL_KOS_TRACE("gather");
+
+    /* Kept in locals, the stores to dst could alias the globals */
+    const pvr_vertex_t *cache = GL_KOS_ELEMENT_CACHE;
+    const GLuint start = GL_KOS_ELEMENT_START;
+    const GLubyte *index8 = GL_KOS_INDEX_POINTER_U8;
+    const GLushort *index16 = GL_KOS_INDEX_POINTER_U16;
+    const GLuint *index32 = GL_KOS_INDEX_POINTER_U32;
+    GLuint i, n, k = 0;
+
+    for(i = 0; i < count; i++) {
+        n = (type == GL_UNSIGNED_BYTE ? index8[i] :
+             type == GL_UNSIGNED_SHORT ? index16[i] : index32[i]) - start;
+
+        /* Into the slot _glKosArraysKernelVertex() then sets the flags of */
+        _glKosVertexCopyPVR(&cache[n], &dst[mode == GL_QUADS ? i ^ ((i >> 1) & 1) : i]);
+        _glKosArraysKernelVertex(mode, dst, i, count, &k);
     }
-    else {
-        /* Transform vertices with no perspective divide, store w component */
-        _glKosArraysTransformClipElements(count);
+}
 
-        /* Unpack the indexed positions into primitives for rasterization */
-        switch(type) {
-            case GL_UNSIGNED_BYTE:
-                _glKosArraysUnpackClipElementsS8(dst, count);
-                break;
+/* The same, for near-Z clipping: no flags, and the w of each vertex to W */
+static inline void _glKosArraysGatherClip(GLenum type, pvr_vertex_t *dst, GLfloat *W, GLuint count) {
+    GLuint i, n;
 
-            case GL_UNSIGNED_SHORT:
-                _glKosArraysUnpackClipElementsS16(dst, count);
-                break;
-        }
+    for(i = 0; i < count; i++) {
+        n = _glKosArraysIndex(type, i) - GL_KOS_ELEMENT_START;
+
+        _glKosVertexCopyPVR(&GL_KOS_ELEMENT_CACHE[n], &dst[i]);
+        W[i] = GL_KOS_ARRAY_BUFW[n];
+    }
+}
+
+static void _glKosArraysGatherElements(GLenum type, GLenum mode, pvr_vertex_t *dst, GLuint count) {
+    switch(type) {
+        case GL_UNSIGNED_BYTE:
+            _glKosArraysGather(GL_UNSIGNED_BYTE, mode, dst, count);
+            break;
+
+        case GL_UNSIGNED_SHORT:
+            _glKosArraysGather(GL_UNSIGNED_SHORT, mode, dst, count);
+            break;
+
+        case GL_UNSIGNED_INT:
+            _glKosArraysGather(GL_UNSIGNED_INT, mode, dst, count);
+            break;
+    }
+}
+
+static GLubyte _glKosDrawElementsPiece(GLenum mode, GLenum type, GLuint count) {
+    GLubyte clip = _glKosEnabledNearZClip() && GL_KOS_VERTEX_SIZE == 3;
+
+    if(!(clip ? _glKosArraysReserve(mode, count, "glDrawElements") :
+         _glKosVertexBufReserve(count, "glDrawElements")))
+        return 0;
+
+    /* Check if Multi Texture Coordinates are enabled */
+    if((GL_KOS_VERTEX_PTR_MODE & GL_KOS_USE_TEXTURE1) && (_glKosEnabledTexture2D() >= 0))
+        _glKosElementMultiTexCoord2f(type, count, clip);
+
+    if(!clip)
+        /* Gather the cached vertices into primitives for rasterization */
+        _glKosArraysGatherElements(type, mode, _glKosVertexBufPointer(), count);
+    else {
+        /* Gather the cached vertices and their w component, then clip them */
+        _glKosArraysGatherClip(type, _glKosClipBufAddress(), GL_KOS_ARRAY_DSTW, count);
 
         count = _glKosArraysApplyClipping(GL_KOS_ARRAY_BUFUV, 2, mode, count);
     }
@@ -990,6 +1029,255 @@ GLAPI void APIENTRY glDrawElements(GLenum mode, GLsizei count, GLenum type, cons
     _glKosArraysApplyMultiTexture(mode, count);
 
     _glKosArraysFlush(count);
+
+    return 1;
+}
+
+/* Submit the n strips of count elements from the element cache, back to back in one
+   piece, each ending with an EOL vertex */
+static GLubyte _glKosDrawStripsPiece(const GLushort *strips, GLuint n, GLuint count) {
+    pvr_vertex_t *dst;
+    GLuint i;
+
+    if(!_glKosVertexBufReserve(count, "glDrawElements"))
+        return 0;
+
+    /* Check if Multi Texture Coordinates are enabled */
+    if((GL_KOS_VERTEX_PTR_MODE & GL_KOS_USE_TEXTURE1) && (_glKosEnabledTexture2D() >= 0))
+        _glKosElementMultiTexCoord2f(GL_UNSIGNED_INT, count, 0);
+
+    for(i = 0, dst = _glKosVertexBufPointer(); i < n; dst += strips[i++]) {
+        _glKosArraysGather(GL_UNSIGNED_INT, GL_TRIANGLE_STRIP, dst, strips[i]);
+
+        GL_KOS_INDEX_POINTER_U32 += strips[i];
+    }
+
+    _glKosArraysApplyMultiTexture(GL_TRIANGLE_STRIP, count);
+
+    _glKosArraysFlush(count);
+
+    return 1;
+}
+
+/* Submit the strips glKosOptimizeElements() made of the elements of a draw. The range
+   is known, so the cache is filled without scanning, then as many whole strips as fit
+   in GL_KOS_MAX_DRAW_VERTS are gathered per piece. */
+static void _glKosArraysDrawStrips(const GL_KOS_ELEMENT_STRIPS *obj) {
+    const GLushort *strips = obj->strips;
+    GLuint i, n, count;
+
+    GL_KOS_INDEX_POINTER_U32 = obj->strip_index;
+
+    _glKosArraysApplyDrawState();
+
+    if(!_glKosArraysCacheReserve(obj->end - obj->start + 1)) {
+        _glKosThrowError(GL_OUT_OF_MEMORY, "glDrawElements");
+        _glKosPrintError();
+        _glKosArraysResetState();
+        return;
+    }
+
+    _glKosArraysFillCache(obj->start, obj->end - obj->start + 1, 0);
+
+    for(i = 0; i < obj->strip_count; i += n) {
+        for(n = 0, count = 0; i + n < obj->strip_count
+            && count + strips[i + n] <= GL_KOS_MAX_DRAW_VERTS; n++)
+            count += strips[i + n];
+
+        if(!_glKosDrawStripsPiece(&strips[i], n, count))
+            break;
+    }
+
+    _glKosArraysResetState();
+}
+
+/* Expand the points or segments of a draw from the element cache into quads, at most
+   GL_KOS_MAX_DRAW_VERTS vertices per piece. The second texture unit is not drawn. */
+static void _glKosArraysDrawExpanded(GLenum mode, const GL_KOS_PRIMITIVE *prim, GLubyte clip,
+                                     char *name) {
+    GLuint per = _glKosPrimitiveQuadElements(mode);
+    GLuint i, n, quads = prim->index_count / per;
+
+    for(i = 0; i < quads; i += n) {
+        n = quads - i < GL_KOS_MAX_DRAW_VERTS / 4 ? quads - i : GL_KOS_MAX_DRAW_VERTS / 4;
+
+        if(!_glKosVertexBufReserve(n * 4, name))
+            break;
+
+        _glKosArraysFlush(_glKosPrimitiveExpand(mode, GL_KOS_ELEMENT_CACHE, clip ? GL_KOS_ARRAY_BUFW : NULL,
+                          prim->index + i * per, GL_KOS_ELEMENT_START, n,
+                          _glKosVertexBufPointer()));
+    }
+
+    _glKosArraysResetState();
+}
+
+/* Submit count vertices or elements of a primitive type the PVR has no strip order
+   for, in the order _glKosPrimitiveBuild() gives, as GL_UNSIGNED_INT elements through
+   the element cache. With end < start, the range is found by scanning the elements. */
+static void _glKosArraysDrawConverted(GLenum mode, GLenum type, GLuint count,
+                                      GLuint start, GLuint end) {
+    char *name = type ? "glDrawElements" : "glDrawArrays";
+    GLubyte clip = _glKosEnabledNearZClip() && GL_KOS_VERTEX_SIZE == 3;
+    GL_KOS_ELEMENT_STRIPS strips;
+    GL_KOS_PRIMITIVE prim;
+    GLuint i;
+
+    if(GL_KOS_LIST_RECORD && _glKosPrimitiveExpanded(mode)) { /* Points and lines are not recorded */
+        _glKosThrowError(GL_INVALID_OPERATION, name);
+        _glKosPrintError();
+        _glKosArraysResetState();
+        return;
+    }
+
+    /* Near-Z clipping and Display Lists take the triangles of a fan */
+    if(!_glKosPrimitiveBuild(mode, count, clip || GL_KOS_LIST_RECORD, &prim)) {
+        _glKosThrowError(GL_OUT_OF_MEMORY, name);
+        _glKosPrintError();
+        _glKosArraysResetState();
+        return;
+    }
+
+    if(!prim.index_count) {
+        _glKosArraysResetState();
+        return;
+    }
+
+    if(type) /* Through the elements of the draw */
+        for(i = 0; i < prim.index_count; i++)
+            prim.index[i] = _glKosArraysIndex(type, prim.index[i]);
+
+    GL_KOS_INDEX_POINTER_U32 = prim.index;
+
+    if(GL_KOS_LIST_RECORD) { /* Compiling a Display List */
+        _glKosArraysRecord(GL_TRIANGLES, GL_UNSIGNED_INT, prim.index_count);
+        _glKosArraysResetState();
+        return;
+    }
+
+    if(end < start)
+        _glKosArraysElementRange(GL_UNSIGNED_INT, prim.index_count, &start, &end);
+
+    if(end - start >= GL_KOS_MAX_VERTS) {
+        _glKosThrowError(GL_OUT_OF_MEMORY, name);
+        _glKosPrintError();
+        _glKosArraysResetState();
+        return;
+    }
+
+    if(prim.strips) {
+        strips.start = start;
+        strips.end = end;
+        strips.strip_index = prim.index;
+        strips.strips = prim.strips;
+        strips.strip_count = prim.strip_count;
+
+        _glKosArraysDrawStrips(&strips);
+        return;
+    }
+
+    _glKosArraysApplyDrawState();
+
+    if(!_glKosArraysCacheReserve(end - start + 1)) {
+        _glKosThrowError(GL_OUT_OF_MEMORY, name);
+        _glKosPrintError();
+        _glKosArraysResetState();
+        return;
+    }
+
+    _glKosArraysFillCache(start, end - start + 1, clip);
+
+    if(_glKosPrimitiveExpanded(mode))
+        _glKosArraysDrawExpanded(mode, &prim, clip, name);
+    else
+        _glKosArraysDrawPieces(GL_TRIANGLES, GL_UNSIGNED_INT, prim.index_count, _glKosDrawElementsPiece);
+}
+
+/* Submit count elements that reference the vertices start to end, once the parameters
+   are verified. With end < start, the range is found by scanning the elements. */
+static void _glKosArraysDrawElements(GLenum mode, GLsizei count, GLenum type,
+                                     const GLvoid *indices, GLuint start, GLuint end) {
+    GL_KOS_ELEMENT_STRIPS *strips;
+
+    if(mode == GL_QUAD_STRIP) { /* A triangle strip of whole quads */
+        mode = GL_TRIANGLE_STRIP;
+        count &= ~1;
+    }
+
+    /* Elements converted to strips by glKosOptimizeElements(). Near-Z clipping cuts
+       strips into separate triangles, so clipped draws keep the triangle list. */
+    strips = mode == GL_TRIANGLES && !GL_KOS_LIST_RECORD
+             && !(_glKosEnabledNearZClip() && GL_KOS_VERTEX_SIZE == 3) ?
+             _glKosElementStrips(indices, count, type) : NULL;
+
+    _glKosArraysIndexPointer(type, indices);
+
+    if(_glKosPrimitiveConverted(mode)) {
+        _glKosArraysDrawConverted(mode, type, count, start, end);
+        return;
+    }
+
+    if(GL_KOS_LIST_RECORD) { /* Compiling a Display List */
+        _glKosArraysRecord(mode, type, count);
+        _glKosArraysResetState();
+        return;
+    }
+
+    if(strips) {
+        _glKosArraysDrawStrips(strips);
+        return;
+    }
+
+    if(_glKosArraysDrawPacked(mode, type, 0, count))
+        return;
+
+    if(!count) {
+        _glKosArraysResetState();
+        return;
+    }
+
+    if(end < start)
+        _glKosArraysElementRange(type, count, &start, &end);
+
+    _glKosArraysApplyDrawState();
+
+    /* When the elements reference more vertices than there are elements, converting
+       each element in a single pass does less work than filling the cache */
+    if((end - start >= (GLuint)count || end - start >= GL_KOS_MAX_VERTS)
+       && _glKosArraysDrawKernel(mode, type, count))
+        return;
+
+    if(end - start >= GL_KOS_MAX_VERTS || !_glKosArraysCacheReserve(end - start + 1)) {
+        _glKosThrowError(GL_OUT_OF_MEMORY, "glDrawElements");
+        _glKosPrintError();
+        _glKosArraysResetState();
+        return;
+    }
+
+    /* Convert each referenced vertex once, every piece gathers from the cache */
+    _glKosArraysFillCache(start, end - start + 1, _glKosEnabledNearZClip() && GL_KOS_VERTEX_SIZE == 3);
+
+    _glKosArraysDrawPieces(mode, type, count, _glKosDrawElementsPiece);
+}
+
+GLAPI void APIENTRY glDrawElements(GLenum mode, GLsizei count, GLenum type, const GLvoid *indices) {
+    /* Before we process the vertex data, ensure all parameters are valid */
+    if(_glKosArraysVerifyParameter(mode, count, type, 1) && !_glKosArraysCulled())
+        _glKosArraysDrawElements(mode, count, type, indices, 1, 0);
+
+    _glKosBoundsEnd();
+}
+
+GLAPI void APIENTRY glDrawRangeElements(GLenum mode, GLuint start, GLuint end,
+                                        GLsizei count, GLenum type, const GLvoid *indices) {
+    if(end < start) {
+        _glKosThrowError(GL_INVALID_VALUE, "glDrawRangeElements");
+        _glKosPrintError();
+    }
+    else if(_glKosArraysVerifyParameter(mode, count, type, 1) && !_glKosArraysCulled())
+        _glKosArraysDrawElements(mode, count, type, indices, start, end);
+
+    _glKosBoundsEnd();
 }
 
 //========================================================================================//
@@ -1041,6 +1329,41 @@ static inline void _glKosArrayColor4f(pvr_vertex_t *dst, GLuint count) {
     }
 }
 
+/* Colors of count vertices, from the Color Pointer or the current color */
+static void _glKosArraysApplyColor(pvr_vertex_t *dst, GLuint count) {
+    if(!(GL_KOS_VERTEX_PTR_MODE & GL_KOS_USE_COLOR)) {
+        _glKosArrayColor0(dst, count); /* No colors bound */
+        return;
+    }
+
+    switch(GL_KOS_COLOR_TYPE) {
+        case GL_FLOAT:
+            switch(GL_KOS_COLOR_COMPONENTS) {
+                case 3:
+                    _glKosArrayColor3f(dst, count);
+                    break;
+
+                case 4:
+                    _glKosArrayColor4f(dst, count);
+                    break;
+            }
+
+            break;
+
+        case GL_UNSIGNED_INT:
+            if(GL_KOS_COLOR_COMPONENTS == 1)
+                _glKosArrayColor1ui(dst, count);
+
+            break;
+
+        case GL_UNSIGNED_BYTE:
+            if(GL_KOS_COLOR_COMPONENTS == 4)
+                _glKosArrayColor4ub(dst, count);
+
+            break;
+    }
+}
+
 //== Texture Coordinates ==//
 
 static inline void _glKosArrayTexCoord2f(pvr_vertex_t *dst, GLuint count) {
@@ -1085,111 +1408,464 @@ static inline void _glKosArrayMultiTexCoord2f(GLuint count) {
 }
 
 //========================================================================================//
-//== Open GL Draw Arrays ==//
+//== Single Pass Kernels ==//
+
+/* When the elements of a glDrawElements() reference more vertices than there are
+   elements, filling the element cache would convert vertices no element uses.
+   If no lighting, Multi-Texture, texture matrix or near-Z clipping is needed, a
+   kernel specialized at compile time for the pointers and index type converts
+   each element in one pass instead, straight from the indexed vertices.
+   glDrawArrays() has the interleaved arrays kernels below; with separate pointers,
+   its passes measured faster than a kernel. The kernels of type 0 read the arrays
+   in order, for the sub-draws of a multi-draw, too short to amortize the passes. */
+
+/* Packed ARGB of a color of the GL_KOS_KERNEL_* source */
+static inline GLuint _glKosArraysKernelColor(const GLfloat *c, GLuint color, GLuint argb) {
+    switch(color) {
+        case GL_KOS_KERNEL_1UI:
+            return *(GLuint *)c;
+
+        case GL_KOS_KERNEL_4UB:
+            return RGBA32_2_ARGB32(*(GLuint *)c);
+
+        case GL_KOS_KERNEL_3F:
+            return (0xFF000000 | ((GLubyte)(c[0] * 0xFF)) << 16
+                    | ((GLubyte)(c[1] * 0xFF)) << 8
+                    | ((GLubyte)(c[2] * 0xFF)));
+
+        case GL_KOS_KERNEL_4F:
+            return (((GLubyte)(c[3] * 0xFF)) << 24
+                    | ((GLubyte)(c[0] * 0xFF)) << 16
+                    | ((GLubyte)(c[1] * 0xFF)) << 8
+                    | ((GLubyte)(c[2] * 0xFF)));
+    }
 
-static void _glKosDrawArrays2D(GLenum mode, GLint first, GLsizei count) {
-    pvr_vertex_t *dst = _glKosVertexBufPointer();
+    return argb;
+}
 
-    /* Check for Color Submission */
-    if(GL_KOS_VERTEX_PTR_MODE & GL_KOS_USE_COLOR) {
-        switch(GL_KOS_COLOR_TYPE) {
-            case GL_FLOAT:
-                switch(GL_KOS_COLOR_COMPONENTS) {
-                    case 3:
-                        _glKosArrayColor3f(dst, count);
-                        break;
+/* Convert count elements of the index type, reading each attribute through its
+   own pointer and stride. Every argument after count is constant in the kernels
+   of the table, so the compiler drops the branches on them. */
+static inline void _glKosArraysKernel(GLenum mode, pvr_vertex_t *dst, GLuint count,
+                                      GLenum type, GLuint vsize, GLuint color, GLuint tex) {
+    GL_KOS_TRACE("kernel");
+
+    /* Kept in locals, the stores to dst could alias the globals */
+    const GLfloat *pos = GL_KOS_VERTEX_POINTER, *uv = GL_KOS_TEXCOORD0_POINTER;
+    const GLfloat *col = GL_KOS_COLOR_POINTER, *p;
+    const GLuint vstride = GL_KOS_VERTEX_STRIDE, tstride = GL_KOS_TEXCOORD0_STRIDE;
+    const GLuint cstride = GL_KOS_COLOR_STRIDE;
+    const GLubyte *index8 = GL_KOS_INDEX_POINTER_U8;
+    const GLushort *index16 = GL_KOS_INDEX_POINTER_U16;
+    const GLuint *index32 = GL_KOS_INDEX_POINTER_U32;
+    const GLuint argb = _glKosVertexColor();
+    pvr_vertex_t *d;
+    GLuint i, n, k = 0;
+
+    register float __x  GL_KOS_FREG("fr12");
+    register float __y  GL_KOS_FREG("fr13");
+    register float __z  GL_KOS_FREG("fr14");
+
+    for(i = 0; i < count; i++) {
+        n = type == GL_UNSIGNED_BYTE ? index8[i] :
+            type == GL_UNSIGNED_SHORT ? index16[i] :
+            type == GL_UNSIGNED_INT ? index32[i] : i;
 
-                    case 4:
-                        _glKosArrayColor4f(dst, count);
-                        break;
-                }
+        p = pos + n * vstride;
 
-                break;
+        __x = p[0];
+        __y = p[1];
+        __z = vsize == 3 ? p[2] : 0;
 
-            case GL_UNSIGNED_INT:
-                if(GL_KOS_COLOR_COMPONENTS == 1)
-                    _glKosArrayColor1ui(dst, count);
+        mat_trans_fv12()
 
-                break;
+        d = _glKosArraysKernelVertex(mode, dst, i, count, &k);
 
-            case GL_UNSIGNED_BYTE:
-                if(GL_KOS_COLOR_COMPONENTS == 4)
-                    _glKosArrayColor4ub(dst, count);
+        d->x = __x;
+        d->y = __y;
+        d->z = __z;
 
-                break;
+        if(tex) {
+            d->u = uv[n * tstride];
+            d->v = uv[n * tstride + 1];
         }
+        else
+            d->u = d->v = 0;
+
+        d->argb = _glKosArraysKernelColor(col + n * cstride, color, argb);
+        d->oargb = 0;
     }
-    else
-        _glKosArrayColor0(dst, count); /* No colors bound */
+}
 
-    /* Check if Texture Coordinates are enabled */
-    if((GL_KOS_VERTEX_PTR_MODE & GL_KOS_USE_TEXTURE0) && (_glKosEnabledTexture2D() >= 0))
-        _glKosArrayTexCoord2f(dst, count);
+/* One kernel for every index type, position size, color source and texture
+   coordinates or not. The color sources are numbered as GL_KOS_KERNEL_*. */
+#define GL_KOS_KERNEL_U8  GL_UNSIGNED_BYTE
+#define GL_KOS_KERNEL_U16 GL_UNSIGNED_SHORT
+#define GL_KOS_KERNEL_U32 GL_UNSIGNED_INT
+#define GL_KOS_KERNEL_A   0
 
-    _glKosMatrixApplyRender(); /* Apply the Render Matrix Stack */
+#define GL_KOS_KERNEL_NAME(i, v, c, t) _glKosArraysKernel##i##_V##v##_C##c##_T##t
 
-    /* Transform Vertex Positions */
-    _glKosArraysTransform2D(count);
+#define GL_KOS_KERNEL_DEFINE(i, v, c, t) \
+    static void GL_KOS_KERNEL_NAME(i, v, c, t)(GLenum mode, pvr_vertex_t *dst, GLuint count) { \
+        _glKosArraysKernel(mode, dst, count, GL_KOS_KERNEL_##i, v, c, t); \
+    }
 
-    /* Set the vertex flags for use with the PVR */
-    _glKosArraysApplyVertexFlags(mode, dst, count);
+#define GL_KOS_KERNEL_ENTRY(i, v, c, t) GL_KOS_KERNEL_NAME(i, v, c, t),
+
+#define GL_KOS_KERNELS_C(X, i, v, c) X(i, v, c, 0) X(i, v, c, 1)
+
+#define GL_KOS_KERNELS_V(X, i, v) \
+    GL_KOS_KERNELS_C(X, i, v, 0) GL_KOS_KERNELS_C(X, i, v, 1) GL_KOS_KERNELS_C(X, i, v, 2) \
+    GL_KOS_KERNELS_C(X, i, v, 3) GL_KOS_KERNELS_C(X, i, v, 4)
+
+#define GL_KOS_KERNELS(X, i) GL_KOS_KERNELS_V(X, i, 2) GL_KOS_KERNELS_V(X, i, 3)
+
+GL_KOS_KERNELS(GL_KOS_KERNEL_DEFINE, U8)
+GL_KOS_KERNELS(GL_KOS_KERNEL_DEFINE, U16)
+GL_KOS_KERNELS(GL_KOS_KERNEL_DEFINE, U32)
+GL_KOS_KERNELS(GL_KOS_KERNEL_DEFINE, A)
+
+/* Indexed by the index type, or arrays, then by GL_KOS_ARRAYS_KEY */
+static const GL_KOS_ARRAYS_KERNEL GL_KOS_ARRAYS_KERNELS[4][GL_KOS_KERNEL_KEYS] = {
+    { GL_KOS_KERNELS(GL_KOS_KERNEL_ENTRY, U8) },
+    { GL_KOS_KERNELS(GL_KOS_KERNEL_ENTRY, U16) },
+    { GL_KOS_KERNELS(GL_KOS_KERNEL_ENTRY, U32) },
+    { GL_KOS_KERNELS(GL_KOS_KERNEL_ENTRY, A) },
+};
+
+#undef GL_KOS_KERNEL_U8
+#undef GL_KOS_KERNEL_U16
+#undef GL_KOS_KERNEL_U32
+#undef GL_KOS_KERNEL_A
+#undef GL_KOS_KERNEL_NAME
+#undef GL_KOS_KERNEL_DEFINE
+#undef GL_KOS_KERNEL_ENTRY
+#undef GL_KOS_KERNELS_C
+#undef GL_KOS_KERNELS_V
+#undef GL_KOS_KERNELS
+
+/* The pointers changed, find the kernel table key they select */
+static void _glKosArraysUpdateKey() {
+    GLuint color = GL_KOS_KERNEL_COLOR0;
+
+    if(GL_KOS_VERTEX_PTR_MODE & GL_KOS_USE_COLOR)
+        switch(GL_KOS_COLOR_TYPE) {
+            case GL_UNSIGNED_INT:
+                color = GL_KOS_KERNEL_1UI;
+                break;
 
-    _glKosArraysFlush(count);
-}
+            case GL_UNSIGNED_BYTE:
+                color = GL_KOS_KERNEL_4UB;
+                break;
 
-GLAPI void APIENTRY glDrawArrays(GLenum mode, GLint first, GLsizei count) {
-    /* Before we process the vertex data, ensure all parameters are valid */
-    if(!_glKosArraysVerifyParameter(mode, count, first, 0))
-        return;
+            case GL_FLOAT:
+                color = GL_KOS_COLOR_COMPONENTS == 3 ? GL_KOS_KERNEL_3F : GL_KOS_KERNEL_4F;
+                break;
+        }
 
-    GL_KOS_VERTEX_POINTER   += first;       /* Add Pointer Offset */
-    GL_KOS_TEXCOORD0_POINTER += first;
-    GL_KOS_COLOR_POINTER    += first;
-    GL_KOS_NORMAL_POINTER   += first;
+    GL_KOS_ARRAYS_COLOR = color;
+    GL_KOS_ARRAYS_KEY = ((GL_KOS_VERTEX_SIZE == 3) * GL_KOS_KERNEL_COLORS + color) * 2
+                        + ((GL_KOS_VERTEX_PTR_MODE & GL_KOS_USE_TEXTURE0) != 0);
+}
 
-    /* Compile the PVR polygon context with the currently enabled flags */
-    _glKosArraysApplyHeader();
+/* The kernel for a glDrawElements() of the index type, or for arrays with type 0,
+   or NULL if lighting, Multi-Texture, the texture matrix or near-Z clipping needs
+   the fallback passes */
+static GL_KOS_ARRAYS_KERNEL _glKosArraysTableKernel(GLenum type) {
+    if(GL_KOS_VERTEX_PTR_MODE & GL_KOS_USE_TEXTURE1)
+        return NULL;
 
-    if(GL_KOS_VERTEX_SIZE == 2)
-        return _glKosDrawArrays2D(mode, first, count);
+    if((GL_KOS_VERTEX_PTR_MODE & GL_KOS_USE_TEXTURE0) && _glKosEnabledTextureMatrix())
+        return NULL;
 
-    /* Destination of Output Vertex Array */
-    pvr_vertex_t *dst = _glKosArraysDest();
+    if(_glKosEnabledNearZClip())
+        return NULL;
 
-    /* Check if Vertex Lighting is enabled. Else, check for Color Submission */
     if((GL_KOS_VERTEX_PTR_MODE & GL_KOS_USE_NORMAL) && _glKosEnabledLighting())
-        _glKosArraysApplyLighting(dst, count);
+        return NULL;
 
-    else if(GL_KOS_VERTEX_PTR_MODE & GL_KOS_USE_COLOR) {
-        switch(GL_KOS_COLOR_TYPE) {
-            case GL_FLOAT:
-                switch(GL_KOS_COLOR_COMPONENTS) {
-                    case 3:
-                        _glKosArrayColor3f(dst, count);
-                        break;
+    switch(type) {
+        case GL_UNSIGNED_SHORT:
+            return GL_KOS_ARRAYS_KERNELS[1][GL_KOS_ARRAYS_KEY];
 
-                    case 4:
-                        _glKosArrayColor4f(dst, count);
-                        break;
-                }
+        case GL_UNSIGNED_INT:
+            return GL_KOS_ARRAYS_KERNELS[2][GL_KOS_ARRAYS_KEY];
 
-                break;
+        case 0:
+            return GL_KOS_ARRAYS_KERNELS[3][GL_KOS_ARRAYS_KEY];
+    }
 
-            case GL_UNSIGNED_INT:
-                if(GL_KOS_COLOR_COMPONENTS == 1)
-                    _glKosArrayColor1ui(dst, count);
+    return GL_KOS_ARRAYS_KERNELS[0][GL_KOS_ARRAYS_KEY];
+}
 
-                break;
+//========================================================================================//
+//== Interleaved Arrays ==//
 
-            case GL_UNSIGNED_BYTE:
-                if(GL_KOS_COLOR_COMPONENTS == 4)
-                    _glKosArrayColor4ub(dst, count);
+/* Convert count interleaved vertices in one pass, like the kernels of the table
+   but with every attribute at a constant offset from the vertex position pointer,
+   with the source prefetched ahead. t, c and v are the offsets of the texture
+   coordinates, color and position in the vertex, in floats. */
+static inline void _glKosInterleavedKernel(GLenum mode, pvr_vertex_t *dst, GLuint count,
+        GLuint tex, GLuint color, GLuint t, GLuint c, GLuint v, GLuint vsize) {
+    GL_KOS_TRACE("interleaved");
 
-                break;
+    const GLfloat *src = GL_KOS_VERTEX_POINTER - v;
+    const GLuint stride = GL_KOS_VERTEX_STRIDE;
+    const GLuint argb = _glKosVertexColor();
+    pvr_vertex_t *d;
+    GLuint i, k = 0;
+
+    register float __x  GL_KOS_FREG("fr12");
+    register float __y  GL_KOS_FREG("fr13");
+    register float __z  GL_KOS_FREG("fr14");
+
+    for(i = 0; i < count; i++, src += stride) {
+        GL_KOS_PREFETCH(src + stride * 2);
+
+        __x = src[v];
+        __y = src[v + 1];
+        __z = vsize == 3 ? src[v + 2] : 0;
+
+        mat_trans_fv12()
+
+        d = _glKosArraysKernelVertex(mode, dst, i, count, &k);
+
+        d->x = __x;
+        d->y = __y;
+        d->z = __z;
+
+        if(tex) {
+            d->u = src[t];
+            d->v = src[t + 1];
         }
+        else
+            d->u = d->v = 0;
+
+        d->argb = _glKosArraysKernelColor(src + c, color, argb);
+        d->oargb = 0;
     }
+}
+
+static void _glKosInterleavedV2F(GLenum mode, pvr_vertex_t *dst, GLuint count) {
+    _glKosInterleavedKernel(mode, dst, count, 0, GL_KOS_KERNEL_COLOR0, 0, 0, 0, 2);
+}
+
+static void _glKosInterleavedV3F(GLenum mode, pvr_vertex_t *dst, GLuint count) {
+    _glKosInterleavedKernel(mode, dst, count, 0, GL_KOS_KERNEL_COLOR0, 0, 0, 0, 3);
+}
+
+static void _glKosInterleavedC4UB_V2F(GLenum mode, pvr_vertex_t *dst, GLuint count) {
+    _glKosInterleavedKernel(mode, dst, count, 0, GL_KOS_KERNEL_4UB, 0, 0, 1, 2);
+}
+
+static void _glKosInterleavedC4UB_V3F(GLenum mode, pvr_vertex_t *dst, GLuint count) {
+    _glKosInterleavedKernel(mode, dst, count, 0, GL_KOS_KERNEL_4UB, 0, 0, 1, 3);
+}
+
+static void _glKosInterleavedC3F_V3F(GLenum mode, pvr_vertex_t *dst, GLuint count) {
+    _glKosInterleavedKernel(mode, dst, count, 0, GL_KOS_KERNEL_3F, 0, 0, 3, 3);
+}
+
+static void _glKosInterleavedN3F_V3F(GLenum mode, pvr_vertex_t *dst, GLuint count) {
+    _glKosInterleavedKernel(mode, dst, count, 0, GL_KOS_KERNEL_COLOR0, 0, 0, 3, 3);
+}
+
+static void _glKosInterleavedC4F_N3F_V3F(GLenum mode, pvr_vertex_t *dst, GLuint count) {
+    _glKosInterleavedKernel(mode, dst, count, 0, GL_KOS_KERNEL_4F, 0, 0, 7, 3);
+}
+
+static void _glKosInterleavedT2F_V3F(GLenum mode, pvr_vertex_t *dst, GLuint count) {
+    _glKosInterleavedKernel(mode, dst, count, 1, GL_KOS_KERNEL_COLOR0, 0, 0, 2, 3);
+}
+
+static void _glKosInterleavedT2F_C4UB_V3F(GLenum mode, pvr_vertex_t *dst, GLuint count) {
+    _glKosInterleavedKernel(mode, dst, count, 1, GL_KOS_KERNEL_4UB, 0, 2, 3, 3);
+}
+
+static void _glKosInterleavedT2F_C3F_V3F(GLenum mode, pvr_vertex_t *dst, GLuint count) {
+    _glKosInterleavedKernel(mode, dst, count, 1, GL_KOS_KERNEL_3F, 0, 2, 5, 3);
+}
+
+static void _glKosInterleavedT2F_N3F_V3F(GLenum mode, pvr_vertex_t *dst, GLuint count) {
+    _glKosInterleavedKernel(mode, dst, count, 1, GL_KOS_KERNEL_COLOR0, 0, 0, 5, 3);
+}
+
+static void _glKosInterleavedT2F_C4F_N3F_V3F(GLenum mode, pvr_vertex_t *dst, GLuint count) {
+    _glKosInterleavedKernel(mode, dst, count, 1, GL_KOS_KERNEL_4F, 0, 2, 9, 3);
+}
+
+#define GL_KOS_V GL_KOS_USE_ARRAY
+#define GL_KOS_T GL_KOS_USE_TEXTURE0
+#define GL_KOS_C GL_KOS_USE_COLOR
+#define GL_KOS_N GL_KOS_USE_NORMAL
+
+static const GL_KOS_INTERLEAVED_FORMAT GL_KOS_INTERLEAVED_FORMATS[] = {
+    /* format              arrays                          t  c  n  v  cs vs stride type */
+    { GL_V2F,              GL_KOS_V,                       0, 0, 0, 0, 0, 2, 2,  0,                _glKosInterleavedV2F },
+    { GL_V3F,              GL_KOS_V,                       0, 0, 0, 0, 0, 3, 3,  0,                _glKosInterleavedV3F },
+    { GL_C4UB_V2F,         GL_KOS_V | GL_KOS_C,            0, 0, 0, 1, 4, 2, 3,  GL_UNSIGNED_BYTE, _glKosInterleavedC4UB_V2F },
+    { GL_C4UB_V3F,         GL_KOS_V | GL_KOS_C,            0, 0, 0, 1, 4, 3, 4,  GL_UNSIGNED_BYTE, _glKosInterleavedC4UB_V3F },
+    { GL_C3F_V3F,          GL_KOS_V | GL_KOS_C,            0, 0, 0, 3, 3, 3, 6,  GL_FLOAT,         _glKosInterleavedC3F_V3F },
+    { GL_N3F_V3F,          GL_KOS_V | GL_KOS_N,            0, 0, 0, 3, 0, 3, 6,  0,                _glKosInterleavedN3F_V3F },
+    { GL_C4F_N3F_V3F,      GL_KOS_V | GL_KOS_C | GL_KOS_N, 0, 0, 4, 7, 4, 3, 10, GL_FLOAT,         _glKosInterleavedC4F_N3F_V3F },
+    { GL_T2F_V3F,          GL_KOS_V | GL_KOS_T,            0, 0, 0, 2, 0, 3, 5,  0,                _glKosInterleavedT2F_V3F },
+    { GL_T2F_C4UB_V3F,     GL_KOS_V | GL_KOS_T | GL_KOS_C, 0, 2, 0, 3, 4, 3, 6,  GL_UNSIGNED_BYTE, _glKosInterleavedT2F_C4UB_V3F },
+    { GL_T2F_C3F_V3F,      GL_KOS_V | GL_KOS_T | GL_KOS_C, 0, 2, 0, 5, 3, 3, 8,  GL_FLOAT,         _glKosInterleavedT2F_C3F_V3F },
+    { GL_T2F_N3F_V3F,      GL_KOS_V | GL_KOS_T | GL_KOS_N, 0, 0, 2, 5, 0, 3, 8,  0,                _glKosInterleavedT2F_N3F_V3F },
+    { GL_T2F_C4F_N3F_V3F,  GL_KOS_V | GL_KOS_T | GL_KOS_C | GL_KOS_N,
+                                                           0, 2, 6, 9, 4, 3, 12, GL_FLOAT,         _glKosInterleavedT2F_C4F_N3F_V3F },
+};
+
+#undef GL_KOS_V
+#undef GL_KOS_T
+#undef GL_KOS_C
+#undef GL_KOS_N
+
+/* The single pass kernel for the interleaved arrays of the draw, or NULL if
+   lighting, Multi-Texture, the texture matrix or near-Z clipping needs the
+   separate attribute passes */
+static GL_KOS_ARRAYS_KERNEL _glKosArraysInterleavedKernel() {
+    const GL_KOS_INTERLEAVED_FORMAT *fmt = GL_KOS_INTERLEAVED;
+
+    if(fmt == NULL || GL_KOS_VERTEX_PTR_MODE != fmt->attribs)
+        return NULL;
+
+    if((fmt->attribs & GL_KOS_USE_TEXTURE0) && _glKosEnabledTextureMatrix())
+        return NULL;
+
+    if(fmt->vertex_size == 3) {
+        if(_glKosEnabledNearZClip())
+            return NULL;
+
+        if((fmt->attribs & GL_KOS_USE_NORMAL) && _glKosEnabledLighting())
+            return NULL;
+    }
+
+    return fmt->kernel;
+}
+
+GLAPI void APIENTRY glInterleavedArrays(GLenum format, GLsizei stride, const GLvoid *pointer) {
+    const GL_KOS_INTERLEAVED_FORMAT *fmt = NULL;
+    const GLfloat *src = (const GLfloat *)pointer;
+    GLubyte i;
+
+    for(i = 0; i < sizeof(GL_KOS_INTERLEAVED_FORMATS) / sizeof(GL_KOS_INTERLEAVED_FORMAT); i++)
+        if(GL_KOS_INTERLEAVED_FORMATS[i].format == format)
+            fmt = &GL_KOS_INTERLEAVED_FORMATS[i];
+
+    if(fmt == NULL) {
+        _glKosThrowError(GL_INVALID_ENUM, "glInterleavedArrays");
+        _glKosPrintError();
+        return;
+    }
+
+    if(!stride)
+        stride = fmt->stride * 4;
+
+    /* Arrays that are not part of the format are disabled */
+    GL_KOS_VERTEX_PTR_MODE &= ~(GL_KOS_USE_ARRAY | GL_KOS_USE_COLOR | GL_KOS_USE_NORMAL |
+                                (GL_KOS_CLIENT_ACTIVE_TEXTURE ? GL_KOS_USE_TEXTURE1 : GL_KOS_USE_TEXTURE0));
+
+    if(fmt->attribs & GL_KOS_USE_TEXTURE0)
+        glTexCoordPointer(2, GL_FLOAT, stride, src + fmt->texcoord);
+
+    if(fmt->attribs & GL_KOS_USE_COLOR)
+        glColorPointer(fmt->color_size, fmt->color_type, stride, src + fmt->color);
+
+    if(fmt->attribs & GL_KOS_USE_NORMAL)
+        glNormalPointer(GL_FLOAT, stride, src + fmt->normal);
+
+    glVertexPointer(fmt->vertex_size, GL_FLOAT, stride, src + fmt->vertex);
+
+    GL_KOS_INTERLEAVED = fmt;
+}
+
+//========================================================================================//
+//== Open GL Draw Arrays ==//
+
+static GLubyte _glKosDrawArrays2DPiece(GLenum mode, GLenum type, GLuint count) {
+    (void)type; /* Arrays have no element type */
+
+    if(!_glKosVertexBufReserve(count, "glDrawArrays"))
+        return 0;
+
+    pvr_vertex_t *dst = _glKosVertexBufPointer();
+
+    GL_KOS_TRACE_BEGIN(color);
+
+    /* Check for Color Submission */
+    _glKosArraysApplyColor(dst, count);
+
+    GL_KOS_TRACE_END(color, "color");
+
+    GL_KOS_TRACE_BEGIN(texcoord);
+
+    /* Check if Texture Coordinates are enabled */
+    if((GL_KOS_VERTEX_PTR_MODE & GL_KOS_USE_TEXTURE0) && (_glKosEnabledTexture2D() >= 0))
+        _glKosArrayTexCoord2f(dst, count);
+
+    GL_KOS_TRACE_END(texcoord, "texcoord");
+
+    /* Transform Vertex Positions */
+    _glKosArraysTransform2D(count);
+
+    /* Set the vertex flags for use with the PVR */
+    _glKosArraysApplyVertexFlags(mode, dst, count);
+
+    _glKosArraysFlush(count);
+
+    return 1;
+}
+
+static GL_KOS_ARRAYS_KERNEL GL_KOS_ARRAYS_DRAW_KERNEL = NULL; /* Of the draw in progress */
+
+static GLubyte _glKosDrawKernelPiece(GLenum mode, GLenum type, GLuint count) {
+    if(!_glKosVertexBufReserve(count, type ? "glDrawElements" : "glDrawArrays"))
+        return 0;
+
+    GL_KOS_ARRAYS_DRAW_KERNEL(mode, _glKosVertexBufPointer(), count);
+
+    _glKosArraysFlush(count);
+
+    return 1;
+}
+
+/* Submit the draw with a single pass kernel, if one covers the current state:
+   the interleaved arrays kernel for glDrawArrays(), the kernel table for
+   glDrawElements(). The header and Render Matrix are already applied. */
+static GLubyte _glKosArraysDrawKernel(GLenum mode, GLenum type, GLuint count) {
+    GL_KOS_ARRAYS_DRAW_KERNEL = type ? _glKosArraysTableKernel(type) : _glKosArraysInterleavedKernel();
+
+    if(GL_KOS_ARRAYS_DRAW_KERNEL == NULL)
+        return 0;
+
+    _glKosArraysDrawPieces(mode, type, count, _glKosDrawKernelPiece);
+
+    return 1;
+}
+
+static GLubyte _glKosDrawArraysPiece(GLenum mode, GLenum type, GLuint count) {
+    (void)type; /* Arrays have no element type */
+
+    if(!_glKosArraysReserve(mode, count, "glDrawArrays"))
+        return 0;
+
+    /* Destination of Output Vertex Array */
+    pvr_vertex_t *dst = _glKosArraysDest();
+
+    GL_KOS_TRACE_BEGIN(color);
+
+    /* Check if Vertex Lighting is enabled. Else, check for Color Submission */
+    if((GL_KOS_VERTEX_PTR_MODE & GL_KOS_USE_NORMAL) && _glKosEnabledLighting())
+        _glKosArraysApplyLighting(dst, count);
+
     else
-        _glKosArrayColor0(dst, count); /* No colors bound, color white */
+        _glKosArraysApplyColor(dst, count);
+
+    GL_KOS_TRACE_END(color, "color");
+
+    GL_KOS_TRACE_BEGIN(texcoord);
 
     /* Check if Texture Coordinates are enabled */
     if((GL_KOS_VERTEX_PTR_MODE & GL_KOS_USE_TEXTURE0) && (_glKosEnabledTexture2D() >= 0))
@@ -1199,7 +1875,9 @@ GLAPI void APIENTRY glDrawArrays(GLenum mode, GLint first, GLsizei count) {
     if((GL_KOS_VERTEX_PTR_MODE & GL_KOS_USE_TEXTURE1) && (_glKosEnabledTexture2D() >= 0))
         _glKosArrayMultiTexCoord2f(count);
 
-    _glKosMatrixApplyRender(); /* Apply the Render Matrix Stack */
+    GL_KOS_TRACE_END(texcoord, "texcoord");
+
+    _glKosMatrixLoadRender(); /* Lighting and the Texture Matrix replace it */
 
     if(!_glKosEnabledNearZClip()) { /* No NearZ Clipping Enabled */
         /* Transform Vertex Positions */
@@ -1219,6 +1897,619 @@ GLAPI void APIENTRY glDrawArrays(GLenum mode, GLint first, GLsizei count) {
     _glKosArraysApplyMultiTexture(mode, count);
 
     _glKosArraysFlush(count);
+
+    return 1;
+}
+
+/* Submit count vertices from first, once the parameters are verified */
+static void _glKosArraysDrawArrays(GLenum mode, GLint first, GLsizei count) {
+    if(mode == GL_QUAD_STRIP) { /* A triangle strip of whole quads */
+        mode = GL_TRIANGLE_STRIP;
+        count &= ~1;
+    }
+
+    if(_glKosPrimitiveConverted(mode)) {
+        _glKosArraysAdvance(first);
+        _glKosArraysDrawConverted(mode, 0, count, 0, count - 1);
+        return;
+    }
+
+    if(!GL_KOS_LIST_RECORD && _glKosArraysDrawPacked(mode, 0, first, count))
+        return;
+
+    _glKosArraysAdvance(first); /* Add Pointer Offset */
+
+    if(GL_KOS_LIST_RECORD) { /* Compiling a Display List */
+        _glKosArraysRecord(mode, 0, count);
+        _glKosArraysResetState();
+        return;
+    }
+
+    _glKosArraysApplyDrawState();
+
+    /* Convert in a single pass when nothing needs the separate attribute passes */
+    if(!_glKosArraysDrawKernel(mode, 0, count))
+        _glKosArraysDrawPieces(mode, 0, count, GL_KOS_VERTEX_SIZE == 2 ?
+                               _glKosDrawArrays2DPiece : _glKosDrawArraysPiece);
+}
+
+GLAPI void APIENTRY glDrawArrays(GLenum mode, GLint first, GLsizei count) {
+    /* Before we process the vertex data, ensure all parameters are valid */
+    if(_glKosArraysVerifyParameter(mode, count, first, 0) && !_glKosArraysCulled())
+        _glKosArraysDrawArrays(mode, first, count);
+
+    _glKosBoundsEnd();
+}
+
+//========================================================================================//
+//== Multi-Draw ==//
+
+/* Element sub-draws up to this long go through the kernels; longer ones are drawn
+   alone, and fill the element cache when it does less work */
+#define GL_KOS_MULTI_KERNEL_ELEMENTS 192
+
+/* A draw moves the pointers and clears them when done, each sub-draw puts them back */
+static void _glKosArraysSavePointers(GL_KOS_ARRAYS_POINTERS *p) {
+    p->vertex = GL_KOS_VERTEX_POINTER;
+    p->normal = GL_KOS_NORMAL_POINTER;
+    p->texcoord0 = GL_KOS_TEXCOORD0_POINTER;
+    p->texcoord1 = GL_KOS_TEXCOORD1_POINTER;
+    p->color = GL_KOS_COLOR_POINTER;
+    p->mode = GL_KOS_VERTEX_PTR_MODE;
+    p->interleaved = GL_KOS_INTERLEAVED;
+}
+
+static void _glKosArraysLoadPointers(const GL_KOS_ARRAYS_POINTERS *p) {
+    GL_KOS_VERTEX_POINTER = p->vertex;
+    GL_KOS_NORMAL_POINTER = p->normal;
+    GL_KOS_TEXCOORD0_POINTER = p->texcoord0;
+    GL_KOS_TEXCOORD1_POINTER = p->texcoord1;
+    GL_KOS_COLOR_POINTER = p->color;
+
+    if(GL_KOS_VERTEX_PTR_MODE != p->mode || GL_KOS_INTERLEAVED != p->interleaved) {
+        GL_KOS_VERTEX_PTR_MODE = p->mode;
+        GL_KOS_INTERLEAVED = p->interleaved;
+
+        _glKosArraysUpdateKey();
+    }
+}
+
+/* Vertices of the whole primitives of a sub-draw: the kernels set the flags by the
+   position of each vertex in its sub-draw */
+static inline GLuint _glKosArraysMultiCount(GLenum mode, GLuint count) {
+    switch(mode) {
+        case GL_TRIANGLES:
+            return count - count % 3;
+
+        case GL_QUADS:
+            return count & ~3;
+    }
+
+    return count < 3 ? 0 : count;
+}
+
+/* Whether sub-draw i can share a piece with others through the kernel */
+static inline GLubyte _glKosArraysMultiBatched(const GL_KOS_ARRAYS_MULTI_DRAW *m, GLuint i) {
+    if(!m->type)
+        return m->count[i] <= GL_KOS_MAX_DRAW_VERTS;
+
+    return m->count[i] <= GL_KOS_MULTI_KERNEL_ELEMENTS
+           && !(m->mode == GL_TRIANGLES && _glKosElementStrips(m->indices[i], m->count[i], m->type));
+}
+
+/* Convert the sub-draws from i that can share a piece back to back with kernel, in
+   one Vertex Buffer reservation, so tiny draws share the reserve and the flush.
+   Returns the first sub-draw not converted. */
+static GLuint _glKosArraysMultiBatch(const GL_KOS_ARRAYS_MULTI_DRAW *m, GL_KOS_ARRAYS_KERNEL kernel, GLuint i) {
+    pvr_vertex_t *dst;
+    GLuint j, c, n = 0;
+
+    for(j = i; j < (GLuint)m->drawcount && _glKosArraysMultiBatched(m, j); j++) {
+        if(n + (c = _glKosArraysMultiCount(m->mode, m->count[j])) > GL_KOS_MAX_DRAW_VERTS)
+            break;
+
+        n += c;
+    }
+
+    if(!n)
+        return j;
+
+    if(!_glKosVertexBufReserve(n, m->name))
+        return m->drawcount;
+
+    dst = _glKosVertexBufPointer();
+
+    _glKosMatrixLoadRender();
+
+    for(; i < j; i++) {
+        if(!(c = _glKosArraysMultiCount(m->mode, m->count[i])))
+            continue;
+
+        _glKosArraysLoadPointers(&m->pointers);
+
+        if(m->type)
+            _glKosArraysIndexPointer(m->type, m->indices[i]);
+        else
+            _glKosArraysAdvance(m->first[i]);
+
+        if(m->model)
+            _glKosMatrixApplyModel(m->model + i * 16, 0);
+
+        kernel(m->mode, dst, c);
+
+        dst += c;
+    }
+
+    _glKosArraysFlush(n);
+
+    return j;
+}
+
+/* Submit the sub-draws of a multi-draw: the polygon header is compiled and the Render
+   Matrix applied once, or once per sub-draw model matrix. Sub-draws the kernels cover
+   are converted back to back, the others are drawn one at a time. */
+static void _glKosArraysMultiDraw(GL_KOS_ARRAYS_MULTI_DRAW *m) {
+    GL_KOS_ARRAYS_KERNEL kernel = NULL;
+    GLuint i, j;
+
+    if(m->model && GL_KOS_LIST_RECORD) { /* The matrices are not recorded */
+        _glKosThrowError(GL_INVALID_OPERATION, m->name);
+        _glKosPrintError();
+        _glKosArraysResetState();
+        return;
+    }
+
+    if(_glKosArraysCulled())
+        return;
+
+    _glKosArraysSavePointers(&m->pointers);
+
+    if(!GL_KOS_LIST_RECORD) {
+        _glKosArraysApplyDrawState();
+
+        if(m->model)
+            _glKosMatrixBeginModel();
+
+        /* Static Buffer Objects have their own path, the kernels take the native types */
+        if(!_glKosArraysPackedBuffer()
+                && (m->mode == GL_TRIANGLES || m->mode == GL_TRIANGLE_STRIP || m->mode == GL_QUADS))
+            kernel = !m->type && GL_KOS_INTERLEAVED ? _glKosArraysInterleavedKernel() :
+                     _glKosArraysTableKernel(m->type);
+
+        GL_KOS_ARRAYS_MULTI = 1;
+    }
+
+    for(i = 0; i < (GLuint)m->drawcount; i = j) {
+        if(kernel && (j = _glKosArraysMultiBatch(m, kernel, i)) > i)
+            continue;
+
+        _glKosArraysLoadPointers(&m->pointers);
+
+        if(m->model)
+            _glKosMatrixApplyModel(m->model + i * 16,
+                                   (GL_KOS_VERTEX_PTR_MODE & GL_KOS_USE_NORMAL) && _glKosEnabledLighting());
+
+        if(m->type)
+            _glKosArraysDrawElements(m->mode, m->count[i], m->type, m->indices[i], 1, 0);
+        else
+            _glKosArraysDrawArrays(m->mode, m->first[i], m->count[i]);
+
+        j = i + 1;
+    }
+
+    if(m->model)
+        _glKosMatrixEndModel();
+
+    GL_KOS_ARRAYS_MULTI = 0;
+
+    _glKosArraysResetState();
+}
+
+/* The sub-draws take the same first and count as glDrawArrays() and glDrawElements() */
+static GLuint _glKosArraysVerifyMulti(const GL_KOS_ARRAYS_MULTI_DRAW *m) {
+    GLsizei i;
+
+    if(m->drawcount < 0)
+        _glKosThrowError(GL_INVALID_VALUE, m->name);
+
+    for(i = 0; i < m->drawcount; i++)
+        if(m->count[i] < 0 || (!m->type && m->first[i] < 0)) {
+            _glKosThrowError(GL_INVALID_VALUE, m->name);
+            break;
+        }
+
+    if(_glKosGetError()) {
+        _glKosPrintError();
+        return 0;
+    }
+
+    return 1;
+}
+
+GLAPI void APIENTRY glMultiDrawArrays(GLenum mode, const GLint *first, const GLsizei *count,
+                                      GLsizei drawcount) {
+    glKosMultiDrawArraysModel(mode, first, count, NULL, drawcount);
+}
+
+GLAPI void APIENTRY glMultiDrawElements(GLenum mode, const GLsizei *count, GLenum type,
+                                        const GLvoid *const *indices, GLsizei drawcount) {
+    glKosMultiDrawElementsModel(mode, count, type, indices, NULL, drawcount);
+}
+
+GLAPI void APIENTRY glKosMultiDrawArraysModel(GLenum mode, const GLint *first, const GLsizei *count,
+        const GLfloat *model, GLsizei drawcount) {
+    GL_KOS_ARRAYS_MULTI_DRAW m = {
+        .mode = mode, .first = first, .count = count, .model = model, .drawcount = drawcount,
+        .name = model ? "glKosMultiDrawArraysModel" : "glMultiDrawArrays"
+    };
+
+    /* Before we process the vertex data, ensure all parameters are valid */
+    if(_glKosArraysVerifyParameter(mode, 0, 0, 0) && _glKosArraysVerifyMulti(&m))
+        _glKosArraysMultiDraw(&m);
+
+    _glKosBoundsEnd();
+}
+
+GLAPI void APIENTRY glKosMultiDrawElementsModel(GLenum mode, const GLsizei *count, GLenum type,
+        const GLvoid *const *indices, const GLfloat *model, GLsizei drawcount) {
+    GL_KOS_ARRAYS_MULTI_DRAW m = {
+        .mode = mode, .type = type, .count = count, .indices = indices, .model = model,
+        .drawcount = drawcount, .name = model ? "glKosMultiDrawElementsModel" : "glMultiDrawElements"
+    };
+
+    if(_glKosArraysVerifyParameter(mode, 0, type, 1) && _glKosArraysVerifyMulti(&m))
+        _glKosArraysMultiDraw(&m);
+
+    _glKosBoundsEnd();
+}
+
+//========================================================================================//
+//== Buffer Object Submission ==//
+
+/* The GL_STATIC_DRAW Buffer Object every attribute of the draw comes from, or NULL.
+   Lighting, the second texture unit and the texture matrix need the client path. */
+static GL_BUFFER_OBJECT *_glKosArraysPackedBuffer() {
+    GL_BUFFER_OBJECT *buf = GL_KOS_VERTEX_BUFFER;
+
+    if(buf == NULL || buf->usage != GL_STATIC_DRAW)
+        return NULL;
+
+    if((GL_KOS_VERTEX_PTR_MODE & GL_KOS_USE_COLOR) && GL_KOS_COLOR_BUFFER != buf)
+        return NULL;
+
+    if((GL_KOS_VERTEX_PTR_MODE & GL_KOS_USE_TEXTURE0)
+       && (GL_KOS_TEXCOORD0_BUFFER != buf || _glKosEnabledTextureMatrix()))
+        return NULL;
+
+    if(GL_KOS_VERTEX_PTR_MODE & GL_KOS_USE_TEXTURE1)
+        return NULL;
+
+    if((GL_KOS_VERTEX_PTR_MODE & GL_KOS_USE_NORMAL) && _glKosEnabledLighting()
+       && GL_KOS_VERTEX_SIZE == 3)
+        return NULL;
+
+    return buf;
+}
+
+/* Vertices from offset to the end of a buffer of size bytes, with elements of
+   bytes every stride floats */
+static inline GLuint _glKosArraysPackedCount(GLuint size, GLuint offset, GLuint stride, GLuint bytes) {
+    if(offset + bytes > size)
+        return 0;
+
+    return (size - offset - bytes) / (stride * 4) + 1;
+}
+
+/* Convert the buffer to PVR vertices with the current pointers, unless it already
+   was with the same layout: object space positions, packed colors and raw texture
+   coordinates. Colors come from the current color at draw time, if none are bound. */
+static GLubyte _glKosArraysPack(GL_BUFFER_OBJECT *buf) {
+    GL_BUFFER_LAYOUT layout;
+    pvr_vertex_t *dst;
+    GLfloat *src;
+    GLuint i, count;
+
+    memset(&layout, 0, sizeof(GL_BUFFER_LAYOUT));
+
+    layout.attribs = GL_KOS_VERTEX_PTR_MODE & (GL_KOS_USE_COLOR | GL_KOS_USE_TEXTURE0);
+    layout.vertex_offset = (GLubyte *)GL_KOS_VERTEX_POINTER - (GLubyte *)buf->data;
+    layout.vertex_stride = GL_KOS_VERTEX_STRIDE;
+    layout.vertex_size = GL_KOS_VERTEX_SIZE;
+
+    count = _glKosArraysPackedCount(buf->size, layout.vertex_offset, layout.vertex_stride,
+                                    layout.vertex_size * 4);
+
+    if(layout.attribs & GL_KOS_USE_COLOR) {
+        layout.color_offset = (GLubyte *)GL_KOS_COLOR_POINTER - (GLubyte *)buf->data;
+        layout.color_stride = GL_KOS_COLOR_STRIDE;
+        layout.color_type = GL_KOS_COLOR_TYPE;
+        layout.color_components = GL_KOS_COLOR_COMPONENTS;
+
+        i = _glKosArraysPackedCount(buf->size, layout.color_offset, layout.color_stride,
+                                    layout.color_type == GL_FLOAT ? layout.color_components * 4 : 4);
+
+        if(i < count)
+            count = i;
+    }
+
+    if(layout.attribs & GL_KOS_USE_TEXTURE0) {
+        layout.texcoord_offset = (GLubyte *)GL_KOS_TEXCOORD0_POINTER - (GLubyte *)buf->data;
+        layout.texcoord_stride = GL_KOS_TEXCOORD0_STRIDE;
+
+        i = _glKosArraysPackedCount(buf->size, layout.texcoord_offset, layout.texcoord_stride, 8);
+
+        if(i < count)
+            count = i;
+    }
+
+    if(buf->packed != NULL && !memcmp(&layout, &buf->layout, sizeof(GL_BUFFER_LAYOUT)))
+        return 1;
+
+    free(buf->packed);
+
+    buf->packed_count = 0;
+    buf->packed = count ? memalign(32, count * sizeof(pvr_vertex_t)) : NULL;
+
+    if(buf->packed == NULL)
+        return 0;
+
+    dst = buf->packed;
+    src = GL_KOS_VERTEX_POINTER;
+
+    for(i = 0; i < count; i++) {
+        dst[i].flags = PVR_CMD_VERTEX;
+        dst[i].x = src[0];
+        dst[i].y = src[1];
+        dst[i].z = layout.vertex_size == 3 ? src[2] : 0;
+        dst[i].u = dst[i].v = 0;
+        dst[i].argb = dst[i].oargb = 0;
+        src += layout.vertex_stride;
+    }
+
+    if(layout.attribs & GL_KOS_USE_COLOR)
+        _glKosArraysApplyColor(dst, count);
+
+    if(layout.attribs & GL_KOS_USE_TEXTURE0)
+        for(i = 0, src = GL_KOS_TEXCOORD0_POINTER; i < count; i++) {
+            dst[i].u = src[0];
+            dst[i].v = src[1];
+            src += layout.texcoord_stride;
+        }
+
+    buf->packed_count = count;
+    buf->layout = layout;
+
+    return 1;
+}
+
+static inline void _glKosArraysTransformPackedVertex(const pvr_vertex_t *src, pvr_vertex_t *dst,
+        GLubyte color, GLuint argb) {
+    register float __x  GL_KOS_FREG("fr12");
+    register float __y  GL_KOS_FREG("fr13");
+    register float __z  GL_KOS_FREG("fr14");
+
+    __x = src->x;
+    __y = src->y;
+    __z = src->z;
+
+    mat_trans_fv12();
+
+    _glKosVertexCopyPVR(src, dst);
+
+    dst->x = __x;
+    dst->y = __y;
+    dst->z = __z;
+
+    if(!color)
+        dst->argb = argb;
+}
+
+/* Gather count packed vertices, or the ones the elements index, into dst and
+   transform them with the Render Matrix. With no Color Pointer, the current
+   color is set on the way. */
+static void _glKosArraysTransformPacked(GLenum type, pvr_vertex_t *dst, GLuint count) {
+    GL_KOS_TRACE("transform");
+
+    const pvr_vertex_t *src = GL_KOS_PACKED_POINTER;
+    GLubyte color = GL_KOS_VERTEX_PTR_MODE & GL_KOS_USE_COLOR ? 1 : 0;
+    GLuint i, argb = _glKosVertexColor();
+
+    switch(type) {
+        case GL_UNSIGNED_BYTE:
+            for(i = 0; i < count; i++)
+                _glKosArraysTransformPackedVertex(&src[GL_KOS_INDEX_POINTER_U8[i]], &dst[i], color, argb);
+
+            break;
+
+        case GL_UNSIGNED_SHORT:
+            for(i = 0; i < count; i++)
+                _glKosArraysTransformPackedVertex(&src[GL_KOS_INDEX_POINTER_U16[i]], &dst[i], color, argb);
+
+            break;
+
+        case GL_UNSIGNED_INT:
+            for(i = 0; i < count; i++)
+                _glKosArraysTransformPackedVertex(&src[GL_KOS_INDEX_POINTER_U32[i]], &dst[i], color, argb);
+
+            break;
+
+        default:
+            for(i = 0; i < count; i++)
+                _glKosArraysTransformPackedVertex(&src[i], &dst[i], color, argb);
+
+            break;
+    }
+}
+
+/* Gather count packed vertices, or the ones the elements index, into dst untransformed */
+static void _glKosArraysUnpackPacked(GLenum type, pvr_vertex_t *dst, GLuint count) {
+    const pvr_vertex_t *src = GL_KOS_PACKED_POINTER;
+    GLuint i;
+
+    switch(type) {
+        case GL_UNSIGNED_BYTE:
+            for(i = 0; i < count; i++)
+                _glKosVertexCopyPVR(&src[GL_KOS_INDEX_POINTER_U8[i]], &dst[i]);
+
+            break;
+
+        case GL_UNSIGNED_SHORT:
+            for(i = 0; i < count; i++)
+                _glKosVertexCopyPVR(&src[GL_KOS_INDEX_POINTER_U16[i]], &dst[i]);
+
+            break;
+
+        case GL_UNSIGNED_INT:
+            for(i = 0; i < count; i++)
+                _glKosVertexCopyPVR(&src[GL_KOS_INDEX_POINTER_U32[i]], &dst[i]);
+
+            break;
+
+        default:
+            memcpy(dst, src, count * sizeof(pvr_vertex_t));
+            break;
+    }
+}
+
+static GLubyte _glKosDrawPackedPiece(GLenum mode, GLenum type, GLuint count) {
+    char *name = type ? "glDrawElements" : "glDrawArrays";
+    GLubyte clip = _glKosEnabledNearZClip() && GL_KOS_VERTEX_SIZE == 3;
+    pvr_vertex_t *src, *dst;
+
+    if(!(clip ? _glKosArraysReserve(mode, count, name) : _glKosVertexBufReserve(count, name)))
+        return 0;
+
+    dst = _glKosVertexBufPointer();
+
+    if(!clip) {
+        _glKosArraysTransformPacked(type, dst, count);
+
+        /* Set the vertex flags for use with the PVR */
+        _glKosArraysApplyVertexFlags(mode, dst, count);
+    }
+    else {
+        /* Clip in object space, then transform what is left */
+        src = _glKosClipBufAddress();
+
+        _glKosArraysUnpackPacked(type, src, count);
+
+        if(!(GL_KOS_VERTEX_PTR_MODE & GL_KOS_USE_COLOR))
+            _glKosArrayColor0(src, count);
+
+        GLuint cverts = 0;
+
+        switch(mode) {
+            case GL_TRIANGLES:
+                cverts = _glKosClipTriangles(src, dst, count);
+                break;
+
+            case GL_TRIANGLE_STRIP:
+                cverts = _glKosClipTriangleStrip(src, dst, count);
+                break;
+
+            case GL_QUADS:
+                cverts = _glKosClipQuads(src, dst, count);
+                break;
+        }
+
+        GL_KOS_STAT_CLIP(mode, count, dst, cverts);
+
+        _glKosTransformClipBuf(dst, cverts);
+
+        count = cverts;
+    }
+
+    _glKosArraysFlush(count);
+
+    return 1;
+}
+
+/* Draw from the PVR vertices of a GL_STATIC_DRAW Buffer Object, when the draw can:
+   only the position transform and the vertex flags are left to do per draw.
+   first is the first vertex of glDrawArrays(), type the element type of glDrawElements(). */
+static GLubyte _glKosArraysDrawPacked(GLenum mode, GLenum type, GLuint first, GLuint count) {
+    GL_BUFFER_OBJECT *buf = _glKosArraysPackedBuffer();
+
+    if(buf == NULL || !_glKosArraysPack(buf))
+        return 0;
+
+    if(!type && first + count > buf->packed_count)
+        return 0;
+
+    GL_KOS_PACKED_POINTER = buf->packed + first;
+
+    _glKosArraysApplyDrawState();
+
+    _glKosArraysDrawPieces(mode, type, count, _glKosDrawPackedPiece);
+
+    return 1;
+}
+
+//========================================================================================//
+//== Display List Recording ==//
+
+/* Record count vertices into the Display List being compiled, in object space.
+   type is the element type, or 0 for glDrawArrays(). Texture coordinates go
+   through the texture matrix here, the second texture unit is not recorded. */
+static void _glKosArraysRecord(GLenum mode, GLenum type, GLuint count) {
+    GLubyte textured = (GL_KOS_VERTEX_PTR_MODE & GL_KOS_USE_TEXTURE0) ? 1 : 0;
+    GLubyte lit = (GL_KOS_VERTEX_PTR_MODE & GL_KOS_USE_NORMAL) && GL_KOS_VERTEX_SIZE == 3;
+    GLubyte texmat = textured && _glKosEnabledTextureMatrix();
+    pvr_vertex_t *dst = _glKosListReserve(count);
+    GLfloat *N = (dst != NULL && lit) ? _glKosListNormals() : NULL;
+    GLfloat *src;
+    GLuint i, index, argb = _glKosVertexColor();
+
+    if(dst == NULL || (lit && N == NULL)) {
+        _glKosThrowError(GL_OUT_OF_MEMORY, type ? "glDrawElements" : "glDrawArrays");
+        _glKosPrintError();
+        return;
+    }
+
+    if(texmat)
+        _glKosMatrixLoadTexture();
+
+    for(i = 0; i < count; i++) {
+        index = _glKosArraysIndex(type, i);
+
+        src = GL_KOS_VERTEX_POINTER + index * GL_KOS_VERTEX_STRIDE;
+
+        dst[i].x = src[0];
+        dst[i].y = src[1];
+        dst[i].z = GL_KOS_VERTEX_SIZE == 3 ? src[2] : 0;
+        dst[i].oargb = 0;
+
+        dst[i].argb = _glKosArraysKernelColor(GL_KOS_COLOR_POINTER + index * GL_KOS_COLOR_STRIDE,
+                                              GL_KOS_ARRAYS_COLOR, argb);
+
+        if(!textured)
+            dst[i].u = dst[i].v = 0;
+        else {
+            src = GL_KOS_TEXCOORD0_POINTER + index * GL_KOS_TEXCOORD0_STRIDE;
+
+            if(texmat) {
+                mat_trans_texture2_nomod(src[0], src[1], dst[i].u, dst[i].v);
+            }
+            else {
+                dst[i].u = src[0];
+                dst[i].v = src[1];
+            }
+        }
+
+        if(lit) {
+            src = GL_KOS_NORMAL_POINTER + index * GL_KOS_NORMAL_STRIDE;
+
+            N[0] = src[0];
+            N[1] = src[1];
+            N[2] = src[2];
+            N += 3;
+        }
+    }
+
+    if(texmat)
+        _glKosMatrixLoadRender();
+
+    _glKosListAddBlock(mode, count, textured, lit);
 }
 
 void APIENTRY glClientActiveTextureARB(GLenum texture) {
@@ -27,4 +27,47 @@
 #define GL_KOS_USE_COLOR     (1<<3)
 #define GL_KOS_USE_NORMAL    (1<<4)
 
+/* Color sources of the single pass kernels */
+#define GL_KOS_KERNEL_COLOR0  0  /* The current color, no Color Pointer */
+#define GL_KOS_KERNEL_1UI     1
+#define GL_KOS_KERNEL_4UB     2
+#define GL_KOS_KERNEL_3F      3
+#define GL_KOS_KERNEL_4F      4
+#define GL_KOS_KERNEL_COLORS  5
+
+/* Kernel table keys: 2D or 3D positions, color source, texture coordinates or not */
+#define GL_KOS_KERNEL_KEYS    (2 * GL_KOS_KERNEL_COLORS * 2)
+
+/* Converts count vertices of the client arrays to PVR vertices in dst, flags included */
+typedef void (*GL_KOS_ARRAYS_KERNEL)(GLenum mode, pvr_vertex_t *dst, GLuint count);
+
+typedef struct {
+    GLenum  format;
+    GLubyte attribs;            /* GL_KOS_USE_* arrays of the format */
+    GLubyte texcoord, color,    /* Offsets of the attributes, in floats */
+            normal, vertex;
+    GLubyte color_size, vertex_size,
+            stride;             /* Default stride, in floats */
+    GLenum  color_type;
+    GL_KOS_ARRAYS_KERNEL kernel;
+} GL_KOS_INTERLEAVED_FORMAT;
+
+/* The pointers as set before a multi-draw, put back for each sub-draw */
+typedef struct {
+    GLfloat *vertex, *normal, *texcoord0, *texcoord1, *color;
+    GLuint   mode;              /* GL_KOS_USE_* pointers submitted */
+    const GL_KOS_INTERLEAVED_FORMAT *interleaved;
+} GL_KOS_ARRAYS_POINTERS;
+
+typedef struct {
+    GLenum  mode, type;         /* type is 0 for arrays */
+    const GLint   *first;       /* Arrays: first vertex of each sub-draw */
+    const GLsizei *count;
+    const GLvoid *const *indices; /* Elements: indices of each sub-draw */
+    const GLfloat *model;       /* Model matrix of each sub-draw, 16 floats apart, or NULL */
+    GLsizei drawcount;
+    char   *name;               /* Entry point, for errors */
+    GL_KOS_ARRAYS_POINTERS pointers;
+} GL_KOS_ARRAYS_MULTI_DRAW;
+
 #endif
@@ -0,0 +1,146 @@
+/* KallistiGL for KallistiOS ##version##
+
+   libgl/gl-bounds.c
+
+   Draw-level frustum culling. glKosBoundingBox() and glKosBoundingSphere()
+   test a volume holding the next draw against the planes of the Render
+   Matrix: the four screen edges, and the near-Z clipping plane with
+   GL_KOS_NEARZ_CLIPPING enabled. A draw entirely outside is dropped before
+   any of its vertices are read. A draw entirely in front of the near plane
+   is submitted without near-Z clipping.
+
+   The planes are those of the Render Matrix pulled back to object space, so
+   neither the volume nor its corners are transformed.
+*/
+
+#include <dc/fmath.h>
+
+#include <GL/gl.h>
+#include "gl-api.h"
+#include "gl-clip.h"
+#include "gl-list.h"
+#include "gl-pvr.h"
+#include "gl-stats.h"
+
+static GLenum GL_KOS_BOUNDS_RESULT = 0; /* Result held for the next draw, or 0 */
+
+//========================================================================================//
+//== Internal API ==//
+
+GLubyte _glKosBoundsOutside() {
+    return GL_KOS_BOUNDS_RESULT == GL_KOS_BOUNDS_OUTSIDE;
+}
+
+GLubyte _glKosBoundsInside() {
+    return GL_KOS_BOUNDS_RESULT == GL_KOS_BOUNDS_INSIDE;
+}
+
+/* The draw the result was held for is done */
+void _glKosBoundsEnd() {
+    GL_KOS_BOUNDS_RESULT = 0;
+}
+
+/* The half-spaces a * x + b * y + c * z + d >= 0 the draw is visible in: the screen
+   edges, then the near-Z clipping plane, or the plane of the eye without clipping.
+   Row r of the Render Matrix gives the screen x, y, z and w of a vertex. */
+static void _glKosBoundsPlanes(GLfloat planes[5][4], GLubyte clip) {
+    const GLfloat width = vid_mode->width, height = vid_mode->height;
+    GLfloat m[16], x, y, z, w;
+    GLuint c;
+
+    _glKosMatrixApplyRender();
+
+    glKosGetMatrix(GL_RENDER, m);
+
+    for(c = 0; c < 4; c++) {
+        x = m[c * 4 + 0];
+        y = m[c * 4 + 1];
+        z = m[c * 4 + 2];
+        w = m[c * 4 + 3];
+
+        planes[0][c] = x;              /* x / w >= 0 */
+        planes[1][c] = width * w - x;  /* x / w <= width */
+        planes[2][c] = y;
+        planes[3][c] = height * w - y;
+        planes[4][c] = clip ? -z : w;  /* z < CLIP_NEARZ, or w > 0 */
+    }
+
+    if(clip)
+        planes[4][3] += CLIP_NEARZ;
+}
+
+/* Classify the volume centered on x, y, z, reaching half[i] along axis i for a box,
+   or radius in every direction for a sphere, and hold the result for the next draw */
+static GLenum _glKosBoundsTest(GLfloat x, GLfloat y, GLfloat z, const GLfloat *half, GLfloat radius) {
+    GLfloat planes[5][4], *p, d, e;
+    GLubyte clip;
+    GLuint i;
+
+    GL_KOS_BOUNDS_RESULT = 0; /* A result held for no draw yet is replaced */
+
+    clip = _glKosEnabledNearZClip();
+
+    _glKosBoundsPlanes(planes, clip);
+
+    for(i = 0; i < 5; i++) {
+        p = planes[i];
+
+        d = p[0] * x + p[1] * y + p[2] * z + p[3];
+
+        if(half)
+            e = (p[0] < 0.0f ? -p[0] : p[0]) * half[0]
+                + (p[1] < 0.0f ? -p[1] : p[1]) * half[1]
+                + (p[2] < 0.0f ? -p[2] : p[2]) * half[2];
+        else
+            e = radius * fsqrt(p[0] * p[0] + p[1] * p[1] + p[2] * p[2]);
+
+        if(d + e < 0.0f) {
+            GL_KOS_STAT_ADD(frame.bounds_rejected, 1);
+            return GL_KOS_BOUNDS_RESULT = GL_KOS_BOUNDS_OUTSIDE;
+        }
+
+        if(i == 4 && clip && d - e < 0.0f) {
+            GL_KOS_STAT_ADD(frame.bounds_clipped, 1);
+            return GL_KOS_BOUNDS_RESULT = GL_KOS_BOUNDS_CLIPPED;
+        }
+    }
+
+    GL_KOS_STAT_ADD(frame.bounds_accepted, 1);
+
+    return GL_KOS_BOUNDS_RESULT = GL_KOS_BOUNDS_INSIDE;
+}
+
+//========================================================================================//
+//== Public KOS Open GL API Bounding Volume Functionality ==//
+
+GLAPI GLenum APIENTRY glKosBoundingBox(const GLfloat *min, const GLfloat *max) {
+    GLfloat half[3];
+
+    if(min == NULL || max == NULL) {
+        _glKosThrowError(GL_INVALID_VALUE, "glKosBoundingBox");
+        _glKosPrintError();
+        return GL_KOS_BOUNDS_CLIPPED;
+    }
+
+    if(GL_KOS_LIST_RECORD) /* Recorded draws are drawn as usual */
+        return GL_KOS_BOUNDS_CLIPPED;
+
+    half[0] = (max[0] - min[0]) * 0.5f;
+    half[1] = (max[1] - min[1]) * 0.5f;
+    half[2] = (max[2] - min[2]) * 0.5f;
+
+    return _glKosBoundsTest(min[0] + half[0], min[1] + half[1], min[2] + half[2], half, 0.0f);
+}
+
+GLAPI GLenum APIENTRY glKosBoundingSphere(GLfloat x, GLfloat y, GLfloat z, GLfloat radius) {
+    if(radius < 0.0f) {
+        _glKosThrowError(GL_INVALID_VALUE, "glKosBoundingSphere");
+        _glKosPrintError();
+        return GL_KOS_BOUNDS_CLIPPED;
+    }
+
+    if(GL_KOS_LIST_RECORD)
+        return GL_KOS_BOUNDS_CLIPPED;
+
+    return _glKosBoundsTest(x, y, z, NULL, radius);
+}
@@ -0,0 +1,252 @@
+/* KallistiGL for KallistiOS ##version##
+
+   libgl/gl-buffer.c
+
+   Open GL Buffer Objects for vertex and element arrays. Buffers are kept in main
+   RAM, in a linked list like the Frame Buffer Objects. A GL_STATIC_DRAW buffer
+   also keeps its vertices converted to PVR vertices, built by gl-arrays.c on the
+   first draw and dropped whenever the buffer data changes.
+*/
+
+#include <string.h>
+#include <malloc.h>
+
+#include <GL/gl.h>
+#include "gl-api.h"
+#include "gl-elements.h"
+
+//========================================================================================//
+//== Internal KOS Open GL Buffer Object Structures / Global Variables ==//
+
+static GL_BUFFER_OBJECT  GL_KOS_BUFFER_OBJ; /* Head of the list, index 0 is never used */
+
+static GL_BUFFER_OBJECT *GL_KOS_ARRAY_BUFFER   = NULL;
+static GL_BUFFER_OBJECT *GL_KOS_ELEMENT_BUFFER = NULL;
+
+//========================================================================================//
+//== Internal KOS Open GL Buffer Object Functionality ==//
+
+static GL_BUFFER_OBJECT *_glKosBufferFind(GLuint index) {
+    GL_BUFFER_OBJECT *ptr = GL_KOS_BUFFER_OBJ.link;
+
+    while(ptr != NULL && ptr->index != index)
+        ptr = (GL_BUFFER_OBJECT *)ptr->link;
+
+    return ptr;
+}
+
+/* glBindBuffer() creates buffers of any name, so the list is not sorted */
+static GLuint _glKosBufferLastIndex() {
+    GL_BUFFER_OBJECT *ptr = GL_KOS_BUFFER_OBJ.link;
+    GLuint index = 0;
+
+    for(; ptr != NULL; ptr = (GL_BUFFER_OBJECT *)ptr->link)
+        if(ptr->index > index)
+            index = ptr->index;
+
+    return index;
+}
+
+static GL_BUFFER_OBJECT *_glKosBufferCreate(GLuint index) {
+    GL_BUFFER_OBJECT *ptr = &GL_KOS_BUFFER_OBJ, *obj = malloc(sizeof(GL_BUFFER_OBJECT));
+
+    if(obj == NULL)
+        return NULL;
+
+    memset(obj, 0, sizeof(GL_BUFFER_OBJECT));
+    obj->index = index;
+    obj->usage = GL_STATIC_DRAW;
+
+    while(ptr->link != NULL)
+        ptr = (GL_BUFFER_OBJECT *)ptr->link;
+
+    ptr->link = obj;
+
+    return obj;
+}
+
+/* The buffer data changed, the PVR vertices are converted again on the next draw,
+   and strips made from its elements are dropped */
+static void _glKosBufferInvalidate(GL_BUFFER_OBJECT *obj) {
+    _glKosElementStripsInvalidate(obj);
+
+    free(obj->packed);
+
+    obj->packed = NULL;
+    obj->packed_count = 0;
+}
+
+static GL_BUFFER_OBJECT **_glKosBufferTarget(GLenum target) {
+    switch(target) {
+        case GL_ARRAY_BUFFER:
+            return &GL_KOS_ARRAY_BUFFER;
+
+        case GL_ELEMENT_ARRAY_BUFFER:
+            return &GL_KOS_ELEMENT_BUFFER;
+    }
+
+    return NULL;
+}
+
+GL_BUFFER_OBJECT *_glKosBoundBuffer(GLenum target) {
+    return target == GL_ARRAY_BUFFER ? GL_KOS_ARRAY_BUFFER : GL_KOS_ELEMENT_BUFFER;
+}
+
+//========================================================================================//
+//== Public KOS Open GL API Buffer Object Functionality ==//
+
+GLAPI void APIENTRY glGenBuffers(GLsizei n, GLuint *buffers) {
+    GLuint index = _glKosBufferLastIndex();
+    GL_BUFFER_OBJECT *obj;
+
+    while(n--) {
+        if((obj = _glKosBufferCreate(++index)) == NULL) {
+            _glKosThrowError(GL_OUT_OF_MEMORY, "glGenBuffers");
+            _glKosPrintError();
+            return;
+        }
+
+        *buffers++ = obj->index;
+    }
+}
+
+GLAPI void APIENTRY glDeleteBuffers(GLsizei n, const GLuint *buffers) {
+    GL_BUFFER_OBJECT *ptr, *lptr;
+
+    while(n--) {
+        lptr = &GL_KOS_BUFFER_OBJ;
+        ptr = GL_KOS_BUFFER_OBJ.link;
+
+        while(ptr != NULL && ptr->index != *buffers) {
+            lptr = ptr;
+            ptr = (GL_BUFFER_OBJECT *)ptr->link;
+        }
+
+        if(ptr != NULL) {
+            lptr->link = ptr->link;
+
+            if(GL_KOS_ARRAY_BUFFER == ptr)
+                GL_KOS_ARRAY_BUFFER = NULL;
+
+            if(GL_KOS_ELEMENT_BUFFER == ptr)
+                GL_KOS_ELEMENT_BUFFER = NULL;
+
+            _glKosBufferInvalidate(ptr);
+            free(ptr->data);
+            free(ptr);
+        }
+
+        ++buffers;
+    }
+}
+
+GLAPI void APIENTRY glBindBuffer(GLenum target, GLuint buffer) {
+    GL_BUFFER_OBJECT **bound = _glKosBufferTarget(target), *obj = NULL;
+
+    if(bound == NULL) {
+        _glKosThrowError(GL_INVALID_ENUM, "glBindBuffer");
+        _glKosPrintError();
+        return;
+    }
+
+    /* Binding a name that was never generated creates the buffer */
+    if(buffer && (obj = _glKosBufferFind(buffer)) == NULL
+       && (obj = _glKosBufferCreate(buffer)) == NULL) {
+        _glKosThrowError(GL_OUT_OF_MEMORY, "glBindBuffer");
+        _glKosPrintError();
+        return;
+    }
+
+    *bound = obj;
+}
+
+GLAPI void APIENTRY glBufferData(GLenum target, GLsizeiptr size, const GLvoid *data, GLenum usage) {
+    GL_BUFFER_OBJECT **bound = _glKosBufferTarget(target);
+
+    if(bound == NULL)
+        _glKosThrowError(GL_INVALID_ENUM, "glBufferData");
+
+    if(usage != GL_STATIC_DRAW)
+        if(usage != GL_DYNAMIC_DRAW)
+            if(usage != GL_STREAM_DRAW)
+                _glKosThrowError(GL_INVALID_ENUM, "glBufferData");
+
+    if(size < 0)
+        _glKosThrowError(GL_INVALID_VALUE, "glBufferData");
+
+    if(bound != NULL && *bound == NULL)
+        _glKosThrowError(GL_INVALID_OPERATION, "glBufferData");
+
+    if(_glKosGetError()) {
+        _glKosPrintError();
+        return;
+    }
+
+    GL_BUFFER_OBJECT *obj = *bound;
+
+    _glKosBufferInvalidate(obj);
+
+    /* Keep the allocation when the size does not change, for dynamic buffers */
+    if(obj->size != (GLuint)size) {
+        free(obj->data);
+
+        obj->size = 0;
+        obj->data = size ? memalign(32, size) : NULL;
+
+        if(size && obj->data == NULL) {
+            _glKosThrowError(GL_OUT_OF_MEMORY, "glBufferData");
+            _glKosPrintError();
+            return;
+        }
+
+        obj->size = size;
+    }
+
+    if(data != NULL && size)
+        memcpy(obj->data, data, size);
+
+    obj->usage = usage;
+}
+
+GLAPI void APIENTRY glBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const GLvoid *data) {
+    GL_BUFFER_OBJECT **bound = _glKosBufferTarget(target);
+
+    if(bound == NULL)
+        _glKosThrowError(GL_INVALID_ENUM, "glBufferSubData");
+
+    else if(*bound == NULL)
+        _glKosThrowError(GL_INVALID_OPERATION, "glBufferSubData");
+
+    else if(offset < 0 || size < 0 || (GLuint)(offset + size) > (*bound)->size)
+        _glKosThrowError(GL_INVALID_VALUE, "glBufferSubData");
+
+    if(_glKosGetError()) {
+        _glKosPrintError();
+        return;
+    }
+
+    _glKosBufferInvalidate(*bound);
+
+    memcpy((GLubyte *)(*bound)->data + offset, data, size);
+}
+
+GLAPI void APIENTRY glGetBufferParameteriv(GLenum target, GLenum pname, GLint *params) {
+    GL_BUFFER_OBJECT **bound = _glKosBufferTarget(target);
+
+    if(bound == NULL || (pname != GL_BUFFER_SIZE && pname != GL_BUFFER_USAGE))
+        _glKosThrowError(GL_INVALID_ENUM, "glGetBufferParameteriv");
+
+    else if(*bound == NULL)
+        _glKosThrowError(GL_INVALID_OPERATION, "glGetBufferParameteriv");
+
+    if(_glKosGetError()) {
+        _glKosPrintError();
+        return;
+    }
+
+    *params = pname == GL_BUFFER_SIZE ? (GLint)(*bound)->size : (GLint)(*bound)->usage;
+}
+
+GLAPI GLboolean APIENTRY glIsBuffer(GLuint buffer) {
+    return buffer && _glKosBufferFind(buffer) != NULL ? GL_TRUE : GL_FALSE;
+}
@@ -8,6 +8,8 @@
 
 #include <GL/gl.h>
 #include "gl-api.h"
+#include "gl-list.h"
+#include "gl-pvr.h"
 
 #include <malloc.h>
 #include <stdio.h>
@@ -25,6 +27,7 @@
 #define GL_KOS_ENABLE_TEXTURE2D    (1<<7)
 #define GL_KOS_ENABLE_BLENDING     (1<<8)
 #define GL_KOS_ENABLE_TEXTURE_MAT  (1<<9)
+#define GL_KOS_ENABLE_ALPHA_TEST   (1<<10)
 
 static GLbitfield GL_KOS_ENABLE_CAP = 0;
 
@@ -41,7 +44,12 @@ void APIENTRY glEnable(GLenum cap) {
 
         case GL_BLEND:
             GL_KOS_ENABLE_CAP |= GL_KOS_ENABLE_BLENDING;
-            _glKosVertexBufSwitchTR();
+            _glKosSelectList();
+            break;
+
+        case GL_ALPHA_TEST:
+            GL_KOS_ENABLE_CAP |= GL_KOS_ENABLE_ALPHA_TEST;
+            _glKosSelectList();
             break;
 
         case GL_DEPTH_TEST:
@@ -84,7 +92,12 @@ void APIENTRY glDisable(GLenum cap) {
 
         case GL_BLEND:
             GL_KOS_ENABLE_CAP &= ~GL_KOS_ENABLE_BLENDING;
-            _glKosVertexBufSwitchOP();
+            _glKosSelectList();
+            break;
+
+        case GL_ALPHA_TEST:
+            GL_KOS_ENABLE_CAP &= ~GL_KOS_ENABLE_ALPHA_TEST;
+            _glKosSelectList();
             break;
 
         case GL_DEPTH_TEST:
@@ -137,7 +150,7 @@ GLboolean APIENTRY glIsEnabled(GLenum cap) {
             return _glKosEnabledLighting() ? GL_TRUE : GL_FALSE;
 
         case GL_KOS_NEARZ_CLIPPING:
-            return _glKosEnabledNearZClip() ? GL_TRUE : GL_FALSE;
+            return (GL_KOS_ENABLE_CAP & GL_KOS_ENABLE_ZCLIPPING) ? GL_TRUE : GL_FALSE;
 
         case GL_TEXTURE_2D:
             return _glKosEnabledTexture2D() ? GL_TRUE : GL_FALSE;
@@ -145,6 +158,9 @@ GLboolean APIENTRY glIsEnabled(GLenum cap) {
         case GL_BLEND:
             return _glKosEnabledBlend() ? GL_TRUE : GL_FALSE;
 
+        case GL_ALPHA_TEST:
+            return _glKosEnabledAlphaTest() ? GL_TRUE : GL_FALSE;
+
         case GL_KOS_TEXTURE_MATRIX:
             return _glKosEnabledTextureMatrix() ? GL_TRUE : GL_FALSE;
     }
@@ -159,7 +175,11 @@ void APIENTRY glGetIntegerv(GLenum pname, GLint *params) {
             break;
 
         case GL_BLEND:
-            *params = _glKosList();
+            *params = _glKosEnabledBlend();
+            break;
+
+        case GL_ALPHA_TEST:
+            *params = _glKosEnabledAlphaTest();
             break;
 
         case GL_BLEND_DST:
@@ -202,10 +222,51 @@ void APIENTRY glGetIntegerv(GLenum pname, GLint *params) {
             *params = _glKosGetMaxLights();
             break;
 
+        case GL_MAX_ELEMENTS_VERTICES:
+            *params = GL_KOS_MAX_VERTS;
+            break;
+
+        case GL_MAX_ELEMENTS_INDICES:
+            *params = GL_KOS_MAX_DRAW_VERTS;
+            break;
+
         case GL_TEXTURE_BINDING_2D:
             *params = _glKosBoundTexID();
             break;
 
+        case GL_KOS_DIRECT_RENDER_BYTES:
+            *params = _glKosVertexBufDirectBytes();
+            break;
+
+        case GL_KOS_HEADERS_REQUESTED:
+            *params = _glKosHdrRequested();
+            break;
+
+        case GL_KOS_HEADERS_EMITTED:
+            *params = _glKosHdrEmitted();
+            break;
+
+        case GL_LIST_BASE:
+            *params = _glKosListBase();
+            break;
+
+        case GL_LIST_INDEX:
+            *params = _glKosListIndex();
+            break;
+
+        case GL_LIST_MODE:
+            *params = _glKosListMode();
+            break;
+
+        case GL_ARRAY_BUFFER_BINDING:
+            *params = _glKosBoundBuffer(GL_ARRAY_BUFFER) ? _glKosBoundBuffer(GL_ARRAY_BUFFER)->index : 0;
+            break;
+
+        case GL_ELEMENT_ARRAY_BUFFER_BINDING:
+            *params = _glKosBoundBuffer(GL_ELEMENT_ARRAY_BUFFER) ?
+                      _glKosBoundBuffer(GL_ELEMENT_ARRAY_BUFFER)->index : 0;
+            break;
+
         default:
             _glKosThrowError(GL_INVALID_ENUM, "glGetIntegerv");
             _glKosPrintError();
@@ -221,6 +282,14 @@ void APIENTRY glGetFloatv(GLenum pname, GLfloat *params) {
             glKosGetMatrix(pname - GL_MODELVIEW_MATRIX + 1, params);
             break;
 
+        case GL_LINE_WIDTH:
+            *params = _glKosLineWidth();
+            break;
+
+        case GL_POINT_SIZE:
+            *params = _glKosPointSize();
+            break;
+
         default:
             _glKosThrowError(GL_INVALID_ENUM, "glGetFloatv");
             _glKosPrintError();
@@ -249,6 +318,15 @@ const GLbyte *glGetString(GLenum name) {
 //===============================================================================//
 //== Internal API Functions ==//
 
+GLuint _glKosEnabledCaps() {
+    return GL_KOS_ENABLE_CAP;
+}
+
+/* Put back capabilities saved by _glKosEnabledCaps(), the caller selects the list */
+void _glKosRestoreCaps(GLuint caps) {
+    GL_KOS_ENABLE_CAP = caps;
+}
+
 GLubyte _glKosEnabledDepthTest() {
     return GL_KOS_ENABLE_CAP & GL_KOS_ENABLE_DEPTH_TEST;
 }
@@ -269,8 +347,10 @@ GLubyte _glKosEnabledLighting() {
     return GL_KOS_ENABLE_CAP & GL_KOS_ENABLE_LIGHTING;
 }
 
+/* A draw glKosBoundingBox() or glKosBoundingSphere() found in front of the near plane
+   skips near-Z clipping */
 GLubyte _glKosEnabledNearZClip() {
-    return GL_KOS_ENABLE_CAP & GL_KOS_ENABLE_ZCLIPPING;
+    return (GL_KOS_ENABLE_CAP & GL_KOS_ENABLE_ZCLIPPING) && !_glKosBoundsInside();
 }
 
 GLubyte _glKosEnabledTexture2D() {
@@ -284,3 +364,7 @@ GLubyte _glKosEnabledBlend() {
 GLubyte _glKosEnabledTextureMatrix() {
     return (GL_KOS_ENABLE_CAP & GL_KOS_ENABLE_TEXTURE_MAT) >> 9;
 }
+
+GLubyte _glKosEnabledAlphaTest() {
+    return (GL_KOS_ENABLE_CAP & GL_KOS_ENABLE_ALPHA_TEST) >> 10;
+}
@@ -0,0 +1,444 @@
+/* KallistiGL for KallistiOS ##version##
+
+   libgl/gl-capture.c
+
+   TA command stream capture to a file, and replay of captured scenes straight
+   to the TA with none of the GL state machine involved. Replaying a capture
+   times pure submission, apart from the CPU cost of building the frame.
+
+   Texture blocks are written the first time a capture references them, so a
+   texture changed later in the same capture replays with its first contents.
+*/
+
+#include <malloc.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <dc/sq.h>
+
+#include <GL/gl.h>
+#include "gl-api.h"
+#include "gl-capture.h"
+
+#ifdef __sh__
+#define GL_KOS_CAPTURE_VRAM ((GLubyte *)PVR_RAM_INT_BASE) /* pvr_mem_malloc() area */
+#else
+#define GL_KOS_CAPTURE_VRAM pvr_host_vram()
+#endif
+
+#define GL_KOS_CAPTURE_TXR_ADDR_MASK 0x001fffff /* Texture address of the header mode3 word */
+
+#define GL_KOS_CAPTURE_PAD(bytes) (((bytes) + 31) & ~31)
+
+GLubyte GL_KOS_CAPTURE = 0;
+
+static FILE  *GL_KOS_CAPTURE_FILE = NULL;
+static long   GL_KOS_CAPTURE_LIST_POS;             /* File position of the open LIST record */
+static GLuint GL_KOS_CAPTURE_LIST_BYTES,
+              GL_KOS_CAPTURE_SCENES,               /* Scenes closed so far */
+              GL_KOS_CAPTURE_IN_SCENE;
+
+static GLuint GL_KOS_CAPTURE_TEX[GL_KOS_CAPTURE_TEXTURES], /* VRAM offsets referenced */
+              GL_KOS_CAPTURE_TEX_COUNT,
+              GL_KOS_CAPTURE_TEX_WRITTEN,                  /* Of those, written to the file */
+              GL_KOS_CAPTURE_TEX_LAST;
+
+static GLubyte *GL_KOS_REPLAY_DATA = NULL;          /* Loaded capture file */
+static GL_KOS_CAPTURE_RECORD **GL_KOS_REPLAY_SCENES = NULL;
+static GLuint   GL_KOS_REPLAY_SCENE_COUNT = 0;
+static GLvoid  *GL_KOS_REPLAY_TEX[GL_KOS_CAPTURE_TEXTURES];
+static GLuint   GL_KOS_REPLAY_TEX_OFFSET[GL_KOS_CAPTURE_TEXTURES],
+                GL_KOS_REPLAY_TEX_COUNT = 0;
+
+static inline GLuint _glKosCaptureOffset(const GLvoid *vram) {
+    return (GLuint)((const GLubyte *)vram - GL_KOS_CAPTURE_VRAM) & 0x00fffff8;
+}
+
+static inline GL_KOS_CAPTURE_RECORD *_glKosCaptureNext(GL_KOS_CAPTURE_RECORD *rec) {
+    return (GL_KOS_CAPTURE_RECORD *)((GLubyte *)(rec + 1) + GL_KOS_CAPTURE_PAD(rec->bytes));
+}
+
+static void _glKosCaptureWrite(GLuint tag, GLuint bytes, const GLuint *arg) {
+    GL_KOS_CAPTURE_RECORD rec;
+
+    memset(&rec, 0, sizeof(rec));
+
+    rec.tag = tag;
+    rec.bytes = bytes;
+
+    if(arg)
+        memcpy(rec.arg, arg, sizeof(rec.arg));
+
+    fwrite(&rec, sizeof(rec), 1, GL_KOS_CAPTURE_FILE);
+}
+
+/* Remember a texture referenced by the scene, to be written when it closes */
+static void _glKosCaptureTexture(GLuint offset) {
+    GLuint i;
+
+    if(offset == GL_KOS_CAPTURE_TEX_LAST)
+        return;
+
+    GL_KOS_CAPTURE_TEX_LAST = offset;
+
+    for(i = 0; i < GL_KOS_CAPTURE_TEX_COUNT; i++)
+        if(GL_KOS_CAPTURE_TEX[i] == offset)
+            return;
+
+    if(GL_KOS_CAPTURE_TEX_COUNT < GL_KOS_CAPTURE_TEXTURES)
+        GL_KOS_CAPTURE_TEX[GL_KOS_CAPTURE_TEX_COUNT++] = offset;
+}
+
+/* Write the VRAM blocks of the textures first referenced by this scene.
+   Blocks that no texture object owns are left out, and replay with
+   whatever VRAM holds at that address. */
+static void _glKosCaptureWriteTextures() {
+    static const GLubyte pad[32] = { 0 };
+
+    while(GL_KOS_CAPTURE_TEX_WRITTEN < GL_KOS_CAPTURE_TEX_COUNT) {
+        GLuint offset = GL_KOS_CAPTURE_TEX[GL_KOS_CAPTURE_TEX_WRITTEN++];
+        GL_TEXTURE_OBJECT *tex = _glKosTextureFindData(GL_KOS_CAPTURE_VRAM + offset);
+        GLuint arg[6] = { offset, 0, 0, 0, 0, 0 };
+
+        if(!tex || !tex->bytes)
+            continue;
+
+        _glKosCaptureWrite(GL_KOS_CAPTURE_TEXTURE, tex->bytes, arg);
+
+        fwrite(tex->data, 1, tex->bytes, GL_KOS_CAPTURE_FILE);
+        fwrite(pad, 1, GL_KOS_CAPTURE_PAD(tex->bytes) - tex->bytes, GL_KOS_CAPTURE_FILE);
+    }
+}
+
+//===============================================================================//
+//== Internal Capture Hooks, called by gl-pvr.c while GL_KOS_CAPTURE is set ==//
+
+void _glKosCaptureSceneBegin(const GLfloat *bg_color, GLubyte pt_alpha_ref,
+                             GLvoid *target, GLuint width, GLuint height) {
+    GLuint arg[6];
+
+    memcpy(arg, bg_color, 3 * sizeof(GLfloat));
+
+    arg[3] = pt_alpha_ref;
+    arg[4] = target ? _glKosCaptureOffset(target) : GL_KOS_CAPTURE_SCREEN;
+    arg[5] = width | (height << 16);
+
+    if(target)
+        _glKosCaptureTexture(arg[4]);
+
+    _glKosCaptureWrite(GL_KOS_CAPTURE_SCENE, 0, arg);
+
+    GL_KOS_CAPTURE_IN_SCENE = 1;
+}
+
+void _glKosCaptureSceneFinish() {
+    if(!GL_KOS_CAPTURE_IN_SCENE)
+        return;
+
+    _glKosCaptureWriteTextures();
+
+    _glKosCaptureWrite(GL_KOS_CAPTURE_END, 0, NULL);
+
+    GL_KOS_CAPTURE_IN_SCENE = 0;
+    ++GL_KOS_CAPTURE_SCENES;
+}
+
+void _glKosCaptureListBegin(GLuint list) {
+    GLuint arg[6] = { list, 0, 0, 0, 0, 0 };
+
+    if(!GL_KOS_CAPTURE_IN_SCENE)
+        return;
+
+    GL_KOS_CAPTURE_LIST_POS = ftell(GL_KOS_CAPTURE_FILE);
+    GL_KOS_CAPTURE_LIST_BYTES = 0;
+
+    _glKosCaptureWrite(GL_KOS_CAPTURE_LIST, 0, arg);
+}
+
+/* Go back and fill in the size of the list */
+void _glKosCaptureListFinish() {
+    if(!GL_KOS_CAPTURE_IN_SCENE)
+        return;
+
+    fseek(GL_KOS_CAPTURE_FILE, GL_KOS_CAPTURE_LIST_POS + sizeof(GLuint), SEEK_SET);
+    fwrite(&GL_KOS_CAPTURE_LIST_BYTES, sizeof(GLuint), 1, GL_KOS_CAPTURE_FILE);
+    fseek(GL_KOS_CAPTURE_FILE, 0, SEEK_END);
+}
+
+void _glKosCaptureCommands(const GLvoid *src, GLuint count) {
+    const pvr_cmd_t *cmd = src;
+    GLuint i;
+
+    if(!GL_KOS_CAPTURE_IN_SCENE)
+        return;
+
+    fwrite(src, sizeof(pvr_cmd_t), count, GL_KOS_CAPTURE_FILE);
+
+    GL_KOS_CAPTURE_LIST_BYTES += count * sizeof(pvr_cmd_t);
+
+    /* Textured polygon headers reference VRAM */
+    for(i = 0; i < count; i++, cmd++)
+        if((cmd->cmd[0] >> 29) == 4 && (cmd->cmd[0] & GL_PVR_CMD_TXR_ENABLE))
+            _glKosCaptureTexture((cmd->cmd[3] & GL_KOS_CAPTURE_TXR_ADDR_MASK) << 3);
+}
+
+//===============================================================================//
+//== Replay ==//
+
+static GLvoid *_glKosReplayTexture(GLuint offset) {
+    GLuint i;
+
+    for(i = 0; i < GL_KOS_REPLAY_TEX_COUNT; i++)
+        if(GL_KOS_REPLAY_TEX_OFFSET[i] == offset)
+            return GL_KOS_REPLAY_TEX[i];
+
+    return NULL;
+}
+
+/* Point the textured headers of a list at the replay's copies of the textures */
+static void _glKosReplayRelocate(pvr_cmd_t *cmd, GLuint count) {
+    while(count--) {
+        if((cmd->cmd[0] >> 29) == 4 && (cmd->cmd[0] & GL_PVR_CMD_TXR_ENABLE)) {
+            GLvoid *tex = _glKosReplayTexture((cmd->cmd[3] & GL_KOS_CAPTURE_TXR_ADDR_MASK) << 3);
+
+            if(tex)
+                cmd->cmd[3] = (cmd->cmd[3] & ~GL_KOS_CAPTURE_TXR_ADDR_MASK)
+                              | (_glKosCaptureOffset(tex) >> 3);
+        }
+
+        ++cmd;
+    }
+}
+
+//===============================================================================//
+//== External API Functions ==//
+
+GLint APIENTRY glKosCaptureBegin(const char *filename) {
+    GLuint arg[6] = { GL_KOS_CAPTURE_VERSION, 0, 0, 0, 0, 0 };
+
+    if(GL_KOS_CAPTURE) {
+        _glKosThrowError(GL_INVALID_OPERATION, "glKosCaptureBegin");
+        _glKosPrintError();
+        return 0;
+    }
+
+    GL_KOS_CAPTURE_FILE = fopen(filename, "wb");
+
+    if(!GL_KOS_CAPTURE_FILE) {
+        _glKosThrowError(GL_INVALID_VALUE, "glKosCaptureBegin");
+        _glKosPrintError();
+        return 0;
+    }
+
+    _glKosCaptureWrite(GL_KOS_CAPTURE_MAGIC, 0, arg);
+
+    GL_KOS_CAPTURE_SCENES = 0;
+    GL_KOS_CAPTURE_IN_SCENE = 0;
+    GL_KOS_CAPTURE_TEX_COUNT = GL_KOS_CAPTURE_TEX_WRITTEN = 0;
+    GL_KOS_CAPTURE_TEX_LAST = GL_KOS_CAPTURE_SCREEN;
+
+    GL_KOS_CAPTURE = 1;
+
+    return 1;
+}
+
+GLint APIENTRY glKosCaptureEnd() {
+    GLuint scenes = GL_KOS_CAPTURE_SCENES;
+
+    if(!GL_KOS_CAPTURE) {
+        _glKosThrowError(GL_INVALID_OPERATION, "glKosCaptureEnd");
+        _glKosPrintError();
+        return -1;
+    }
+
+    /* A scene still open on the PVR has no END record, and replay skips it */
+    fseek(GL_KOS_CAPTURE_FILE, 3 * sizeof(GLuint), SEEK_SET);
+    fwrite(&scenes, sizeof(GLuint), 1, GL_KOS_CAPTURE_FILE);
+    fclose(GL_KOS_CAPTURE_FILE);
+
+    GL_KOS_CAPTURE_FILE = NULL;
+    GL_KOS_CAPTURE = 0;
+
+    return scenes;
+}
+
+void APIENTRY glKosReplayFree() {
+    GLuint i;
+
+    for(i = 0; i < GL_KOS_REPLAY_TEX_COUNT; i++)
+        pvr_mem_free(GL_KOS_REPLAY_TEX[i]);
+
+    free(GL_KOS_REPLAY_DATA);
+    free(GL_KOS_REPLAY_SCENES);
+
+    GL_KOS_REPLAY_DATA = NULL;
+    GL_KOS_REPLAY_SCENES = NULL;
+    GL_KOS_REPLAY_SCENE_COUNT = GL_KOS_REPLAY_TEX_COUNT = 0;
+}
+
+/* Walk the records after the file header, checking that each one ends within the
+   file. Returns the number of scene ends, or -1 for a record running past end. */
+static GLint _glKosReplayVerify(GL_KOS_CAPTURE_RECORD *rec, GL_KOS_CAPTURE_RECORD *end) {
+    GLint scenes = 0;
+
+    for(rec = _glKosCaptureNext(rec); rec < end; rec = _glKosCaptureNext(rec)) {
+        if((GLubyte *)end - (GLubyte *)rec < (long)sizeof(GL_KOS_CAPTURE_RECORD)
+                || rec->bytes > (GLuint)((GLubyte *)end - (GLubyte *)(rec + 1)))
+            return -1;
+
+        if(rec->tag == GL_KOS_CAPTURE_END)
+            ++scenes;
+    }
+
+    return scenes;
+}
+
+/* Load failed: drop what was loaded so far */
+static GLint _glKosReplayLoadError(GLenum error) {
+    glKosReplayFree();
+    _glKosThrowError(error, "glKosReplayLoad");
+    _glKosPrintError();
+    return -1;
+}
+
+GLint APIENTRY glKosReplayLoad(const char *filename) {
+    GL_KOS_CAPTURE_RECORD *rec, *end, *scene = NULL;
+    GLint scenes;
+    FILE *f;
+    long size;
+
+    glKosReplayFree();
+
+    f = fopen(filename, "rb");
+
+    if(!f) {
+        _glKosThrowError(GL_INVALID_VALUE, "glKosReplayLoad");
+        _glKosPrintError();
+        return -1;
+    }
+
+    fseek(f, 0, SEEK_END);
+    size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+
+    GL_KOS_REPLAY_DATA = memalign(0x20, size);
+
+    if(!GL_KOS_REPLAY_DATA || fread(GL_KOS_REPLAY_DATA, 1, size, f) != (size_t)size) {
+        fclose(f);
+        return _glKosReplayLoadError(GL_OUT_OF_MEMORY);
+    }
+
+    fclose(f);
+
+    rec = (GL_KOS_CAPTURE_RECORD *)GL_KOS_REPLAY_DATA;
+    end = (GL_KOS_CAPTURE_RECORD *)(GL_KOS_REPLAY_DATA + size);
+
+    if(size < (long)sizeof(GL_KOS_CAPTURE_RECORD) || rec->tag != GL_KOS_CAPTURE_MAGIC
+            || rec->arg[0] != GL_KOS_CAPTURE_VERSION)
+        return _glKosReplayLoadError(GL_INVALID_VALUE);
+
+    /* A truncated or corrupt file: nothing is read past its end */
+    if((scenes = _glKosReplayVerify(rec, end)) < 0)
+        return _glKosReplayLoadError(GL_INVALID_VALUE);
+
+    GL_KOS_REPLAY_SCENES = malloc((scenes + 1) * sizeof(GL_KOS_CAPTURE_RECORD *));
+
+    if(!GL_KOS_REPLAY_SCENES)
+        return _glKosReplayLoadError(GL_OUT_OF_MEMORY);
+
+    /* Textures first, so the lists can be pointed at them */
+    for(rec = _glKosCaptureNext(rec); rec < end; rec = _glKosCaptureNext(rec))
+        if(rec->tag == GL_KOS_CAPTURE_TEXTURE && !_glKosReplayTexture(rec->arg[0])
+                && GL_KOS_REPLAY_TEX_COUNT < GL_KOS_CAPTURE_TEXTURES) {
+            GLvoid *tex = pvr_mem_malloc(rec->bytes);
+
+            if(!tex)
+                return _glKosReplayLoadError(GL_OUT_OF_MEMORY);
+
+            sq_cpy(tex, rec + 1, rec->bytes);
+
+            GL_KOS_REPLAY_TEX[GL_KOS_REPLAY_TEX_COUNT] = tex;
+            GL_KOS_REPLAY_TEX_OFFSET[GL_KOS_REPLAY_TEX_COUNT++] = rec->arg[0];
+        }
+
+    rec = _glKosCaptureNext((GL_KOS_CAPTURE_RECORD *)GL_KOS_REPLAY_DATA);
+
+    for(; rec < end; rec = _glKosCaptureNext(rec))
+        switch(rec->tag) {
+            case GL_KOS_CAPTURE_SCENE:
+                scene = rec;
+
+                if(rec->arg[4] != GL_KOS_CAPTURE_SCREEN) {
+                    GLvoid *target = _glKosReplayTexture(rec->arg[4]);
+
+                    rec->arg[4] = target ? _glKosCaptureOffset(target) : rec->arg[4];
+                }
+
+                break;
+
+            case GL_KOS_CAPTURE_LIST:
+                _glKosReplayRelocate((pvr_cmd_t *)(rec + 1), rec->bytes / sizeof(pvr_cmd_t));
+                break;
+
+            case GL_KOS_CAPTURE_END:
+                if(scene && GL_KOS_REPLAY_SCENE_COUNT
+                        < ((GL_KOS_CAPTURE_RECORD *)GL_KOS_REPLAY_DATA)->arg[1]
+                        && GL_KOS_REPLAY_SCENE_COUNT < (GLuint)scenes)
+                    GL_KOS_REPLAY_SCENES[GL_KOS_REPLAY_SCENE_COUNT++] = scene;
+
+                scene = NULL;
+                break;
+        }
+
+    return GL_KOS_REPLAY_SCENE_COUNT;
+}
+
+GLint APIENTRY glKosReplayScene(GLint index) {
+    GL_KOS_CAPTURE_RECORD *rec;
+    GLfloat bg_color[3];
+    GLint bytes = 0;
+
+    if(index < 0 || (GLuint)index >= GL_KOS_REPLAY_SCENE_COUNT) {
+        _glKosThrowError(GL_INVALID_VALUE, "glKosReplayScene");
+        _glKosPrintError();
+        return -1;
+    }
+
+    /* Replayed scenes go to the PVR between GL frames, never inside one */
+    if(!_glKosFrameFlush()) {
+        _glKosThrowError(GL_INVALID_OPERATION, "glKosReplayScene");
+        _glKosPrintError();
+        return -1;
+    }
+
+    rec = GL_KOS_REPLAY_SCENES[index];
+
+    memcpy(bg_color, rec->arg, sizeof(bg_color));
+
+    pvr_wait_ready();
+
+    pvr_set_bg_color(bg_color[0], bg_color[1], bg_color[2]);
+    PVR_SET(PVR_PT_ALPHA_REF, rec->arg[3]);
+
+    if(rec->arg[4] != GL_KOS_CAPTURE_SCREEN) {
+        uint32 width = rec->arg[5] & 0xffff, height = rec->arg[5] >> 16;
+
+        pvr_scene_begin_txr(GL_KOS_CAPTURE_VRAM + rec->arg[4], &width, &height);
+    }
+    else
+        pvr_scene_begin();
+
+    for(rec = _glKosCaptureNext(rec); rec->tag != GL_KOS_CAPTURE_END; rec = _glKosCaptureNext(rec))
+        if(rec->tag == GL_KOS_CAPTURE_LIST) {
+            pvr_list_begin(rec->arg[0]);
+            _glKosSubmitCommands(rec + 1, rec->bytes / sizeof(pvr_cmd_t));
+            pvr_list_finish();
+
+            bytes += rec->bytes;
+        }
+
+    pvr_scene_finish();
+
+    return bytes;
+}
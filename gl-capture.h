@@ -0,0 +1,53 @@
+/* KallistiGL for KallistiOS ##version##
+
+   libgl/gl-capture.h
+
+   TA command stream capture and replay. While a capture is open, gl-pvr.c
+   reports each scene, list and command burst it sends to the TA, and the
+   capture file gets an exact copy of the stream plus the VRAM textures the
+   stream references.
+
+   A capture file is a sequence of 32 byte records, each followed by its
+   payload padded to 32 bytes:
+   FILE    - first record, arg[0] version, arg[1] scenes
+   SCENE   - arg[0..2] background color, arg[3] PT alpha reference,
+             arg[4] render target VRAM offset or GL_KOS_CAPTURE_SCREEN,
+             arg[5] render target width | height << 16
+   LIST    - arg[0] PVR list, payload is the TA commands of the list
+   TEXTURE - arg[0] VRAM offset, payload is the VRAM block
+   END     - closes the scene
+*/
+
+#ifndef GL_CAPTURE_H
+#define GL_CAPTURE_H
+
+#include "gl-pvr.h"
+
+#define GL_KOS_CAPTURE_MAGIC    0x434c474b /* "KGLC" */
+#define GL_KOS_CAPTURE_VERSION  1
+
+#define GL_KOS_CAPTURE_SCENE    1
+#define GL_KOS_CAPTURE_LIST     2
+#define GL_KOS_CAPTURE_TEXTURE  3
+#define GL_KOS_CAPTURE_END      4
+
+#define GL_KOS_CAPTURE_SCREEN   0xffffffff
+
+#define GL_KOS_CAPTURE_TEXTURES 1024 /* Distinct textures a capture can hold */
+
+typedef struct {
+    unsigned int tag,        /* GL_KOS_CAPTURE_* or GL_KOS_CAPTURE_MAGIC */
+             bytes,      /* Payload following the record */
+             arg[6];
+} GL_KOS_CAPTURE_RECORD; /* Same size as a TA command */
+
+extern GLubyte GL_KOS_CAPTURE; /* Nonzero while a capture file is open */
+
+void _glKosCaptureSceneBegin(const GLfloat *bg_color, GLubyte pt_alpha_ref,
+                             GLvoid *target, GLuint width, GLuint height);
+void _glKosCaptureSceneFinish();
+void _glKosCaptureListBegin(GLuint list);
+void _glKosCaptureListFinish();
+void _glKosCaptureCommands(const GLvoid *src, GLuint count);
+
+#endif
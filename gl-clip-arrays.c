@@ -8,6 +8,7 @@
    -GL_TRIANGLES
    -GL_TRIANGLE_STRIPS
    -GL_QUADS
+   -Line segments, before they are expanded to quads
    Outputs a mix of Triangles and Triangle Strips for use with the PVR
 */
 
@@ -222,6 +223,34 @@ unsigned int _glKosClipQuadsTransformed(pvr_vertex_t *src, GLfloat *w, pvr_verte
     return verts_out;
 }
 
+/* Clip the segment v[0] to v[1] in place, then divide both ends by their w.
+   Returns 0 if the segment is entirely outside of the clip plane. */
+GLubyte _glKosClipLineTransformed(pvr_vertex_t *v, GLfloat *w) {
+    GLushort clip = 0;
+
+    if(v[0].z >= CLIP_NEARZ) clip |= FIRST;
+
+    if(v[1].z >= CLIP_NEARZ) clip |= SECOND;
+
+    switch(clip) {
+        case FIRST | SECOND:
+            return 0;
+
+        case FIRST:
+            _glKosVertexClipZNear3(&v[0], &v[1], &w[0], &w[1]);
+            break;
+
+        case SECOND:
+            _glKosVertexClipZNear3(&v[1], &v[0], &w[1], &w[0]);
+            break;
+    }
+
+    _glKosVertexPerspectiveDivide(&v[0], w[0]);
+    _glKosVertexPerspectiveDivide(&v[1], w[1]);
+
+    return 1;
+}
+
 static inline GLubyte _glKosClipTriTransformedMT(pvr_vertex_t *src, float *w, pvr_vertex_t *dst,
         GLfloat *uvsrc, glTexCoord *uvdst, GLuint uv_src_stride) {
     GLushort clip = 0; /* Clip Code for current Triangle */
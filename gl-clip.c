@@ -173,9 +173,9 @@ static inline unsigned char _glKosClipTri(pvr_vertex_t *src, pvr_vertex_t *dst)
 
     /* Transform all 3 Vertices of Triangle */
     {
-        register float __x __asm__("fr12") = src->x;
-        register float __y __asm__("fr13") = src->y;
-        register float __z __asm__("fr14") = src->z;
+        register float __x GL_KOS_FREG("fr12") = src->x;
+        register float __y GL_KOS_FREG("fr13") = src->y;
+        register float __z GL_KOS_FREG("fr14") = src->z;
 
         mat_trans_fv12_nodiv();
 
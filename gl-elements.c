@@ -0,0 +1,395 @@
+/* KallistiGL for KallistiOS ##version##
+
+   libgl/gl-elements.c
+
+   Optimized Elements. The PVR takes triangle strips natively, one vertex per
+   triangle once a strip is started, where a triangle list costs three. Here,
+   glKosOptimizeElements() walks the triangles of an index buffer and joins
+   them into strips, greedily: each strip starts next to the end of the last
+   one, so the order of the vertices stays as local as the original, and is
+   extended while a free triangle shares its last edge with the winding order
+   the strip needs. The strips are kept in a linked list, by the index pointer,
+   count and type they were made from, and glDrawElements() of GL_TRIANGLES
+   looks them up and gathers the strips from the element cache in gl-arrays.c.
+*/
+
+#include <GL/gl.h>
+#include "gl-api.h"
+#include "gl-elements.h"
+#include "gl-pvr.h"
+
+#include <malloc.h>
+#include <string.h>
+
+//========================================================================================//
+//== Internal KOS Open GL Optimized Elements Structures / Global Variables ==//
+
+static GL_KOS_ELEMENT_STRIPS GL_KOS_ELEMENT_OBJ; /* Head of the list, index 0 is never used */
+
+static GLuint GL_KOS_ELEMENT_INDEX = 0;
+
+#define GL_KOS_STRIP_NONE 0xFFFFFFFF
+#define GL_KOS_STRIP_USED 1          /* Mark of a triangle in a strip, trials use higher stamps */
+
+typedef struct {
+    const GLuint *tri;          /* 3 vertices per triangle, degenerate triangles removed */
+    const GLuint *first;        /* Triangles around vertex v are list[first[v - lo]] to */
+    const GLuint *list;         /* list[first[v - lo + 1] - 1] */
+    GLuint *mark;               /* Per triangle, GL_KOS_STRIP_USED or a trial stamp */
+    GLuint  lo;
+} GL_KOS_STRIP_MESH;
+
+//========================================================================================//
+//== Stripification ==//
+
+/* A triangle around a with the directed edge a->b, not in a strip nor taken by
+   the trial of stamp, or GL_KOS_STRIP_NONE */
+static inline GLuint _glKosStripFind(const GL_KOS_STRIP_MESH *mesh, GLuint a, GLuint b, GLuint stamp) {
+    GLuint i, t;
+    const GLuint *v;
+
+    for(i = mesh->first[a - mesh->lo]; i < mesh->first[a - mesh->lo + 1]; i++) {
+        t = mesh->list[i];
+
+        if(mesh->mark[t] == GL_KOS_STRIP_USED || mesh->mark[t] == stamp)
+            continue;
+
+        v = &mesh->tri[t * 3];
+
+        if((v[0] == a && v[1] == b) || (v[1] == a && v[2] == b) || (v[2] == a && v[0] == b))
+            return t;
+    }
+
+    return GL_KOS_STRIP_NONE;
+}
+
+/* The vertex of triangle v that is neither a nor b */
+static inline GLuint _glKosStripThird(const GLuint *v, GLuint a, GLuint b) {
+    return v[0] + v[1] + v[2] - a - b;
+}
+
+/* Free triangles sharing an edge with triangle t */
+static GLuint _glKosStripNeighbors(const GL_KOS_STRIP_MESH *mesh, GLuint t) {
+    const GLuint *v = &mesh->tri[t * 3];
+
+    return (_glKosStripFind(mesh, v[1], v[0], GL_KOS_STRIP_USED) != GL_KOS_STRIP_NONE)
+           + (_glKosStripFind(mesh, v[2], v[1], GL_KOS_STRIP_USED) != GL_KOS_STRIP_NONE)
+           + (_glKosStripFind(mesh, v[0], v[2], GL_KOS_STRIP_USED) != GL_KOS_STRIP_NONE);
+}
+
+/* Grow a strip from triangle t, its vertices rotated by r, marking its triangles
+   with stamp. Triangle k of the strip is (s[k], s[k+1], s[k+2]) when k is even and
+   (s[k+1], s[k], s[k+2]) when odd, so it takes the edge s[k]->s[k+1] or s[k+1]->s[k]
+   from the last two vertices. Returns the length, the vertices go to out if set. */
+static GLuint _glKosStripBuild(GL_KOS_STRIP_MESH *mesh, GLuint t, GLuint r, GLuint stamp, GLuint *out) {
+    const GLuint *v = &mesh->tri[t * 3];
+    GLuint a = v[(r + 1) % 3], b = v[(r + 2) % 3], c, u, k, len = 3;
+
+    mesh->mark[t] = stamp;
+
+    if(out) {
+        out[0] = v[r];
+        out[1] = a;
+        out[2] = b;
+    }
+
+    for(k = 1; len < GL_KOS_MAX_DRAW_VERTS; k++, len++) {
+        u = (k & 1) ? _glKosStripFind(mesh, b, a, stamp) : _glKosStripFind(mesh, a, b, stamp);
+
+        if(u == GL_KOS_STRIP_NONE)
+            break;
+
+        mesh->mark[u] = stamp;
+
+        c = _glKosStripThird(&mesh->tri[u * 3], a, b);
+
+        if(out)
+            out[len] = c;
+
+        a = b;
+        b = c;
+    }
+
+    return len;
+}
+
+/* The free triangle around vertex v with the fewest free neighbors, so strips
+   start at the border of what is left, or GL_KOS_STRIP_NONE */
+static GLuint _glKosStripStart(const GL_KOS_STRIP_MESH *mesh, GLuint v) {
+    GLuint i, t, n, best = GL_KOS_STRIP_NONE, fewest = 4;
+
+    for(i = mesh->first[v - mesh->lo]; i < mesh->first[v - mesh->lo + 1]; i++) {
+        t = mesh->list[i];
+
+        if(mesh->mark[t] == GL_KOS_STRIP_USED)
+            continue;
+
+        if((n = _glKosStripNeighbors(mesh, t)) < fewest) {
+            best = t;
+            fewest = n;
+        }
+    }
+
+    return best;
+}
+
+/* Join the count triangles of tri into strips. The vertices go to out, the
+   length of each strip to strips, and the number of strips is returned. */
+static GLuint _glKosStripify(GL_KOS_STRIP_MESH *mesh, GLuint count, GLuint *out, GLushort *strips) {
+    GLuint n = 0, t, r, len, best, longest, cursor = 0, stamp = GL_KOS_STRIP_USED + 1;
+    GLuint *o = out;
+
+    for(;;) {
+        /* Continue from the last vertex of the last strip, else in the original order */
+        t = o > out ? _glKosStripStart(mesh, o[-1]) : GL_KOS_STRIP_NONE;
+
+        if(t == GL_KOS_STRIP_NONE) {
+            while(cursor < count && mesh->mark[cursor] == GL_KOS_STRIP_USED)
+                cursor++;
+
+            if(cursor == count)
+                break;
+
+            t = cursor;
+        }
+
+        /* Keep the longest of the strips from each rotation of the first triangle */
+        for(r = 0, best = 0, longest = 0; r < 3; r++)
+            if((len = _glKosStripBuild(mesh, t, r, stamp++, NULL)) > longest) {
+                best = r;
+                longest = len;
+            }
+
+        o += strips[n++] = _glKosStripBuild(mesh, t, best, GL_KOS_STRIP_USED, o);
+    }
+
+    return n;
+}
+
+//========================================================================================//
+//== Optimized Element Objects ==//
+
+static void _glKosElementStripsFree(GL_KOS_ELEMENT_STRIPS *obj) {
+    free(obj->strip_index);
+    free(obj->strips);
+    free(obj);
+}
+
+static void _glKosElementStripsDelete(GLuint index) {
+    GL_KOS_ELEMENT_STRIPS *ptr = GL_KOS_ELEMENT_OBJ.link, *lptr = &GL_KOS_ELEMENT_OBJ;
+
+    while(ptr != NULL && ptr->index != index) {
+        lptr = ptr;
+        ptr = (GL_KOS_ELEMENT_STRIPS *)ptr->link;
+    }
+
+    if(ptr != NULL) {
+        lptr->link = ptr->link;
+        _glKosElementStripsFree(ptr);
+    }
+}
+
+GL_KOS_ELEMENT_STRIPS *_glKosElementStrips(const GLvoid *indices, GLsizei count, GLenum type) {
+    GL_KOS_ELEMENT_STRIPS *ptr = GL_KOS_ELEMENT_OBJ.link;
+    GL_BUFFER_OBJECT *buffer;
+
+    if(ptr == NULL)
+        return NULL;
+
+    buffer = _glKosBoundBuffer(GL_ELEMENT_ARRAY_BUFFER);
+
+    while(ptr != NULL && (ptr->indices != indices || ptr->count != count
+                          || ptr->type != type || ptr->buffer != buffer))
+        ptr = (GL_KOS_ELEMENT_STRIPS *)ptr->link;
+
+    return ptr;
+}
+
+void _glKosElementStripsInvalidate(GL_BUFFER_OBJECT *buffer) {
+    GL_KOS_ELEMENT_STRIPS *ptr = GL_KOS_ELEMENT_OBJ.link, *lptr = &GL_KOS_ELEMENT_OBJ;
+
+    while(ptr != NULL) {
+        if(ptr->buffer == buffer) {
+            lptr->link = ptr->link;
+            _glKosElementStripsFree(ptr);
+        }
+        else
+            lptr = ptr;
+
+        ptr = (GL_KOS_ELEMENT_STRIPS *)lptr->link;
+    }
+}
+
+/* Read the triangles of count elements, without the degenerate ones, and find
+   the range of vertices they reference. Returns the number of triangles. */
+static GLuint _glKosElementsTriangles(const GLvoid *indices, GLuint count, GLenum type,
+                                      GLuint *tri, GLuint *start, GLuint *end) {
+    GLuint i, j, n = 0, lo = 0xFFFFFFFF, hi = 0;
+    GLuint *v;
+
+    for(i = 0; i + 2 < count; i += 3) {
+        v = &tri[n * 3];
+
+        for(j = 0; j < 3; j++)
+            v[j] = type == GL_UNSIGNED_BYTE ? ((const GLubyte *)indices)[i + j] :
+                   type == GL_UNSIGNED_SHORT ? ((const GLushort *)indices)[i + j] :
+                   ((const GLuint *)indices)[i + j];
+
+        if(v[0] == v[1] || v[1] == v[2] || v[2] == v[0])
+            continue;
+
+        for(j = 0; j < 3; j++) {
+            lo = v[j] < lo ? v[j] : lo;
+            hi = v[j] > hi ? v[j] : hi;
+        }
+
+        n++;
+    }
+
+    *start = lo;
+    *end = hi;
+
+    return n;
+}
+
+/* Convert the triangles of tri into the strips of obj, which get the range start to end */
+static GLubyte _glKosElementsOptimize(GL_KOS_ELEMENT_STRIPS *obj, const GLuint *tri, GLuint count,
+                                      GLuint start, GLuint end) {
+    GL_KOS_STRIP_MESH mesh;
+    GLuint *first = calloc(end - start + 2, sizeof(GLuint));
+    GLuint *list = malloc(count * 3 * sizeof(GLuint));
+    GLuint *mark = calloc(count, sizeof(GLuint));
+    GLuint i, v;
+
+    obj->strip_index = malloc(count * 3 * sizeof(GLuint));
+    obj->strips = malloc(count * sizeof(GLushort));
+
+    if(first == NULL || list == NULL || mark == NULL || obj->strip_index == NULL || obj->strips == NULL) {
+        free(first);
+        free(list);
+        free(mark);
+        return 0;
+    }
+
+    /* Triangles around each vertex: count them, sum the counts to where each vertex
+       ends, then place the triangles backwards, leaving where each vertex starts */
+    for(i = 0; i < count * 3; i++)
+        first[tri[i] - start]++;
+
+    for(v = 1; v <= end - start + 1; v++)
+        first[v] += first[v - 1];
+
+    for(i = count * 3; i > 0; i--)
+        list[--first[tri[i - 1] - start]] = (i - 1) / 3;
+
+    mesh.tri = tri;
+    mesh.first = first;
+    mesh.list = list;
+    mesh.mark = mark;
+    mesh.lo = start;
+
+    obj->strip_count = _glKosStripify(&mesh, count, obj->strip_index, obj->strips);
+
+    for(i = 0, obj->index_count = 0; i < obj->strip_count; i++)
+        obj->index_count += obj->strips[i];
+
+    free(first);
+    free(list);
+    free(mark);
+
+    return 1;
+}
+
+//========================================================================================//
+//== Public KOS Open GL API Optimized Elements Functionality ==//
+
+GLAPI GLuint APIENTRY glKosOptimizeElements(GLsizei count, GLenum type, const GLvoid *indices) {
+    GL_BUFFER_OBJECT *buffer = _glKosBoundBuffer(GL_ELEMENT_ARRAY_BUFFER);
+    GL_KOS_ELEMENT_STRIPS *obj, *ptr;
+    const GLvoid *data = indices;
+    GLuint *tri, triangles, start, end;
+
+    if(type != GL_UNSIGNED_BYTE)
+        if(type != GL_UNSIGNED_SHORT)
+            if(type != GL_UNSIGNED_INT)
+                _glKosThrowError(GL_INVALID_ENUM, "glKosOptimizeElements");
+
+    if(count < 0)
+        _glKosThrowError(GL_INVALID_VALUE, "glKosOptimizeElements");
+
+    if(_glKosGetError()) {
+        _glKosPrintError();
+        return 0;
+    }
+
+    if(count < 3)
+        return 0;
+
+    /* Optimizing the same elements again replaces their strips */
+    if((ptr = _glKosElementStrips(indices, count, type)) != NULL)
+        _glKosElementStripsDelete(ptr->index);
+
+    /* While a GL_ELEMENT_ARRAY_BUFFER is bound, indices is an offset into it */
+    if(buffer)
+        data = (GLubyte *)buffer->data + (size_t)indices;
+
+    if((tri = malloc((count / 3) * 3 * sizeof(GLuint))) == NULL) {
+        _glKosThrowError(GL_OUT_OF_MEMORY, "glKosOptimizeElements");
+        _glKosPrintError();
+        return 0;
+    }
+
+    triangles = _glKosElementsTriangles(data, count, type, tri, &start, &end);
+
+    /* Strips are drawn from the element cache, the range must fit in it */
+    if(!triangles || end - start >= GL_KOS_MAX_VERTS) {
+        free(tri);
+        return 0;
+    }
+
+    if((obj = malloc(sizeof(GL_KOS_ELEMENT_STRIPS))) == NULL) {
+        free(tri);
+        _glKosThrowError(GL_OUT_OF_MEMORY, "glKosOptimizeElements");
+        _glKosPrintError();
+        return 0;
+    }
+
+    memset(obj, 0, sizeof(GL_KOS_ELEMENT_STRIPS));
+    obj->index = ++GL_KOS_ELEMENT_INDEX;
+    obj->buffer = buffer;
+    obj->indices = indices;
+    obj->count = count;
+    obj->type = type;
+    obj->start = start;
+    obj->end = end;
+
+    if(!_glKosElementsOptimize(obj, tri, triangles, start, end)) {
+        free(tri);
+        _glKosElementStripsFree(obj);
+        _glKosThrowError(GL_OUT_OF_MEMORY, "glKosOptimizeElements");
+        _glKosPrintError();
+        return 0;
+    }
+
+    free(tri);
+
+    for(ptr = &GL_KOS_ELEMENT_OBJ; ptr->link != NULL;)
+        ptr = (GL_KOS_ELEMENT_STRIPS *)ptr->link;
+
+    ptr->link = obj;
+
+    return obj->index;
+}
+
+GLAPI void APIENTRY glKosDeleteOptimizedElements(GLuint handle) {
+    _glKosElementStripsDelete(handle);
+}
+
+GLAPI GLuint APIENTRY glKosOptimizedElementsCount(GLuint handle) {
+    GL_KOS_ELEMENT_STRIPS *ptr = GL_KOS_ELEMENT_OBJ.link;
+
+    while(ptr != NULL && ptr->index != handle)
+        ptr = (GL_KOS_ELEMENT_STRIPS *)ptr->link;
+
+    return ptr != NULL ? ptr->index_count : 0;
+}
@@ -0,0 +1,36 @@
+/* KallistiGL for KallistiOS ##version##
+
+   libgl/gl-elements.h
+
+   Optimized Elements. glKosOptimizeElements() converts GL_TRIANGLES elements to
+   triangle strips, kept by the index pointer they were made from, so a later
+   glDrawElements() of the same elements submits about one vertex per triangle
+   instead of three.
+*/
+
+#ifndef GL_ELEMENTS_H
+#define GL_ELEMENTS_H
+
+#include "gl-api.h"
+
+typedef struct {
+    GLuint  index;              /* Handle returned by glKosOptimizeElements() */
+    GL_BUFFER_OBJECT *buffer;   /* Element Array Buffer indices is an offset into, or NULL */
+    const GLvoid *indices;
+    GLsizei count;
+    GLenum  type;
+    GLuint  start, end;         /* Lowest and highest vertex the strips reference */
+    GLuint *strip_index;        /* Elements of every strip, back to back */
+    GLushort *strips;           /* Length of each strip, at most GL_KOS_MAX_DRAW_VERTS */
+    GLuint  strip_count, index_count;
+    GLvoid *link;
+} GL_KOS_ELEMENT_STRIPS;
+
+/* The strips of count elements of the index type at indices, an offset into the
+   bound Element Array Buffer if there is one, or NULL if they were not optimized */
+GL_KOS_ELEMENT_STRIPS *_glKosElementStrips(const GLvoid *indices, GLsizei count, GLenum type);
+
+/* The data of buffer changed or it was deleted, drop the strips made from it */
+void _glKosElementStripsInvalidate(GL_BUFFER_OBJECT *buffer);
+
+#endif
@@ -23,6 +23,8 @@
 #include "gl-api.h"
 #include "gl-clip.h"
 #include "gl-light.h"
+#include "gl-stats.h"
+#include "gl-trace.h"
 
 #define GL_KOS_MAX_LIGHTS 16 /* Number of Light Sources that may be enabled at once */
 
@@ -94,6 +96,10 @@ GLubyte _glKosGetMaxLights() {
     return GL_KOS_MAX_LIGHTS;
 }
 
+const GLfloat *_glKosVertexNormal() {
+    return GL_VERTEX_NORMAL;
+}
+
 /* Vertex Normal Submission */
 void glNormal3f(GLfloat x, GLfloat y, GLfloat z) {
     GL_VERTEX_NORMAL[0] = x;
@@ -408,6 +414,8 @@ void _glKosVertex3flc(GLfloat x, GLfloat y, GLfloat z) {
 
 /**** Compute Vertex Light Color  ***/
 void _glKosVertexLights(glVertex *P, pvr_vertex_t *v, GLuint count) {
+    GL_KOS_TRACE("_glKosVertexLights");
+
 #ifdef GL_ENABLE_SPECULAR
     float S;
 #endif
@@ -423,6 +431,9 @@ void _glKosVertexLights(glVertex *P, pvr_vertex_t *v, GLuint count) {
                    GL_MATERIAL.Ke[2] + GL_MATERIAL.Ka[2] *GL_GLOBAL_AMBIENT[2]
                  };
 
+    GL_KOS_STAT_ADD(frame.lit_vertices, count);
+    GL_KOS_STAT_PEAK(array_buf_peak, count);
+
     while(count--) {
         for(i = 0; i < GL_KOS_MAX_LIGHTS; i++)
             if(GL_LIGHT_ENABLED & 1 << i)
@@ -554,6 +565,9 @@ void _glKosVertexComputeLighting(pvr_vertex_t *v, int verts) {
     unsigned int i;
     glVertex *s = _glKosArrayBufAddr();
 
+    GL_KOS_STAT_ADD(frame.lit_vertices, verts);
+    GL_KOS_STAT_PEAK(array_buf_peak, verts);
+
     _glKosMatrixLoadModelView();
 
     for(i = 0; i < verts; i++) {
@@ -0,0 +1,768 @@
+/* KallistiGL for KallistiOS ##version##
+
+   libgl/gl-list.c
+
+   Open GL Display List implementation.
+   This implementation uses a dynamic linked list to store the display lists.
+
+   A list is recorded as blocks of object space pvr_vertex_t, with the color
+   packed, the texture coordinates run through the texture matrix, and the
+   vertex flags set. Each block keeps the header state it was recorded with -
+   blending, alpha test, depth, culling, shading, fog and scissor - the PVR
+   list that state selects, and the name of the bound texture. glCallList()
+   looks the texture up by name and compiles the header from the recorded
+   state and the texture as it is at the time of the call, then copies each
+   vertex to the Vertex Buffer while transforming it. Lighting and Near-Z
+   clipping follow the state at the time of the call, through the same clip
+   buffer path as glEnd().
+
+   State calls made between glNewList() and glEndList() shape the recorded
+   blocks. With GL_COMPILE, glEndList() puts back the vertex attributes, header
+   state, enabled capabilities and texture bindings glNewList() found.
+*/
+
+#include <GL/gl.h>
+#include "gl-api.h"
+#include "gl-list.h"
+#include "gl-primitive.h"
+#include "gl-pvr.h"
+#include "gl-sh4.h"
+#include "gl-stats.h"
+#include "gl-trace.h"
+
+#include <malloc.h>
+#include <string.h>
+
+//========================================================================================//
+//== Internal KOS Open GL Display List Structures / Global Variables ==//
+
+#define GL_KOS_LIST_MIN_VERTS  64
+#define GL_KOS_LIST_MIN_BLOCKS 8
+
+static GL_KOS_DISPLAY_LIST GL_KOS_LIST_OBJ; /* Head of the list, index 0 is never used */
+
+GL_KOS_DISPLAY_LIST *GL_KOS_LIST_RECORD = NULL;
+
+static GLuint  GL_KOS_LIST_BASE = 0;
+
+static GLenum  GL_KOS_LIST_PRIM  = GL_TRIANGLES; /* glBegin() block being recorded */
+static GLuint  GL_KOS_LIST_VERTS = 0;
+static GLubyte GL_KOS_LIST_LIT   = 0;
+
+//========================================================================================//
+//== Display List Objects ==//
+
+static GL_KOS_DISPLAY_LIST *_glKosListFind(GLuint index) {
+    GL_KOS_DISPLAY_LIST *ptr = GL_KOS_LIST_OBJ.link;
+
+    while(ptr != NULL && ptr->index != index)
+        ptr = (GL_KOS_DISPLAY_LIST *)ptr->link;
+
+    return ptr;
+}
+
+static GLuint _glKosListLastIndex() {
+    GL_KOS_DISPLAY_LIST *ptr = GL_KOS_LIST_OBJ.link;
+    GLuint index = 0;
+
+    while(ptr != NULL) {
+        if(ptr->index > index)
+            index = ptr->index;
+
+        ptr = (GL_KOS_DISPLAY_LIST *)ptr->link;
+    }
+
+    return index;
+}
+
+static GL_KOS_DISPLAY_LIST *_glKosListCreate(GLuint index) {
+    GL_KOS_DISPLAY_LIST *ptr = &GL_KOS_LIST_OBJ;
+    GL_KOS_DISPLAY_LIST *list = calloc(1, sizeof(GL_KOS_DISPLAY_LIST));
+
+    if(list == NULL)
+        return NULL;
+
+    list->index = index;
+
+    while(ptr->link != NULL)
+        ptr = (GL_KOS_DISPLAY_LIST *)ptr->link;
+
+    ptr->link = list;
+
+    return list;
+}
+
+static void _glKosListClear(GL_KOS_DISPLAY_LIST *list) {
+    free(list->blocks);
+    free(list->verts);
+    free(list->norms);
+
+    list->blocks = NULL;
+    list->verts = NULL;
+    list->norms = NULL;
+    list->block_count = list->block_size = 0;
+    list->vert_count = list->vert_size = 0;
+}
+
+/* Trim a finished list to its size. The vertices are moved to a 32 byte
+   aligned block, so every vertex sits on its own cache line. */
+static void _glKosListCompact(GL_KOS_DISPLAY_LIST *list) {
+    pvr_vertex_t *verts;
+
+    if(!list->vert_count) {
+        _glKosListClear(list);
+        return;
+    }
+
+    verts = memalign(32, list->vert_count * sizeof(pvr_vertex_t));
+
+    if(verts != NULL) {
+        memcpy(verts, list->verts, list->vert_count * sizeof(pvr_vertex_t));
+        free(list->verts);
+        list->verts = verts;
+        list->vert_size = list->vert_count;
+    }
+
+    if(list->norms != NULL && list->vert_size == list->vert_count) {
+        GLfloat *norms = realloc(list->norms, list->vert_count * 3 * sizeof(GLfloat));
+
+        if(norms != NULL)
+            list->norms = norms;
+    }
+
+    if(list->block_count < list->block_size) {
+        GL_KOS_LIST_BLOCK *blocks = realloc(list->blocks, list->block_count * sizeof(GL_KOS_LIST_BLOCK));
+
+        if(blocks != NULL) {
+            list->blocks = blocks;
+            list->block_size = list->block_count;
+        }
+    }
+}
+
+//========================================================================================//
+//== Display List Recording ==//
+
+pvr_vertex_t *_glKosListReserve(GLuint count) {
+    GL_KOS_DISPLAY_LIST *list = GL_KOS_LIST_RECORD;
+    GLuint size = list->vert_size ? list->vert_size : GL_KOS_LIST_MIN_VERTS;
+
+    while(size < list->vert_count + count)
+        size *= 2;
+
+    if(size != list->vert_size) {
+        pvr_vertex_t *verts = realloc(list->verts, size * sizeof(pvr_vertex_t));
+
+        if(verts == NULL)
+            return NULL;
+
+        list->verts = verts;
+
+        if(list->norms != NULL) {
+            GLfloat *norms = realloc(list->norms, size * 3 * sizeof(GLfloat));
+
+            if(norms == NULL)
+                return NULL;
+
+            list->norms = norms;
+        }
+
+        list->vert_size = size;
+    }
+
+    return list->verts + list->vert_count;
+}
+
+GLfloat *_glKosListNormals() {
+    GL_KOS_DISPLAY_LIST *list = GL_KOS_LIST_RECORD;
+
+    if(list->norms == NULL)
+        list->norms = malloc(list->vert_size * 3 * sizeof(GLfloat));
+
+    return list->norms ? list->norms + list->vert_count * 3 : NULL;
+}
+
+/* Add a block drawn with the texture, list and header state of src */
+static void _glKosListAddBlockAs(GLenum mode, GLuint count, GLubyte textured, GLubyte lit,
+                                 const GL_KOS_LIST_BLOCK *src) {
+    GL_KOS_DISPLAY_LIST *list = GL_KOS_LIST_RECORD;
+    GL_KOS_LIST_BLOCK *block;
+    pvr_vertex_t *v = list->verts + list->vert_count;
+    GLuint i;
+
+    switch(mode) {
+        case GL_TRIANGLES:
+            count -= count % 3;
+
+            for(i = 0; i < count; i++)
+                v[i].flags = (i % 3 == 2) ? PVR_CMD_VERTEX_EOL : PVR_CMD_VERTEX;
+
+            break;
+
+        case GL_QUADS:
+            count -= count % 4;
+
+            /* Quads keep the submission order, the clipper expects it. glCallList()
+               swaps the last two vertices, so the third one ends the strip. */
+            for(i = 0; i < count; i++)
+                v[i].flags = (i % 4 == 2) ? PVR_CMD_VERTEX_EOL : PVR_CMD_VERTEX;
+
+            break;
+
+        case GL_TRIANGLE_STRIP:
+            if(count < 3)
+                count = 0;
+
+            for(i = 0; i < count; i++)
+                v[i].flags = (i == count - 1) ? PVR_CMD_VERTEX_EOL : PVR_CMD_VERTEX;
+
+            break;
+
+        default:
+            count = 0;
+    }
+
+    if(!count)
+        return;
+
+    block = list->block_count ? &list->blocks[list->block_count - 1] : NULL;
+
+    /* Separate primitives continue the last block when they are drawn the same way */
+    if(block != NULL && mode != GL_TRIANGLE_STRIP && block->mode == mode
+            && block->textured == textured && block->lit == lit && block->list == src->list
+            && block->texture == src->texture
+            && !memcmp(&block->state, &src->state, sizeof(GL_KOS_HDR_STATE)))
+        block->count += count;
+    else {
+        if(list->block_count == list->block_size) {
+            GLuint size = list->block_size ? list->block_size * 2 : GL_KOS_LIST_MIN_BLOCKS;
+
+            block = realloc(list->blocks, size * sizeof(GL_KOS_LIST_BLOCK));
+
+            if(block == NULL) {
+                _glKosThrowError(GL_OUT_OF_MEMORY, "glEndList");
+                _glKosPrintError();
+                return;
+            }
+
+            list->blocks = block;
+            list->block_size = size;
+        }
+
+        block = &list->blocks[list->block_count++];
+
+        block->mode = mode;
+        block->first = list->vert_count;
+        block->count = count;
+        block->textured = textured;
+        block->lit = lit;
+        block->list = src->list;
+        block->texture = src->texture;
+        block->state = src->state;
+    }
+
+    list->vert_count += count;
+}
+
+/* Add a block drawn as the current state would draw it now */
+void _glKosListAddBlock(GLenum mode, GLuint count, GLubyte textured, GLubyte lit) {
+    GL_TEXTURE_OBJECT *tex = _glKosBoundTexObject();
+    GL_KOS_LIST_BLOCK src;
+
+    src.list = _glKosList();
+    src.texture = (textured && _glKosEnabledTexture2D() && tex) ? tex->index : 0;
+
+    _glKosHdrState(&src.state);
+
+    _glKosListAddBlockAs(mode, count, textured, lit, &src);
+}
+
+/* Copy the blocks of a list into the list being compiled */
+static void _glKosListAppend(GL_KOS_DISPLAY_LIST *src) {
+    GL_KOS_LIST_BLOCK *block = src->blocks;
+    pvr_vertex_t *v;
+    GLfloat *n;
+    GLuint i;
+
+    for(i = 0; i < src->block_count; i++, block++) {
+        v = _glKosListReserve(block->count);
+        n = (v != NULL && block->lit) ? _glKosListNormals() : NULL;
+
+        if(v == NULL || (block->lit && n == NULL)) {
+            _glKosThrowError(GL_OUT_OF_MEMORY, "glCallList");
+            _glKosPrintError();
+            return;
+        }
+
+        memcpy(v, src->verts + block->first, block->count * sizeof(pvr_vertex_t));
+
+        if(n != NULL)
+            memcpy(n, src->norms + block->first * 3, block->count * 3 * sizeof(GLfloat));
+
+        _glKosListAddBlockAs(block->mode, block->count, block->textured, block->lit, block);
+    }
+}
+
+void _glKosListBegin(GLenum mode) {
+    GL_KOS_LIST_PRIM = mode;
+    GL_KOS_LIST_VERTS = 0;
+    GL_KOS_LIST_LIT = _glKosEnabledLighting();
+}
+
+void _glKosListVertex3f(GLfloat x, GLfloat y, GLfloat z) {
+    pvr_vertex_t *v = _glKosListReserve(GL_KOS_LIST_VERTS + 1);
+    const GLfloat *uv = _glKosVertexTexCoord();
+
+    if(v == NULL) {
+        _glKosThrowError(GL_OUT_OF_MEMORY, "glVertex3f");
+        _glKosPrintError();
+        return;
+    }
+
+    v += GL_KOS_LIST_VERTS;
+
+    v->x = x;
+    v->y = y;
+    v->z = z;
+    v->u = uv[0];
+    v->v = uv[1];
+    v->argb = _glKosVertexColor();
+    v->oargb = 0;
+
+    if(GL_KOS_LIST_LIT) {
+        GLfloat *n = _glKosListNormals();
+        const GLfloat *N = _glKosVertexNormal();
+
+        if(n == NULL) {
+            _glKosThrowError(GL_OUT_OF_MEMORY, "glVertex3f");
+            _glKosPrintError();
+            return;
+        }
+
+        n += GL_KOS_LIST_VERTS * 3;
+        n[0] = N[0];
+        n[1] = N[1];
+        n[2] = N[2];
+    }
+
+    ++GL_KOS_LIST_VERTS;
+}
+
+void _glKosListVertex3fv(const GLfloat *xyz) {
+    _glKosListVertex3f(xyz[0], xyz[1], xyz[2]);
+}
+
+/* Expand the fan or polygon being recorded in place into the triangles of the fan,
+   back to front, so every vertex is read before its slot is written */
+static void _glKosListFan() {
+    GL_KOS_PRIMITIVE prim;
+    pvr_vertex_t *v;
+    GLfloat *n = NULL;
+    GLuint i, k;
+
+    if(!_glKosPrimitiveBuild(GL_KOS_LIST_PRIM, GL_KOS_LIST_VERTS, 1, &prim)
+            || (v = _glKosListReserve(prim.index_count)) == NULL
+            || (GL_KOS_LIST_LIT && (n = _glKosListNormals()) == NULL)) {
+        _glKosThrowError(GL_OUT_OF_MEMORY, "glEnd");
+        _glKosPrintError();
+        return;
+    }
+
+    for(k = prim.index_count; k--;) {
+        i = prim.index[k];
+
+        v[k] = v[i];
+
+        if(n != NULL) {
+            n[k * 3 + 0] = n[i * 3 + 0];
+            n[k * 3 + 1] = n[i * 3 + 1];
+            n[k * 3 + 2] = n[i * 3 + 2];
+        }
+    }
+
+    _glKosListAddBlock(GL_TRIANGLES, prim.index_count, 1, GL_KOS_LIST_LIT);
+}
+
+void _glKosListEnd() {
+    switch(GL_KOS_LIST_PRIM) {
+        case GL_TRIANGLES:
+        case GL_TRIANGLE_STRIP:
+        case GL_QUADS:
+            _glKosListAddBlock(GL_KOS_LIST_PRIM, GL_KOS_LIST_VERTS, 1, GL_KOS_LIST_LIT);
+            break;
+
+        case GL_QUAD_STRIP: /* A triangle strip of whole quads */
+            _glKosListAddBlock(GL_TRIANGLE_STRIP, GL_KOS_LIST_VERTS & ~1, 1, GL_KOS_LIST_LIT);
+            break;
+
+        case GL_TRIANGLE_FAN:
+        case GL_POLYGON:
+            _glKosListFan();
+            break;
+
+        default: /* GL_POINTS and lines are not recorded */
+            _glKosThrowError(GL_INVALID_OPERATION, "glEnd");
+            _glKosPrintError();
+    }
+}
+
+GLuint _glKosListIndex() {
+    return GL_KOS_LIST_RECORD ? GL_KOS_LIST_RECORD->index : 0;
+}
+
+GLenum _glKosListMode() {
+    return GL_KOS_LIST_RECORD ? GL_KOS_LIST_RECORD->mode : 0;
+}
+
+GLuint _glKosListBase() {
+    return GL_KOS_LIST_BASE;
+}
+
+//========================================================================================//
+//== Display List Submission ==//
+
+/* Copy count vertices to dst with the Render Matrix applied. Quads swap
+   their last two vertices on the way, for the PVR strip order. */
+static void _glKosListTransform(const pvr_vertex_t *src, pvr_vertex_t *dst, GLuint count, GLubyte quads) {
+    register float __x  GL_KOS_FREG("fr12");
+    register float __y  GL_KOS_FREG("fr13");
+    register float __z  GL_KOS_FREG("fr14");
+    GLuint i, s;
+
+    for(i = 0; i < count; i++) {
+        s = quads ? i ^ ((i >> 1) & 1) : i;
+
+        __x = src[s].x;
+        __y = src[s].y;
+        __z = src[s].z;
+
+        mat_trans_fv12();
+
+        _glKosVertexCopyPVR(&src[s], dst);
+
+        dst->x = __x;
+        dst->y = __y;
+        dst->z = __z;
+        ++dst;
+    }
+}
+
+/* Light count vertices into the Clip Buffer */
+static pvr_vertex_t *_glKosListLight(GL_KOS_DISPLAY_LIST *list, GLuint first, GLuint count) {
+    pvr_vertex_t *src = list->verts + first;
+    pvr_vertex_t *dst = _glKosClipBufAddress();
+    GLfloat *N = list->norms + first * 3;
+    glVertex *P = _glKosArrayBufAddr();
+    GLuint i;
+
+    for(i = 0; i < count; i++) {
+        P[i].pos[0] = src[i].x;
+        P[i].pos[1] = src[i].y;
+        P[i].pos[2] = src[i].z;
+        P[i].norm[0] = N[0];
+        P[i].norm[1] = N[1];
+        P[i].norm[2] = N[2];
+        N += 3;
+    }
+
+    memcpy(dst, src, count * sizeof(pvr_vertex_t));
+
+    _glKosVertexComputeLighting(dst, count);
+
+    _glKosMatrixLoadRender();
+
+    return dst;
+}
+
+static GLubyte _glKosListDrawPiece(GL_KOS_DISPLAY_LIST *list, GLenum mode,
+                                   GLuint first, GLuint count, GLubyte lit) {
+    pvr_vertex_t *src = list->verts + first, *dst;
+    GLuint cverts = count;
+
+    /* Clipping emits at most 4 vertices per input triangle */
+    if(_glKosEnabledNearZClip())
+        cverts = mode == GL_TRIANGLES ? (count / 3) * 4 :
+                 mode == GL_QUADS ? count * 2 :
+                 count * 4;
+
+    if(!_glKosVertexBufReserve(cverts, "glCallList"))
+        return 0;
+
+    if(lit)
+        src = _glKosListLight(list, first, count);
+
+    dst = _glKosVertexBufPointer();
+
+    if(!_glKosEnabledNearZClip()) {
+        _glKosListTransform(src, dst, count, mode == GL_QUADS);
+
+        if(mode == GL_TRIANGLE_STRIP) /* The piece may end mid-strip */
+            dst[count - 1].flags = PVR_CMD_VERTEX_EOL;
+    }
+    else {
+        switch(mode) {
+            case GL_TRIANGLES:
+                cverts = _glKosClipTriangles(src, dst, count);
+                break;
+
+            case GL_TRIANGLE_STRIP:
+                cverts = _glKosClipTriangleStrip(src, dst, count);
+                break;
+
+            case GL_QUADS:
+                cverts = _glKosClipQuads(src, dst, count);
+                break;
+        }
+
+        GL_KOS_STAT_CLIP(mode, count, dst, cverts);
+
+        _glKosTransformClipBuf(dst, cverts);
+    }
+
+    _glKosVertexBufAdd(cverts);
+
+    _glKosVertexBufStream();
+
+    return 1;
+}
+
+/* Route the following geometry to a recorded block's list */
+static void _glKosListSelect(GLubyte list) {
+    switch(list) {
+        case GL_KOS_LIST_TR:
+            _glKosVertexBufSwitchTR();
+            break;
+
+        case GL_KOS_LIST_PT:
+            _glKosVertexBufSwitchPT();
+            break;
+
+        default:
+            _glKosVertexBufSwitchOP();
+    }
+}
+
+/* Submit a block in pieces of at most GL_KOS_MAX_DRAW_VERTS, like glDrawArrays() */
+static void _glKosListDrawBlock(GL_KOS_DISPLAY_LIST *list, GL_KOS_LIST_BLOCK *block) {
+    GLubyte lit = block->lit && _glKosEnabledLighting();
+    GLuint first = block->first, count = block->count, n;
+
+    GL_TEXTURE_OBJECT *tex = block->texture ? _glKosTextureObject(block->texture) : NULL;
+
+    /* The texture is looked up by name on every call: it may have been specified
+       again, or deleted, since the list was recorded */
+    if(tex != NULL && tex->data == NULL)
+        tex = NULL;
+
+    _glKosListSelect(block->list);
+
+    _glKosCompileHdrState(&block->state, tex);
+
+    while(count) {
+        n = count < GL_KOS_MAX_DRAW_VERTS ? count : GL_KOS_MAX_DRAW_VERTS;
+
+        if(!_glKosListDrawPiece(list, block->mode, first, n, lit) || n == count)
+            break;
+
+        if(block->mode == GL_TRIANGLE_STRIP)
+            n -= 2;
+
+        first += n;
+        count -= n;
+    }
+}
+
+//========================================================================================//
+//== Public KOS Open GL API Display List Functionality ==//
+
+GLuint APIENTRY glGenLists(GLsizei range) {
+    GLuint index = _glKosListLastIndex() + 1, i;
+
+    if(!range)
+        return 0;
+
+    for(i = 0; i < range; i++)
+        if(_glKosListCreate(index + i) == NULL) {
+            glDeleteLists(index, i);
+            _glKosThrowError(GL_OUT_OF_MEMORY, "glGenLists");
+            _glKosPrintError();
+            return 0;
+        }
+
+    return index;
+}
+
+void APIENTRY glNewList(GLuint list, GLenum mode) {
+    if(GL_KOS_LIST_RECORD != NULL)
+        _glKosThrowError(GL_INVALID_OPERATION, "glNewList");
+
+    if(list == 0)
+        _glKosThrowError(GL_INVALID_VALUE, "glNewList");
+
+    if(mode != GL_COMPILE && mode != GL_COMPILE_AND_EXECUTE)
+        _glKosThrowError(GL_INVALID_ENUM, "glNewList");
+
+    if(_glKosGetError()) {
+        _glKosPrintError();
+        return;
+    }
+
+    /* The old contents stay callable until glEndList() replaces them */
+    GL_KOS_LIST_RECORD = calloc(1, sizeof(GL_KOS_DISPLAY_LIST));
+
+    if(GL_KOS_LIST_RECORD == NULL) {
+        _glKosThrowError(GL_OUT_OF_MEMORY, "glNewList");
+        _glKosPrintError();
+        return;
+    }
+
+    GL_KOS_LIST_RECORD->index = list;
+    GL_KOS_LIST_RECORD->mode = mode;
+
+    _glKosStateSave(&GL_KOS_LIST_RECORD->state);
+
+    _glKosBoundsEnd(); /* Recorded draws are not tested */
+}
+
+void APIENTRY glEndList() {
+    GL_KOS_DISPLAY_LIST *src = GL_KOS_LIST_RECORD, *dst;
+
+    if(src == NULL) {
+        _glKosThrowError(GL_INVALID_OPERATION, "glEndList");
+        _glKosPrintError();
+        return;
+    }
+
+    GL_KOS_LIST_RECORD = NULL;
+
+    /* State calls made while compiling only shape the recorded blocks */
+    if(src->mode == GL_COMPILE)
+        _glKosStateRestore(&src->state);
+
+    _glKosListCompact(src);
+
+    dst = _glKosListFind(src->index);
+
+    if(dst == NULL)
+        dst = _glKosListCreate(src->index);
+
+    if(dst == NULL) {
+        _glKosListClear(src);
+        free(src);
+        _glKosThrowError(GL_OUT_OF_MEMORY, "glEndList");
+        _glKosPrintError();
+        return;
+    }
+
+    _glKosListClear(dst);
+
+    dst->mode = src->mode;
+    dst->blocks = src->blocks;
+    dst->block_count = src->block_count;
+    dst->block_size = src->block_size;
+    dst->verts = src->verts;
+    dst->norms = src->norms;
+    dst->vert_count = src->vert_count;
+    dst->vert_size = src->vert_size;
+
+    free(src);
+
+    if(dst->mode == GL_COMPILE_AND_EXECUTE)
+        glCallList(dst->index);
+}
+
+void APIENTRY glCallList(GLuint list) {
+    GL_KOS_DISPLAY_LIST *obj = _glKosListFind(list);
+    GLuint i;
+
+    if(obj == NULL || _glKosBoundsOutside()) {
+        _glKosBoundsEnd();
+        return;
+    }
+
+    if(GL_KOS_LIST_RECORD != NULL) {
+        _glKosListAppend(obj);
+        return;
+    }
+
+    GL_KOS_TRACE("glCallList");
+
+    _glKosMatrixApplyRender(); /* Apply the Render Matrix Stack */
+
+    for(i = 0; i < obj->block_count; i++)
+        _glKosListDrawBlock(obj, &obj->blocks[i]);
+
+    _glKosSelectList(); /* Back to the list of the current state */
+
+    _glKosBoundsEnd();
+}
+
+void APIENTRY glCallLists(GLsizei n, GLenum type, const GLvoid *lists) {
+    GLsizei i;
+
+    switch(type) {
+        case GL_BYTE:
+            for(i = 0; i < n; i++)
+                glCallList(GL_KOS_LIST_BASE + ((const signed char *)lists)[i]);
+
+            break;
+
+        case GL_UNSIGNED_BYTE:
+            for(i = 0; i < n; i++)
+                glCallList(GL_KOS_LIST_BASE + ((const GLubyte *)lists)[i]);
+
+            break;
+
+        case GL_SHORT:
+            for(i = 0; i < n; i++)
+                glCallList(GL_KOS_LIST_BASE + ((const GLshort *)lists)[i]);
+
+            break;
+
+        case GL_UNSIGNED_SHORT:
+            for(i = 0; i < n; i++)
+                glCallList(GL_KOS_LIST_BASE + ((const GLushort *)lists)[i]);
+
+            break;
+
+        case GL_INT:
+            for(i = 0; i < n; i++)
+                glCallList(GL_KOS_LIST_BASE + ((const GLint *)lists)[i]);
+
+            break;
+
+        case GL_UNSIGNED_INT:
+            for(i = 0; i < n; i++)
+                glCallList(GL_KOS_LIST_BASE + ((const GLuint *)lists)[i]);
+
+            break;
+
+        default:
+            _glKosThrowError(GL_INVALID_ENUM, "glCallLists");
+            _glKosPrintError();
+    }
+}
+
+void APIENTRY glListBase(GLuint base) {
+    GL_KOS_LIST_BASE = base;
+}
+
+void APIENTRY glDeleteLists(GLuint list, GLsizei range) {
+    GL_KOS_DISPLAY_LIST *ptr = &GL_KOS_LIST_OBJ, *obj;
+
+    while(ptr->link != NULL) {
+        obj = (GL_KOS_DISPLAY_LIST *)ptr->link;
+
+        if(obj->index >= list && obj->index - list < range) {
+            ptr->link = obj->link;
+            _glKosListClear(obj);
+            free(obj);
+        }
+        else
+            ptr = obj;
+    }
+}
+
+GLboolean APIENTRY glIsList(GLuint list) {
+    return list && _glKosListFind(list) ? GL_TRUE : GL_FALSE;
+}
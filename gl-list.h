@@ -0,0 +1,59 @@
+/* KallistiGL for KallistiOS ##version##
+
+   libgl/gl-list.h
+
+   Display Lists. glBegin()/glEnd() blocks and glDrawArrays()/glDrawElements()
+   draws made between glNewList() and glEndList() are recorded into blocks of
+   object space PVR vertices: packed color, texture coordinates and vertex
+   flags are done at compile time, so glCallList() only transforms, and lights
+   or clips when enabled.
+*/
+
+#ifndef GL_LIST_H
+#define GL_LIST_H
+
+#include "gl-api.h"
+
+typedef struct {
+    GLenum  mode;       /* GL_TRIANGLES, GL_TRIANGLE_STRIP or GL_QUADS */
+    GLuint  first,      /* First vertex of the block in the list */
+            count;
+    GLubyte textured,   /* Texture coordinates were recorded */
+            lit,        /* Normals were recorded */
+            list,       /* GL_KOS_LIST_* the recorded blend and alpha test state selected */
+            pad;
+    GLuint  texture;    /* Name of the texture bound when recorded, 0 for none */
+    GL_KOS_HDR_STATE state; /* Header state the block was recorded with */
+} GL_KOS_LIST_BLOCK;
+
+typedef struct {
+    GLuint  index;
+    GLenum  mode;               /* GL_COMPILE or GL_COMPILE_AND_EXECUTE */
+    GL_KOS_LIST_BLOCK *blocks;
+    GLuint  block_count, block_size;
+    pvr_vertex_t *verts;        /* Object space positions, quads in submission order */
+    GLfloat *norms;             /* Object space normal per vertex, NULL if no block is lit */
+    GLuint  vert_count, vert_size;
+    GL_KOS_STATE state;         /* Current state at glNewList(), put back after GL_COMPILE */
+    GLvoid *link;
+} GL_KOS_DISPLAY_LIST;
+
+extern GL_KOS_DISPLAY_LIST *GL_KOS_LIST_RECORD; /* List being compiled, or NULL */
+
+/* Immediate mode recording, from glBegin()/glVertex()/glEnd() */
+void _glKosListBegin(GLenum mode);
+void _glKosListEnd();
+void _glKosListVertex3f(GLfloat x, GLfloat y, GLfloat z);
+void _glKosListVertex3fv(const GLfloat *xyz);
+
+/* Room for count vertices after the last block, or NULL. The normals of the same
+   vertices are allocated by _glKosListNormals(), once the vertices are reserved. */
+pvr_vertex_t *_glKosListReserve(GLuint count);
+GLfloat      *_glKosListNormals();
+void _glKosListAddBlock(GLenum mode, GLuint count, GLubyte textured, GLubyte lit);
+
+GLuint _glKosListIndex();
+GLenum _glKosListMode();
+GLuint _glKosListBase();
+
+#endif
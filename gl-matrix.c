@@ -64,6 +64,9 @@ static matrix4f OrthoMatrix __attribute__((aligned(32))) = {
 /* Matrix for user to submit externally, ensure 32byte allignment */
 static matrix4f ml __attribute__((aligned(32)));
 
+/* Render and Model View Matrices of a draw with per sub-draw model matrices */
+static matrix4f MatrixModel[2] __attribute__((aligned(32)));
+
 /* Look-At Matrix */
 static matrix4f MatrixLookAt __attribute__((aligned(32))) = {
     { 1.0f, 0.0f, 0.0f, 0.0f },
@@ -365,6 +368,34 @@ void _glKosMatrixApplyRender() {
     mat_store(Matrix + GL_RENDER);
 }
 
+/* Keep the Render and Model View Matrices of a draw with a model matrix per sub-draw */
+void _glKosMatrixBeginModel() {
+    memcpy(MatrixModel, Matrix + GL_RENDER, sizeof(matrix4f));
+    memcpy(MatrixModel + 1, Matrix + GL_MODELVIEW, sizeof(matrix4f));
+}
+
+/* The kept Render Matrix times model, left loaded for the sub-draw. Lighting works in
+   eye space, so with modelview set, the Model View Matrix is multiplied by model too. */
+void _glKosMatrixApplyModel(const GLfloat *model, GLubyte modelview) {
+    memcpy(ml, model, sizeof(matrix4f));
+
+    if(modelview) {
+        mat_load(MatrixModel + 1);
+        mat_apply(&ml);
+        mat_store(Matrix + GL_MODELVIEW);
+    }
+
+    mat_load(MatrixModel);
+    mat_apply(&ml);
+    mat_store(Matrix + GL_RENDER);
+}
+
+/* Back to the Render and Model View Matrices kept by _glKosMatrixBeginModel() */
+void _glKosMatrixEndModel() {
+    memcpy(Matrix + GL_RENDER, MatrixModel, sizeof(matrix4f));
+    memcpy(Matrix + GL_MODELVIEW, MatrixModel + 1, sizeof(matrix4f));
+}
+
 void _glKosMatrixLoadRender() {
     mat_load(Matrix + GL_RENDER);
 }
@@ -381,6 +412,18 @@ void _glKosMatrixLoadModelRot() {
     mat_load(&MatrixMdlRot);
 }
 
+/* The screen offset of a unit step along the x (axes[0], axes[1]) and y (axes[2],
+   axes[3]) axes of eye space, before the divide by w. Projections are taken to have
+   no w term for x and y, as those of glFrustum() and glOrtho() do not. */
+void _glKosMatrixEyeAxes(GLfloat *axes) {
+    GLuint c, r;
+
+    for(c = 0; c < 2; c++)
+        for(r = 0; r < 2; r++)
+            axes[c * 2 + r] = Matrix[GL_SCREENVIEW][0][r] * Matrix[GL_PROJECTION][c][0]
+                              + Matrix[GL_SCREENVIEW][1][r] * Matrix[GL_PROJECTION][c][1];
+}
+
 void _glKosMatrixApplyScreenSpace() {
     mat_load(Matrix + GL_SCREENVIEW);
     mat_apply(Matrix + GL_PROJECTION);
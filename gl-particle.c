@@ -0,0 +1,149 @@
+/* KallistiGL for KallistiOS ##version##
+
+   libgl/gl-particle.c
+
+   Particles. Each particle is a quad facing the camera: its center is
+   transformed once, and the quad is built around it in screen space from the
+   size and rotation of the particle in eye space. Particles behind the eye,
+   nearer than the near plane with near-Z clipping enabled, or off the screen
+   are dropped before anything is written for them.
+
+   The quads are triangle strips, not PVR sprites: a sprite takes its color
+   from the polygon header, where each particle has a color of its own.
+*/
+
+#include <dc/fmath.h>
+
+#include <GL/gl.h>
+#include "gl-api.h"
+#include "gl-clip.h"
+#include "gl-list.h"
+#include "gl-pvr.h"
+#include "gl-sh4.h"
+
+void APIENTRY glKosDrawParticles(GLsizei count, const GLfloat *position, const GLfloat *size,
+                                 const GLfloat *rotation, const GLuint *color) {
+    register float __x  GL_KOS_FREG("fr12");
+    register float __y  GL_KOS_FREG("fr13");
+    register float __z  GL_KOS_FREG("fr14");
+    register float __w  GL_KOS_FREG("fr15");
+
+    const GLfloat width = vid_mode->width, height = vid_mode->height;
+    GLfloat axes[4], facing, top, x, y, c, s, ux, uy, vx, vy, ex, ey;
+    GLuint argb = _glKosVertexColor(), i, j, n, verts;
+    GLubyte clip = _glKosEnabledNearZClip();
+    pvr_vertex_t *dst;
+
+    if(count < 0 || position == NULL) {
+        _glKosThrowError(GL_INVALID_VALUE, "glKosDrawParticles");
+        _glKosPrintError();
+        _glKosBoundsEnd();
+        return;
+    }
+
+    if(GL_KOS_LIST_RECORD) { /* The particles are not recorded */
+        _glKosThrowError(GL_INVALID_OPERATION, "glKosDrawParticles");
+        _glKosPrintError();
+        _glKosBoundsEnd();
+        return;
+    }
+
+    if(!count || _glKosBoundsOutside()) {
+        _glKosBoundsEnd();
+        return;
+    }
+
+    if(_glKosEnabledTexture2D() && _glKosBoundTexID() > 0)
+        _glKosCompileHdrTx();
+    else
+        _glKosCompileHdr();
+
+    _glKosMatrixApplyRender();
+
+    _glKosMatrixEyeAxes(axes);
+
+    /* The quads wind clockwise on screen unless culling needs them the other way.
+       The texture is flipped with them, so it stays upright. */
+    facing = _glKosFacing();
+    top = facing > 0.0f ? 0.0f : 1.0f;
+
+    for(i = 0; i < (GLuint)count; i += n) {
+        n = count - i < GL_KOS_MAX_DRAW_VERTS / 4 ? count - i : GL_KOS_MAX_DRAW_VERTS / 4;
+
+        if(!_glKosVertexBufReserve(n * 4, "glKosDrawParticles"))
+            break;
+
+        dst = _glKosVertexBufPointer();
+        verts = 0;
+
+        for(j = i; j < i + n; j++) {
+            __x = position[j * 3 + 0];
+            __y = position[j * 3 + 1];
+            __z = position[j * 3 + 2];
+
+            mat_trans_fv12_nodivw()
+
+            if(__w <= 0.0f || (clip && __z >= CLIP_NEARZ))
+                continue;
+
+            __w = 1.0f / __w;
+            x = __x * __w;
+            y = __y * __w;
+
+            /* Half the quad along its own x axis, turned in eye space */
+            c = (size ? size[j] : 1.0f) * 0.5f * __w;
+
+            if(rotation) {
+                s = fsin(rotation[j]) * c;
+                c = fcos(rotation[j]) * c;
+            }
+            else
+                s = 0.0f;
+
+            /* Half axes of the quad on screen: eye (c, s) and (-s, c) */
+            ux = axes[0] * c + axes[2] * s;
+            uy = axes[1] * c + axes[3] * s;
+            vx = (axes[2] * c - axes[0] * s) * facing;
+            vy = (axes[3] * c - axes[1] * s) * facing;
+
+            ex = (ux < 0.0f ? -ux : ux) + (vx < 0.0f ? -vx : vx);
+            ey = (uy < 0.0f ? -uy : uy) + (vy < 0.0f ? -vy : vy);
+
+            if(x + ex < 0.0f || x - ex > width || y + ey < 0.0f || y - ey > height)
+                continue;
+
+            if(color)
+                argb = color[j];
+
+            dst[0].x = x - ux - vx;
+            dst[0].y = y - uy - vy;
+            dst[1].x = x - ux + vx;
+            dst[1].y = y - uy + vy;
+            dst[2].x = x + ux - vx;
+            dst[2].y = y + uy - vy;
+            dst[3].x = x + ux + vx;
+            dst[3].y = y + uy + vy;
+
+            dst[0].z = dst[1].z = dst[2].z = dst[3].z = __w;
+            dst[0].argb = dst[1].argb = dst[2].argb = dst[3].argb = argb;
+            dst[0].oargb = dst[1].oargb = dst[2].oargb = dst[3].oargb = 0;
+
+            dst[0].u = dst[1].u = 0.0f;
+            dst[2].u = dst[3].u = 1.0f;
+            dst[0].v = dst[2].v = 1.0f - top;
+            dst[1].v = dst[3].v = top;
+
+            dst[0].flags = dst[1].flags = dst[2].flags = PVR_CMD_VERTEX;
+            dst[3].flags = PVR_CMD_VERTEX_EOL;
+
+            dst += 4;
+            verts += 4;
+        }
+
+        _glKosVertexBufAdd(verts);
+
+        _glKosVertexBufStream();
+    }
+
+    _glKosBoundsEnd();
+}
@@ -0,0 +1,443 @@
+/* KallistiGL for KallistiOS ##version##
+
+   libgl/gl-primitive.c
+
+   Primitive Conversion. A fan is drawn as strips of 5 vertices, each covering
+   3 triangles of the fan, as "i, i + 1, 0, i + 2, i + 3": the odd triangle of
+   the strip winds back, so all 3 keep the winding of the fan. A polygon is
+   convex, so it is drawn as one strip zigzagging across it, 0, 1, n - 1, 2,
+   n - 2, ..., one vertex per triangle. Near-Z clipping and display lists take
+   triangle lists, so there both are drawn as the triangles of the fan.
+
+   The PVR has no lines. Each segment becomes a quad in screen space, the
+   segment moved half the line width to either side, so the width is in
+   pixels at any depth, as in GL. Each point becomes a square in screen space
+   around its vertex, transformed once, and is dropped if it is off screen.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>
+
+#include <dc/fmath.h>
+
+#include <GL/gl.h>
+#include "gl-api.h"
+#include "gl-clip.h"
+#include "gl-primitive.h"
+#include "gl-pvr.h"
+#include "gl-sh4.h"
+#include "gl-stats.h"
+
+//========================================================================================//
+//== Local Variables ==//
+
+static GLuint   *GL_KOS_PRIMITIVE_INDEX = NULL;  /* 3 indices per vertex of the largest draw */
+static GLushort *GL_KOS_PRIMITIVE_STRIPS = NULL; /* 1 strip length per vertex */
+static GLuint    GL_KOS_PRIMITIVE_SIZE = 0;      /* In vertices */
+
+static pvr_vertex_t *GL_KOS_PRIMITIVE_VERTS = NULL; /* Scratch vertices, and their w */
+static GLfloat      *GL_KOS_PRIMITIVE_W = NULL;
+static GLuint        GL_KOS_PRIMITIVE_VERTS_SIZE = 0;
+
+//========================================================================================//
+//== Vertex Order ==//
+
+static GLubyte _glKosPrimitiveReserve(GLuint count) {
+    if(count <= GL_KOS_PRIMITIVE_SIZE)
+        return 1;
+
+    free(GL_KOS_PRIMITIVE_INDEX);
+    free(GL_KOS_PRIMITIVE_STRIPS);
+
+    GL_KOS_PRIMITIVE_SIZE = (count + 1023) & ~1023;
+    GL_KOS_PRIMITIVE_INDEX = malloc(GL_KOS_PRIMITIVE_SIZE * 3 * sizeof(GLuint));
+    GL_KOS_PRIMITIVE_STRIPS = malloc(GL_KOS_PRIMITIVE_SIZE * sizeof(GLushort));
+
+    if(GL_KOS_PRIMITIVE_INDEX == NULL || GL_KOS_PRIMITIVE_STRIPS == NULL) {
+        free(GL_KOS_PRIMITIVE_INDEX);
+        free(GL_KOS_PRIMITIVE_STRIPS);
+
+        GL_KOS_PRIMITIVE_INDEX = NULL;
+        GL_KOS_PRIMITIVE_STRIPS = NULL;
+        GL_KOS_PRIMITIVE_SIZE = 0;
+
+        return 0;
+    }
+
+    return 1;
+}
+
+/* The triangles (0, i, i + 1) of a fan, three at a time */
+static GLuint *_glKosPrimitiveFan(GLuint *dst, GLuint count, GL_KOS_PRIMITIVE *prim) {
+    GLuint i, n;
+
+    for(i = 1; i + 1 < count; i += 3) {
+        n = count - i < 4 ? count - i : 4; /* Vertices from i, one more than triangles */
+
+        dst[0] = i;
+        dst[1] = i + 1;
+        dst[2] = 0;
+
+        if(n > 2)
+            dst[3] = i + 2;
+
+        if(n > 3)
+            dst[4] = i + 3;
+
+        prim->strips[prim->strip_count++] = n + 1;
+
+        dst += n + 1;
+    }
+
+    return dst;
+}
+
+/* The zigzag of a polygon, in strips of at most GL_KOS_MAX_DRAW_VERTS. A strip
+   goes on from the last 2 vertices of the one before, which start on an even
+   vertex, so the winding order is kept. */
+static GLuint *_glKosPrimitivePolygon(GLuint *dst, GLuint count, GL_KOS_PRIMITIVE *prim) {
+    GLuint p, start = 0, n;
+
+    do {
+        n = count - start < GL_KOS_MAX_DRAW_VERTS ? count - start : GL_KOS_MAX_DRAW_VERTS;
+
+        for(p = start; p < start + n; p++)
+            *dst++ = p < 2 ? p : (p & 1) ? (p + 1) / 2 : count - p / 2;
+
+        prim->strips[prim->strip_count++] = n;
+
+        start += n - 2;
+    }
+    while(start + 2 < count);
+
+    return dst;
+}
+
+GLubyte _glKosPrimitiveBuild(GLenum mode, GLuint count, GLubyte triangles, GL_KOS_PRIMITIVE *prim) {
+    GLuint *dst, i;
+
+    prim->strips = NULL;
+    prim->index_count = prim->strip_count = 0;
+
+    if(!_glKosPrimitiveReserve(count))
+        return 0;
+
+    dst = prim->index = GL_KOS_PRIMITIVE_INDEX;
+
+    switch(mode) {
+        case GL_POINTS:
+            for(i = 0; i < count; i++)
+                *dst++ = i;
+
+            break;
+
+        case GL_LINES:
+            for(i = 0; i < (count & ~1); i++)
+                *dst++ = i;
+
+            break;
+
+        case GL_LINE_STRIP:
+        case GL_LINE_LOOP:
+            for(i = 1; i < count; i++) {
+                *dst++ = i - 1;
+                *dst++ = i;
+            }
+
+            if(mode == GL_LINE_LOOP && count > 1) {
+                *dst++ = count - 1;
+                *dst++ = 0;
+            }
+
+            break;
+
+        case GL_TRIANGLE_FAN:
+        case GL_POLYGON:
+            if(count < 3)
+                break;
+
+            if(triangles) {
+                for(i = 1; i + 1 < count; i++) {
+                    *dst++ = 0;
+                    *dst++ = i;
+                    *dst++ = i + 1;
+                }
+
+                break;
+            }
+
+            prim->strips = GL_KOS_PRIMITIVE_STRIPS;
+
+            dst = mode == GL_TRIANGLE_FAN ? _glKosPrimitiveFan(dst, count, prim) :
+                  _glKosPrimitivePolygon(dst, count, prim);
+
+            break;
+    }
+
+    prim->index_count = dst - prim->index;
+
+    return 1;
+}
+
+//========================================================================================//
+//== Points and Lines ==//
+
+static GLuint _glKosPrimitiveLineQuads(const pvr_vertex_t *src, const GLfloat *w, const GLuint *index,
+                                GLuint base, GLuint segments, GLfloat half, pvr_vertex_t *dst) {
+    pvr_vertex_t v[2];
+    GLfloat W[2], dx, dy, d;
+    GLuint i, n = 0;
+
+    for(i = 0; i < segments; i++, index += 2) {
+        _glKosVertexCopyPVR(&src[index[0] - base], &v[0]);
+        _glKosVertexCopyPVR(&src[index[1] - base], &v[1]);
+
+        if(w != NULL) {
+            W[0] = w[index[0] - base];
+            W[1] = w[index[1] - base];
+
+            if(!_glKosClipLineTransformed(v, W))
+                continue;
+        }
+
+        dx = v[1].x - v[0].x;
+        dy = v[1].y - v[0].y;
+        d = dx * dx + dy * dy;
+
+        if(d == 0.0f) /* No direction to be wide across */
+            continue;
+
+        /* Half the width along the segment, the quad spans (-dy, dx) either side */
+        d = half * frsqrt(d);
+        dx *= d;
+        dy *= d;
+
+        _glKosVertexCopyPVR(&v[0], &dst[0]);
+        _glKosVertexCopyPVR(&v[0], &dst[1]);
+        _glKosVertexCopyPVR(&v[1], &dst[2]);
+        _glKosVertexCopyPVR(&v[1], &dst[3]);
+
+        dst[0].x -= dy;
+        dst[0].y += dx;
+        dst[1].x += dy;
+        dst[1].y -= dx;
+        dst[2].x -= dy;
+        dst[2].y += dx;
+        dst[3].x += dy;
+        dst[3].y -= dx;
+
+        dst[0].flags = dst[1].flags = dst[2].flags = PVR_CMD_VERTEX;
+        dst[3].flags = PVR_CMD_VERTEX_EOL;
+
+        dst += 4;
+        n += 4;
+    }
+
+    return n;
+}
+
+static GLuint _glKosPrimitivePointQuads(const pvr_vertex_t *src, const GLfloat *w, const GLuint *index,
+                                        GLuint base, GLuint points, GLfloat half, pvr_vertex_t *dst) {
+    const GLfloat width = vid_mode->width, height = vid_mode->height;
+    GLfloat extent = half < 0.0f ? -half : half;
+    GLuint i, n = 0;
+
+    for(i = 0; i < points; i++) {
+        _glKosVertexCopyPVR(&src[index[i] - base], &dst[0]);
+
+        if(w != NULL) {
+            if(dst[0].z >= CLIP_NEARZ)
+                continue;
+
+            dst[0].z = 1.0f / w[index[i] - base];
+            dst[0].x *= dst[0].z;
+            dst[0].y *= dst[0].z;
+        }
+        else if(dst[0].z <= 0.0f) /* Behind the eye */
+            continue;
+
+        if(dst[0].x + extent < 0.0f || dst[0].x - extent > width
+           || dst[0].y + extent < 0.0f || dst[0].y - extent > height)
+            continue;
+
+        _glKosVertexCopyPVR(&dst[0], &dst[1]);
+        _glKosVertexCopyPVR(&dst[0], &dst[2]);
+        _glKosVertexCopyPVR(&dst[0], &dst[3]);
+
+        dst[0].x -= half;
+        dst[0].y += half;
+        dst[1].x -= half;
+        dst[1].y -= half;
+        dst[2].x += half;
+        dst[2].y += half;
+        dst[3].x += half;
+        dst[3].y -= half;
+
+        dst[0].flags = dst[1].flags = dst[2].flags = PVR_CMD_VERTEX;
+        dst[3].flags = PVR_CMD_VERTEX_EOL;
+
+        dst += 4;
+        n += 4;
+    }
+
+    return n;
+}
+
+GLuint _glKosPrimitiveExpand(GLenum mode, const pvr_vertex_t *src, const GLfloat *w,
+                             const GLuint *index, GLuint base, GLuint quads, pvr_vertex_t *dst) {
+    if(mode == GL_POINTS)
+        return _glKosPrimitivePointQuads(src, w, index, base, quads, _glKosPointHalfSize(), dst);
+
+    return _glKosPrimitiveLineQuads(src, w, index, base, quads, _glKosLineHalfWidth(), dst);
+}
+
+//========================================================================================//
+//== Immediate Mode ==//
+
+pvr_vertex_t *_glKosPrimitiveScratch(GLuint count) {
+    if(count <= GL_KOS_PRIMITIVE_VERTS_SIZE)
+        return GL_KOS_PRIMITIVE_VERTS;
+
+    free(GL_KOS_PRIMITIVE_VERTS);
+    free(GL_KOS_PRIMITIVE_W);
+
+    GL_KOS_PRIMITIVE_VERTS_SIZE = (count + 1023) & ~1023;
+    GL_KOS_PRIMITIVE_VERTS = memalign(32, GL_KOS_PRIMITIVE_VERTS_SIZE * sizeof(pvr_vertex_t));
+    GL_KOS_PRIMITIVE_W = malloc(GL_KOS_PRIMITIVE_VERTS_SIZE * sizeof(GLfloat));
+
+    if(GL_KOS_PRIMITIVE_VERTS == NULL || GL_KOS_PRIMITIVE_W == NULL) {
+        free(GL_KOS_PRIMITIVE_VERTS);
+        free(GL_KOS_PRIMITIVE_W);
+
+        GL_KOS_PRIMITIVE_VERTS = NULL;
+        GL_KOS_PRIMITIVE_W = NULL;
+        GL_KOS_PRIMITIVE_VERTS_SIZE = 0;
+    }
+
+    return GL_KOS_PRIMITIVE_VERTS;
+}
+
+/* Transform count object space vertices with no perspective divide, w to W */
+static void _glKosPrimitiveTransformClip(const pvr_vertex_t *src, pvr_vertex_t *dst,
+        GLfloat *W, GLuint count) {
+    register float __x  GL_KOS_FREG("fr12");
+    register float __y  GL_KOS_FREG("fr13");
+    register float __z  GL_KOS_FREG("fr14");
+    register float __w  GL_KOS_FREG("fr15");
+
+    while(count--) {
+        __x = src->x;
+        __y = src->y;
+        __z = src->z;
+
+        mat_trans_fv12_nodivw()
+
+        _glKosVertexCopyPVR(src, dst);
+
+        dst->x = __x;
+        dst->y = __y;
+        dst->z = __z;
+        *W++ = __w;
+
+        ++src;
+        ++dst;
+    }
+}
+
+void _glKosPrimitiveImmediate(GLenum mode, pvr_vertex_t *src, GLuint count, GLubyte clip) {
+    GL_KOS_PRIMITIVE prim;
+    pvr_vertex_t *v, *dst;
+    GLuint i, j, k, m, n, per, quads;
+
+    if(!_glKosPrimitiveBuild(mode, count, clip, &prim)) {
+        _glKosThrowError(GL_OUT_OF_MEMORY, "glEnd");
+        _glKosPrintError();
+        return;
+    }
+
+    if(!prim.index_count)
+        return;
+
+    if(_glKosPrimitiveExpanded(mode)) {
+        per = _glKosPrimitiveQuadElements(mode);
+        quads = prim.index_count / per;
+        v = src;
+
+        if(clip) {
+            if((v = _glKosPrimitiveScratch(count)) == NULL) {
+                _glKosThrowError(GL_OUT_OF_MEMORY, "glEnd");
+                _glKosPrintError();
+                return;
+            }
+
+            _glKosPrimitiveTransformClip(src, v, GL_KOS_PRIMITIVE_W, count);
+        }
+
+        for(i = 0; i < quads; i += n) {
+            n = quads - i < GL_KOS_MAX_DRAW_VERTS / 4 ? quads - i : GL_KOS_MAX_DRAW_VERTS / 4;
+
+            if(!_glKosVertexBufReserve(n * 4, "glEnd"))
+                return;
+
+            _glKosVertexBufAdd(_glKosPrimitiveExpand(mode, v, clip ? GL_KOS_PRIMITIVE_W : NULL,
+                               prim.index + i * per, 0, n, _glKosVertexBufPointer()));
+        }
+
+        return;
+    }
+
+    if(!clip) { /* Gather as many whole strips as fit a piece, each ending with an EOL vertex */
+        for(i = 0, k = 0; i < prim.strip_count; i += j) {
+            for(j = 0, n = 0; i + j < prim.strip_count
+                && n + prim.strips[i + j] <= GL_KOS_MAX_DRAW_VERTS; j++)
+                n += prim.strips[i + j];
+
+            if(!_glKosVertexBufReserve(n, "glEnd"))
+                return;
+
+            dst = _glKosVertexBufPointer();
+
+            for(n = 0; n < j; n++) {
+                for(m = 0; m < prim.strips[i + n]; m++, k++, dst++) {
+                    _glKosVertexCopyPVR(&src[prim.index[k]], dst);
+                    dst->flags = PVR_CMD_VERTEX;
+                }
+
+                dst[-1].flags = PVR_CMD_VERTEX_EOL;
+            }
+
+            _glKosVertexBufAdd(dst - (pvr_vertex_t *)_glKosVertexBufPointer());
+        }
+
+        return;
+    }
+
+    /* Gather the triangles of the fan, then clip them as GL_TRIANGLES */
+    if((v = _glKosPrimitiveScratch(GL_KOS_MAX_DRAW_VERTS)) == NULL) {
+        _glKosThrowError(GL_OUT_OF_MEMORY, "glEnd");
+        _glKosPrintError();
+        return;
+    }
+
+    for(i = 0; i < prim.index_count; i += n) {
+        n = prim.index_count - i < GL_KOS_MAX_DRAW_VERTS ? prim.index_count - i : GL_KOS_MAX_DRAW_VERTS;
+
+        /* Clipping emits at most 4 vertices per input triangle */
+        if(!_glKosVertexBufReserve((n / 3) * 4, "glEnd"))
+            return;
+
+        for(j = 0; j < n; j++)
+            _glKosVertexCopyPVR(&src[prim.index[i + j]], &v[j]);
+
+        dst = _glKosVertexBufPointer();
+
+        k = _glKosClipTriangles(v, dst, n);
+
+        GL_KOS_STAT_CLIP(GL_TRIANGLES, n, dst, k);
+
+        _glKosTransformClipBuf(dst, k);
+
+        _glKosVertexBufAdd(k);
+    }
+}
@@ -0,0 +1,72 @@
+/* KallistiGL for KallistiOS ##version##
+
+   libgl/gl-primitive.h
+
+   Primitive Conversion. The PVR draws triangle strips only, so the primitive
+   types it has no strip order for are converted into strips here:
+   GL_TRIANGLE_FAN and GL_POLYGON into short strips, lines into a screen
+   space quad per segment, glLineWidth() pixels wide, and points into a
+   screen space square each, glPointSize() pixels across. GL_QUAD_STRIP is
+   a triangle strip as it is, and is drawn as one.
+*/
+
+#ifndef GL_PRIMITIVE_H
+#define GL_PRIMITIVE_H
+
+#include "gl-api.h"
+
+typedef struct {
+    GLuint   *index;            /* Vertex order, from 0 */
+    GLushort *strips;           /* Length of each strip, NULL for a triangle list or lines */
+    GLuint    index_count, strip_count;
+} GL_KOS_PRIMITIVE;
+
+/* GL_TRIANGLE_FAN, GL_POLYGON, GL_POINTS or a line type, the types converted here */
+static inline GLubyte _glKosPrimitiveConverted(GLenum mode) {
+    switch(mode) {
+        case GL_POINTS:
+        case GL_TRIANGLE_FAN:
+        case GL_POLYGON:
+        case GL_LINES:
+        case GL_LINE_STRIP:
+        case GL_LINE_LOOP:
+            return 1;
+    }
+
+    return 0;
+}
+
+/* GL_POINTS or a line type, expanded to a screen space quad per point or segment */
+static inline GLubyte _glKosPrimitiveExpanded(GLenum mode) {
+    return mode == GL_POINTS || mode == GL_LINES || mode == GL_LINE_STRIP || mode == GL_LINE_LOOP;
+}
+
+/* Elements per quad of an expanded type: 1 per point, 2 per segment */
+static inline GLuint _glKosPrimitiveQuadElements(GLenum mode) {
+    return mode == GL_POINTS ? 1 : 2;
+}
+
+/* The vertex order of count vertices of mode, in a buffer kept for the next call:
+   strips for a fan or polygon, or a triangle list if triangles is set, as near-Z
+   clipping and display lists take; two vertices per segment for lines, one per point.
+   Returns 0 if the buffer could not grow. */
+GLubyte _glKosPrimitiveBuild(GLenum mode, GLuint count, GLubyte triangles, GL_KOS_PRIMITIVE *prim);
+
+/* Expand quads points or segments of mode, of vertices src[index[i] - base], into 4
+   vertices each to dst. src is in screen space, or in clip space with the w of each
+   vertex in w, and then clipped to the near plane. Points off the screen are dropped.
+   Returns the vertices written. */
+GLuint _glKosPrimitiveExpand(GLenum mode, const pvr_vertex_t *src, const GLfloat *w,
+                             const GLuint *index, GLuint base, GLuint quads, pvr_vertex_t *dst);
+
+/* Room for count vertices the caller can keep a glBegin()/glEnd() block in, while
+   what it converts to is written where it was. NULL if it could not grow. */
+pvr_vertex_t *_glKosPrimitiveScratch(GLuint count);
+
+/* Convert a glBegin()/glEnd() block of count vertices of mode at src into the Vertex
+   Buffer, in pieces of at most GL_KOS_MAX_DRAW_VERTS: src is in screen space, or with
+   clip set, in object space, and is then near-Z clipped and transformed with the
+   Render Matrix, which must be loaded. */
+void _glKosPrimitiveImmediate(GLenum mode, pvr_vertex_t *src, GLuint count, GLubyte clip);
+
+#endif
@@ -16,7 +16,30 @@
 
    The size of the Vertex Buffer can be controlled by setting some params on gl-pvr.h:
    GL_PVR_VERTEX_BUF_SIZE controls size of Vertex Buffer in the PVR VRAM
-   GL_KOS_MAX_VERTS conrols the number of vertices per list in the Vertex Buffer in SH4 RAM
+   GL_PVR_BIN_SIZE controls the object pointer block of each list per tile in the PVR VRAM
+   GL_KOS_VERTEX_CHUNK_SIZE controls the number of commands per chunk of the Vertex Buffer in SH4 RAM
+   GL_KOS_VERTEX_BUF_BUDGET controls the total SH4 RAM the chunks may grow to
+
+   Each list of each frame is a chain of chunks. A list starts with one chunk and grows
+   by taking chunks from a shared pool, so a scene is only limited by the budget. Chunks
+   are recycled to the pool when their frame context is reused.
+
+   The buffers are grouped into GL_KOS_FRAME_CONTEXTS Frame Contexts. The client
+   always fills the "record" context; glutSwapBuffers() closes it and hands it to the
+   PVR as soon as the PVR is ready for a new scene. If the PVR is still busy, the
+   closed frame is queued and the client moves on to the next free context, so the
+   CPU only blocks in pvr_wait_ready() once every context is waiting on the PVR.
+   glKosFrameContexts() lowers the number of contexts in use, down to 1: every
+   closed frame then goes to the PVR before the client records the next one.
+
+   With glHint(GL_KOS_DIRECT_RENDER_HINT, GL_FASTEST) the opaque list is streamed to
+   the TA as each draw completes, instead of being kept for glutSwapBuffers(). The
+   first opaque draw of a frame begins the scene, so it waits for the PVR and the
+   frame is not pipelined. The opaque chunks are rewound after every draw and stay
+   in cache; only the translucent list and multi-texture sources are buffered.
+
+   The two PVR VRAM sizes are only defaults for glKosInit(); glKosInitEx() takes
+   them at startup, as measured by bench/binsim.
 */
 
 #include <malloc.h>
@@ -30,28 +53,72 @@
 #include "gl-api.h"
 #include "gl-sh4.h"
 #include "gl-pvr.h"
+#include "gl-capture.h"
+#include "gl-stats.h"
+#include "gl-trace.h"
 
 /* Vertex Buffer Functions *************************************************************************/
 
+#define GL_KOS_MAX_MULTITEXTURE_OBJECTS 512
+
+typedef struct {
+    pvr_cmd_t          *data;                                       /* Commands, follow this header */
+    GLuint              size,                                       /* Capacity in commands */
+                        count;                                      /* Commands written, set on close */
+    GLvoid             *link;                                       /* Next chunk of the list or pool */
+} GL_VERTEX_CHUNK; /* 32 byte header of a Vertex Buffer chunk */
+
+typedef struct {
+    GL_VERTEX_CHUNK    *chunks[GL_KOS_LISTS],                       /* First chunk per list */
+                       *tail[GL_KOS_LISTS];                         /* Chunk being filled per list */
+    pvr_cmd_t          *vbuf[GL_KOS_LISTS];                         /* Commands of the tail chunk */
+    glTexCoord         *uvbuf;                                      /* Multi-Texture UV Buffer */
+    GL_MULTITEX_OBJECT  mtobjs[GL_KOS_MAX_MULTITEXTURE_OBJECTS];
+    GLuint              verts[GL_KOS_LISTS],                        /* Commands in the tail chunk */
+                        vsize[GL_KOS_LISTS],                        /* Capacity of the tail chunk */
+                        vmark[GL_KOS_LISTS],                        /* Start of the open primitive block */
+                        uvverts,
+                        mtobjects;
+    GLfloat             bg_color[3];                                /* Clear color of the frame */
+    GLubyte             pt_alpha_ref;                               /* Punch-Through alpha reference */
+    GLvoid             *fbo_data;                                   /* Render-To-Texture target, or NULL */
+    GLsizei             fbo_width,
+                        fbo_height;
+} GL_FRAME_CONTEXT; /* Everything recorded by the client for one frame */
+
 #ifdef GL_KOS_USE_MALLOC
-static pvr_cmd_t   *GL_VBUF[2] __attribute__((aligned(32)));  /* Dynamic Vertex Buffer */
 static pvr_cmd_t   *GL_CBUF;                                  /* Dynamic Clip Buffer */
-static glTexCoord  *GL_UVBUF;                                 /* Dynamic Multi-Texture UV Buffer */
 #else
-static pvr_cmd_t    GL_VBUF[2][GL_KOS_MAX_VERTS] __attribute__((aligned(32))); /* Static Vertex Buffer */
-static pvr_cmd_t    GL_CBUF[GL_KOS_MAX_VERTS / 2];                             /* Static Clip Buffer */
-static glTexCoord   GL_UVBUF[GL_KOS_MAX_VERTS / 2];                    /* Static Multi-Texture UV Buffer */
+static pvr_cmd_t    GL_VBUF[GL_KOS_VERTEX_BUF_BUDGET / sizeof(pvr_cmd_t)] __attribute__((aligned(32))); /* Static Vertex Buffer chunks */
+static pvr_cmd_t    GL_CBUF[GL_KOS_MAX_VERTS / 2];                                                 /* Static Clip Buffer */
+static glTexCoord   GL_UVBUF[GL_KOS_FRAME_CONTEXTS][GL_KOS_MAX_VERTS / 2];                         /* Static Multi-Texture UV Buffer */
 #endif
 
-static GLuint GL_VERTS[2] = {0, 0},
-                            GL_CVERTS = 0,
-                            GL_UVVERTS = 0,
-                            GL_LIST = GL_KOS_LIST_OP;
+static GL_FRAME_CONTEXT  GL_FRAMES[GL_KOS_FRAME_CONTEXTS];
+static GL_FRAME_CONTEXT *GL_FRAME = &GL_FRAMES[0]; /* Context being filled by the client */
 
-#define GL_KOS_MAX_MULTITEXTURE_OBJECTS 512
+static GLuint GL_FRAME_RECORD = 0, /* Index of the record context */
+              GL_FRAME_SUBMIT = 0, /* Index of the oldest closed frame */
+              GL_FRAME_QUEUED = 0, /* Closed frames still waiting for the PVR */
+              GL_FRAME_LIMIT = GL_KOS_FRAME_CONTEXTS; /* Contexts in use */
+
+static GL_VERTEX_CHUNK *GL_VBUF_POOL = NULL; /* Free standard size chunks */
+static GLuint GL_VBUF_BYTES = 0;              /* SH4 RAM taken by chunks */
+
+static GLuint GL_CVERTS = 0,
+              GL_LIST = GL_KOS_LIST_OP;
+
+static GLubyte GL_DIRECT = 0,              /* Stream the OP list at draw time */
+               GL_DIRECT_SCENE = 0,        /* Record frame's scene is open on the PVR */
+               GL_DIRECT_PINNED = 0;       /* Multi-Texture sources live in the OP list */
+static GL_VERTEX_CHUNK *GL_DIRECT_CHUNK;   /* First OP chunk not yet streamed */
+static GLuint GL_DIRECT_SENT = 0,          /* Commands of GL_DIRECT_CHUNK already streamed */
+              GL_DIRECT_BYTES = 0,         /* Bytes streamed in the record frame */
+              GL_DIRECT_BYTES_LAST = 0;    /* Bytes streamed in the last frame */
+
+static void _glKosFrameSubmit();
 
-static GL_MULTITEX_OBJECT GL_MTOBJS[GL_KOS_MAX_MULTITEXTURE_OBJECTS];
-static GLuint             GL_MTOBJECTS = 0;
+#ifdef __sh__
 
 /* Custom version of sq_cpy from KOS for copying vertex data to the PVR */
 static inline void pvr_list_submit(void *src, int n) {
@@ -94,37 +161,56 @@ static inline void pvr_hdr_submit(const GLuint *src) {
     __asm__("pref @%0" : : "r"(d));
 }
 
+#else
+
+/* Host build - the stand-in records each store queue burst in the open list */
+static inline void pvr_list_submit(void *src, int n) {
+    pvr_host_ta_submit(src, n);
+}
+
+static inline void pvr_hdr_submit(const GLuint *src) {
+    pvr_host_ta_submit(src, 1);
+}
+
+#endif
+
 inline void _glKosPushMultiTexObject(GL_TEXTURE_OBJECT *tex,
                                      pvr_vertex_t *src,
                                      GLuint count) {
-    _glKosCompileHdrMT(&GL_MTOBJS[GL_MTOBJECTS].hdr, tex);
+    _glKosCompileHdrMT(&GL_FRAME->mtobjs[GL_FRAME->mtobjects].hdr, tex);
+
+    if(GL_LIST == GL_KOS_LIST_OP) /* src must survive until the Multi-Texture Pass */
+        GL_DIRECT_PINNED = 1;
 
-    GL_MTOBJS[GL_MTOBJECTS].src = src;
-    GL_MTOBJS[GL_MTOBJECTS++].count = count;
+    GL_FRAME->mtobjs[GL_FRAME->mtobjects].src = src;
+    GL_FRAME->mtobjs[GL_FRAME->mtobjects++].count = count;
+
+    GL_KOS_STAT_ADD(frame.multitex_objects, 1);
+    GL_KOS_STAT_ADD(mt_bytes, (count + 1) * sizeof(pvr_cmd_t));
 }
 
 inline void _glKosResetMultiTexObject() {
-    GL_MTOBJECTS = 0;
+    GL_FRAME->mtobjects = 0;
 }
 
 inline void *_glKosMultiUVBufAddress() {
-    return &GL_UVBUF[0];
+    return &GL_FRAME->uvbuf[0];
 }
 
 inline void *_glKosMultiUVBufPointer() {
-    return &GL_UVBUF[GL_UVVERTS];
+    return &GL_FRAME->uvbuf[GL_FRAME->uvverts];
 }
 
 inline void _glKosMultiUVBufIncrement() {
-    ++GL_UVVERTS;
+    ++GL_FRAME->uvverts;
 }
 
 inline void _glKosMultiUVBufAdd(GLuint count) {
-    GL_UVVERTS += count;
+    GL_FRAME->uvverts += count;
 }
 
 inline void _glKosMultiUVBufReset() {
-    GL_UVVERTS = 0;
+    GL_FRAME->uvverts = 0;
 }
 
 inline void *_glKosClipBufAddress() {
@@ -155,44 +241,210 @@ inline void _glKosVertexBufSwitchTR() {
     GL_LIST = GL_KOS_LIST_TR;
 }
 
+inline void _glKosVertexBufSwitchPT() {
+    GL_LIST = GL_KOS_LIST_PT;
+}
+
+/* Take a new chunk out of the Vertex Buffer budget */
+static GL_VERTEX_CHUNK *_glKosVertexChunkNew(GLuint size) {
+    GLuint bytes = (size + 1) * sizeof(pvr_cmd_t);
+    GL_VERTEX_CHUNK *chunk;
+
+    if(GL_VBUF_BYTES + bytes > GL_KOS_VERTEX_BUF_BUDGET)
+        return NULL;
+
+#ifdef GL_KOS_USE_MALLOC
+    chunk = memalign(0x20, bytes);
+
+    if(!chunk)
+        return NULL;
+#else
+    if(size != GL_KOS_VERTEX_CHUNK_SIZE) /* Oversized chunks need malloc */
+        return NULL;
+
+    chunk = (GL_VERTEX_CHUNK *)&GL_VBUF[GL_VBUF_BYTES / sizeof(pvr_cmd_t)];
+#endif
+
+    GL_VBUF_BYTES += bytes;
+
+    chunk->data = (pvr_cmd_t *)chunk + 1;
+    chunk->size = size;
+
+    return chunk;
+}
+
+/* Get a chunk of at least size commands, from the pool when possible */
+static GL_VERTEX_CHUNK *_glKosVertexChunkAlloc(GLuint size) {
+    GL_VERTEX_CHUNK *chunk;
+
+    if(size > GL_KOS_VERTEX_CHUNK_SIZE)
+        chunk = _glKosVertexChunkNew(size);
+    else if(GL_VBUF_POOL) {
+        chunk = GL_VBUF_POOL;
+        GL_VBUF_POOL = chunk->link;
+    }
+    else
+        chunk = _glKosVertexChunkNew(GL_KOS_VERTEX_CHUNK_SIZE);
+
+    if(chunk) {
+        chunk->count = 0;
+        chunk->link = NULL;
+    }
+
+    return chunk;
+}
+
+static void _glKosVertexChunkFree(GL_VERTEX_CHUNK *chunk) {
+#ifdef GL_KOS_USE_MALLOC
+    if(chunk->size != GL_KOS_VERTEX_CHUNK_SIZE) {
+        GL_VBUF_BYTES -= (chunk->size + 1) * sizeof(pvr_cmd_t);
+        free(chunk);
+        return;
+    }
+#endif
+
+    chunk->link = GL_VBUF_POOL;
+    GL_VBUF_POOL = chunk;
+}
+
+/* Close the tail chunk of list and continue in a new chunk with room for size
+   commands, moving the last keep commands of the old tail over to it */
+static GLubyte _glKosVertexBufGrow(GLubyte list, GLuint size, GLuint keep) {
+    GL_VERTEX_CHUNK *tail = GL_FRAME->tail[list], *prev;
+    GL_VERTEX_CHUNK *chunk = _glKosVertexChunkAlloc(size + keep);
+
+    if(!chunk)
+        return 0;
+
+    tail->count = GL_FRAME->verts[list] - keep;
+
+    memcpy(chunk->data, tail->data + tail->count, keep * sizeof(pvr_cmd_t));
+
+    if(!tail->count && tail != GL_FRAME->chunks[list]) {
+        /* Nothing left in the old tail - replace it */
+        for(prev = GL_FRAME->chunks[list]; prev->link != tail; prev = prev->link);
+
+        if(tail == GL_DIRECT_CHUNK)
+            GL_DIRECT_CHUNK = chunk;
+
+        _glKosVertexChunkFree(tail);
+
+        tail = prev;
+    }
+
+    tail->link = chunk;
+
+    GL_FRAME->tail[list] = chunk;
+    GL_FRAME->vbuf[list] = chunk->data;
+    GL_FRAME->verts[list] = keep;
+    GL_FRAME->vsize[list] = chunk->size;
+    GL_FRAME->vmark[list] = 0;
+
+    return 1;
+}
+
+/* The tail chunk is full in the middle of a glBegin()/glEnd() block.
+   The block must stay contiguous, so it moves to a chunk twice its size. */
+static void _glKosVertexBufSpill(GLubyte list) {
+    GLuint open = GL_FRAME->verts[list] - GL_FRAME->vmark[list];
+
+    if(!_glKosVertexBufGrow(list, open, open)) {
+        _glKosThrowError(GL_OUT_OF_MEMORY, "glVertex3f");
+        _glKosPrintError();
+
+        GL_FRAME->verts[list] = GL_FRAME->vmark[list]; /* Drop the open block */
+
+        _glKosHdrInvalidate(list);
+    }
+}
+
+/* Make room for count commands in the current list, and start a new primitive
+   block there. There is always at least one free command left after count. */
+GLubyte _glKosVertexBufReserve(GLuint count, char *functionName) {
+    if(GL_FRAME->verts[GL_LIST] + count >= GL_FRAME->vsize[GL_LIST]
+            && !_glKosVertexBufGrow(GL_LIST, count + 1, 0)) {
+        _glKosThrowError(GL_OUT_OF_MEMORY, functionName);
+        _glKosPrintError();
+        return 0;
+    }
+
+    GL_FRAME->vmark[GL_LIST] = GL_FRAME->verts[GL_LIST];
+
+    return 1;
+}
+
+/* Commands written to the current list since the last reserve */
+GLuint _glKosVertexBufOpen() {
+    return GL_FRAME->verts[GL_LIST] - GL_FRAME->vmark[GL_LIST];
+}
+
 inline void *_glKosVertexBufAddress(GLubyte list) {
-    return &GL_VBUF[list][0];
+    return GL_FRAME->chunks[list]->data;
 }
 
 inline void *_glKosVertexBufPointer() {
-    return &GL_VBUF[GL_LIST][GL_VERTS[GL_LIST]];
+    return &GL_FRAME->vbuf[GL_LIST][GL_FRAME->verts[GL_LIST]];
 }
 
 inline void _glKosVertexBufIncrement() {
-    ++GL_VERTS[GL_LIST];
+    if(++GL_FRAME->verts[GL_LIST] == GL_FRAME->vsize[GL_LIST])
+        _glKosVertexBufSpill(GL_LIST);
 }
 
 inline void *_glKosTRVertexBufPointer() {
-    return &GL_VBUF[GL_KOS_LIST_TR][GL_VERTS[GL_KOS_LIST_TR]];
+    return &GL_FRAME->vbuf[GL_KOS_LIST_TR][GL_FRAME->verts[GL_KOS_LIST_TR]];
 }
 
 inline void _glKosTRVertexBufIncrement() {
-    ++GL_VERTS[GL_KOS_LIST_TR];
+    if(++GL_FRAME->verts[GL_KOS_LIST_TR] == GL_FRAME->vsize[GL_KOS_LIST_TR])
+        _glKosVertexBufSpill(GL_KOS_LIST_TR);
 }
 
 inline void _glKosVertexBufAdd(GLuint count) {
-    GL_VERTS[GL_LIST] += count;
+    GL_FRAME->verts[GL_LIST] += count;
 }
 
 inline void _glKosTRVertexBufAdd(GLuint count) {
-    GL_VERTS[GL_KOS_LIST_TR] += count;
+    GL_FRAME->verts[GL_KOS_LIST_TR] += count;
 }
 
 inline void _glKosVertexBufDecrement() {
-    --GL_VERTS[GL_LIST];
+    --GL_FRAME->verts[GL_LIST];
+}
+
+/* Give every chunk but the first of a list back to the pool */
+static void _glKosVertexBufResetList(GLubyte list) {
+    GL_VERTEX_CHUNK *chunk, *next;
+
+    for(chunk = GL_FRAME->chunks[list]->link; chunk; chunk = next) {
+        next = chunk->link;
+        _glKosVertexChunkFree(chunk);
+    }
+
+    chunk = GL_FRAME->chunks[list];
+    chunk->link = NULL;
+
+    GL_FRAME->tail[list] = chunk;
+    GL_FRAME->vbuf[list] = chunk->data;
+    GL_FRAME->verts[list] = 0;
+    GL_FRAME->vsize[list] = chunk->size;
+    GL_FRAME->vmark[list] = 0;
 }
 
 inline void _glKosVertexBufReset() {
-    GL_VERTS[0] = GL_VERTS[1] = 0;
+    _glKosVertexBufResetList(GL_KOS_LIST_OP);
+    _glKosVertexBufResetList(GL_KOS_LIST_TR);
+    _glKosVertexBufResetList(GL_KOS_LIST_PT);
 }
 
 inline GLuint _glKosVertexBufCount(GLubyte list) {
-    return GL_VERTS[list];
+    GL_VERTEX_CHUNK *chunk;
+    GLuint count = GL_FRAME->verts[list];
+
+    for(chunk = GL_FRAME->chunks[list]; chunk != GL_FRAME->tail[list]; chunk = chunk->link)
+        count += chunk->count;
+
+    return count;
 }
 
 GLubyte _glKosList() {
@@ -203,96 +455,370 @@ inline void _glKosVertexBufCopy(void *dst, void *src, GLuint count) {
     memcpy(dst, src, count * 0x20);
 }
 
-static inline void glutSwapBuffer() {
+void _glKosFrameClearColor(GLfloat r, GLfloat g, GLfloat b) {
+    GL_FRAME->bg_color[0] = r;
+    GL_FRAME->bg_color[1] = g;
+    GL_FRAME->bg_color[2] = b;
+}
+
+void _glKosFrameAlphaRef(GLubyte ref) {
+    GL_FRAME->pt_alpha_ref = ref;
+}
+
+/* Load the per-scene PVR registers recorded with a frame */
+static inline void _glKosFrameApplyState(GL_FRAME_CONTEXT *frame) {
+    pvr_set_bg_color(frame->bg_color[0], frame->bg_color[1], frame->bg_color[2]);
+
+    PVR_SET(PVR_PT_ALPHA_REF, frame->pt_alpha_ref);
+}
+
+/* Begin a scene on the PVR, rendering to target if it is not NULL */
+static void _glKosFrameBeginScene(GL_FRAME_CONTEXT *frame, GLvoid *target,
+                                  GLsizei *width, GLsizei *height) {
+    _glKosFrameApplyState(frame);
+
+    if(target)
+        pvr_scene_begin_txr(target, width, height);
+    else
+        pvr_scene_begin();
+
+    if(GL_KOS_CAPTURE)
+        _glKosCaptureSceneBegin(frame->bg_color, frame->pt_alpha_ref, target,
+                                target ? *width : 0, target ? *height : 0);
+}
+
+static inline void _glKosFrameFinishScene() {
+    pvr_scene_finish();
+
+    if(GL_KOS_CAPTURE)
+        _glKosCaptureSceneFinish();
+}
+
+static inline void _glKosListBegin(GLuint list) {
+    pvr_list_begin(list);
+
+    if(GL_KOS_CAPTURE)
+        _glKosCaptureListBegin(list);
+}
+
+static inline void _glKosListFinish() {
+    pvr_list_finish();
+
+    if(GL_KOS_CAPTURE)
+        _glKosCaptureListFinish();
+}
+
+static inline void _glKosVertexChunkSubmit(pvr_cmd_t *src, GLuint count) {
+    if(GL_KOS_CAPTURE)
+        _glKosCaptureCommands(src, count);
+
+#ifdef GL_KOS_USE_DMA
+    pvr_dma_transfer(src, 0, count * 32, PVR_DMA_TA, 1, NULL, 0);
+#else
+    pvr_list_submit(src, count);
+#endif
+}
+
+/* Send commands to the open list, outside of any frame context */
+void _glKosSubmitCommands(GLvoid *src, GLuint count) {
 #ifndef GL_KOS_USE_DMA
     QACR0 = QACRTA;
     QACR1 = QACRTA;
 #endif
 
-    pvr_list_begin(PVR_LIST_OP_POLY);
-#ifdef GL_KOS_USE_DMA
-    pvr_dma_transfer(_glKosVertexBufAddress(GL_KOS_LIST_OP), 0,
-                     _glKosVertexBufCount(GL_KOS_LIST_OP) * 32,
-                     PVR_DMA_TA, 1, NULL, 0);
-#else
-    pvr_list_submit(_glKosVertexBufAddress(GL_KOS_LIST_OP), _glKosVertexBufCount(GL_KOS_LIST_OP));
+    _glKosVertexChunkSubmit(src, count);
+}
+
+/* Send the chunks of a list to the TA, in the order they were filled */
+static inline void _glKosVertexBufSubmit(GL_FRAME_CONTEXT *frame, GLubyte list) {
+    GL_VERTEX_CHUNK *chunk;
+
+    frame->tail[list]->count = frame->verts[list];
+
+    for(chunk = frame->chunks[list]; chunk; chunk = chunk->link)
+        _glKosVertexChunkSubmit(chunk->data, chunk->count);
+}
+
+/* Stream the OP commands recorded since the last call into the open OP list */
+static void _glKosVertexBufStreamOP() {
+    GL_VERTEX_CHUNK *chunk;
+
+#ifndef GL_KOS_USE_DMA
+    QACR0 = QACRTA;
+    QACR1 = QACRTA;
 #endif
-    pvr_list_finish();
 
-    pvr_list_begin(PVR_LIST_TR_POLY);
-#ifdef GL_KOS_USE_DMA
-    pvr_dma_transfer(_glKosVertexBufAddress(GL_KOS_LIST_TR), 0,
-                     _glKosVertexBufCount(GL_KOS_LIST_TR) * 32,
-                     PVR_DMA_TA, 1, NULL, 0);
-#else
-    pvr_list_submit(_glKosVertexBufAddress(GL_KOS_LIST_TR), _glKosVertexBufCount(GL_KOS_LIST_TR));
+    GL_FRAME->tail[GL_KOS_LIST_OP]->count = GL_FRAME->verts[GL_KOS_LIST_OP];
+
+    for(chunk = GL_DIRECT_CHUNK; chunk; chunk = chunk->link) {
+        _glKosVertexChunkSubmit(chunk->data + GL_DIRECT_SENT, chunk->count - GL_DIRECT_SENT);
+
+        GL_DIRECT_BYTES += (chunk->count - GL_DIRECT_SENT) * sizeof(pvr_cmd_t);
+        GL_DIRECT_SENT = 0;
+    }
+
+    if(GL_DIRECT_PINNED) {
+        GL_DIRECT_CHUNK = GL_FRAME->tail[GL_KOS_LIST_OP];
+        GL_DIRECT_SENT = GL_FRAME->verts[GL_KOS_LIST_OP];
+    }
+    else {
+        _glKosVertexBufResetList(GL_KOS_LIST_OP);
+        GL_DIRECT_CHUNK = GL_FRAME->chunks[GL_KOS_LIST_OP];
+    }
+}
+
+/* Submit every queued frame, so the PVR is free for a scene out of the queue.
+   Fails when the record frame's scene is already open on the PVR. */
+GLubyte _glKosFrameFlush() {
+    if(GL_DIRECT_SCENE)
+        return 0;
+
+    while(GL_FRAME_QUEUED) {
+        pvr_wait_ready();
+        _glKosFrameSubmit();
+    }
+
+    return 1;
+}
+
+/* Open the scene of the record frame, with its OP list, on the PVR */
+static void _glKosFrameBeginDirect() {
+    /* Keep scene order - flush the frames queued ahead of this one */
+    _glKosFrameFlush();
+
+    pvr_wait_ready();
+
+    if(_glKosGetFBO()) {
+        GL_FRAME->fbo_width = _glKosGetFBOWidth(_glKosGetFBO());
+        GL_FRAME->fbo_height = _glKosGetFBOHeight(_glKosGetFBO());
+
+        _glKosFrameBeginScene(GL_FRAME, _glKosGetFBOData(_glKosGetFBO()),
+                              &GL_FRAME->fbo_width, &GL_FRAME->fbo_height);
+    }
+    else
+        _glKosFrameBeginScene(GL_FRAME, NULL, NULL, NULL);
+
+    _glKosListBegin(PVR_LIST_OP_POLY);
+
+    GL_DIRECT_CHUNK = GL_FRAME->chunks[GL_KOS_LIST_OP];
+    GL_DIRECT_SENT = 0;
+    GL_DIRECT_SCENE = 1;
+}
+
+/* Called when a draw completes - in direct mode, send OP geometry to the TA now */
+void _glKosVertexBufStream() {
+    if(!GL_DIRECT || GL_LIST != GL_KOS_LIST_OP)
+        return;
+
+    if(!GL_DIRECT_SCENE)
+        _glKosFrameBeginDirect();
+
+    _glKosVertexBufStreamOP();
+}
+
+void _glKosVertexBufDirect(GLubyte enable) {
+    GL_DIRECT = enable;
+}
+
+GLuint _glKosVertexBufDirectBytes() {
+    return GL_DIRECT_BYTES_LAST;
+}
+
+static inline void glutSwapBuffer(GL_FRAME_CONTEXT *frame) {
+#ifndef GL_KOS_USE_DMA
+    QACR0 = QACRTA;
+    QACR1 = QACRTA;
 #endif
+
+    GL_KOS_TRACE_BEGIN(submit);
+
+    if(frame == GL_FRAME && GL_DIRECT_SCENE)
+        _glKosVertexBufStreamOP(); /* The OP list is already open */
+    else {
+        _glKosListBegin(PVR_LIST_OP_POLY);
+        _glKosVertexBufSubmit(frame, GL_KOS_LIST_OP);
+    }
+
+    _glKosListFinish();
+
+    GL_KOS_TRACE_END(submit, "submit OP");
+    GL_KOS_TRACE_BEGIN(submit_pt);
+
+    _glKosListBegin(PVR_LIST_PT_POLY);
+    _glKosVertexBufSubmit(frame, GL_KOS_LIST_PT);
+    _glKosListFinish();
+
+    GL_KOS_TRACE_END(submit_pt, "submit PT");
+    GL_KOS_TRACE_BEGIN(submit_tr);
+
+    _glKosListBegin(PVR_LIST_TR_POLY);
+    _glKosVertexBufSubmit(frame, GL_KOS_LIST_TR);
     /* Multi-Texture Pass - Modify U/V coords of submitted vertices */
     GLuint i, v;
-    glTexCoord *mt = _glKosMultiUVBufAddress();
+    glTexCoord *mt = frame->uvbuf;
+    GL_MULTITEX_OBJECT *mtobj = frame->mtobjs;
 
-    for(i = 0; i < GL_MTOBJECTS; i++) {
+    for(i = 0; i < frame->mtobjects; i++, mtobj++) {
         //copy vertex uv
-        for(v = 0; v < GL_MTOBJS[i].count; v ++) {
-            GL_MTOBJS[i].src[v].u = mt->u;
-            GL_MTOBJS[i].src[v].v = mt->v;
+        for(v = 0; v < mtobj->count; v ++) {
+            mtobj->src[v].u = mt->u;
+            mtobj->src[v].v = mt->v;
             ++mt;
         }
 
+        if(GL_KOS_CAPTURE) {
+            _glKosCaptureCommands(&mtobj->hdr, 1);
+            _glKosCaptureCommands(mtobj->src, mtobj->count);
+        }
+
         // submit vertex data to PVR
 #ifdef GL_KOS_USE_DMA
-        pvr_hdr_submit((GLuint *)&GL_MTOBJS[i].hdr);
-        pvr_dma_transfer(GL_MTOBJS[i].src, 0,
-                         GL_MTOBJS[i].count * 32, PVR_DMA_TA, 1, NULL, 0);
+        pvr_hdr_submit((GLuint *)&mtobj->hdr);
+        pvr_dma_transfer(mtobj->src, 0,
+                         mtobj->count * 32, PVR_DMA_TA, 1, NULL, 0);
 #else
-        pvr_list_submit((pvr_poly_hdr_t *)&GL_MTOBJS[i].hdr, 1);
-        pvr_list_submit((pvr_vertex_t *)GL_MTOBJS[i].src, GL_MTOBJS[i].count);
+        pvr_list_submit((pvr_poly_hdr_t *)&mtobj->hdr, 1);
+        pvr_list_submit((pvr_vertex_t *)mtobj->src, mtobj->count);
 #endif
     }
 
-    _glKosResetMultiTexObject(); /* End Multi-Texture Pass */
+    frame->mtobjects = 0; /* End Multi-Texture Pass */
 
-    pvr_list_finish();
+    _glKosListFinish();
 
-    pvr_scene_finish();
+    GL_KOS_TRACE_END(submit_tr, "submit TR");
+
+    _glKosFrameFinishScene();
+}
+
+/* Render the oldest closed frame. The caller must make sure the PVR is ready. */
+static void _glKosFrameSubmit() {
+    GL_FRAME_CONTEXT *frame = &GL_FRAMES[GL_FRAME_SUBMIT];
+
+    _glKosFrameBeginScene(frame, frame->fbo_data, &frame->fbo_width, &frame->fbo_height);
+
+    glutSwapBuffer(frame);
+
+    GL_FRAME_SUBMIT = (GL_FRAME_SUBMIT + 1) % GL_KOS_FRAME_CONTEXTS;
+    --GL_FRAME_QUEUED;
+}
+
+/* Reset the next free context and make it the record context */
+static void _glKosFrameAdvance() {
+    GL_FRAME_CONTEXT *prev = GL_FRAME;
+
+#ifndef GL_KOS_NO_STATS
+    /* In direct mode the OP list was streamed and rewound as it was drawn */
+    GLuint cmds[GL_KOS_LISTS] = {
+        GL_DIRECT_BYTES ? GL_DIRECT_BYTES / sizeof(pvr_cmd_t) : _glKosVertexBufCount(GL_KOS_LIST_OP),
+        _glKosVertexBufCount(GL_KOS_LIST_TR),
+        _glKosVertexBufCount(GL_KOS_LIST_PT)
+    };
+
+    _glKosStatsFrameEnd(cmds, GL_FRAME->uvverts);
+#endif
+
+    GL_FRAME_RECORD = (GL_FRAME_RECORD + 1) % GL_KOS_FRAME_CONTEXTS;
+    GL_FRAME = &GL_FRAMES[GL_FRAME_RECORD];
+
+    GL_FRAME->bg_color[0] = prev->bg_color[0];
+    GL_FRAME->bg_color[1] = prev->bg_color[1];
+    GL_FRAME->bg_color[2] = prev->bg_color[2];
+    GL_FRAME->pt_alpha_ref = prev->pt_alpha_ref;
+
+    _glKosVertexBufReset();
+
+    _glKosMultiUVBufReset();
+
+    _glKosHdrFrameReset();
+
+    GL_DIRECT_PINNED = 0;
+    GL_DIRECT_BYTES_LAST = GL_DIRECT_BYTES;
+    GL_DIRECT_BYTES = 0;
 }
 
 void glutSwapBuffers() {
-    pvr_wait_ready();
+    if(GL_DIRECT_SCENE) {
+        /* The scene was begun by the first OP draw - close it now */
+        glutSwapBuffer(GL_FRAME);
+
+        GL_DIRECT_SCENE = 0;
+
+        _glKosFrameAdvance();
+
+        GL_FRAME_SUBMIT = GL_FRAME_RECORD; /* Nothing is queued behind this frame */
+
+        return;
+    }
 
     if(_glKosGetFBO()) {
-        GLsizei w = _glKosGetFBOWidth(_glKosGetFBO());
-        GLsizei h = _glKosGetFBOHeight(_glKosGetFBO());
-        pvr_scene_begin_txr(_glKosGetFBOData(_glKosGetFBO()), &w, &h);
+        GL_FRAME->fbo_data = _glKosGetFBOData(_glKosGetFBO());
+        GL_FRAME->fbo_width = _glKosGetFBOWidth(_glKosGetFBO());
+        GL_FRAME->fbo_height = _glKosGetFBOHeight(_glKosGetFBO());
     }
     else
-        pvr_scene_begin();
+        GL_FRAME->fbo_data = NULL;
 
-    glutSwapBuffer();
+    ++GL_FRAME_QUEUED;
 
-    _glKosVertexBufReset();
+    /* Hand over as many closed frames as the PVR will take without waiting */
+    while(GL_FRAME_QUEUED && !pvr_check_ready())
+        _glKosFrameSubmit();
 
-    _glKosMultiUVBufReset();
+    /* Every context is in flight, so the client has nowhere to record: block */
+    while(GL_FRAME_QUEUED >= GL_FRAME_LIMIT) {
+        GL_KOS_TRACE_BEGIN(wait);
+
+        pvr_wait_ready();
+
+        GL_KOS_TRACE_END(wait, "wait");
+
+        _glKosFrameSubmit();
+    }
+
+    _glKosFrameAdvance();
+}
+
+void APIENTRY glKosFrameContexts(GLuint count) {
+    if(count < 1 || count > GL_KOS_FRAME_CONTEXTS) {
+        _glKosThrowError(GL_INVALID_VALUE, "glKosFrameContexts");
+        _glKosPrintError();
+        return;
+    }
 
+    GL_FRAME_LIMIT = count;
 }
 
 void glutCopyBufferToTexture(void *dst, GLsizei *x, GLsizei *y) {
+    if(GL_DIRECT_SCENE) { /* The OP list has already gone to the screen */
+        _glKosThrowError(GL_INVALID_OPERATION, "glutCopyBufferToTexture");
+        _glKosPrintError();
+        return;
+    }
+
     if(_glKosGetFBO()) {
+        /* Keep scene order - flush the frames queued ahead of this one */
+        _glKosFrameFlush();
+
         pvr_wait_ready();
 
-        pvr_scene_begin_txr(dst, x, y);
+        _glKosFrameBeginScene(GL_FRAME, dst, x, y);
 
-        glutSwapBuffer();
+        glutSwapBuffer(GL_FRAME);
     }
 }
 
-int _glKosInitPVR() {
+int _glKosInitPVR(const GL_KOS_INIT_PARAMS *init) {
     pvr_init_params_t params = {
 
-        /* Enable opaque and translucent polygons with size 32 and 32 */
-        { PVR_BINSIZE_32, PVR_BINSIZE_0, PVR_BINSIZE_32, PVR_BINSIZE_0, PVR_BINSIZE_0 },
+        /* Enable opaque, translucent and punch-through polygons, no modifier volumes */
+        {
+            init->bin_size[GL_KOS_LIST_OP], PVR_BINSIZE_0,
+            init->bin_size[GL_KOS_LIST_TR], PVR_BINSIZE_0,
+            init->bin_size[GL_KOS_LIST_PT]
+        },
 
-        GL_PVR_VERTEX_BUF_SIZE, /* Vertex buffer size */
+        init->vertex_buf_size, /* Vertex buffer size */
 
         0, /* No DMA */
 
@@ -302,11 +828,26 @@ int _glKosInitPVR() {
 
     pvr_init(&params);
 
+    GLuint i;
+
+    for(i = 0; i < GL_KOS_FRAME_CONTEXTS; i++) {
+        GL_FRAMES[i].chunks[GL_KOS_LIST_OP] = _glKosVertexChunkAlloc(GL_KOS_VERTEX_CHUNK_SIZE);
+        GL_FRAMES[i].chunks[GL_KOS_LIST_TR] = _glKosVertexChunkAlloc(GL_KOS_VERTEX_CHUNK_SIZE);
+        GL_FRAMES[i].chunks[GL_KOS_LIST_PT] = _glKosVertexChunkAlloc(GL_KOS_VERTEX_CHUNK_SIZE);
+#ifdef GL_KOS_USE_MALLOC
+        GL_FRAMES[i].uvbuf = malloc(GL_KOS_MAX_VERTS * sizeof(glTexCoord));
+#else
+        GL_FRAMES[i].uvbuf = GL_UVBUF[i];
+#endif
+
+        GL_FRAME = &GL_FRAMES[i];
+        _glKosVertexBufReset();
+    }
+
+    GL_FRAME = &GL_FRAMES[GL_FRAME_RECORD];
+
 #ifdef GL_KOS_USE_MALLOC
-    GL_VBUF[0] = memalign(0x20, GL_KOS_MAX_VERTS * sizeof(pvr_cmd_t));
-    GL_VBUF[1] = memalign(0x20, GL_KOS_MAX_VERTS * sizeof(pvr_cmd_t));
     GL_CBUF = malloc((GL_KOS_MAX_VERTS / 2) * sizeof(pvr_cmd_t));
-    GL_UVBUF = malloc(GL_KOS_MAX_VERTS * sizeof(glTexCoord));
 #endif
 
     return 1;
@@ -24,10 +24,19 @@ typedef struct {
 } pvr_cmd_tclip_t; /* Tile Clip command for the pvr */
 
 #define GL_PVR_VERTEX_BUF_SIZE 2560 * 256 /* PVR Vertex buffer size */
+#define GL_PVR_BIN_SIZE        PVR_BINSIZE_32 /* PVR object pointer block size, per list */
 #define GL_KOS_MAX_VERTS       1024*64    /* SH4 Vertex Count */
 
+#define GL_KOS_VERTEX_CHUNK_SIZE 1024*4         /* Commands per Vertex Buffer chunk */
+#define GL_KOS_VERTEX_BUF_BUDGET 1024*1024*4    /* Max SH4 RAM used by Vertex Buffer chunks */
+#define GL_KOS_MAX_DRAW_VERTS    1020           /* glDraw* split size - clipped output must fit a chunk */
+
+#define GL_KOS_FRAME_CONTEXTS  2          /* Frames that can be recorded while the PVR is busy */
+
 #define GL_KOS_LIST_OP 0
 #define GL_KOS_LIST_TR 1
+#define GL_KOS_LIST_PT 2 /* _glKosList() * 2 gives the PVR list */
+#define GL_KOS_LISTS   3
 
 #define GL_KOS_USE_MALLOC 1 /* Use Dynamic Vertex Array */
 //#define GL_KOS_USE_DMA    1 /* Use PVR DMA for vertex data transfer instead of store queues */
@@ -51,4 +60,10 @@ typedef struct {
 #define GL_PVR_SAMPLE_POINT 0x0
 #define GL_PVR_SAMPLE_SUPER 0x1
 
+#define GL_PVR_CMD_TXR_ENABLE       (1 << 3) /* Textured bit of the polygon header cmd word */
+
+#define GL_PVR_PM2_TXR_MASK (PVR_TA_PM2_UVFLIP_MASK | PVR_TA_PM2_UVCLAMP_MASK | \
+                             PVR_TA_PM2_FILTER_MASK | PVR_TA_PM2_MIPBIAS_MASK | \
+                             PVR_TA_PM2_USIZE_MASK  | PVR_TA_PM2_VSIZE_MASK)
+
 #endif
@@ -18,6 +18,14 @@ typedef float matrix4f[4][4];  /* 4x4 float matrix */
 /* Calculate Spot Light Angle Cosine = (PI / 180.0f) * (n / 2) */
 #define LCOS(n) fcos(n*0.00872664625997164788461845384244)
 
+#ifdef __sh__
+
+/* Pin a float to an SH4 FPU register, for the fv12 transform macros */
+#define GL_KOS_FREG(reg) __asm__(reg)
+
+/* Fetch the 32 byte cache line at addr ahead of use */
+#define GL_KOS_PREFETCH(addr) __asm__ __volatile__("pref @%0" : : "r"(addr))
+
 /* Internal GL API macro */
 #define mat_trans_fv12() { \
         __asm__ __volatile__( \
@@ -83,4 +91,55 @@ typedef float matrix4f[4][4];  /* 4x4 float matrix */
         so = __s; to = __t; \
     }
 
+#else
+
+/* Host build - the same transforms in C, against the stand-in XMTRX.
+   The operands are register variables, so they go through a temporary. */
+#define GL_KOS_FREG(reg)
+
+#define GL_KOS_PREFETCH(addr) __builtin_prefetch(addr)
+
+/* Internal GL API macro */
+#define mat_trans_fv12() { \
+        float __v[4] = { __x, __y, __z, 1.0f }; \
+        mat_host_ftrv(&__v[0], &__v[1], &__v[2], &__v[3]); \
+        __z = 1.0f / __v[3]; \
+        __x = __v[0] * __z; \
+        __y = __v[1] * __z; \
+    }
+
+/* Internal GL API macro */
+#define mat_trans_fv12_nodiv() { \
+        float __v[4] = { __x, __y, __z, 1.0f }; \
+        mat_host_ftrv(&__v[0], &__v[1], &__v[2], &__v[3]); \
+        __x = __v[0]; \
+        __y = __v[1]; \
+        __z = __v[2]; \
+    }
+
+#define mat_trans_fv12_nodivw() { \
+        float __v[4] = { __x, __y, __z, 1.0f }; \
+        mat_host_ftrv(&__v[0], &__v[1], &__v[2], &__v[3]); \
+        __x = __v[0]; \
+        __y = __v[1]; \
+        __z = __v[2]; \
+        __w = __v[3]; \
+    }
+
+#define mat_trans_texture4(s, t, r, q) { \
+        float __s = (s), __t = (t), __r = (r), __q = (q); \
+        mat_host_ftrv(&__s, &__t, &__r, &__q); \
+        __r = 1.0f / __q; \
+        s = __s * __r; t = __t * __r; r = __r; \
+    }
+
+#define mat_trans_texture2_nomod(s, t, so, to) { \
+        float __s = (s), __t = (t), __r = 0.0f, __q = 1.0f; \
+        mat_host_ftrv(&__s, &__t, &__r, &__q); \
+        __r = 1.0f / __q; \
+        so = __s * __r; to = __t * __r; \
+    }
+
+#endif
+
 #endif
@@ -0,0 +1,86 @@
+/* KallistiGL for KallistiOS ##version##
+
+   libgl/gl-stats.c
+
+   Per-frame pipeline counters.
+
+   Counters accumulate while a frame is recorded, and are closed by
+   glutSwapBuffers(). glKosGetFrameStats() returns the last closed frame.
+   Commands and bytes are those the frame sends to the TA, whenever the
+   PVR actually takes them.
+*/
+
+#include <string.h>
+
+#include <GL/gl.h>
+#include "gl-api.h"
+#include "gl-stats.h"
+
+#ifndef GL_KOS_NO_STATS
+
+GL_KOS_STATS_RECORD GL_KOS_STATS;
+
+static GL_KOS_FRAME_STATS GL_KOS_STATS_LAST;
+
+/* Near-Z clipping: count input triangles, and the triangles of the strips it emitted */
+void _glKosStatsClip(GLenum mode, GLuint count, pvr_vertex_t *dst, GLuint verts) {
+    GLuint strip = 0;
+
+    switch(mode) {
+        case GL_TRIANGLES:
+            GL_KOS_STATS.frame.clip_tris_in += count / 3;
+            break;
+
+        case GL_TRIANGLE_STRIP:
+            if(count > 2)
+                GL_KOS_STATS.frame.clip_tris_in += count - 2;
+
+            break;
+
+        case GL_QUADS:
+            GL_KOS_STATS.frame.clip_tris_in += (count / 4) * 2;
+            break;
+    }
+
+    while(verts--)
+        if((dst++)->flags == PVR_CMD_VERTEX_EOL) {
+            GL_KOS_STATS.frame.clip_tris_out += strip - 1;
+            strip = 0;
+        }
+        else
+            ++strip;
+
+    GL_KOS_STAT_PEAK(clip_buf_peak, count);
+}
+
+/* Close the record frame. cmds holds the commands recorded on each list. */
+void _glKosStatsFrameEnd(GLuint *cmds, GLuint uvverts) {
+    GLuint i;
+
+    for(i = 0; i < GL_KOS_LISTS; i++) {
+        GL_KOS_STATS.frame.vertices[i] = cmds[i] - GL_KOS_STATS.frame.headers[i]
+                                         - GL_KOS_STATS.clips[i];
+        GL_KOS_STATS.frame.bytes_sent += cmds[i] * sizeof(pvr_cmd_t);
+    }
+
+    GL_KOS_STATS.frame.bytes_sent += GL_KOS_STATS.mt_bytes;
+
+    GL_KOS_STAT_PEAK(uv_buf_peak, uvverts);
+
+    GL_KOS_STATS_LAST = GL_KOS_STATS.frame;
+
+    memset(&GL_KOS_STATS, 0, sizeof(GL_KOS_STATS_RECORD));
+}
+
+#endif
+
+//===============================================================================//
+//== External API Functions ==//
+
+void APIENTRY glKosGetFrameStats(GL_KOS_FRAME_STATS *stats) {
+#ifndef GL_KOS_NO_STATS
+    *stats = GL_KOS_STATS_LAST;
+#else
+    memset(stats, 0, sizeof(GL_KOS_FRAME_STATS));
+#endif
+}
@@ -0,0 +1,46 @@
+/* KallistiGL for KallistiOS ##version##
+
+   libgl/gl-stats.h
+
+   Per-frame pipeline counters. Building with GL_KOS_NO_STATS defined
+   (make RELEASE=true) turns every counter into a no-op.
+*/
+
+#ifndef GL_STATS_H
+#define GL_STATS_H
+
+#include "gl-pvr.h"
+
+typedef struct {
+    GL_KOS_FRAME_STATS frame;                   /* Counters reported by glKosGetFrameStats() */
+    GLuint             clips[GL_KOS_LISTS],     /* User clip commands per list */
+                       mt_bytes;                /* Bytes of the Multi-Texture pass */
+} GL_KOS_STATS_RECORD; /* Counters of the frame being recorded */
+
+#ifndef GL_KOS_NO_STATS
+
+extern GL_KOS_STATS_RECORD GL_KOS_STATS;
+
+#define GL_KOS_STAT_ADD(field, n)  (GL_KOS_STATS.field += (n))
+
+#define GL_KOS_STAT_PEAK(field, n)             \
+    do {                                       \
+        GLuint _peak = (n);                    \
+        if(_peak > GL_KOS_STATS.frame.field)   \
+            GL_KOS_STATS.frame.field = _peak;  \
+    } while(0)
+
+#define GL_KOS_STAT_CLIP(mode, count, dst, verts) _glKosStatsClip(mode, count, dst, verts)
+
+void _glKosStatsClip(GLenum mode, GLuint count, pvr_vertex_t *dst, GLuint verts);
+void _glKosStatsFrameEnd(GLuint *cmds, GLuint uvverts);
+
+#else
+
+#define GL_KOS_STAT_ADD(field, n)                 ((void)0)
+#define GL_KOS_STAT_PEAK(field, n)                ((void)0)
+#define GL_KOS_STAT_CLIP(mode, count, dst, verts) ((void)0)
+
+#endif
+
+#endif
@@ -12,6 +12,8 @@
 #include <GL/glext.h>
 #include "gl-api.h"
 #include "gl-rgb.h"
+#include "gl-stats.h"
+#include "gl-trace.h"
 
 #include <malloc.h>
 #include <stdio.h>
@@ -37,6 +39,7 @@ GLubyte _glKosInitTextures() {
         return 0;
 
     TEXTURE_OBJ->index = 0;
+    TEXTURE_OBJ->hdr[0] = TEXTURE_OBJ->hdr[1] = 0;
     TEXTURE_OBJ->data = NULL;
     TEXTURE_OBJ->link = NULL;
 
@@ -93,11 +96,54 @@ GLvoid *_glKosTextureData(GLuint index) {
     return tex->data;
 }
 
+/* Texture Object whose VRAM block starts at data, or NULL */
+GL_TEXTURE_OBJECT *_glKosTextureFindData(GLvoid *data) {
+    GL_TEXTURE_OBJECT *ptr = TEXTURE_OBJ->link;
+
+    while(ptr != NULL && ptr->data != data)
+        ptr = (GL_TEXTURE_OBJECT *)ptr->link;
+
+    return ptr;
+}
+
+/* Texture Object named index, or NULL if there is none */
+GL_TEXTURE_OBJECT *_glKosTextureObject(GLuint index) {
+    GL_TEXTURE_OBJECT *ptr = TEXTURE_OBJ->link;
+
+    while(ptr != NULL && ptr->index != index)
+        ptr = (GL_TEXTURE_OBJECT *)ptr->link;
+
+    return ptr;
+}
+
+/* Texture bindings are kept by name, the objects may be deleted before they are restored */
+void _glKosTextureSave(GL_KOS_STATE *state) {
+    GLubyte i;
+
+    for(i = 0; i < GL_KOS_MAX_TEXTURE_UNITS; i++)
+        state->texture[i] = GL_KOS_TEXTURE_UNIT[i] ? GL_KOS_TEXTURE_UNIT[i]->index : 0;
+
+    state->active_texture = GL_KOS_ACTIVE_TEXTURE;
+}
+
+void _glKosTextureRestore(const GL_KOS_STATE *state) {
+    GLubyte i;
+
+    for(i = 0; i < GL_KOS_MAX_TEXTURE_UNITS; i++)
+        GL_KOS_TEXTURE_UNIT[i] = state->texture[i] ? _glKosTextureObject(state->texture[i]) : NULL;
+
+    GL_KOS_ACTIVE_TEXTURE = state->active_texture;
+}
+
 void _glKosCompileHdrTx() {
     return GL_KOS_TEXTURE_UNIT[GL_TEXTURE0_ARB & 0xF] ?
            _glKosCompileHdrT(GL_KOS_TEXTURE_UNIT[GL_TEXTURE0_ARB & 0xF]) : _glKosCompileHdr();
 }
 
+GL_TEXTURE_OBJECT *_glKosBoundTexObject() {
+    return GL_KOS_TEXTURE_UNIT[GL_TEXTURE0_ARB & 0xF];
+}
+
 GL_TEXTURE_OBJECT *_glKosBoundMultiTexID() {
     return GL_KOS_TEXTURE_UNIT[GL_TEXTURE1_ARB & 0xF];
 }
@@ -121,6 +167,7 @@ void APIENTRY glGenTextures(GLsizei n, GLuint *textures) {
         GL_TEXTURE_OBJECT *txr = malloc(sizeof(GL_TEXTURE_OBJECT));
         txr->index = ++index;
         txr->data = NULL;
+        txr->bytes = 0;
         txr->link = NULL;
 
         txr->width = txr->height = 0;
@@ -128,6 +175,7 @@ void APIENTRY glGenTextures(GLsizei n, GLuint *textures) {
         txr->uv_clamp = 0;
         txr->env = PVR_TXRENV_MODULATEALPHA;
         txr->filter = PVR_FILTER_NONE;
+        txr->hdr[0] = txr->hdr[1] = 0;
 
         _glKosInsertTextureObj(txr);
 
@@ -214,9 +262,18 @@ void APIENTRY glCompressedTexImage2D(GLenum target,
         pvr_mem_free(GL_KOS_TEXTURE_UNIT[GL_KOS_ACTIVE_TEXTURE]->data);
 
     GL_KOS_TEXTURE_UNIT[GL_KOS_ACTIVE_TEXTURE]->data = pvr_mem_malloc(imageSize);
+    GL_KOS_TEXTURE_UNIT[GL_KOS_ACTIVE_TEXTURE]->bytes = imageSize;
+
+    if(data) {
+        GL_KOS_TRACE("upload");
 
-    if(data)
         sq_cpy(GL_KOS_TEXTURE_UNIT[GL_KOS_ACTIVE_TEXTURE]->data, data, imageSize);
+
+        GL_KOS_STAT_ADD(frame.texture_uploads, 1);
+        GL_KOS_STAT_ADD(frame.texture_bytes, imageSize);
+    }
+
+    _glKosCompileHdrTexture(GL_KOS_TEXTURE_UNIT[GL_KOS_ACTIVE_TEXTURE]);
 }
 
 void APIENTRY glTexImage2D(GLenum target, GLint level, GLint internalFormat,
@@ -272,9 +329,12 @@ void APIENTRY glTexImage2D(GLenum target, GLint level, GLint internalFormat,
         GL_KOS_TEXTURE_UNIT[GL_KOS_ACTIVE_TEXTURE]->color   = type;
 
         GL_KOS_TEXTURE_UNIT[GL_KOS_ACTIVE_TEXTURE]->data = pvr_mem_malloc(bytes);
+        GL_KOS_TEXTURE_UNIT[GL_KOS_ACTIVE_TEXTURE]->bytes = bytes;
     }
 
     if(data) {
+        GL_KOS_TRACE("upload");
+
         switch(type) {
             case GL_BYTE:          /* Texture Formats that need conversion for PVR */
             case GL_UNSIGNED_BYTE:
@@ -288,24 +348,32 @@ void APIENTRY glTexImage2D(GLenum target, GLint level, GLint internalFormat,
                 if(!tex) {
                     _glKosThrowError(GL_OUT_OF_MEMORY, "glTexImage2D");
                     _glKosPrintError();
+                    _glKosCompileHdrTexture(GL_KOS_TEXTURE_UNIT[GL_KOS_ACTIVE_TEXTURE]);
                     return;
                 }
 
+                GL_KOS_TRACE_BEGIN(convert);
+
                 switch(internalFormat) {
                     case GL_RGB:
                         _glKosPixelConvertRGB(type, width, height, (void *)data, tex);
+                        GL_KOS_TRACE_END(convert, "convert");
                         GL_KOS_TEXTURE_UNIT[GL_KOS_ACTIVE_TEXTURE]->color = (PVR_TXRFMT_RGB565 | PVR_TXRFMT_NONTWIDDLED);
                         sq_cpy(GL_KOS_TEXTURE_UNIT[GL_KOS_ACTIVE_TEXTURE]->data, tex, bytes);
                         break;
 
                     case GL_RGBA:
                         _glKosPixelConvertRGBA(type, width, height, (void *)data, tex);
+                        GL_KOS_TRACE_END(convert, "convert");
                         GL_KOS_TEXTURE_UNIT[GL_KOS_ACTIVE_TEXTURE]->color = (PVR_TXRFMT_ARGB4444 | PVR_TXRFMT_NONTWIDDLED);
                         sq_cpy(GL_KOS_TEXTURE_UNIT[GL_KOS_ACTIVE_TEXTURE]->data, tex, bytes);
                         break;
                 }
 
                 free(tex);
+
+                GL_KOS_STAT_ADD(frame.texture_uploads, 1);
+                GL_KOS_STAT_ADD(frame.texture_bytes, bytes);
             }
             break;
 
@@ -316,6 +384,9 @@ void APIENTRY glTexImage2D(GLenum target, GLint level, GLint internalFormat,
             case GL_UNSIGNED_SHORT_4_4_4_4:
             case GL_UNSIGNED_SHORT_4_4_4_4_TWID:
                 sq_cpy(GL_KOS_TEXTURE_UNIT[GL_KOS_ACTIVE_TEXTURE]->data, data, bytes);
+
+                GL_KOS_STAT_ADD(frame.texture_uploads, 1);
+                GL_KOS_STAT_ADD(frame.texture_bytes, bytes);
                 break;
 
             default: /* Unsupported Texture Format */
@@ -323,6 +394,8 @@ void APIENTRY glTexImage2D(GLenum target, GLint level, GLint internalFormat,
                 break;
         }
     }
+
+    _glKosCompileHdrTexture(GL_KOS_TEXTURE_UNIT[GL_KOS_ACTIVE_TEXTURE]);
 }
 
 void APIENTRY glTexParameteri(GLenum target, GLenum pname, GLint param) {
@@ -379,6 +452,8 @@ void APIENTRY glTexParameteri(GLenum target, GLenum pname, GLint param) {
 
                 break;
         }
+
+        _glKosCompileHdrTexture(GL_KOS_TEXTURE_UNIT[GL_KOS_ACTIVE_TEXTURE]);
     }
 }
 
@@ -0,0 +1,93 @@
+/* KallistiGL for KallistiOS ##version##
+
+   libgl/gl-trace.c
+
+   Hot-path trace event ring, and its export to Chrome trace-event JSON
+   (load the file in chrome://tracing or ui.perfetto.dev).
+*/
+
+#include <stdio.h>
+
+#include <GL/gl.h>
+#include "gl-api.h"
+#include "gl-trace.h"
+
+#ifdef GL_ENABLE_TRACE
+
+typedef struct {
+    const char *name;
+    uint64_t    start,
+                end;
+} GL_KOS_TRACE_EVENT;
+
+static GL_KOS_TRACE_EVENT GL_KOS_TRACE_RING[GL_KOS_TRACE_EVENTS];
+static GLuint GL_KOS_TRACE_HEAD = 0,  /* Next event to write */
+              GL_KOS_TRACE_COUNT = 0; /* Events held by the ring */
+
+void _glKosTraceInit() {
+#ifdef __sh__
+    GL_KOS_PMCR2 = GL_KOS_PMCR_CLEAR;
+    GL_KOS_PMCR2 = GL_KOS_PMCR_RUN | GL_KOS_PMCR_TIME;
+#endif
+
+    GL_KOS_TRACE_HEAD = GL_KOS_TRACE_COUNT = 0;
+}
+
+void _glKosTraceEvent(const char *name, uint64_t start) {
+    GL_KOS_TRACE_EVENT *e = &GL_KOS_TRACE_RING[GL_KOS_TRACE_HEAD];
+
+    e->end = _glKosTraceClock();
+    e->start = start;
+    e->name = name;
+
+    GL_KOS_TRACE_HEAD = (GL_KOS_TRACE_HEAD + 1) % GL_KOS_TRACE_EVENTS;
+
+    if(GL_KOS_TRACE_COUNT < GL_KOS_TRACE_EVENTS)
+        ++GL_KOS_TRACE_COUNT;
+}
+
+/* Clock ticks to the microseconds of the trace-event format */
+static inline double _glKosTraceMicros(uint64_t t) {
+    return (double)t * 1000000.0 / GL_KOS_TRACE_HZ;
+}
+
+#endif
+
+//===============================================================================//
+//== External API Functions ==//
+
+GLint APIENTRY glKosTraceDump(const char *filename) {
+#ifdef GL_ENABLE_TRACE
+    GLuint i, n = GL_KOS_TRACE_COUNT;
+    GL_KOS_TRACE_EVENT *e;
+    FILE *f = fopen(filename, "w");
+
+    if(!f) {
+        _glKosThrowError(GL_INVALID_VALUE, "glKosTraceDump");
+        _glKosPrintError();
+        return -1;
+    }
+
+    fprintf(f, "{\"traceEvents\":[\n");
+
+    for(i = 0; i < n; i++) {
+        e = &GL_KOS_TRACE_RING[(GL_KOS_TRACE_HEAD + GL_KOS_TRACE_EVENTS - n + i) % GL_KOS_TRACE_EVENTS];
+
+        fprintf(f, "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":0,\"ts\":%.3f,\"dur\":%.3f}%s\n",
+                e->name, _glKosTraceMicros(e->start), _glKosTraceMicros(e->end - e->start),
+                i + 1 < n ? "," : "");
+    }
+
+    fprintf(f, "],\"displayTimeUnit\":\"ns\"}\n");
+
+    fclose(f);
+
+    GL_KOS_TRACE_HEAD = GL_KOS_TRACE_COUNT = 0;
+
+    return n;
+#else
+    (void)filename;
+
+    return 0;
+#endif
+}
@@ -0,0 +1,95 @@
+/* KallistiGL for KallistiOS ##version##
+
+   libgl/gl-trace.h
+
+   Hot-path trace points. Only built with GL_ENABLE_TRACE defined (make TRACE=true),
+   otherwise every macro here is empty.
+
+   GL_KOS_TRACE(name) times the rest of the enclosing scope.
+   GL_KOS_TRACE_BEGIN(t) / GL_KOS_TRACE_END(t, name) time a span inside a scope.
+
+   Events go to a ring of GL_KOS_TRACE_EVENTS entries, the oldest are overwritten.
+   glKosTraceDump() writes the ring as Chrome trace-event JSON.
+*/
+
+#ifndef GL_TRACE_H
+#define GL_TRACE_H
+
+#ifdef GL_ENABLE_TRACE
+
+#include <stdint.h>
+
+#define GL_KOS_TRACE_EVENTS 4096
+
+#ifdef __sh__
+
+/* SH4 performance counter 2, in elapsed time mode counting CPU cycles */
+#define GL_KOS_PMCR2      (*(volatile uint16_t *)0xff000088)
+#define GL_KOS_PMCTR2_HI  (*(volatile uint32_t *)0xff10000c)
+#define GL_KOS_PMCTR2_LO  (*(volatile uint32_t *)0xff100010)
+
+#define GL_KOS_PMCR_CLEAR 0x2000
+#define GL_KOS_PMCR_RUN   0xc000
+#define GL_KOS_PMCR_TIME  0x0023
+
+#define GL_KOS_TRACE_HZ   200000000ULL /* SH4 core clock */
+
+static inline uint64_t _glKosTraceClock() {
+    uint32_t hi, lo;
+
+    do {
+        hi = GL_KOS_PMCTR2_HI;
+        lo = GL_KOS_PMCTR2_LO;
+    }
+    while(hi != GL_KOS_PMCTR2_HI);
+
+    return ((uint64_t)(hi & 0xffff) << 32) | lo;
+}
+
+#else
+
+#include <time.h>
+
+#define GL_KOS_TRACE_HZ   1000000000ULL
+
+static inline uint64_t _glKosTraceClock() {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * GL_KOS_TRACE_HZ + ts.tv_nsec;
+}
+
+#endif
+
+typedef struct {
+    const char *name;
+    uint64_t    start;
+} GL_KOS_TRACE_SCOPE; /* Open trace point, closed when it goes out of scope */
+
+void _glKosTraceInit();
+void _glKosTraceEvent(const char *name, uint64_t start);
+
+static inline void _glKosTraceScopeEnd(GL_KOS_TRACE_SCOPE *scope) {
+    _glKosTraceEvent(scope->name, scope->start);
+}
+
+#define GL_KOS_TRACE_CAT(a, b) a##b
+#define GL_KOS_TRACE_VAR(line) GL_KOS_TRACE_CAT(__gl_kos_trace_, line)
+
+#define GL_KOS_TRACE(name) \
+    GL_KOS_TRACE_SCOPE GL_KOS_TRACE_VAR(__LINE__) \
+    __attribute__((cleanup(_glKosTraceScopeEnd))) = { name, _glKosTraceClock() }
+
+#define GL_KOS_TRACE_BEGIN(t)     uint64_t t = _glKosTraceClock()
+#define GL_KOS_TRACE_END(t, name) _glKosTraceEvent(name, t)
+
+#else
+
+#define GL_KOS_TRACE(name)
+#define GL_KOS_TRACE_BEGIN(t)
+#define GL_KOS_TRACE_END(t, name)
+
+#endif
+
+#endif
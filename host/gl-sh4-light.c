@@ -0,0 +1,87 @@
+/* KallistiGL for KallistiOS ##version##
+
+   libgl/host/gl-sh4-light.c
+
+   Host build C version of gl-sh4-light.S. It follows the assembly step by
+   step, so lighting results match the SH4 build.
+*/
+
+#include <GL/gl.h>
+#include "gl-api.h"
+#include "gl-light.h"
+
+static inline float _glKosHostRsqrt(float x) {
+    return 1.0f / sqrtf(x);
+}
+
+/* N dot H, with H = normalize(L + normalize(E - P)) */
+float _glKosSpecular(void *vertex6f, void *eyepos, void *Lvectorin) {
+    GLfloat *P = vertex6f, *N = P + 3, *E = eyepos, *L = Lvectorin;
+    GLfloat V[3], H[3], r;
+
+    V[0] = E[0] - P[0];
+    V[1] = E[1] - P[1];
+    V[2] = E[2] - P[2];
+
+    r = _glKosHostRsqrt(V[0] * V[0] + V[1] * V[1] + V[2] * V[2]);
+    V[0] *= r;
+    V[1] *= r;
+    V[2] *= r;
+
+    H[0] = L[0] + V[0];
+    H[1] = L[1] + V[1];
+    H[2] = L[2] + V[2];
+
+    r = _glKosHostRsqrt(H[0] * H[0] + H[1] * H[1] + H[2] * H[2]);
+    H[0] *= r;
+    H[1] *= r;
+    H[2] *= r;
+
+    return N[0] * H[0] + N[1] * H[1] + N[2] * H[2];
+}
+
+/* Writes the normalized L vector and (N dot L) * attenuation to Lvectorout.
+   Returns 0 when the vertex is outside of a spot light, or faces away. */
+int _glKosSpotlight(void *lightin, void *vertex6f, void *Lvectorout) {
+    glLight *light = lightin;
+    GLfloat *P = vertex6f, *N = P + 3, *out = Lvectorout;
+    GLfloat L[3], D, NdotL, r;
+
+    if(light->Pos[3] > 0.0f) { /* Spot light */
+        GLfloat S[3];
+
+        S[0] = P[0] - light->Pos[0];
+        S[1] = P[1] - light->Pos[1];
+        S[2] = P[2] - light->Pos[2];
+
+        r = _glKosHostRsqrt(S[0] * S[0] + S[1] * S[1] + S[2] * S[2]);
+
+        if(S[0] * r * light->Dir[0] + S[1] * r * light->Dir[1]
+                + S[2] * r * light->Dir[2] > light->CutOff)
+            return 0;
+    }
+
+    L[0] = light->Pos[0] - P[0];
+    L[1] = light->Pos[1] - P[1];
+    L[2] = light->Pos[2] - P[2];
+
+    D = _glKosHostRsqrt(L[0] * L[0] + L[1] * L[1] + L[2] * L[2]);
+    L[0] *= D;
+    L[1] *= D;
+    L[2] *= D;
+
+    if(!(D > 0.0f))
+        return 0;
+
+    NdotL = N[0] * L[0] + N[1] * L[1] + N[2] * L[2];
+
+    if(!(NdotL > 0.0f))
+        return 0;
+
+    out[0] = L[0];
+    out[1] = L[1];
+    out[2] = L[2];
+    out[3] = NdotL / (light->Kc + light->Kl * D + light->Kq * D * D);
+
+    return 1;
+}
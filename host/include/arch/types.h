@@ -0,0 +1,30 @@
+/* KallistiGL for KallistiOS ##version##
+
+   libgl/host/include/arch/types.h
+
+   Host build stand-in for the KOS fixed size types.
+*/
+
+#ifndef __ARCH_TYPES_H
+#define __ARCH_TYPES_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef uint8_t  uint8;
+typedef uint16_t uint16;
+typedef uint32_t uint32;
+typedef uint64_t uint64;
+
+typedef int8_t   int8;
+typedef int16_t  int16;
+typedef int32_t  int32;
+typedef int64_t  int64;
+
+typedef volatile uint8  vuint8;
+typedef volatile uint16 vuint16;
+typedef volatile uint32 vuint32;
+
+typedef uintptr_t ptr_t;
+
+#endif
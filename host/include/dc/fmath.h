@@ -0,0 +1,27 @@
+/* KallistiGL for KallistiOS ##version##
+
+   libgl/host/include/dc/fmath.h
+
+   Host build stand-in for the SH4 fast math macros, using libm.
+*/
+
+#ifndef __DC_FMATH_H
+#define __DC_FMATH_H
+
+#include <math.h>
+
+#define F_PI 3.1415926f
+
+#define fsin(x)   sinf(x)
+#define fcos(x)   cosf(x)
+#define ftan(x)   tanf(x)
+#define fsqrt(x)  sqrtf(x)
+#define frsqrt(x) (1.0f / sqrtf(x))
+
+#define fipr(x, y, z, w, a, b, c, d) \
+    ((x) * (a) + (y) * (b) + (z) * (c) + (w) * (d))
+
+#define fipr_magnitude_sqr(x, y, z, w) \
+    ((x) * (x) + (y) * (y) + (z) * (z) + (w) * (w))
+
+#endif
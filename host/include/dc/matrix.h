@@ -0,0 +1,108 @@
+/* KallistiGL for KallistiOS ##version##
+
+   libgl/host/include/dc/matrix.h
+
+   Host build stand-in for the SH4 matrix unit. XMTRX is a plain matrix,
+   and the transform macros do in C what ftrv does on the SH4: the matrix
+   is column major, so v' = XMTRX * v with matrix[i] being column i.
+*/
+
+#ifndef __DC_MATRIX_H
+#define __DC_MATRIX_H
+
+#include <sys/cdefs.h>
+#include <arch/types.h>
+
+__BEGIN_DECLS
+
+typedef float matrix_t[4][4];
+
+typedef struct vectorstr {
+    float x, y, z, w;
+} vector_t;
+
+typedef vector_t point_t;
+
+extern matrix_t mat_host_xmtrx; /* Stand-in for the SH4 XMTRX register bank */
+
+void mat_store(matrix_t *out);
+void mat_load(matrix_t *out);
+void mat_identity(void);
+void mat_apply(matrix_t *src);
+void mat_transform(vector_t *invecs, vector_t *outvecs, int veccnt, int vecskip);
+void mat_transform_sq(void *input, void *output, int veccnt);
+
+/* ftrv XMTRX, fv */
+static inline void mat_host_ftrv(float *x, float *y, float *z, float *w) {
+    const float vx = *x, vy = *y, vz = *z, vw = *w;
+
+    *x = mat_host_xmtrx[0][0] * vx + mat_host_xmtrx[1][0] * vy + mat_host_xmtrx[2][0] * vz + mat_host_xmtrx[3][0] * vw;
+    *y = mat_host_xmtrx[0][1] * vx + mat_host_xmtrx[1][1] * vy + mat_host_xmtrx[2][1] * vz + mat_host_xmtrx[3][1] * vw;
+    *z = mat_host_xmtrx[0][2] * vx + mat_host_xmtrx[1][2] * vy + mat_host_xmtrx[2][2] * vz + mat_host_xmtrx[3][2] * vw;
+    *w = mat_host_xmtrx[0][3] * vx + mat_host_xmtrx[1][3] * vy + mat_host_xmtrx[2][3] * vz + mat_host_xmtrx[3][3] * vw;
+}
+
+/* Transform a point and divide by w. z is replaced by 1/w, as on the SH4. */
+#define mat_trans_single(x, y, z) { \
+        float __x = (x), __y = (y), __z = (z), __w = 1.0f; \
+        mat_host_ftrv(&__x, &__y, &__z, &__w); \
+        __w = 1.0f / __w; \
+        x = __x * __w; \
+        y = __y * __w; \
+        z = __w; \
+    }
+
+#define mat_trans_single3_nomod(x, y, z, x2, y2, z2) { \
+        float __x = (x), __y = (y), __z = (z), __w = 1.0f; \
+        mat_host_ftrv(&__x, &__y, &__z, &__w); \
+        __w = 1.0f / __w; \
+        x2 = __x * __w; \
+        y2 = __y * __w; \
+        z2 = __w; \
+    }
+
+#define mat_trans_single3_nodiv(x, y, z) { \
+        float __x = (x), __y = (y), __z = (z), __w = 1.0f; \
+        mat_host_ftrv(&__x, &__y, &__z, &__w); \
+        x = __x; \
+        y = __y; \
+        z = __z; \
+    }
+
+#define mat_trans_single3_nodiv_nomod(x, y, z, x2, y2, z2) { \
+        float __x = (x), __y = (y), __z = (z), __w = 1.0f; \
+        mat_host_ftrv(&__x, &__y, &__z, &__w); \
+        x2 = __x; \
+        y2 = __y; \
+        z2 = __z; \
+    }
+
+#define mat_trans_single4(x, y, z, w) { \
+        float __x = (x), __y = (y), __z = (z), __w = (w); \
+        mat_host_ftrv(&__x, &__y, &__z, &__w); \
+        __w = 1.0f / __w; \
+        x = __x * __w; \
+        y = __y * __w; \
+        z = __z * __w; \
+        w = __w; \
+    }
+
+#define mat_trans_normal3(x, y, z) { \
+        float __x = (x), __y = (y), __z = (z), __w = 0.0f; \
+        mat_host_ftrv(&__x, &__y, &__z, &__w); \
+        x = __x; \
+        y = __y; \
+        z = __z; \
+    }
+
+#define mat_trans_normal3_nomod(x, y, z, x2, y2, z2) { \
+        float __x = (x), __y = (y), __z = (z), __w = 0.0f; \
+        mat_host_ftrv(&__x, &__y, &__z, &__w); \
+        x2 = __x; \
+        y2 = __y; \
+        z2 = __z; \
+    }
+
+__END_DECLS
+
+#endif
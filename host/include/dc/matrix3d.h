@@ -0,0 +1,26 @@
+/* KallistiGL for KallistiOS ##version##
+
+   libgl/host/include/dc/matrix3d.h
+
+   Host build stand-in for the KOS 3D matrix helpers. Each one multiplies
+   XMTRX by the matching transform, as KOS does.
+*/
+
+#ifndef __DC_MATRIX3D_H
+#define __DC_MATRIX3D_H
+
+#include <sys/cdefs.h>
+#include <dc/matrix.h>
+
+__BEGIN_DECLS
+
+void mat_rotate_x(float r);
+void mat_rotate_y(float r);
+void mat_rotate_z(float r);
+void mat_rotate(float xr, float yr, float zr);
+void mat_translate(float x, float y, float z);
+void mat_scale(float x, float y, float z);
+
+__END_DECLS
+
+#endif
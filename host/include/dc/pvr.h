@@ -0,0 +1,382 @@
+/* KallistiGL for KallistiOS ##version##
+
+   libgl/host/include/dc/pvr.h
+
+   Host build stand-in for the KOS PowerVR interface. Types, constants and
+   header bit layouts match KOS, so compiled polygon headers are bit exact.
+
+   Instead of driving the TA, the stand-in records each scene: the 32 byte
+   TA stream of every list, the background color and the render target.
+   Texture memory is a plain 8MB VRAM image. See the pvr_host_* functions
+   at the end of this file.
+*/
+
+#ifndef __DC_PVR_H
+#define __DC_PVR_H
+
+#include <sys/cdefs.h>
+#include <arch/types.h>
+#include <dc/sq.h>
+
+__BEGIN_DECLS
+
+typedef void *pvr_ptr_t;
+typedef uint32 pvr_list_t;
+
+typedef struct {
+    int list_type;
+    struct {
+        int alpha;
+        int shading;
+        int fog_type;
+        int culling;
+        int color_clamp;
+        int clip_mode;
+        int modifier_mode;
+        int specular;
+        int alpha2;
+        int fog_type2;
+        int color_clamp2;
+    } gen;
+    struct {
+        int src;
+        int dst;
+        int src_enable;
+        int dst_enable;
+        int src2;
+        int dst2;
+        int src_enable2;
+        int dst_enable2;
+    } blend;
+    struct {
+        int color;
+        int uv;
+        int modifier;
+    } fmt;
+    struct {
+        int comparison;
+        int write;
+    } depth;
+    struct {
+        int enable;
+        int filter;
+        int mipmap;
+        int mipmap_bias;
+        int uv_flip;
+        int uv_clamp;
+        int alpha;
+        int env;
+        int width;
+        int height;
+        int format;
+        pvr_ptr_t base;
+    } txr, txr2;
+} pvr_poly_cxt_t;
+
+typedef struct {
+    uint32 cmd;
+    uint32 mode1, mode2, mode3;
+    uint32 d1, d2, d3, d4;
+} pvr_poly_hdr_t;
+
+typedef struct {
+    uint32 flags;
+    float  x, y, z;
+    float  u, v;
+    uint32 argb, oargb;
+} pvr_vertex_t;
+
+#define PVR_LIST_OP_POLY        0
+#define PVR_LIST_OP_MOD         1
+#define PVR_LIST_TR_POLY        2
+#define PVR_LIST_TR_MOD         3
+#define PVR_LIST_PT_POLY        4
+
+#define PVR_SHADE_FLAT          0
+#define PVR_SHADE_GOURAUD       1
+
+#define PVR_DEPTHCMP_NEVER      0
+#define PVR_DEPTHCMP_LESS       1
+#define PVR_DEPTHCMP_EQUAL      2
+#define PVR_DEPTHCMP_LEQUAL     3
+#define PVR_DEPTHCMP_GREATER    4
+#define PVR_DEPTHCMP_NOTEQUAL   5
+#define PVR_DEPTHCMP_GEQUAL     6
+#define PVR_DEPTHCMP_ALWAYS     7
+
+#define PVR_CULLING_NONE        0
+#define PVR_CULLING_SMALL       1
+#define PVR_CULLING_CCW         2
+#define PVR_CULLING_CW          3
+
+#define PVR_DEPTHWRITE_ENABLE   0
+#define PVR_DEPTHWRITE_DISABLE  1
+
+#define PVR_TEXTURE_DISABLE     0
+#define PVR_TEXTURE_ENABLE      1
+
+#define PVR_BLEND_ZERO          0
+#define PVR_BLEND_ONE           1
+#define PVR_BLEND_DESTCOLOR     2
+#define PVR_BLEND_INVDESTCOLOR  3
+#define PVR_BLEND_SRCALPHA      4
+#define PVR_BLEND_INVSRCALPHA   5
+#define PVR_BLEND_DESTALPHA     6
+#define PVR_BLEND_INVDESTALPHA  7
+
+#define PVR_BLEND_DISABLE       0
+#define PVR_BLEND_ENABLE        1
+
+#define PVR_FOG_TABLE           0
+#define PVR_FOG_VERTEX          1
+#define PVR_FOG_DISABLE         2
+#define PVR_FOG_TABLE2          3
+
+#define PVR_USERCLIP_DISABLE    0
+#define PVR_USERCLIP_INSIDE     2
+#define PVR_USERCLIP_OUTSIDE    3
+
+#define PVR_CLRCLAMP_DISABLE    0
+#define PVR_CLRCLAMP_ENABLE     1
+
+#define PVR_SPECULAR_DISABLE    0
+#define PVR_SPECULAR_ENABLE     1
+
+#define PVR_ALPHA_DISABLE       0
+#define PVR_ALPHA_ENABLE        1
+
+#define PVR_TXRALPHA_ENABLE     0
+#define PVR_TXRALPHA_DISABLE    1
+
+#define PVR_UVFLIP_NONE         0
+#define PVR_UVFLIP_V            1
+#define PVR_UVFLIP_U            2
+#define PVR_UVFLIP_UV           3
+
+#define PVR_UVCLAMP_NONE        0
+#define PVR_UVCLAMP_V           1
+#define PVR_UVCLAMP_U           2
+#define PVR_UVCLAMP_UV          3
+
+#define PVR_FILTER_NONE         0
+#define PVR_FILTER_NEAREST      0
+#define PVR_FILTER_BILINEAR     2
+#define PVR_FILTER_TRILINEAR1   4
+#define PVR_FILTER_TRILINEAR2   6
+
+#define PVR_MIPBIAS_NORMAL      4
+
+#define PVR_TXRENV_REPLACE          0
+#define PVR_TXRENV_MODULATE         1
+#define PVR_TXRENV_DECAL            2
+#define PVR_TXRENV_MODULATEALPHA    3
+
+#define PVR_MIPMAP_DISABLE      0
+#define PVR_MIPMAP_ENABLE       1
+
+#define PVR_TXRFMT_NONE         0
+#define PVR_TXRFMT_VQ_DISABLE   (0 << 30)
+#define PVR_TXRFMT_VQ_ENABLE    (1 << 30)
+#define PVR_TXRFMT_ARGB1555     (0 << 27)
+#define PVR_TXRFMT_RGB565       (1 << 27)
+#define PVR_TXRFMT_ARGB4444     (2 << 27)
+#define PVR_TXRFMT_YUV422       (3 << 27)
+#define PVR_TXRFMT_BUMP         (4 << 27)
+#define PVR_TXRFMT_PAL4BPP      (5 << 27)
+#define PVR_TXRFMT_PAL8BPP      (6 << 27)
+#define PVR_TXRFMT_TWIDDLED     (0 << 26)
+#define PVR_TXRFMT_NONTWIDDLED  (1 << 26)
+#define PVR_TXRFMT_NOSTRIDE     (0 << 21)
+#define PVR_TXRFMT_STRIDE       (1 << 21)
+
+#define PVR_CLRFMT_ARGBPACKED       0
+#define PVR_CLRFMT_4FLOATS          1
+#define PVR_CLRFMT_INTENSITY        2
+#define PVR_CLRFMT_INTENSITY_PREV   3
+
+#define PVR_UVFMT_32BIT         0
+#define PVR_UVFMT_16BIT         1
+
+#define PVR_MODIFIER_DISABLE    0
+#define PVR_MODIFIER_ENABLE     1
+
+#define PVR_CMD_POLYHDR         0x80840000
+#define PVR_CMD_VERTEX          0xe0000000
+#define PVR_CMD_VERTEX_EOL      0xf0000000
+#define PVR_CMD_USERCLIP        0x20000000
+#define PVR_CMD_MODIFIER        0x80000000
+#define PVR_CMD_SPRITE          0xA0000000
+
+#define PVR_TA_CMD_TYPE_SHIFT           24
+#define PVR_TA_CMD_TYPE_MASK            (7 << PVR_TA_CMD_TYPE_SHIFT)
+#define PVR_TA_CMD_USERCLIP_SHIFT       16
+#define PVR_TA_CMD_USERCLIP_MASK        (3 << PVR_TA_CMD_USERCLIP_SHIFT)
+#define PVR_TA_CMD_CLRFMT_SHIFT         4
+#define PVR_TA_CMD_CLRFMT_MASK          (7 << PVR_TA_CMD_CLRFMT_SHIFT)
+#define PVR_TA_CMD_SPECULAR_SHIFT       2
+#define PVR_TA_CMD_SPECULAR_MASK        (1 << PVR_TA_CMD_SPECULAR_SHIFT)
+#define PVR_TA_CMD_SHADE_SHIFT          1
+#define PVR_TA_CMD_SHADE_MASK           (1 << PVR_TA_CMD_SHADE_SHIFT)
+#define PVR_TA_CMD_UVFMT_SHIFT          0
+#define PVR_TA_CMD_UVFMT_MASK           (1 << PVR_TA_CMD_UVFMT_SHIFT)
+#define PVR_TA_CMD_MODIFIER_SHIFT       7
+#define PVR_TA_CMD_MODIFIER_MASK        (1 << PVR_TA_CMD_MODIFIER_SHIFT)
+#define PVR_TA_CMD_MODIFIERMODE_SHIFT   6
+#define PVR_TA_CMD_MODIFIERMODE_MASK    (1 << PVR_TA_CMD_MODIFIERMODE_SHIFT)
+
+#define PVR_TA_PM1_DEPTHCMP_SHIFT       29
+#define PVR_TA_PM1_DEPTHCMP_MASK        (7 << PVR_TA_PM1_DEPTHCMP_SHIFT)
+#define PVR_TA_PM1_CULLING_SHIFT        27
+#define PVR_TA_PM1_CULLING_MASK         (3 << PVR_TA_PM1_CULLING_SHIFT)
+#define PVR_TA_PM1_DEPTHWRITE_SHIFT     26
+#define PVR_TA_PM1_DEPTHWRITE_MASK      (1 << PVR_TA_PM1_DEPTHWRITE_SHIFT)
+#define PVR_TA_PM1_TXRENABLE_SHIFT      25
+#define PVR_TA_PM1_TXRENABLE_MASK       (1 << PVR_TA_PM1_TXRENABLE_SHIFT)
+
+#define PVR_TA_PM2_SRCBLEND_SHIFT       29
+#define PVR_TA_PM2_SRCBLEND_MASK        (7u << PVR_TA_PM2_SRCBLEND_SHIFT)
+#define PVR_TA_PM2_DSTBLEND_SHIFT       26
+#define PVR_TA_PM2_DSTBLEND_MASK        (7 << PVR_TA_PM2_DSTBLEND_SHIFT)
+#define PVR_TA_PM2_SRCENABLE_SHIFT      25
+#define PVR_TA_PM2_SRCENABLE_MASK       (1 << PVR_TA_PM2_SRCENABLE_SHIFT)
+#define PVR_TA_PM2_DSTENABLE_SHIFT      24
+#define PVR_TA_PM2_DSTENABLE_MASK       (1 << PVR_TA_PM2_DSTENABLE_SHIFT)
+#define PVR_TA_PM2_FOG_SHIFT            22
+#define PVR_TA_PM2_FOG_MASK             (3 << PVR_TA_PM2_FOG_SHIFT)
+#define PVR_TA_PM2_CLAMP_SHIFT          21
+#define PVR_TA_PM2_CLAMP_MASK           (1 << PVR_TA_PM2_CLAMP_SHIFT)
+#define PVR_TA_PM2_ALPHA_SHIFT          20
+#define PVR_TA_PM2_ALPHA_MASK           (1 << PVR_TA_PM2_ALPHA_SHIFT)
+#define PVR_TA_PM2_TXRALPHA_SHIFT       19
+#define PVR_TA_PM2_TXRALPHA_MASK        (1 << PVR_TA_PM2_TXRALPHA_SHIFT)
+#define PVR_TA_PM2_UVFLIP_SHIFT         17
+#define PVR_TA_PM2_UVFLIP_MASK          (3 << PVR_TA_PM2_UVFLIP_SHIFT)
+#define PVR_TA_PM2_UVCLAMP_SHIFT        15
+#define PVR_TA_PM2_UVCLAMP_MASK         (3 << PVR_TA_PM2_UVCLAMP_SHIFT)
+#define PVR_TA_PM2_FILTER_SHIFT         12
+#define PVR_TA_PM2_FILTER_MASK          (7 << PVR_TA_PM2_FILTER_SHIFT)
+#define PVR_TA_PM2_MIPBIAS_SHIFT        8
+#define PVR_TA_PM2_MIPBIAS_MASK         (15 << PVR_TA_PM2_MIPBIAS_SHIFT)
+#define PVR_TA_PM2_TXRENV_SHIFT         6
+#define PVR_TA_PM2_TXRENV_MASK          (3 << PVR_TA_PM2_TXRENV_SHIFT)
+#define PVR_TA_PM2_USIZE_SHIFT          3
+#define PVR_TA_PM2_USIZE_MASK           (7 << PVR_TA_PM2_USIZE_SHIFT)
+#define PVR_TA_PM2_VSIZE_SHIFT          0
+#define PVR_TA_PM2_VSIZE_MASK           (7 << PVR_TA_PM2_VSIZE_SHIFT)
+
+#define PVR_TA_PM3_MIPMAP_SHIFT         31
+#define PVR_TA_PM3_MIPMAP_MASK          (1u << PVR_TA_PM3_MIPMAP_SHIFT)
+#define PVR_TA_PM3_TXRFMT_SHIFT         0
+#define PVR_TA_PM3_TXRFMT_MASK          0xffffffff
+
+#define PVR_PACK_COLOR(a, r, g, b) ( \
+    ( ((uint32)(uint8)( a * 255 ) ) << 24 ) | \
+    ( ((uint32)(uint8)( r * 255 ) ) << 16 ) | \
+    ( ((uint32)(uint8)( g * 255 ) ) << 8 ) | \
+    ( ((uint32)(uint8)( b * 255 ) ) << 0 ) )
+
+#define PVR_BINSIZE_0   0
+#define PVR_BINSIZE_8   8
+#define PVR_BINSIZE_16  16
+#define PVR_BINSIZE_32  32
+
+typedef struct {
+    int opb_sizes[5];
+    int vertex_buf_size;
+    int dma_enabled;
+    int fsaa_enabled;
+    int autosort_disabled;
+} pvr_init_params_t;
+
+#define PVR_DMA_VRAM64  0
+#define PVR_DMA_VRAM32  1
+#define PVR_DMA_TA      2
+
+typedef void (*pvr_dma_callback_t)(ptr_t data);
+
+/* PVR registers - the stand-in keeps them in pvr_host_regs */
+#define PVR_FOG_TABLE_COLOR     0x00b0
+#define PVR_FOG_VERTEX_COLOR    0x00b4
+#define PVR_FOG_DENSITY         0x00b8
+#define PVR_PT_ALPHA_REF        0x011c
+#define PVR_FOG_TABLE_BASE      0x0200
+
+#define PVR_HOST_REGS_SIZE      0x2000
+
+extern uint32 pvr_host_regs[PVR_HOST_REGS_SIZE / 4];
+
+#define PVR_GET(REG)        (pvr_host_regs[(REG) / 4])
+#define PVR_SET(REG, VALUE) (pvr_host_regs[(REG) / 4] = (VALUE))
+
+int pvr_init(pvr_init_params_t *params);
+int pvr_init_defaults(void);
+int pvr_shutdown(void);
+int pvr_wait_ready(void);
+int pvr_check_ready(void);
+int pvr_scene_begin(void);
+int pvr_scene_begin_txr(pvr_ptr_t txr, uint32 *rx, uint32 *ry);
+int pvr_scene_finish(void);
+int pvr_list_begin(pvr_list_t list);
+int pvr_list_finish(void);
+int pvr_prim(void *data, int size);
+void pvr_set_bg_color(float r, float g, float b);
+pvr_ptr_t pvr_mem_malloc(size_t size);
+void pvr_mem_free(pvr_ptr_t chunk);
+uint32 pvr_mem_available(void);
+int pvr_dma_transfer(void *src, uint32 dest, uint32 count, int type,
+                     int block, pvr_dma_callback_t callback, ptr_t cbdata);
+int pvr_dma_ready(void);
+
+void pvr_poly_compile(pvr_poly_hdr_t *dst, pvr_poly_cxt_t *src);
+void pvr_poly_cxt_col(pvr_poly_cxt_t *dst, pvr_list_t list);
+void pvr_poly_cxt_txr(pvr_poly_cxt_t *dst, pvr_list_t list, int textureformat,
+                      int tw, int th, pvr_ptr_t textureaddr, int filtering);
+
+void pvr_fog_table_color(float a, float r, float g, float b);
+void pvr_fog_table_custom(float tbl1[]);
+void pvr_fog_table_linear(float start, float end);
+void pvr_fog_table_exp(float density);
+void pvr_fog_table_exp2(float density);
+
+/* Host stand-in extensions */
+
+#define PVR_HOST_LISTS      5
+#define PVR_HOST_VRAM_SIZE  (8 * 1024 * 1024)
+
+typedef struct {
+    const uint8 *list[PVR_HOST_LISTS];       /* TA stream of each list, in submission order */
+    uint32       list_bytes[PVR_HOST_LISTS];
+    uint32       stray_bytes;                /* TA writes made while no list was open */
+    float        bg_color[3];
+    uint32       pt_alpha_ref;               /* PVR_PT_ALPHA_REF when the scene finished */
+    pvr_ptr_t    target;                     /* Render-to-texture target, NULL for the screen */
+    uint32       target_width, target_height;
+} pvr_host_scene_t;
+
+/* Store queue burst to the TA: n 32 byte commands, appended to the open list */
+void pvr_host_ta_submit(const void *src, int n);
+
+/* Simulated render time: after each pvr_scene_finish() the PVR stays busy for
+   usecs microseconds, so pvr_check_ready() fails and pvr_wait_ready() blocks
+   until it is done. 0, the default, renders every scene instantly. */
+void pvr_host_render_time(uint32 usecs);
+
+/* Added to the render time: nsecs_per_kb nanoseconds per KB of the scene's TA
+   stream, so heavier scenes keep the PVR busy longer. 0 by default. */
+void pvr_host_render_cost(uint32 nsecs_per_kb);
+
+/* The last finished scene. Valid until the next pvr_scene_finish(). */
+const pvr_host_scene_t *pvr_host_last_scene(void);
+uint32 pvr_host_scene_count(void);
+
+/* The VRAM image that pvr_mem_malloc() hands out, PVR_HOST_VRAM_SIZE bytes */
+uint8 *pvr_host_vram(void);
+
+/* Reference rasterizer: draws a recorded scene the way the PVR would, into
+   width x height pixels of 0xAARRGGBB. A scene rendered to a texture is also
+   written to its target in VRAM, as RGB565, for later scenes to sample. */
+void pvr_host_render(const pvr_host_scene_t *scene, uint32 *argb, uint32 width, uint32 height);
+
+__END_DECLS
+
+#endif
@@ -0,0 +1,30 @@
+/* KallistiGL for KallistiOS ##version##
+
+   libgl/host/include/dc/sq.h
+
+   Host build stand-in for the SH4 store queues. The queue address control
+   registers are plain variables, and sq_cpy() writes to the recorded VRAM.
+*/
+
+#ifndef __DC_SQ_H
+#define __DC_SQ_H
+
+#include <sys/cdefs.h>
+#include <arch/types.h>
+
+__BEGIN_DECLS
+
+extern volatile uint32 sq_host_qacr[2];
+
+#define QACR0 (sq_host_qacr[0])
+#define QACR1 (sq_host_qacr[1])
+
+void *sq_cpy(void *dest, const void *src, int n);
+void *sq_set(void *dest, uint32 c, int n);
+void *sq_set16(void *dest, uint32 c, int n);
+void *sq_set32(void *dest, uint32 c, int n);
+void  sq_clr(void *dest, int n);
+
+__END_DECLS
+
+#endif
@@ -0,0 +1,40 @@
+/* KallistiGL for KallistiOS ##version##
+
+   libgl/host/include/dc/vec3f.h
+
+   Host build stand-in for the KOS 3 float vector macros.
+*/
+
+#ifndef __DC_VEC3F_H
+#define __DC_VEC3F_H
+
+#include <dc/fmath.h>
+
+#define vec3f_dot(x1, y1, z1, x2, y2, z2, w) { \
+        w = (x1) * (x2) + (y1) * (y2) + (z1) * (z2); \
+    }
+
+#define vec3f_length(x, y, z, w) { \
+        w = fsqrt((x) * (x) + (y) * (y) + (z) * (z)); \
+    }
+
+#define vec3f_distance(x1, y1, z1, x2, y2, z2, w) { \
+        float __dx = (x2) - (x1), __dy = (y2) - (y1), __dz = (z2) - (z1); \
+        w = fsqrt(__dx * __dx + __dy * __dy + __dz * __dz); \
+    }
+
+#define vec3f_normalize(x, y, z) { \
+        float __l = frsqrt((x) * (x) + (y) * (y) + (z) * (z)); \
+        x *= __l; \
+        y *= __l; \
+        z *= __l; \
+    }
+
+#define vec3f_sub_normalize(x1, y1, z1, x2, y2, z2, x3, y3, z3) { \
+        x3 = (x1) - (x2); \
+        y3 = (y1) - (y2); \
+        z3 = (z1) - (z2); \
+        vec3f_normalize(x3, y3, z3); \
+    }
+
+#endif
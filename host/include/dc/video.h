@@ -0,0 +1,36 @@
+/* KallistiGL for KallistiOS ##version##
+
+   libgl/host/include/dc/video.h
+
+   Host build stand-in for the KOS video mode. The stand-in always runs a
+   640x480 RGB565 mode.
+*/
+
+#ifndef __DC_VIDEO_H
+#define __DC_VIDEO_H
+
+#include <sys/cdefs.h>
+#include <arch/types.h>
+
+__BEGIN_DECLS
+
+typedef struct {
+    int generic;
+    int width, height;
+    int flags;
+    int cable_type;
+    int pm;
+    int scanlines, clocks;
+    int bitmapx, bitmapy;
+    int scanint1, scanint2;
+    int borderx1, borderx2;
+    int bordery1, bordery2;
+    int fb_curr, fb_count;
+    uint32 fb_base[4];
+} vid_mode_t;
+
+extern vid_mode_t *vid_mode;
+
+__END_DECLS
+
+#endif
@@ -0,0 +1,141 @@
+/* KallistiGL for KallistiOS ##version##
+
+   libgl/host/matrix.c
+
+   Host build stand-in for the KOS matrix routines, working on the plain
+   C XMTRX declared in dc/matrix.h.
+*/
+
+#include <string.h>
+
+#include <dc/fmath.h>
+#include <dc/matrix.h>
+#include <dc/matrix3d.h>
+
+matrix_t mat_host_xmtrx = {
+    { 1.0f, 0.0f, 0.0f, 0.0f },
+    { 0.0f, 1.0f, 0.0f, 0.0f },
+    { 0.0f, 0.0f, 1.0f, 0.0f },
+    { 0.0f, 0.0f, 0.0f, 1.0f }
+};
+
+void mat_store(matrix_t *out) {
+    memcpy(out, mat_host_xmtrx, sizeof(matrix_t));
+}
+
+void mat_load(matrix_t *out) {
+    memcpy(mat_host_xmtrx, out, sizeof(matrix_t));
+}
+
+void mat_identity(void) {
+    int i, j;
+
+    for(i = 0; i < 4; i++)
+        for(j = 0; j < 4; j++)
+            mat_host_xmtrx[i][j] = i == j ? 1.0f : 0.0f;
+}
+
+/* XMTRX = XMTRX * src */
+void mat_apply(matrix_t *src) {
+    matrix_t m;
+    int i;
+
+    memcpy(m, src, sizeof(matrix_t));
+
+    for(i = 0; i < 4; i++)
+        mat_host_ftrv(&m[i][0], &m[i][1], &m[i][2], &m[i][3]);
+
+    memcpy(mat_host_xmtrx, m, sizeof(matrix_t));
+}
+
+void mat_transform(vector_t *invecs, vector_t *outvecs, int veccnt, int vecskip) {
+    char *src = (char *)invecs, *dst = (char *)outvecs;
+
+    while(veccnt--) {
+        vector_t v = *(vector_t *)src;
+
+        mat_trans_single4(v.x, v.y, v.z, v.w);
+
+        *(vector_t *)dst = v;
+
+        src += sizeof(vector_t) + vecskip;
+        dst += sizeof(vector_t) + vecskip;
+    }
+}
+
+void mat_transform_sq(void *input, void *output, int veccnt) {
+    float *src = input, *dst = output;
+
+    while(veccnt--) {
+        dst[0] = src[0];
+        dst[1] = src[1];
+        dst[2] = src[2];
+        dst[3] = src[3];
+
+        mat_trans_single4(dst[0], dst[1], dst[2], dst[3]);
+
+        src += 8;
+        dst += 8;
+    }
+}
+
+void mat_rotate_x(float r) {
+    matrix_t m = {
+        { 1.0f,     0.0f,    0.0f, 0.0f },
+        { 0.0f,  fcos(r), fsin(r), 0.0f },
+        { 0.0f, -fsin(r), fcos(r), 0.0f },
+        { 0.0f,     0.0f,    0.0f, 1.0f }
+    };
+
+    mat_apply(&m);
+}
+
+void mat_rotate_y(float r) {
+    matrix_t m = {
+        { fcos(r), 0.0f, -fsin(r), 0.0f },
+        {    0.0f, 1.0f,     0.0f, 0.0f },
+        { fsin(r), 0.0f,  fcos(r), 0.0f },
+        {    0.0f, 0.0f,     0.0f, 1.0f }
+    };
+
+    mat_apply(&m);
+}
+
+void mat_rotate_z(float r) {
+    matrix_t m = {
+        {  fcos(r), fsin(r), 0.0f, 0.0f },
+        { -fsin(r), fcos(r), 0.0f, 0.0f },
+        {     0.0f,    0.0f, 1.0f, 0.0f },
+        {     0.0f,    0.0f, 0.0f, 1.0f }
+    };
+
+    mat_apply(&m);
+}
+
+void mat_rotate(float xr, float yr, float zr) {
+    mat_rotate_x(xr);
+    mat_rotate_y(yr);
+    mat_rotate_z(zr);
+}
+
+void mat_translate(float x, float y, float z) {
+    matrix_t m = {
+        { 1.0f, 0.0f, 0.0f, 0.0f },
+        { 0.0f, 1.0f, 0.0f, 0.0f },
+        { 0.0f, 0.0f, 1.0f, 0.0f },
+        {    x,    y,    z, 1.0f }
+    };
+
+    mat_apply(&m);
+}
+
+void mat_scale(float x, float y, float z) {
+    matrix_t m = {
+        {    x, 0.0f, 0.0f, 0.0f },
+        { 0.0f,    y, 0.0f, 0.0f },
+        { 0.0f, 0.0f,    z, 0.0f },
+        { 0.0f, 0.0f, 0.0f, 1.0f }
+    };
+
+    mat_apply(&m);
+}
@@ -0,0 +1,565 @@
+/* KallistiGL for KallistiOS ##version##
+
+   libgl/host/pvr.c
+
+   Host build stand-in for the KOS PowerVR driver, store queues and video.
+
+   Nothing is rendered. Every 32 byte command the library sends to the TA is
+   appended to the stream of the open list, and pvr_scene_finish() publishes
+   the scene for pvr_host_last_scene(). A scene takes no time to render unless
+   pvr_host_render_time() and pvr_host_render_cost() set one, fixed and per KB
+   of TA stream: the PVR is then busy for that long after each scene is
+   finished, and pvr_check_ready()/pvr_wait_ready() report it. Texture memory
+   is an 8MB VRAM image with a first-fit allocator, and sq_cpy() writes
+   straight into it.
+   host/raster.c can render a recorded scene when an image is wanted.
+*/
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <dc/pvr.h>
+#include <dc/sq.h>
+#include <dc/video.h>
+
+//===============================================================================//
+//== Video / Registers ==//
+
+static vid_mode_t PVR_HOST_MODE = {
+    .generic = 1, /* DM_640x480 */
+    .width = 640,
+    .height = 480,
+    .scanlines = 525,
+    .clocks = 858,
+    .fb_count = 1
+};
+
+vid_mode_t *vid_mode = &PVR_HOST_MODE;
+
+uint32 pvr_host_regs[PVR_HOST_REGS_SIZE / 4];
+
+volatile uint32 sq_host_qacr[2];
+
+//===============================================================================//
+//== VRAM ==//
+
+#define PVR_HOST_VRAM_ALIGN   32
+#define PVR_HOST_VRAM_BLOCKS  8192
+
+typedef struct {
+    uint32 offset;
+    uint32 size;
+} PVR_HOST_BLOCK; /* Allocated VRAM block */
+
+static uint8 PVR_HOST_VRAM[PVR_HOST_VRAM_SIZE] __attribute__((aligned(PVR_HOST_VRAM_ALIGN)));
+
+static PVR_HOST_BLOCK PVR_HOST_BLOCKS[PVR_HOST_VRAM_BLOCKS]; /* Sorted by offset */
+static uint32 PVR_HOST_BLOCK_COUNT = 0;
+
+pvr_ptr_t pvr_mem_malloc(size_t size) {
+    uint32 i, offset = 0;
+
+    size = (size + PVR_HOST_VRAM_ALIGN - 1) & ~(PVR_HOST_VRAM_ALIGN - 1);
+
+    if(PVR_HOST_BLOCK_COUNT == PVR_HOST_VRAM_BLOCKS)
+        return NULL;
+
+    /* First gap between allocated blocks that is large enough */
+    for(i = 0; i < PVR_HOST_BLOCK_COUNT; i++) {
+        if(PVR_HOST_BLOCKS[i].offset - offset >= size)
+            break;
+
+        offset = PVR_HOST_BLOCKS[i].offset + PVR_HOST_BLOCKS[i].size;
+    }
+
+    if(PVR_HOST_VRAM_SIZE - offset < size)
+        return NULL;
+
+    memmove(&PVR_HOST_BLOCKS[i + 1], &PVR_HOST_BLOCKS[i],
+            (PVR_HOST_BLOCK_COUNT - i) * sizeof(PVR_HOST_BLOCK));
+
+    PVR_HOST_BLOCKS[i].offset = offset;
+    PVR_HOST_BLOCKS[i].size = size;
+    ++PVR_HOST_BLOCK_COUNT;
+
+    return PVR_HOST_VRAM + offset;
+}
+
+void pvr_mem_free(pvr_ptr_t chunk) {
+    uint32 i, offset = (uint8 *)chunk - PVR_HOST_VRAM;
+
+    for(i = 0; i < PVR_HOST_BLOCK_COUNT; i++)
+        if(PVR_HOST_BLOCKS[i].offset == offset) {
+            --PVR_HOST_BLOCK_COUNT;
+            memmove(&PVR_HOST_BLOCKS[i], &PVR_HOST_BLOCKS[i + 1],
+                    (PVR_HOST_BLOCK_COUNT - i) * sizeof(PVR_HOST_BLOCK));
+            return;
+        }
+
+    fprintf(stderr, "pvr_mem_free: %p was not allocated\n", chunk);
+}
+
+uint32 pvr_mem_available(void) {
+    uint32 i, used = 0;
+
+    for(i = 0; i < PVR_HOST_BLOCK_COUNT; i++)
+        used += PVR_HOST_BLOCKS[i].size;
+
+    return PVR_HOST_VRAM_SIZE - used;
+}
+
+uint8 *pvr_host_vram(void) {
+    return PVR_HOST_VRAM;
+}
+
+//===============================================================================//
+//== Store Queues ==//
+
+void *sq_cpy(void *dest, const void *src, int n) {
+    return memcpy(dest, src, n);
+}
+
+void *sq_set(void *dest, uint32 c, int n) {
+    return memset(dest, c & 0xff, n);
+}
+
+void *sq_set16(void *dest, uint32 c, int n) {
+    uint16 *d = dest;
+
+    for(n /= 2; n--;)
+        *d++ = c;
+
+    return dest;
+}
+
+void *sq_set32(void *dest, uint32 c, int n) {
+    uint32 *d = dest;
+
+    for(n /= 4; n--;)
+        *d++ = c;
+
+    return dest;
+}
+
+void sq_clr(void *dest, int n) {
+    memset(dest, 0, n);
+}
+
+//===============================================================================//
+//== Scene Recording ==//
+
+typedef struct {
+    uint8 *data;
+    uint32 bytes;
+    uint32 size;
+} PVR_HOST_STREAM; /* Growable TA stream of one list */
+
+static PVR_HOST_STREAM PVR_HOST_LIST[2][PVR_HOST_LISTS]; /* Double buffered by scene */
+static pvr_host_scene_t PVR_HOST_SCENE[2];
+static uint32 PVR_HOST_REC = 0;          /* Index of the scene being recorded */
+static uint32 PVR_HOST_SCENES = 0;       /* Scenes finished since pvr_init() */
+static int    PVR_HOST_OPEN_LIST = -1;   /* List open for TA writes */
+static int    PVR_HOST_IN_SCENE = 0;
+
+static float  PVR_HOST_BG_COLOR[3];
+
+static double PVR_HOST_RENDER_TIME = 0.0; /* Seconds the PVR takes per scene */
+static double PVR_HOST_RENDER_COST = 0.0; /* And per byte of its TA stream */
+static double PVR_HOST_READY_AT = 0.0;    /* When the last finished scene is rendered */
+
+static void pvr_host_stream_write(PVR_HOST_STREAM *s, const void *src, uint32 bytes) {
+    if(s->bytes + bytes > s->size) {
+        uint32 size = s->size ? s->size : 64 * 1024;
+
+        while(size < s->bytes + bytes)
+            size *= 2;
+
+        s->data = realloc(s->data, size);
+
+        if(!s->data) {
+            fprintf(stderr, "pvr_host: out of memory recording the TA stream\n");
+            abort();
+        }
+
+        s->size = size;
+    }
+
+    memcpy(s->data + s->bytes, src, bytes);
+    s->bytes += bytes;
+}
+
+static void pvr_host_ta_write(const void *src, uint32 bytes) {
+    if(PVR_HOST_OPEN_LIST < 0) {
+        PVR_HOST_SCENE[PVR_HOST_REC].stray_bytes += bytes;
+        return;
+    }
+
+    pvr_host_stream_write(&PVR_HOST_LIST[PVR_HOST_REC][PVR_HOST_OPEN_LIST], src, bytes);
+}
+
+void pvr_host_ta_submit(const void *src, int n) {
+    pvr_host_ta_write(src, n * 32);
+}
+
+const pvr_host_scene_t *pvr_host_last_scene(void) {
+    return PVR_HOST_SCENES ? &PVR_HOST_SCENE[PVR_HOST_REC ^ 1] : NULL;
+}
+
+uint32 pvr_host_scene_count(void) {
+    return PVR_HOST_SCENES;
+}
+
+//===============================================================================//
+//== PVR Driver ==//
+
+int pvr_init(pvr_init_params_t *params) {
+    (void)params;
+
+    memset(pvr_host_regs, 0, sizeof(pvr_host_regs));
+
+    PVR_HOST_BLOCK_COUNT = 0;
+    PVR_HOST_SCENES = 0;
+    PVR_HOST_OPEN_LIST = -1;
+    PVR_HOST_IN_SCENE = 0;
+    PVR_HOST_READY_AT = 0.0;
+
+    memset(PVR_HOST_SCENE, 0, sizeof(PVR_HOST_SCENE));
+
+    return 0;
+}
+
+int pvr_init_defaults(void) {
+    pvr_init_params_t params = {
+        { PVR_BINSIZE_16, PVR_BINSIZE_0, PVR_BINSIZE_16, PVR_BINSIZE_0, PVR_BINSIZE_0 },
+        512 * 1024, 0, 0, 0
+    };
+
+    return pvr_init(&params);
+}
+
+int pvr_shutdown(void) {
+    int i, j;
+
+    for(i = 0; i < 2; i++)
+        for(j = 0; j < PVR_HOST_LISTS; j++) {
+            free(PVR_HOST_LIST[i][j].data);
+            memset(&PVR_HOST_LIST[i][j], 0, sizeof(PVR_HOST_STREAM));
+        }
+
+    return 0;
+}
+
+static double pvr_host_now(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+void pvr_host_render_time(uint32 usecs) {
+    PVR_HOST_RENDER_TIME = usecs * 1e-6;
+}
+
+void pvr_host_render_cost(uint32 nsecs_per_kb) {
+    PVR_HOST_RENDER_COST = nsecs_per_kb * 1e-9 / 1024.0;
+}
+
+/* The PVR is ready for the next scene once the last one has rendered */
+int pvr_wait_ready(void) {
+    double wait = PVR_HOST_READY_AT - pvr_host_now();
+    struct timespec ts;
+
+    if(wait > 0.0) {
+        ts.tv_sec = (time_t)wait;
+        ts.tv_nsec = (long)((wait - ts.tv_sec) * 1e9);
+
+        while(nanosleep(&ts, &ts));
+    }
+
+    return 0;
+}
+
+int pvr_check_ready(void) {
+    return pvr_host_now() < PVR_HOST_READY_AT ? -1 : 0;
+}
+
+int pvr_scene_begin(void) {
+    return pvr_scene_begin_txr(NULL, NULL, NULL);
+}
+
+int pvr_scene_begin_txr(pvr_ptr_t txr, uint32 *rx, uint32 *ry) {
+    pvr_host_scene_t *scene = &PVR_HOST_SCENE[PVR_HOST_REC];
+    int i;
+
+    if(PVR_HOST_IN_SCENE)
+        fprintf(stderr, "pvr_scene_begin: previous scene was not finished\n");
+
+    if(pvr_check_ready())
+        fprintf(stderr, "pvr_scene_begin: previous scene is still rendering\n");
+
+    for(i = 0; i < PVR_HOST_LISTS; i++)
+        PVR_HOST_LIST[PVR_HOST_REC][i].bytes = 0;
+
+    memset(scene, 0, sizeof(pvr_host_scene_t));
+
+    scene->target = txr;
+    scene->target_width = rx ? *rx : 0;
+    scene->target_height = ry ? *ry : 0;
+
+    PVR_HOST_IN_SCENE = 1;
+
+    return 0;
+}
+
+int pvr_scene_finish(void) {
+    pvr_host_scene_t *scene = &PVR_HOST_SCENE[PVR_HOST_REC];
+    double render = PVR_HOST_RENDER_TIME;
+    int i;
+
+    if(PVR_HOST_OPEN_LIST >= 0)
+        pvr_list_finish();
+
+    for(i = 0; i < PVR_HOST_LISTS; i++) {
+        scene->list[i] = PVR_HOST_LIST[PVR_HOST_REC][i].data;
+        scene->list_bytes[i] = PVR_HOST_LIST[PVR_HOST_REC][i].bytes;
+        render += scene->list_bytes[i] * PVR_HOST_RENDER_COST;
+    }
+
+    scene->bg_color[0] = PVR_HOST_BG_COLOR[0];
+    scene->bg_color[1] = PVR_HOST_BG_COLOR[1];
+    scene->bg_color[2] = PVR_HOST_BG_COLOR[2];
+    scene->pt_alpha_ref = PVR_GET(PVR_PT_ALPHA_REF);
+
+    PVR_HOST_REC ^= 1;
+    ++PVR_HOST_SCENES;
+    PVR_HOST_IN_SCENE = 0;
+
+    PVR_HOST_READY_AT = pvr_host_now() + render;
+
+    return 0;
+}
+
+int pvr_list_begin(pvr_list_t list) {
+    if(list >= PVR_HOST_LISTS)
+        return -1;
+
+    if(!PVR_HOST_IN_SCENE)
+        fprintf(stderr, "pvr_list_begin: no scene is open\n");
+
+    PVR_HOST_OPEN_LIST = list;
+
+    return 0;
+}
+
+int pvr_list_finish(void) {
+    PVR_HOST_OPEN_LIST = -1;
+
+    return 0;
+}
+
+int pvr_prim(void *data, int size) {
+    pvr_host_ta_write(data, size);
+
+    return 0;
+}
+
+void pvr_set_bg_color(float r, float g, float b) {
+    PVR_HOST_BG_COLOR[0] = r;
+    PVR_HOST_BG_COLOR[1] = g;
+    PVR_HOST_BG_COLOR[2] = b;
+}
+
+int pvr_dma_transfer(void *src, uint32 dest, uint32 count, int type,
+                     int block, pvr_dma_callback_t callback, ptr_t cbdata) {
+    (void)block;
+
+    if(type == PVR_DMA_TA)
+        pvr_host_ta_write(src, count);
+    else if(dest < PVR_HOST_VRAM_SIZE && count <= PVR_HOST_VRAM_SIZE - dest)
+        memcpy(PVR_HOST_VRAM + dest, src, count);
+
+    if(callback)
+        callback(cbdata);
+
+    return 0;
+}
+
+int pvr_dma_ready(void) {
+    return 1;
+}
+
+//===============================================================================//
+//== Polygon Headers ==//
+
+void pvr_poly_cxt_col(pvr_poly_cxt_t *dst, pvr_list_t list) {
+    memset(dst, 0, sizeof(pvr_poly_cxt_t));
+
+    dst->list_type = list;
+    dst->fmt.color = PVR_CLRFMT_ARGBPACKED;
+    dst->fmt.uv = PVR_UVFMT_32BIT;
+    dst->gen.shading = PVR_SHADE_GOURAUD;
+    dst->depth.comparison = PVR_DEPTHCMP_GREATER;
+    dst->depth.write = PVR_DEPTHWRITE_ENABLE;
+    dst->gen.culling = PVR_CULLING_CCW;
+    dst->txr.enable = PVR_TEXTURE_DISABLE;
+
+    if(list == PVR_LIST_OP_POLY) {
+        dst->gen.alpha = PVR_ALPHA_DISABLE;
+        dst->blend.src = PVR_BLEND_ONE;
+        dst->blend.dst = PVR_BLEND_ZERO;
+    }
+    else {
+        dst->gen.alpha = PVR_ALPHA_ENABLE;
+        dst->blend.src = PVR_BLEND_SRCALPHA;
+        dst->blend.dst = PVR_BLEND_INVSRCALPHA;
+    }
+
+    dst->gen.fog_type = PVR_FOG_DISABLE;
+    dst->gen.color_clamp = PVR_CLRCLAMP_DISABLE;
+}
+
+void pvr_poly_cxt_txr(pvr_poly_cxt_t *dst, pvr_list_t list, int textureformat,
+                      int tw, int th, pvr_ptr_t textureaddr, int filtering) {
+    pvr_poly_cxt_col(dst, list);
+
+    dst->txr.enable = PVR_TEXTURE_ENABLE;
+    dst->txr.filter = filtering;
+    dst->txr.mipmap_bias = PVR_MIPBIAS_NORMAL;
+    dst->txr.alpha = list == PVR_LIST_OP_POLY ? PVR_TXRALPHA_DISABLE : PVR_TXRALPHA_ENABLE;
+    dst->txr.env = PVR_TXRENV_MODULATE;
+    dst->txr.width = tw;
+    dst->txr.height = th;
+    dst->txr.base = textureaddr;
+    dst->txr.format = textureformat;
+}
+
+static int pvr_host_txr_size(int size) {
+    int bits = 0;
+
+    while((8 << bits) < size && bits < 7)
+        ++bits;
+
+    if((8 << bits) != size)
+        fprintf(stderr, "pvr_poly_compile: invalid texture size %d\n", size);
+
+    return bits;
+}
+
+void pvr_poly_compile(pvr_poly_hdr_t *dst, pvr_poly_cxt_t *src) {
+    dst->cmd = PVR_CMD_POLYHDR;
+
+    if(src->txr.enable == PVR_TEXTURE_ENABLE)
+        dst->cmd |= 8;
+
+    dst->cmd |= (src->list_type << PVR_TA_CMD_TYPE_SHIFT) & PVR_TA_CMD_TYPE_MASK;
+    dst->cmd |= (src->fmt.color << PVR_TA_CMD_CLRFMT_SHIFT) & PVR_TA_CMD_CLRFMT_MASK;
+    dst->cmd |= (src->gen.shading << PVR_TA_CMD_SHADE_SHIFT) & PVR_TA_CMD_SHADE_MASK;
+    dst->cmd |= (src->fmt.uv << PVR_TA_CMD_UVFMT_SHIFT) & PVR_TA_CMD_UVFMT_MASK;
+    dst->cmd |= (src->gen.clip_mode << PVR_TA_CMD_USERCLIP_SHIFT) & PVR_TA_CMD_USERCLIP_MASK;
+    dst->cmd |= (src->fmt.modifier << PVR_TA_CMD_MODIFIER_SHIFT) & PVR_TA_CMD_MODIFIER_MASK;
+    dst->cmd |= (src->gen.modifier_mode << PVR_TA_CMD_MODIFIERMODE_SHIFT) & PVR_TA_CMD_MODIFIERMODE_MASK;
+    dst->cmd |= (src->gen.specular << PVR_TA_CMD_SPECULAR_SHIFT) & PVR_TA_CMD_SPECULAR_MASK;
+
+    dst->mode1  = ((uint32)src->depth.comparison << PVR_TA_PM1_DEPTHCMP_SHIFT) & PVR_TA_PM1_DEPTHCMP_MASK;
+    dst->mode1 |= (src->gen.culling << PVR_TA_PM1_CULLING_SHIFT) & PVR_TA_PM1_CULLING_MASK;
+    dst->mode1 |= (src->depth.write << PVR_TA_PM1_DEPTHWRITE_SHIFT) & PVR_TA_PM1_DEPTHWRITE_MASK;
+    dst->mode1 |= (src->txr.enable << PVR_TA_PM1_TXRENABLE_SHIFT) & PVR_TA_PM1_TXRENABLE_MASK;
+
+    dst->mode2  = ((uint32)src->blend.src << PVR_TA_PM2_SRCBLEND_SHIFT) & PVR_TA_PM2_SRCBLEND_MASK;
+    dst->mode2 |= (src->blend.dst << PVR_TA_PM2_DSTBLEND_SHIFT) & PVR_TA_PM2_DSTBLEND_MASK;
+    dst->mode2 |= (src->blend.src_enable << PVR_TA_PM2_SRCENABLE_SHIFT) & PVR_TA_PM2_SRCENABLE_MASK;
+    dst->mode2 |= (src->blend.dst_enable << PVR_TA_PM2_DSTENABLE_SHIFT) & PVR_TA_PM2_DSTENABLE_MASK;
+    dst->mode2 |= (src->gen.fog_type << PVR_TA_PM2_FOG_SHIFT) & PVR_TA_PM2_FOG_MASK;
+    dst->mode2 |= (src->gen.color_clamp << PVR_TA_PM2_CLAMP_SHIFT) & PVR_TA_PM2_CLAMP_MASK;
+    dst->mode2 |= (src->gen.alpha << PVR_TA_PM2_ALPHA_SHIFT) & PVR_TA_PM2_ALPHA_MASK;
+
+    if(src->txr.enable == PVR_TEXTURE_DISABLE)
+        dst->mode3 = 0;
+    else {
+        dst->mode2 |= (src->txr.alpha << PVR_TA_PM2_TXRALPHA_SHIFT) & PVR_TA_PM2_TXRALPHA_MASK;
+        dst->mode2 |= (src->txr.uv_flip << PVR_TA_PM2_UVFLIP_SHIFT) & PVR_TA_PM2_UVFLIP_MASK;
+        dst->mode2 |= (src->txr.uv_clamp << PVR_TA_PM2_UVCLAMP_SHIFT) & PVR_TA_PM2_UVCLAMP_MASK;
+        dst->mode2 |= (src->txr.filter << PVR_TA_PM2_FILTER_SHIFT) & PVR_TA_PM2_FILTER_MASK;
+        dst->mode2 |= (src->txr.mipmap_bias << PVR_TA_PM2_MIPBIAS_SHIFT) & PVR_TA_PM2_MIPBIAS_MASK;
+        dst->mode2 |= (src->txr.env << PVR_TA_PM2_TXRENV_SHIFT) & PVR_TA_PM2_TXRENV_MASK;
+        dst->mode2 |= (pvr_host_txr_size(src->txr.width) << PVR_TA_PM2_USIZE_SHIFT) & PVR_TA_PM2_USIZE_MASK;
+        dst->mode2 |= (pvr_host_txr_size(src->txr.height) << PVR_TA_PM2_VSIZE_SHIFT) & PVR_TA_PM2_VSIZE_MASK;
+
+        dst->mode3  = ((uint32)src->txr.mipmap << PVR_TA_PM3_MIPMAP_SHIFT) & PVR_TA_PM3_MIPMAP_MASK;
+        dst->mode3 |= (src->txr.format << PVR_TA_PM3_TXRFMT_SHIFT) & PVR_TA_PM3_TXRFMT_MASK;
+
+        /* Texture address is the VRAM offset in 64 bit words */
+        dst->mode3 |= (((uint8 *)src->txr.base - PVR_HOST_VRAM) & 0x00fffff8) >> 3;
+    }
+
+    dst->d1 = dst->d2 = 0xffffffff;
+    dst->d3 = dst->d4 = 0xffffffff;
+}
+
+//===============================================================================//
+//== Fog Table ==//
+
+/* The table has 128 entries of two 8 bit fog factors each. Entry i covers a
+   depth of 2^(i / 16), which is how the stand-in approximates the hardware's
+   floating point 1/w lookup with the default fog density. */
+
+static inline float pvr_host_fog_depth(int i) {
+    return powf(2.0f, i / 16.0f);
+}
+
+void pvr_fog_table_custom(float tbl1[]) {
+    int i;
+
+    for(i = 0; i < 128; i++)
+        PVR_SET(PVR_FOG_TABLE_BASE + i * 4,
+                ((uint32)(tbl1[i] * 255.0f) << 8) | (uint32)(tbl1[i + 1] * 255.0f));
+}
+
+static void pvr_host_fog_table(float (*fog)(float depth, float a, float b), float a, float b) {
+    float table[129];
+    int i;
+
+    for(i = 0; i < 129; i++) {
+        float f = fog(pvr_host_fog_depth(i), a, b);
+
+        table[i] = f < 0.0f ? 0.0f : f > 1.0f ? 1.0f : f;
+    }
+
+    pvr_fog_table_custom(table);
+}
+
+static float pvr_host_fog_linear(float depth, float start, float end) {
+    return (depth - start) / (end - start);
+}
+
+static float pvr_host_fog_exp(float depth, float density, float unused) {
+    (void)unused;
+
+    return 1.0f - expf(-density * depth);
+}
+
+static float pvr_host_fog_exp2(float depth, float density, float unused) {
+    (void)unused;
+
+    return 1.0f - expf(-density * density * depth * depth);
+}
+
+void pvr_fog_table_color(float a, float r, float g, float b) {
+    PVR_SET(PVR_FOG_TABLE_COLOR, PVR_PACK_COLOR(a, r, g, b));
+}
+
+void pvr_fog_table_linear(float start, float end) {
+    pvr_host_fog_table(pvr_host_fog_linear, start, end);
+}
+
+void pvr_fog_table_exp(float density) {
+    pvr_host_fog_table(pvr_host_fog_exp, density, 0.0f);
+}
+
+void pvr_fog_table_exp2(float density) {
+    pvr_host_fog_table(pvr_host_fog_exp2, density, 0.0f);
+}
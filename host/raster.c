@@ -0,0 +1,758 @@
+/* KallistiGL for KallistiOS ##version##
+
+   libgl/host/raster.c
+
+   Reference rasterizer for the host build. pvr_host_render() draws a scene
+   the stand-in recorded, straight from its TA stream, the way the PVR does:
+   the polygons of each list are binned to 32x32 tiles, and each tile is
+   rendered in turn, OP list first, then PT, then TR, against a tile depth
+   buffer holding 1/w.
+
+   Covered: triangle strips with packed color, flat and gouraud shading,
+   specular offset color, point and bilinear filtering of twiddled,
+   non-twiddled and VQ textures with mipmaps, UV clamp and flip, the four
+   texture shading instructions, depth compare and write, culling, blending,
+   the punch-through alpha test and user clip tiles.
+
+   Not covered: modifier volumes, sprites, fog, floating point and intensity
+   colors, paletted, YUV and bump map texels, and the texture stride register.
+   Polygons and texels of those kinds are skipped or read as zero. The TR list
+   is drawn in submission order, as the PVR does with autosort disabled, and
+   trilinear filtering falls back to bilinear on the nearest mipmap level.
+*/
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <dc/pvr.h>
+
+#define PVR_HOST_TILE       32
+#define PVR_HOST_BG_DEPTH   0.0001f /* Depth of the KOS background plane */
+#define PVR_HOST_VQ_BOOK    2048    /* Bytes of VQ codebook ahead of the indices */
+#define PVR_HOST_CMD_TXR    (1 << 3) /* Textured bit of the polygon header cmd word */
+
+/* Attributes interpolated across a triangle, all perspective corrected */
+#define PVR_HOST_ATTR_U     0
+#define PVR_HOST_ATTR_V     1
+#define PVR_HOST_ATTR_COLOR 2       /* Base color, A R G B */
+#define PVR_HOST_ATTR_OFS   6       /* Offset color, R G B */
+#define PVR_HOST_ATTRS      9
+
+typedef struct {
+    float x, y, invw;
+    float attr[PVR_HOST_ATTRS];
+} PVR_HOST_VERT;
+
+typedef struct {
+    uint32 cmd, mode1, mode2, mode3;
+    uint32 list;
+    int    clip[4];             /* User clip tiles sx, sy, ex, ey, inclusive */
+} PVR_HOST_POLY;
+
+typedef struct {
+    float a, b, c;              /* value(x, y) = a * x + b * y + c */
+} PVR_HOST_PLANE;
+
+typedef struct {
+    const PVR_HOST_POLY *poly;  /* Set once parsing is done and r->poly stops moving */
+    uint32 poly_index;
+    float x[3], y[3];           /* Ordered so the signed area is positive */
+    int   top_left[3];          /* Edge i runs from vertex i to vertex i + 1 */
+    int   bx0, by0, bx1, by1;   /* Pixel bounds, inclusive */
+    PVR_HOST_PLANE invw, attr[PVR_HOST_ATTRS]; /* attr planes hold attr / w */
+    float flat[4];              /* Base color of a flat shaded triangle */
+} PVR_HOST_TRI;
+
+typedef struct {
+    PVR_HOST_POLY *poly;
+    PVR_HOST_TRI  *tri;
+    uint32 polys, poly_size;
+    uint32 tris, tri_size;
+} PVR_HOST_RASTER;
+
+//===============================================================================//
+//== TA Stream Parsing ==//
+
+static void *pvr_host_grow(void *data, uint32 *size, uint32 count, uint32 elem) {
+    if(count < *size)
+        return data;
+
+    *size = *size ? *size * 2 : 1024;
+    data = realloc(data, *size * elem);
+
+    if(!data) {
+        fprintf(stderr, "pvr_host_render: out of memory\n");
+        abort();
+    }
+
+    return data;
+}
+
+static void pvr_host_plane(PVR_HOST_PLANE *p, const float *x, const float *y, const float *v) {
+    float area = (x[1] - x[0]) * (y[2] - y[0]) - (y[1] - y[0]) * (x[2] - x[0]);
+
+    p->a = ((v[1] - v[0]) * (y[2] - y[0]) - (y[1] - y[0]) * (v[2] - v[0])) / area;
+    p->b = ((x[1] - x[0]) * (v[2] - v[0]) - (v[1] - v[0]) * (x[2] - x[0])) / area;
+    p->c = v[0] - p->a * x[0] - p->b * y[0];
+}
+
+static inline float pvr_host_plane_at(const PVR_HOST_PLANE *p, float x, float y) {
+    return p->a * x + p->b * y + p->c;
+}
+
+/* Set up one triangle of a strip; odd triangles of a strip wind the other way */
+static void pvr_host_triangle(PVR_HOST_RASTER *r, uint32 poly_index,
+                              const PVR_HOST_VERT *v0, const PVR_HOST_VERT *v1,
+                              const PVR_HOST_VERT *v2, int odd, int width, int height) {
+    const PVR_HOST_VERT *v[3] = { v0, v1, v2 };
+    const PVR_HOST_POLY *poly = &r->poly[poly_index];
+    uint32 culling = (poly->mode1 & PVR_TA_PM1_CULLING_MASK) >> PVR_TA_PM1_CULLING_SHIFT;
+    float area, x[3], y[3], val[3];
+    PVR_HOST_TRI *t;
+    int i, j;
+
+    if(v0->invw <= 0.0f || v1->invw <= 0.0f || v2->invw <= 0.0f)
+        return; /* Behind the eye - what the PVR draws for these is undefined */
+
+    area = (v0->x - v2->x) * (v1->y - v2->y) - (v0->y - v2->y) * (v1->x - v2->x);
+
+    if(area == 0.0f)
+        return;
+
+    if(culling >= PVR_CULLING_CCW) {
+        int cw = (culling & 1) ^ odd; /* Whether clockwise triangles are culled */
+
+        if(cw ? area > 0.0f : area < 0.0f)
+            return;
+    }
+
+    if(area < 0.0f) {
+        v[1] = v2;
+        v[2] = v1;
+    }
+
+    r->tri = pvr_host_grow(r->tri, &r->tri_size, r->tris, sizeof(PVR_HOST_TRI));
+    t = &r->tri[r->tris];
+
+    t->poly_index = poly_index;
+
+    for(i = 0; i < 3; i++) {
+        x[i] = t->x[i] = v[i]->x;
+        y[i] = t->y[i] = v[i]->y;
+    }
+
+    for(i = 0; i < 3; i++) {
+        float dx = x[(i + 1) % 3] - x[i], dy = y[(i + 1) % 3] - y[i];
+
+        t->top_left[i] = (dy == 0.0f && dx > 0.0f) || dy < 0.0f;
+    }
+
+    /* Clamped as floats, as off-screen vertices can be far out of int range */
+    t->bx0 = (int)floorf(fmaxf(fminf(fminf(x[0], x[1]), x[2]), 0.0f));
+    t->by0 = (int)floorf(fmaxf(fminf(fminf(y[0], y[1]), y[2]), 0.0f));
+    t->bx1 = (int)ceilf(fminf(fmaxf(fmaxf(x[0], x[1]), x[2]), width - 1.0f));
+    t->by1 = (int)ceilf(fminf(fmaxf(fmaxf(y[0], y[1]), y[2]), height - 1.0f));
+
+    if(t->bx0 > t->bx1 || t->by0 > t->by1)
+        return;
+
+    for(i = 0; i < 3; i++)
+        val[i] = v[i]->invw;
+
+    pvr_host_plane(&t->invw, x, y, val);
+
+    for(j = 0; j < PVR_HOST_ATTRS; j++) {
+        for(i = 0; i < 3; i++)
+            val[i] = v[i]->attr[j] * v[i]->invw;
+
+        pvr_host_plane(&t->attr[j], x, y, val);
+    }
+
+    /* Flat shading takes the color of the last vertex */
+    memcpy(t->flat, &v2->attr[PVR_HOST_ATTR_COLOR], sizeof(t->flat));
+
+    ++r->tris;
+}
+
+static void pvr_host_unpack_color(float *dst, uint32 argb) {
+    dst[0] = (float)(argb >> 24);
+    dst[1] = (float)((argb >> 16) & 0xff);
+    dst[2] = (float)((argb >> 8) & 0xff);
+    dst[3] = (float)(argb & 0xff);
+}
+
+static void pvr_host_vertex(PVR_HOST_VERT *dst, const uint32 *cmd, const PVR_HOST_POLY *poly) {
+    float ofs[4];
+
+    memset(dst, 0, sizeof(PVR_HOST_VERT));
+
+    memcpy(&dst->x, &cmd[1], sizeof(float));
+    memcpy(&dst->y, &cmd[2], sizeof(float));
+    memcpy(&dst->invw, &cmd[3], sizeof(float));
+
+    if(poly->cmd & PVR_TA_CMD_UVFMT_MASK) {
+        uint32 u = cmd[4] & 0xffff0000, v = cmd[4] << 16;
+
+        memcpy(&dst->attr[PVR_HOST_ATTR_U], &u, sizeof(float));
+        memcpy(&dst->attr[PVR_HOST_ATTR_V], &v, sizeof(float));
+    }
+    else {
+        memcpy(&dst->attr[PVR_HOST_ATTR_U], &cmd[4], sizeof(float));
+        memcpy(&dst->attr[PVR_HOST_ATTR_V], &cmd[5], sizeof(float));
+    }
+
+    pvr_host_unpack_color(&dst->attr[PVR_HOST_ATTR_COLOR], cmd[6]);
+    pvr_host_unpack_color(ofs, cmd[7]);
+
+    memcpy(&dst->attr[PVR_HOST_ATTR_OFS], &ofs[1], 3 * sizeof(float));
+}
+
+static void pvr_host_parse_list(PVR_HOST_RASTER *r, const uint8 *data, uint32 bytes,
+                                uint32 list, int width, int height) {
+    const uint32 *cmd = (const uint32 *)data, *end = (const uint32 *)(data + bytes);
+    int clip[4] = { 0, 0, width / PVR_HOST_TILE, height / PVR_HOST_TILE };
+    PVR_HOST_VERT strip[3];
+    int poly = -1, skip = 0, count = 0;
+
+    for(; cmd < end; cmd += 8)
+        switch(cmd[0] >> 29) {
+            case 0: /* End of list */
+                poly = -1;
+                count = 0;
+                break;
+
+            case 1: /* User clip */
+                clip[0] = cmd[4];
+                clip[1] = cmd[5];
+                clip[2] = cmd[6];
+                clip[3] = cmd[7];
+                break;
+
+            case 4: { /* Polygon header */
+                PVR_HOST_POLY *p;
+
+                r->poly = pvr_host_grow(r->poly, &r->poly_size, r->polys, sizeof(PVR_HOST_POLY));
+                p = &r->poly[r->polys];
+
+                p->cmd = cmd[0];
+                p->mode1 = cmd[1];
+                p->mode2 = cmd[2];
+                p->mode3 = cmd[3];
+                p->list = list;
+                memcpy(p->clip, clip, sizeof(clip));
+
+                poly = r->polys++;
+                skip = (cmd[0] & PVR_TA_CMD_CLRFMT_MASK) != 0; /* Only packed color */
+                count = 0;
+                break;
+            }
+
+            case 5: /* Sprite header */
+                poly = -1;
+                count = 0;
+                break;
+
+            case 7: /* Vertex */
+                if(poly < 0 || skip)
+                    break;
+
+                pvr_host_vertex(&strip[count < 3 ? count : 2], cmd, &r->poly[poly]);
+
+                if(++count >= 3) {
+                    pvr_host_triangle(r, poly, &strip[0], &strip[1], &strip[2],
+                                      (count - 3) & 1, width, height);
+
+                    strip[0] = strip[1];
+                    strip[1] = strip[2];
+                }
+
+                if(cmd[0] & (1 << 28)) /* End of strip */
+                    count = 0;
+
+                break;
+        }
+}
+
+//===============================================================================//
+//== Textures ==//
+
+/* Twiddled texel index: the bits of y and x interleaved, y first, until the
+   smaller dimension runs out */
+static uint32 pvr_host_twiddle(uint32 x, uint32 y, uint32 xbits, uint32 ybits) {
+    uint32 idx = 0, shift = 0;
+
+    while(xbits || ybits) {
+        if(ybits) {
+            idx |= (y & 1) << shift++;
+            y >>= 1;
+            --ybits;
+        }
+
+        if(xbits) {
+            idx |= (x & 1) << shift++;
+            x >>= 1;
+            --xbits;
+        }
+    }
+
+    return idx;
+}
+
+static inline uint32 pvr_host_log2(uint32 n) {
+    uint32 bits = 0;
+
+    while((1u << bits) < n)
+        ++bits;
+
+    return bits;
+}
+
+static void pvr_host_texel_decode(float *dst, uint32 texel, uint32 format) {
+    switch(format) {
+        case PVR_TXRFMT_ARGB1555:
+            dst[0] = texel & 0x8000 ? 255.0f : 0.0f;
+            dst[1] = (float)(((texel >> 7) & 0xf8) | ((texel >> 12) & 0x7));
+            dst[2] = (float)(((texel >> 2) & 0xf8) | ((texel >> 7) & 0x7));
+            dst[3] = (float)(((texel << 3) & 0xf8) | ((texel >> 2) & 0x7));
+            break;
+
+        case PVR_TXRFMT_RGB565:
+            dst[0] = 255.0f;
+            dst[1] = (float)(((texel >> 8) & 0xf8) | ((texel >> 13) & 0x7));
+            dst[2] = (float)(((texel >> 3) & 0xfc) | ((texel >> 9) & 0x3));
+            dst[3] = (float)(((texel << 3) & 0xf8) | ((texel >> 2) & 0x7));
+            break;
+
+        case PVR_TXRFMT_ARGB4444:
+            dst[0] = (float)(((texel >> 12) & 0xf) * 0x11);
+            dst[1] = (float)(((texel >> 8) & 0xf) * 0x11);
+            dst[2] = (float)(((texel >> 4) & 0xf) * 0x11);
+            dst[3] = (float)((texel & 0xf) * 0x11);
+            break;
+
+        default:
+            dst[0] = dst[1] = dst[2] = dst[3] = 0.0f;
+            break;
+    }
+}
+
+typedef struct {
+    const uint8 *base;      /* Texels of the mipmap level, or VQ indices */
+    const uint16 *book;     /* VQ codebook */
+    uint32 width, height, xbits, ybits;
+    uint32 format, twiddled, vq, uv_clamp, uv_flip;
+} PVR_HOST_TEXTURE;
+
+/* Offset of the size x size level in a mipmap chain stored smallest first.
+   16 bit chains start 6 bytes in; VQ chains hold one index for 1x1 and 2x2. */
+static uint32 pvr_host_mip_offset(uint32 size, uint32 vq) {
+    uint32 s, offset = vq ? 0 : 6;
+
+    if(size == 1)
+        return offset;
+
+    offset += vq ? 1 : 2;
+
+    for(s = 2; s < size; s *= 2)
+        offset += vq ? (s / 2) * (s / 2) : s * s * 2;
+
+    return offset;
+}
+
+static void pvr_host_texture(PVR_HOST_TEXTURE *t, const PVR_HOST_POLY *poly, uint32 level) {
+    const uint8 *vram = pvr_host_vram() + ((poly->mode3 & 0x1fffff) << 3);
+    uint32 vq = (poly->mode3 & PVR_TXRFMT_VQ_ENABLE) != 0;
+
+    t->width = 8 << ((poly->mode2 & PVR_TA_PM2_USIZE_MASK) >> PVR_TA_PM2_USIZE_SHIFT);
+    t->height = 8 << ((poly->mode2 & PVR_TA_PM2_VSIZE_MASK) >> PVR_TA_PM2_VSIZE_SHIFT);
+    t->format = poly->mode3 & (7 << 27);
+    t->uv_clamp = (poly->mode2 & PVR_TA_PM2_UVCLAMP_MASK) >> PVR_TA_PM2_UVCLAMP_SHIFT;
+    t->uv_flip = (poly->mode2 & PVR_TA_PM2_UVFLIP_MASK) >> PVR_TA_PM2_UVFLIP_SHIFT;
+    t->vq = vq;
+
+    /* The PVR reads VQ indices in twiddled order whatever the scan order bit says */
+    t->twiddled = vq || !(poly->mode3 & PVR_TXRFMT_NONTWIDDLED);
+
+    t->book = (const uint16 *)vram;
+    t->base = vq ? vram + PVR_HOST_VQ_BOOK : vram;
+
+    /* Mipmaps are square, and only twiddled textures have them */
+    if((poly->mode3 & PVR_TA_PM3_MIPMAP_MASK) && t->twiddled) {
+        t->width >>= level;
+        t->height = t->width;
+        t->base += pvr_host_mip_offset(t->width, vq);
+    }
+
+    t->xbits = pvr_host_log2(vq ? t->width / 2 : t->width);
+    t->ybits = pvr_host_log2(vq ? t->height / 2 : t->height);
+}
+
+static inline int pvr_host_wrap(int i, int size, int clamp, int flip) {
+    if(clamp)
+        return i < 0 ? 0 : i >= size ? size - 1 : i;
+
+    if(flip) {
+        i &= 2 * size - 1;
+
+        return i < size ? i : 2 * size - 1 - i;
+    }
+
+    return i & (size - 1);
+}
+
+static void pvr_host_texel(float *dst, const PVR_HOST_TEXTURE *t, int x, int y) {
+    uint32 texel;
+
+    x = pvr_host_wrap(x, t->width, t->uv_clamp & PVR_UVCLAMP_U, t->uv_flip & PVR_UVFLIP_U);
+    y = pvr_host_wrap(y, t->height, t->uv_clamp & PVR_UVCLAMP_V, t->uv_flip & PVR_UVFLIP_V);
+
+    if(t->vq) { /* Each index selects a 2x2 block of the codebook */
+        uint32 code = t->base[pvr_host_twiddle(x / 2, y / 2, t->xbits, t->ybits)];
+
+        texel = t->book[code * 4 + ((y & 1) | ((x & 1) << 1))];
+    }
+    else if(t->twiddled)
+        texel = ((const uint16 *)t->base)[pvr_host_twiddle(x, y, t->xbits, t->ybits)];
+    else
+        texel = ((const uint16 *)t->base)[y * t->width + x];
+
+    pvr_host_texel_decode(dst, texel, t->format);
+}
+
+/* Mipmap level for a pixel, from the screen space derivatives of u and v */
+static uint32 pvr_host_mip_level(const PVR_HOST_TRI *t, float x, float y, float invw) {
+    const PVR_HOST_PLANE *pu = &t->attr[PVR_HOST_ATTR_U], *pv = &t->attr[PVR_HOST_ATTR_V];
+    uint32 size = 8 << ((t->poly->mode2 & PVR_TA_PM2_USIZE_MASK) >> PVR_TA_PM2_USIZE_SHIFT);
+    uint32 bias = (t->poly->mode2 & PVR_TA_PM2_MIPBIAS_MASK) >> PVR_TA_PM2_MIPBIAS_SHIFT;
+    float u = pvr_host_plane_at(pu, x, y), v = pvr_host_plane_at(pv, x, y);
+    float w2 = invw * invw, rho, lod;
+    float dudx = (pu->a * invw - u * t->invw.a) / w2, dvdx = (pv->a * invw - v * t->invw.a) / w2;
+    float dudy = (pu->b * invw - u * t->invw.b) / w2, dvdy = (pv->b * invw - v * t->invw.b) / w2;
+
+    rho = fmaxf(sqrtf(dudx * dudx + dvdx * dvdx), sqrtf(dudy * dudy + dvdy * dvdy)) * size;
+    rho *= (bias ? bias : PVR_MIPBIAS_NORMAL) / (float)PVR_MIPBIAS_NORMAL; /* D adjust, 4 is 1.0 */
+
+    lod = rho > 1.0f ? floorf(log2f(rho) + 0.5f) : 0.0f;
+
+    return lod > pvr_host_log2(size) ? pvr_host_log2(size) : (uint32)lod;
+}
+
+static void pvr_host_sample(float *dst, const PVR_HOST_TRI *t, float u, float v,
+                            float x, float y, float invw) {
+    uint32 filter = (t->poly->mode2 & PVR_TA_PM2_FILTER_MASK) >> PVR_TA_PM2_FILTER_SHIFT;
+    uint32 level = 0;
+    PVR_HOST_TEXTURE tex;
+    float tu, tv;
+
+    if(t->poly->mode3 & PVR_TA_PM3_MIPMAP_MASK)
+        level = pvr_host_mip_level(t, x, y, invw);
+
+    pvr_host_texture(&tex, t->poly, level);
+
+    tu = u * tex.width;
+    tv = v * tex.height;
+
+    /* Bit 0 of the filter field is supersampling, which changes nothing here */
+    if((filter & ~1u) != PVR_FILTER_NEAREST) {
+        float c[4][4], fx, fy;
+        int x0, y0, i;
+
+        tu -= 0.5f;
+        tv -= 0.5f;
+        x0 = (int)floorf(tu);
+        y0 = (int)floorf(tv);
+        fx = tu - x0;
+        fy = tv - y0;
+
+        pvr_host_texel(c[0], &tex, x0, y0);
+        pvr_host_texel(c[1], &tex, x0 + 1, y0);
+        pvr_host_texel(c[2], &tex, x0, y0 + 1);
+        pvr_host_texel(c[3], &tex, x0 + 1, y0 + 1);
+
+        for(i = 0; i < 4; i++)
+            dst[i] = (c[0][i] * (1.0f - fx) + c[1][i] * fx) * (1.0f - fy)
+                     + (c[2][i] * (1.0f - fx) + c[3][i] * fx) * fy;
+    }
+    else
+        pvr_host_texel(dst, &tex, (int)floorf(tu), (int)floorf(tv));
+}
+
+//===============================================================================//
+//== Tile Rendering ==//
+
+typedef struct {
+    float color[PVR_HOST_TILE * PVR_HOST_TILE][4]; /* A R G B, 0 to 255 */
+    float depth[PVR_HOST_TILE * PVR_HOST_TILE];
+    int   x, y, tx, ty;                            /* Pixel and tile position */
+} PVR_HOST_TILE_BUF;
+
+static inline int pvr_host_depth_test(uint32 func, float z, float stored) {
+    switch(func) {
+        case PVR_DEPTHCMP_NEVER:    return 0;
+        case PVR_DEPTHCMP_LESS:     return z < stored;
+        case PVR_DEPTHCMP_EQUAL:    return z == stored;
+        case PVR_DEPTHCMP_LEQUAL:   return z <= stored;
+        case PVR_DEPTHCMP_GREATER:  return z > stored;
+        case PVR_DEPTHCMP_NOTEQUAL: return z != stored;
+        case PVR_DEPTHCMP_GEQUAL:   return z >= stored;
+        default:                    return 1;
+    }
+}
+
+/* The dst factor's "other" color is the source, the src factor's the destination */
+static inline float pvr_host_blend_factor(uint32 factor, float other, float src_a, float dst_a) {
+    switch(factor) {
+        case PVR_BLEND_ZERO:         return 0.0f;
+        case PVR_BLEND_ONE:          return 1.0f;
+        case PVR_BLEND_DESTCOLOR:    return other;
+        case PVR_BLEND_INVDESTCOLOR: return 1.0f - other;
+        case PVR_BLEND_SRCALPHA:     return src_a;
+        case PVR_BLEND_INVSRCALPHA:  return 1.0f - src_a;
+        case PVR_BLEND_DESTALPHA:    return dst_a;
+        default:                     return 1.0f - dst_a;
+    }
+}
+
+static inline float pvr_host_clamp(float c) {
+    return c < 0.0f ? 0.0f : c > 255.0f ? 255.0f : c;
+}
+
+static void pvr_host_blend(float *dst, const float *src, uint32 src_blend, uint32 dst_blend) {
+    float sa = src[0] / 255.0f, da = dst[0] / 255.0f, out[4];
+    int i;
+
+    for(i = 0; i < 4; i++)
+        out[i] = src[i] * pvr_host_blend_factor(src_blend, dst[i] / 255.0f, sa, da)
+                 + dst[i] * pvr_host_blend_factor(dst_blend, src[i] / 255.0f, sa, da);
+
+    for(i = 0; i < 4; i++)
+        dst[i] = pvr_host_clamp(out[i]);
+}
+
+/* Shade one pixel: base color, texture and offset color */
+static void pvr_host_shade(float *dst, const PVR_HOST_TRI *t, float x, float y, float invw) {
+    const PVR_HOST_POLY *p = t->poly;
+    float w = 1.0f / invw, col[4], tex[4];
+    int i;
+
+    if(p->cmd & PVR_TA_CMD_SHADE_MASK)
+        for(i = 0; i < 4; i++)
+            col[i] = pvr_host_plane_at(&t->attr[PVR_HOST_ATTR_COLOR + i], x, y) * w;
+    else
+        memcpy(col, t->flat, sizeof(col));
+
+    if(!(p->mode2 & PVR_TA_PM2_ALPHA_MASK))
+        col[0] = 255.0f;
+
+    if(!(p->cmd & PVR_HOST_CMD_TXR)) {
+        for(i = 0; i < 4; i++)
+            dst[i] = pvr_host_clamp(col[i]);
+
+        return;
+    }
+
+    pvr_host_sample(tex, t, pvr_host_plane_at(&t->attr[PVR_HOST_ATTR_U], x, y) * w,
+                    pvr_host_plane_at(&t->attr[PVR_HOST_ATTR_V], x, y) * w, x, y, invw);
+
+    if(p->mode2 & PVR_TA_PM2_TXRALPHA_MASK)
+        tex[0] = 255.0f;
+
+    switch((p->mode2 & PVR_TA_PM2_TXRENV_MASK) >> PVR_TA_PM2_TXRENV_SHIFT) {
+        case PVR_TXRENV_REPLACE:
+            memcpy(dst, tex, sizeof(tex));
+            break;
+
+        case PVR_TXRENV_MODULATE:
+            dst[0] = tex[0];
+
+            for(i = 1; i < 4; i++)
+                dst[i] = col[i] * tex[i] / 255.0f;
+
+            break;
+
+        case PVR_TXRENV_DECAL:
+            dst[0] = col[0];
+
+            for(i = 1; i < 4; i++)
+                dst[i] = (tex[i] * tex[0] + col[i] * (255.0f - tex[0])) / 255.0f;
+
+            break;
+
+        default: /* PVR_TXRENV_MODULATEALPHA */
+            for(i = 0; i < 4; i++)
+                dst[i] = col[i] * tex[i] / 255.0f;
+
+            break;
+    }
+
+    if(p->cmd & PVR_TA_CMD_SPECULAR_MASK)
+        for(i = 0; i < 3; i++)
+            dst[i + 1] += pvr_host_plane_at(&t->attr[PVR_HOST_ATTR_OFS + i], x, y) * w;
+
+    for(i = 0; i < 4; i++)
+        dst[i] = pvr_host_clamp(dst[i]);
+}
+
+static int pvr_host_clipped(const PVR_HOST_POLY *p, int tx, int ty) {
+    uint32 mode = (p->cmd & PVR_TA_CMD_USERCLIP_MASK) >> PVR_TA_CMD_USERCLIP_SHIFT;
+    int inside = tx >= p->clip[0] && tx <= p->clip[2] && ty >= p->clip[1] && ty <= p->clip[3];
+
+    if(mode == PVR_USERCLIP_INSIDE)
+        return !inside;
+
+    if(mode == PVR_USERCLIP_OUTSIDE)
+        return inside;
+
+    return 0;
+}
+
+static void pvr_host_draw(PVR_HOST_TILE_BUF *tile, const PVR_HOST_TRI *t,
+                          uint32 pt_alpha_ref, int width, int height) {
+    const PVR_HOST_POLY *p = t->poly;
+    uint32 depth_func = (p->mode1 & PVR_TA_PM1_DEPTHCMP_MASK) >> PVR_TA_PM1_DEPTHCMP_SHIFT;
+    uint32 src_blend = (p->mode2 & PVR_TA_PM2_SRCBLEND_MASK) >> PVR_TA_PM2_SRCBLEND_SHIFT;
+    uint32 dst_blend = (p->mode2 & PVR_TA_PM2_DSTBLEND_MASK) >> PVR_TA_PM2_DSTBLEND_SHIFT;
+    int depth_write = !(p->mode1 & PVR_TA_PM1_DEPTHWRITE_MASK);
+    int x0 = t->bx0 > tile->x ? t->bx0 : tile->x, y0 = t->by0 > tile->y ? t->by0 : tile->y;
+    int x1 = t->bx1 < tile->x + PVR_HOST_TILE - 1 ? t->bx1 : tile->x + PVR_HOST_TILE - 1;
+    int y1 = t->by1 < tile->y + PVR_HOST_TILE - 1 ? t->by1 : tile->y + PVR_HOST_TILE - 1;
+    int px, py, e;
+
+    if(pvr_host_clipped(p, tile->tx, tile->ty))
+        return;
+
+    x1 = x1 < width ? x1 : width - 1;
+    y1 = y1 < height ? y1 : height - 1;
+
+    for(py = y0; py <= y1; py++)
+        for(px = x0; px <= x1; px++) {
+            float x = px + 0.5f, y = py + 0.5f, invw, src[4];
+            int i = (py - tile->y) * PVR_HOST_TILE + (px - tile->x);
+
+            /* Inside all three edges; pixels on an edge belong to top and left edges */
+            for(e = 0; e < 3; e++) {
+                int n = (e + 1) % 3;
+                float edge = (t->x[n] - t->x[e]) * (y - t->y[e]) - (t->y[n] - t->y[e]) * (x - t->x[e]);
+
+                if(edge < 0.0f || (edge == 0.0f && !t->top_left[e]))
+                    break;
+            }
+
+            if(e < 3)
+                continue;
+
+            invw = pvr_host_plane_at(&t->invw, x, y);
+
+            if(!pvr_host_depth_test(depth_func, invw, tile->depth[i]))
+                continue;
+
+            pvr_host_shade(src, t, x, y, invw);
+
+            if(p->list == PVR_LIST_PT_POLY && src[0] < pt_alpha_ref)
+                continue;
+
+            pvr_host_blend(tile->color[i], src, src_blend, dst_blend);
+
+            if(depth_write)
+                tile->depth[i] = invw;
+        }
+}
+
+//===============================================================================//
+//== Scene Rendering ==//
+
+/* The order the PVR renders the lists of a tile in */
+static const uint32 PVR_HOST_LIST_ORDER[] = { PVR_LIST_OP_POLY, PVR_LIST_PT_POLY, PVR_LIST_TR_POLY };
+
+void pvr_host_render(const pvr_host_scene_t *scene, uint32 *argb, uint32 width, uint32 height) {
+    PVR_HOST_RASTER r;
+    PVR_HOST_TILE_BUF tile;
+    uint32 tiles_x = (width + PVR_HOST_TILE - 1) / PVR_HOST_TILE;
+    uint32 tiles_y = (height + PVR_HOST_TILE - 1) / PVR_HOST_TILE;
+    uint32 *bin_start, *bin, i, l, tx, ty;
+    float bg[4] = { 255.0f, scene->bg_color[0] * 255.0f,
+                    scene->bg_color[1] * 255.0f, scene->bg_color[2] * 255.0f };
+
+    memset(&r, 0, sizeof(r));
+
+    for(l = 0; l < sizeof(PVR_HOST_LIST_ORDER) / sizeof(uint32); l++)
+        pvr_host_parse_list(&r, scene->list[PVR_HOST_LIST_ORDER[l]],
+                            scene->list_bytes[PVR_HOST_LIST_ORDER[l]],
+                            PVR_HOST_LIST_ORDER[l], width, height);
+
+    for(i = 0; i < r.tris; i++)
+        r.tri[i].poly = &r.poly[r.tri[i].poly_index];
+
+    /* Bin the triangles to the tiles they touch, keeping submission order */
+    bin_start = calloc(tiles_x * tiles_y + 1, sizeof(uint32));
+
+    for(i = 0; i < r.tris; i++)
+        for(ty = r.tri[i].by0 / PVR_HOST_TILE; ty <= (uint32)r.tri[i].by1 / PVR_HOST_TILE; ty++)
+            for(tx = r.tri[i].bx0 / PVR_HOST_TILE; tx <= (uint32)r.tri[i].bx1 / PVR_HOST_TILE; tx++)
+                ++bin_start[ty * tiles_x + tx + 1];
+
+    for(i = 0; i < tiles_x * tiles_y; i++)
+        bin_start[i + 1] += bin_start[i];
+
+    bin = malloc((bin_start[tiles_x * tiles_y] + 1) * sizeof(uint32));
+
+    {
+        uint32 *fill = malloc(tiles_x * tiles_y * sizeof(uint32));
+
+        memcpy(fill, bin_start, tiles_x * tiles_y * sizeof(uint32));
+
+        for(i = 0; i < r.tris; i++)
+            for(ty = r.tri[i].by0 / PVR_HOST_TILE; ty <= (uint32)r.tri[i].by1 / PVR_HOST_TILE; ty++)
+                for(tx = r.tri[i].bx0 / PVR_HOST_TILE; tx <= (uint32)r.tri[i].bx1 / PVR_HOST_TILE; tx++)
+                    bin[fill[ty * tiles_x + tx]++] = i;
+
+        free(fill);
+    }
+
+    for(ty = 0; ty < tiles_y; ty++)
+        for(tx = 0; tx < tiles_x; tx++) {
+            uint32 x, y;
+
+            tile.tx = tx;
+            tile.ty = ty;
+            tile.x = tx * PVR_HOST_TILE;
+            tile.y = ty * PVR_HOST_TILE;
+
+            for(i = 0; i < PVR_HOST_TILE * PVR_HOST_TILE; i++) {
+                memcpy(tile.color[i], bg, sizeof(bg));
+                tile.depth[i] = PVR_HOST_BG_DEPTH;
+            }
+
+            for(i = bin_start[ty * tiles_x + tx]; i < bin_start[ty * tiles_x + tx + 1]; i++)
+                pvr_host_draw(&tile, &r.tri[bin[i]], scene->pt_alpha_ref & 0xff, width, height);
+
+            for(y = tile.y; y < (uint32)tile.y + PVR_HOST_TILE && y < height; y++)
+                for(x = tile.x; x < (uint32)tile.x + PVR_HOST_TILE && x < width; x++) {
+                    const float *c = tile.color[(y - tile.y) * PVR_HOST_TILE + (x - tile.x)];
+
+                    argb[y * width + x] = ((uint32)(c[0] + 0.5f) << 24) | ((uint32)(c[1] + 0.5f) << 16)
+                                          | ((uint32)(c[2] + 0.5f) << 8) | (uint32)(c[3] + 0.5f);
+                }
+        }
+
+    /* A scene rendered to a texture lands in VRAM as RGB565 for later scenes */
+    if(scene->target) {
+        uint16 *dst = scene->target;
+        uint32 x, y;
+
+        for(y = 0; y < height && y < scene->target_height; y++)
+            for(x = 0; x < width && x < scene->target_width; x++) {
+                uint32 c = argb[y * width + x];
+
+                dst[y * scene->target_width + x] = ((c >> 8) & 0xf800) | ((c >> 5) & 0x07e0)
+                                                   | ((c >> 3) & 0x001f);
+            }
+    }
+
+    free(bin);
+    free(bin_start);
+    free(r.tri);
+    free(r.poly);
+}
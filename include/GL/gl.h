@@ -290,7 +290,9 @@ __BEGIN_DECLS
 #define GL_OUT_OF_MEMORY                  0x0505
 
 /* GetPName */
+#define GL_POINT_SIZE                     0x0B11
 #define GL_SMOOTH_POINT_SIZE_RANGE        0x0B12
+#define GL_LINE_WIDTH                     0x0B21
 #define GL_SMOOTH_LINE_WIDTH_RANGE        0x0B22
 #define GL_ALIASED_POINT_SIZE_RANGE       0x846D
 #define GL_ALIASED_LINE_WIDTH_RANGE       0x846E
@@ -315,6 +317,40 @@ __BEGIN_DECLS
 #define GL_DEPTH_BITS                     0x0D56
 #define GL_STENCIL_BITS                   0x0D57
 
+/* Display Lists */
+#define GL_COMPILE                        0x1300
+#define GL_COMPILE_AND_EXECUTE            0x1301
+#define GL_LIST_MODE                      0x0B30
+#define GL_LIST_BASE                      0x0B32
+#define GL_LIST_INDEX                     0x0B33
+
+/* Buffer Objects */
+#define GL_ARRAY_BUFFER                   0x8892
+#define GL_ELEMENT_ARRAY_BUFFER           0x8893
+#define GL_ARRAY_BUFFER_BINDING           0x8894
+#define GL_ELEMENT_ARRAY_BUFFER_BINDING   0x8895
+#define GL_STREAM_DRAW                    0x88E0
+#define GL_STATIC_DRAW                    0x88E4
+#define GL_DYNAMIC_DRAW                   0x88E8
+#define GL_BUFFER_SIZE                    0x8764
+#define GL_BUFFER_USAGE                   0x8765
+
+/* Interleaved Array Formats - the T4F and V4F formats are not supported */
+#define GL_V2F                            0x2A20
+#define GL_V3F                            0x2A21
+#define GL_C4UB_V2F                       0x2A22
+#define GL_C4UB_V3F                       0x2A23
+#define GL_C3F_V3F                        0x2A24
+#define GL_N3F_V3F                        0x2A25
+#define GL_C4F_N3F_V3F                    0x2A26
+#define GL_T2F_V3F                        0x2A27
+#define GL_T4F_V4F                        0x2A28
+#define GL_T2F_C4UB_V3F                   0x2A29
+#define GL_T2F_C3F_V3F                    0x2A2A
+#define GL_T2F_N3F_V3F                    0x2A2B
+#define GL_T2F_C4F_N3F_V3F                0x2A2C
+#define GL_T4F_C4F_N3F_V4F                0x2A2D
+
 /* StringName */
 #define GL_VENDOR                         0x1F00
 #define GL_RENDERER                       0x1F01
@@ -327,6 +363,23 @@ __BEGIN_DECLS
 /* GL KOS Texture Matrix Enable Bit */
 #define GL_KOS_TEXTURE_MATRIX       0x002F
 
+/* GL KOS Direct Render - glHint target, and glGetIntegerv bytes of the opaque
+   list streamed to the TA at draw time during the last frame */
+#define GL_KOS_DIRECT_RENDER_HINT   0x0030
+#define GL_KOS_DIRECT_RENDER_BYTES  0x0031
+
+/* GL KOS Polygon Header counts of the last frame, for glGetIntegerv. Draws that
+   share the state of the previous draw on the same list reuse its header, so
+   GL_KOS_HEADERS_EMITTED can be lower than GL_KOS_HEADERS_REQUESTED */
+#define GL_KOS_HEADERS_REQUESTED    0x0032
+#define GL_KOS_HEADERS_EMITTED      0x0033
+
+/* GL KOS Bounding Volume results, returned by glKosBoundingBox() and
+   glKosBoundingSphere() */
+#define GL_KOS_BOUNDS_OUTSIDE       0x0034      /* next draw is dropped */
+#define GL_KOS_BOUNDS_INSIDE        0x0035      /* next draw skips near-Z clipping */
+#define GL_KOS_BOUNDS_CLIPPED       0x0036      /* next draw is drawn as usual */
+
 /* GL KOS Texture Color Modes */
 #define GL_UNSIGNED_SHORT_5_6_5       (PVR_TXRFMT_RGB565 | PVR_TXRFMT_NONTWIDDLED)
 #define GL_UNSIGNED_SHORT_5_6_5_REV   (PVR_TXRFMT_RGB565 | PVR_TXRFMT_NONTWIDDLED)
@@ -389,11 +442,14 @@ __BEGIN_DECLS
 #define GLubyte  unsigned char
 #define GLbitfield unsigned long
 #define GLboolean  unsigned char
+#define GLintptr   long
+#define GLsizeiptr long
 #define GL_FALSE   0
 #define GL_TRUE    1
 
+#define GL_ALPHA_TEST 0x0BC0 /* capability bit */
+
 /* Stubs for portability */
-#define GL_ALPHA_TEST 0
 #define GL_STENCIL_TEST 0
 #define GL_CLAMP_TO_EDGE 0
 #define GL_UNPACK_ALIGNMENT 0
@@ -404,12 +460,41 @@ __BEGIN_DECLS
 /* Initialize the GL pipeline. GL will initialize the PVR. */
 GLAPI void APIENTRY glKosInit();
 
+/* PVR buffer sizes for glKosInitEx(). Per list arrays are ordered opaque,
+   translucent, punch-through. bench/binsim measures them from captured frames. */
+typedef struct {
+    GLuint bin_size[3];         /* Object pointer block per tile, in words: 8, 16 or 32 */
+    GLuint vertex_buf_size;     /* TA vertex buffer in VRAM, in bytes - a multiple of 32 */
+} GL_KOS_INIT_PARAMS;
+
+/* Fill params with the sizes glKosInit() uses */
+GLAPI void APIENTRY glKosInitDefaults(GL_KOS_INIT_PARAMS *params);
+
+/* glKosInit() with the PVR buffers sized by params, or the defaults if NULL.
+   Returns 1, or 0 with GL_INVALID_VALUE and nothing initialized if a size is
+   out of range. */
+GLAPI GLint APIENTRY glKosInitEx(const GL_KOS_INIT_PARAMS *params);
+
+/* Frame contexts glutSwapBuffers() may fill ahead of the PVR, from 1 to 2 (the
+   default). With 2, a frame the PVR is not ready for is queued and the client goes
+   on to record the next one. With 1, every frame waits for the PVR to take it. */
+GLAPI void APIENTRY glKosFrameContexts(GLuint count);
+
 /* Start Submission of Primitive Data */
 /* Currently Supported Primitive Types:
-   -GL_POINTS   ( does NOT work with glDrawArrays )( ZClipping NOT supported )
+   -GL_POINTS           ( works with glDrawArrays )( ZClipping supported )
    -GL_TRIANGLES        ( works with glDrawArrays )( ZClipping supported )
    -GL_TRIANLGLE_STRIP  ( works with glDrawArrays )( ZClipping supported )
    -GL_QUADS            ( works with glDrawArrays )( ZClipping supported )
+   -GL_QUAD_STRIP       ( works with glDrawArrays )( ZClipping supported )
+   -GL_TRIANGLE_FAN     ( works with glDrawArrays )( ZClipping supported )
+   -GL_POLYGON          ( works with glDrawArrays )( ZClipping supported )
+   -GL_LINES            ( works with glDrawArrays )( ZClipping supported )
+   -GL_LINE_STRIP       ( works with glDrawArrays )( ZClipping supported )
+   -GL_LINE_LOOP        ( works with glDrawArrays )( ZClipping supported )
+   The PVR only draws triangle strips: fans and polygons are drawn as short
+   strips, each line segment as a quad glLineWidth() pixels wide, and each
+   point as a square glPointSize() pixels across, dropped if off screen.
 **/
 GLAPI void APIENTRY glBegin(GLenum mode);
 
@@ -462,6 +547,7 @@ GLAPI GLvoid APIENTRY glRectiv(const GLint *v1, const GLint *v2);
 /* Currently Supported Capabilities:
         GL_TEXTURE_2D
         GL_BLEND
+        GL_ALPHA_TEST
         GL_DEPTH_TEST
         GL_LIGHTING
         GL_SCISSOR_TEST
@@ -485,7 +571,12 @@ GLAPI void APIENTRY glDepthFunc(GLenum func);
 
 /* Hints */
 /* Currently Supported Capabilities:
-      GL_PERSPECTIVE_CORRECTION_HINT - This will Enable Texture Super-Sampling on the PVR */
+      GL_PERSPECTIVE_CORRECTION_HINT - This will Enable Texture Super-Sampling on the PVR
+      GL_KOS_DIRECT_RENDER_HINT - GL_FASTEST streams opaque polygons to the PVR as they
+                                  are drawn, instead of buffering them until
+                                  glutSwapBuffers(). Saves a copy of the opaque list,
+                                  but the first opaque draw of a frame waits for the PVR,
+                                  and glutCopyBufferToTexture() is not available. */
 GLAPI void APIENTRY glHint(GLenum target, GLenum mode);
 
 /* Culling */
@@ -496,8 +587,15 @@ GLAPI void APIENTRY glCullFace(GLenum mode);
 GLAPI void APIENTRY glShadeModel(GLenum mode);
 
 /* Blending */
+/* Blending with GL_ONE, GL_ZERO is treated as opaque, and does not use the translucent list */
 GLAPI void APIENTRY glBlendFunc(GLenum sfactor, GLenum dfactor);
 
+/* Alpha Test */
+/* With GL_ALPHA_TEST enabled and blending disabled, GL_GREATER and GL_GEQUAL submit
+   to the PVR punch-through list, which discards pixels below ref. Other functions
+   leave the geometry opaque. The last ref set in a frame applies to the whole frame. */
+GLAPI void APIENTRY glAlphaFunc(GLenum func, GLclampf ref);
+
 /* Texturing */
 GLAPI void APIENTRY glTexParameteri(GLenum target, GLenum pname, GLint param);
 GLAPI void APIENTRY glTexEnvi(GLenum target, GLenum pname, GLint param);
@@ -571,10 +669,113 @@ GLAPI void APIENTRY glNormalPointer(GLenum type, GLsizei stride, const GLvoid *p
 GLAPI void APIENTRY glColorPointer(GLint size, GLenum type,
                                    GLsizei stride, const GLvoid *pointer);
 
+/* Set the Vertex, Color, Normal and Texture Coordinate Pointers of an interleaved
+   format at once. glDrawArrays() then converts each vertex in a single pass,
+   unless lighting, Multi-Texture, the texture matrix or near-Z clipping is used. */
+GLAPI void APIENTRY glInterleavedArrays(GLenum format, GLsizei stride, const GLvoid *pointer);
+
 /* Array Data Submission */
 GLAPI void APIENTRY glDrawArrays(GLenum mode, GLint first, GLsizei count);
 GLAPI void APIENTRY glDrawElements(GLenum mode, GLsizei count, GLenum type, const GLvoid *indices);
 
+/* Elements may be GL_UNSIGNED_BYTE, GL_UNSIGNED_SHORT or GL_UNSIGNED_INT. Each vertex
+   the elements reference is converted once, then gathered by index; glDrawElements()
+   scans the elements for the range of vertices they reference, glDrawRangeElements()
+   takes it from start and end, and elements outside of it give undefined results.
+   A range of more than GL_MAX_ELEMENTS_VERTICES is only drawn without lighting,
+   Multi-Texture, the texture matrix or near-Z clipping. */
+GLAPI void APIENTRY glDrawRangeElements(GLenum mode, GLuint start, GLuint end,
+                                        GLsizei count, GLenum type, const GLvoid *indices);
+
+/* Convert count GL_TRIANGLES elements of the index type at indices, an offset into the
+   bound GL_ELEMENT_ARRAY_BUFFER if there is one, to triangle strips. The PVR takes a
+   strip for about one vertex per triangle, where a triangle list costs three. Later
+   glDrawElements() of GL_TRIANGLES with the same count, type and indices draws the
+   strips, so the elements must not change, or be optimized again; strips made from a
+   buffer are dropped when its data changes. The triangles are drawn in another order,
+   and near-Z clipped draws keep the triangle list. Returns a handle, or 0 if the elements
+   reference more than GL_MAX_ELEMENTS_VERTICES vertices or have no triangles.
+   glKosOptimizedElementsCount() is the number of vertices the strips submit. */
+GLAPI GLuint APIENTRY glKosOptimizeElements(GLsizei count, GLenum type, const GLvoid *indices);
+GLAPI void APIENTRY glKosDeleteOptimizedElements(GLuint handle);
+GLAPI GLuint APIENTRY glKosOptimizedElementsCount(GLuint handle);
+
+/* Draw drawcount sub-draws with one validation and one polygon header. Short sub-draws
+   are converted back to back into shared Vertex Buffer pieces. Sub-draws of triangles
+   or quads should hold whole primitives. */
+GLAPI void APIENTRY glMultiDrawArrays(GLenum mode, const GLint *first, const GLsizei *count,
+                                      GLsizei drawcount);
+GLAPI void APIENTRY glMultiDrawElements(GLenum mode, const GLsizei *count, GLenum type,
+                                        const GLvoid *const *indices, GLsizei drawcount);
+
+/* As above, with sub-draw i transformed by the column major matrix at model + 16 * i
+   after the current matrices, as if each sub-draw had been drawn between glPushMatrix(),
+   glMultMatrixf() and glPopMatrix(). Lit normals are not rotated by model.
+   Not allowed while compiling a display list. */
+GLAPI void APIENTRY glKosMultiDrawArraysModel(GLenum mode, const GLint *first, const GLsizei *count,
+        const GLfloat *model, GLsizei drawcount);
+GLAPI void APIENTRY glKosMultiDrawElementsModel(GLenum mode, const GLsizei *count, GLenum type,
+        const GLvoid *const *indices, const GLfloat *model, GLsizei drawcount);
+
+/* Particles - count quads facing the camera, particle i centered on position[3 * i]
+   (transformed by the current matrices), size[i] eye space units across, turned
+   rotation[i] radians counter-clockwise, and colored color[i] (packed ARGB, as
+   glColor1ui() takes). NULL size, rotation or color draw all particles 1 unit across,
+   unturned, in the current color. With GL_TEXTURE_2D enabled, each quad shows the
+   whole bound texture. Particles behind the eye, nearer than the near plane with
+   GL_KOS_NEARZ_CLIPPING enabled, or off the screen are dropped. Not allowed while
+   compiling a display list. */
+GLAPI void APIENTRY glKosDrawParticles(GLsizei count, const GLfloat *position, const GLfloat *size,
+                                       const GLfloat *rotation, const GLuint *color);
+
+/* Bounding Volumes - test a box from min[3] to max[3], or a sphere, holding the vertices
+   of the next draw (in the coordinates the current matrices transform) against the
+   screen and, with GL_KOS_NEARZ_CLIPPING enabled, the near plane. The result holds for
+   the next glDrawArrays(), glDrawElements(), glDrawRangeElements(), multi-draw,
+   glBegin()/glEnd() block, glCallList() or glKosDrawParticles() only:
+   GL_KOS_BOUNDS_OUTSIDE drops the draw before any of its vertices are read,
+   GL_KOS_BOUNDS_INSIDE draws it without near-Z clipping, GL_KOS_BOUNDS_CLIPPED draws it
+   as usual. The volume of a model matrix multi-draw holds every sub-draw after its model
+   matrix. While compiling a display list nothing is tested, and GL_KOS_BOUNDS_CLIPPED
+   is returned. Counted in the bounds_ fields of GL_KOS_FRAME_STATS. */
+GLAPI GLenum APIENTRY glKosBoundingBox(const GLfloat *min, const GLfloat *max);
+GLAPI GLenum APIENTRY glKosBoundingSphere(GLfloat x, GLfloat y, GLfloat z, GLfloat radius);
+
+/* Display Lists - glBegin()/glEnd() blocks and glDrawArrays()/glDrawElements()
+   between glNewList() and glEndList() are recorded with their colors, texture
+   coordinates (through the texture matrix) and normals (if lighting is enabled,
+   or a Normal Pointer is set), the blending, alpha test, depth, culling, shading,
+   fog and scissor state, and the name of the texture bound. glCallList() uses the
+   texture image that name has at the time of the call (none if it was deleted),
+   and the matrices, lighting and Near-Z clipping state at the time of the call.
+   With GL_COMPILE, glEndList() puts back the current color, texture coordinate,
+   normal, enables, blend, depth, cull, shade and alpha functions and texture
+   bindings changed while recording; matrix, light, material and texture image
+   calls take effect immediately. Points, lines,
+   glRect*() and the second texture unit are not recorded; fans and polygons are
+   recorded as GL_TRIANGLES. */
+GLAPI GLuint APIENTRY glGenLists(GLsizei range);
+GLAPI void APIENTRY glNewList(GLuint list, GLenum mode);
+GLAPI void APIENTRY glEndList();
+GLAPI void APIENTRY glCallList(GLuint list);
+GLAPI void APIENTRY glCallLists(GLsizei n, GLenum type, const GLvoid *lists);
+GLAPI void APIENTRY glListBase(GLuint base);
+GLAPI void APIENTRY glDeleteLists(GLuint list, GLsizei range);
+GLAPI GLboolean APIENTRY glIsList(GLuint list);
+
+/* Buffer Objects - while a GL_ARRAY_BUFFER is bound, the pointer argument of
+   gl*Pointer() is an offset into it, and while a GL_ELEMENT_ARRAY_BUFFER is bound,
+   the indices of glDrawElements() are. Pointers are resolved when they are set.
+   The first draw from a GL_STATIC_DRAW buffer converts its vertices to PVR vertices
+   once; later draws with the same pointer layout only transform them. */
+GLAPI void APIENTRY glGenBuffers(GLsizei n, GLuint *buffers);
+GLAPI void APIENTRY glDeleteBuffers(GLsizei n, const GLuint *buffers);
+GLAPI void APIENTRY glBindBuffer(GLenum target, GLuint buffer);
+GLAPI void APIENTRY glBufferData(GLenum target, GLsizeiptr size, const GLvoid *data, GLenum usage);
+GLAPI void APIENTRY glBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const GLvoid *data);
+GLAPI void APIENTRY glGetBufferParameteriv(GLenum target, GLenum pname, GLint *params);
+GLAPI GLboolean APIENTRY glIsBuffer(GLuint buffer);
+
 /* No need to Enable Array Client State... */
 #define glEnableClientState(cap) {;}
 #define glDisableClientState(cap) {;}
@@ -647,6 +848,52 @@ GLAPI void APIENTRY glGetFloatv(GLenum pname, GLfloat *params);
 GLAPI GLboolean APIENTRY glIsEnabled(GLenum cap);
 GLAPI const GLbyte* APIENTRY glGetString(GLenum name);
 
+/* Pipeline counters of the last frame closed by glutSwapBuffers().
+   Per list arrays are ordered opaque, translucent, punch-through.
+   A library built with GL_KOS_NO_STATS (make RELEASE=true) reports zeros. */
+typedef struct {
+    GLuint vertices[3];         /* Vertices per list */
+    GLuint headers[3];          /* Polygon headers per list */
+    GLuint clip_tris_in;        /* Triangles sent through near-Z clipping */
+    GLuint clip_tris_out;       /* Triangles emitted by near-Z clipping */
+    GLuint lit_vertices;        /* Vertices that went through lighting */
+    GLuint multitex_objects;    /* Multi-Texture objects pushed */
+    GLuint bytes_sent;          /* Bytes sent to the TA by store queues or DMA */
+    GLuint texture_uploads;     /* Texture images uploaded */
+    GLuint texture_bytes;       /* Bytes of texture data uploaded */
+    GLuint array_buf_peak;      /* Peak vertices held by each scratch buffer */
+    GLuint clip_buf_peak;
+    GLuint uv_buf_peak;
+    GLuint bounds_accepted;     /* Bounding volumes drawn without near-Z clipping */
+    GLuint bounds_rejected;     /* Bounding volumes outside, their draws dropped */
+    GLuint bounds_clipped;      /* Bounding volumes crossing the near plane */
+} GL_KOS_FRAME_STATS;
+
+GLAPI void APIENTRY glKosGetFrameStats(GL_KOS_FRAME_STATS *stats);
+
+/* Write the hot-path trace events recorded since the last dump to filename, as
+   Chrome trace-event JSON. Returns the number of events written, or -1 if the file
+   could not be opened. Trace points are only built in with GL_ENABLE_TRACE defined
+   (make TRACE=true); otherwise nothing is written and 0 is returned. */
+GLAPI GLint APIENTRY glKosTraceDump(const char *filename);
+
+/* Capture the TA command stream, as glutSwapBuffers() sends it, to filename:
+   every scene begun until glKosCaptureEnd(), with its lists, headers, vertices,
+   user clip commands and Multi-Texture passes, and the textures it references.
+   glKosCaptureBegin() returns 1 on success, glKosCaptureEnd() the number of
+   scenes captured. */
+GLAPI GLint APIENTRY glKosCaptureBegin(const char *filename);
+GLAPI GLint APIENTRY glKosCaptureEnd(void);
+
+/* Replay a capture straight to the TA, with no GL state involved.
+   glKosReplayLoad() reads filename and copies its textures to VRAM, and returns
+   the number of scenes, or -1. glKosReplayScene() submits a scene once the
+   queued GL frames are out, and returns the TA bytes sent, or -1.
+   glKosReplayFree() releases the capture and its textures. */
+GLAPI GLint APIENTRY glKosReplayLoad(const char *filename);
+GLAPI GLint APIENTRY glKosReplayScene(GLint scene);
+GLAPI void APIENTRY glKosReplayFree(void);
+
 /* Multi-Texture Extensions - Currently not supported in immediate mode */
 GLAPI void APIENTRY glActiveTextureARB(GLenum texture);
 GLAPI void APIENTRY glClientActiveTextureARB(GLenum texture);
@@ -662,9 +909,13 @@ GLAPI GLenum APIENTRY glCheckFramebufferStatus(GLenum target);
 /* Error handling */
 GLAPI GLenum APIENTRY glGetError(void);
 
-/* Non Operational Stubs for portability */
-GLAPI void APIENTRY glAlphaFunc(GLenum func, GLclampf ref);
+/* Width of lines in pixels, at any depth. GL_INVALID_VALUE if not above 0 */
 GLAPI void APIENTRY glLineWidth(GLfloat width);
+
+/* Size of points in pixels, at any depth. GL_INVALID_VALUE if not above 0 */
+GLAPI void APIENTRY glPointSize(GLfloat size);
+
+/* Non Operational Stubs for portability */
 GLAPI void APIENTRY glPolygonOffset(GLfloat factor, GLfloat units);
 GLAPI void APIENTRY glGetTexParameteriv(GLenum target, GLenum pname, GLint * params);
 GLAPI void APIENTRY glColorMask(GLboolean red, GLboolean green, GLboolean blue, GLboolean alpha);